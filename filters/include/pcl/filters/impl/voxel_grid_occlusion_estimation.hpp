@@ -41,6 +41,24 @@
 
 #include <pcl/filters/voxel_grid_occlusion_estimation.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::VoxelGridOcclusionEstimation<PointT>::setNumberOfThreads (unsigned int nr_threads)
+{
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    threads_ = omp_get_num_procs();
+#else
+    threads_ = 1;
+#endif
+  else
+    threads_ = nr_threads;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::VoxelGridOcclusionEstimation<PointT>::initializeVoxelGrid ()
@@ -129,7 +147,8 @@ pcl::VoxelGridOcclusionEstimation<PointT>::occlusionEstimation (int& out_state,
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> int
-pcl::VoxelGridOcclusionEstimation<PointT>::occlusionEstimationAll (std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> >& occluded_voxels)
+pcl::VoxelGridOcclusionEstimation<PointT>::occlusionEstimation (std::vector<int>& out_states,
+                                                                const std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> >& in_target_voxels)
 {
   if (!initialized_)
   {
@@ -137,36 +156,64 @@ pcl::VoxelGridOcclusionEstimation<PointT>::occlusionEstimationAll (std::vector<E
     return -1;
   }
 
-  // reserve space for the ray vector
-  int reserve_size = div_b_[0] * div_b_[1] * div_b_[2];
-  occluded_voxels.reserve (reserve_size);
+  std::ptrdiff_t nr_voxels = static_cast<std::ptrdiff_t> (in_target_voxels.size ());
+  out_states.resize (in_target_voxels.size ());
+
+  // every ray only reads the voxel grid
+#pragma omp parallel for \
+  default(none) \
+  shared(out_states, in_target_voxels, nr_voxels) \
+  schedule(dynamic, 256) \
+  num_threads(threads_)
+  for (std::ptrdiff_t i = 0; i < nr_voxels; ++i)
+  {
+    // estimate direction to target voxel
+    Eigen::Vector4f p = getCentroidCoordinate (in_target_voxels[i]);
+    Eigen::Vector4f direction = p - sensor_origin_;
+    direction.normalize ();
+
+    // estimate entry point into the voxel grid
+    float tmin = rayBoxIntersection (sensor_origin_, direction);
+
+    if (tmin == -1)
+      out_states[i] = -1;
+    else
+      out_states[i] = rayTraversal (in_target_voxels[i], sensor_origin_, direction, tmin);
+  }
 
-  // iterate over the entire voxel grid
+  return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::VoxelGridOcclusionEstimation<PointT>::occlusionEstimationAll (std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> >& occluded_voxels)
+{
+  if (!initialized_)
+  {
+    PCL_ERROR ("Voxel grid not initialized; call initializeVoxelGrid () first! \n");
+    return -1;
+  }
+
+  // collect all free voxels, in the order of the voxel grid
+  std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> > free_voxels;
   for (int kk = min_b_.z (); kk <= max_b_.z (); ++kk)
     for (int jj = min_b_.y (); jj <= max_b_.y (); ++jj)
       for (int ii = min_b_.x (); ii <= max_b_.x (); ++ii)
       {
         Eigen::Vector3i ijk (ii, jj, kk);
-        // process all free voxels
-        int index = this->getCentroidIndexAt (ijk);
-        if (index == -1)
-        {
-          // estimate direction to target voxel
-          Eigen::Vector4f p = getCentroidCoordinate (ijk);
-          Eigen::Vector4f direction = p - sensor_origin_;
-          direction.normalize ();
-          
-          // estimate entry point into the voxel grid
-          float tmin = rayBoxIntersection (sensor_origin_, direction);
-
-          // ray traversal
-          int state = rayTraversal (ijk, sensor_origin_, direction, tmin);
-          
-          // if voxel is occluded
-          if (state == 1)
-            occluded_voxels.push_back (ijk);
-        }
+        if (this->getCentroidIndexAt (ijk) == -1)
+          free_voxels.push_back (ijk);
       }
+
+  // trace the rays to all free voxels
+  std::vector<int> states;
+  occlusionEstimation (states, free_voxels);
+
+  // keep the occluded voxels
+  occluded_voxels.reserve (occluded_voxels.size () + free_voxels.size ());
+  for (std::size_t i = 0; i < free_voxels.size (); ++i)
+    if (states[i] == 1)
+      occluded_voxels.push_back (free_voxels[i]);
   return 0;
 }
 
@@ -44,6 +44,8 @@
 #include <pcl/point_cloud.h> // for PointCloud
 #include <pcl/pcl_exports.h> // for PCL_EXPORTS
 
+#include <Eigen/Core>
+
 namespace pcl
 {
   enum MorphologicalOperators
@@ -68,6 +70,22 @@ namespace pcl
   applyMorphologicalOperator (const typename pcl::PointCloud<PointT>::ConstPtr &cloud_in,
                               float resolution, const int morphological_operator,
                               pcl::PointCloud<PointT> &cloud_out);
+
+  /** \brief Apply morphological operator to a 2.5D grid, e.g. an elevation map
+    * The square structuring element is separated into a row and a column pass, and every pass computes the running
+    * minimum / maximum with the van Herk/Gil-Werman algorithm, in a constant number of comparisons per cell whatever
+    * the window size. Rows, then columns, are processed in parallel.
+    * \param[in] grid_in the input grid, NaN marks the empty cells
+    * \param[in] half_size half the window size in cells, the window covers (2 * half_size + 1)^2 cells
+    * \param[in] morphological_operator the morphological operator to apply (open, close, dilate, erode)
+    * \param[out] grid_out the resultant grid, NaN where the window only covers empty cells
+    * \param[in] nr_threads the number of threads to use (0 for automatic)
+    * \ingroup filters
+    */
+  PCL_EXPORTS void
+  applyMorphologicalOperator (const Eigen::MatrixXf &grid_in, int half_size,
+                              const int morphological_operator, Eigen::MatrixXf &grid_out,
+                              unsigned int nr_threads = 1);
 }
 
 #ifdef PCL_NO_PRECOMPILE
@@ -70,6 +70,7 @@ namespace pcl
       VoxelGridOcclusionEstimation ()
       {
         initialized_ = false;
+        threads_ = 1;
         this->setSaveLeafLayout (true);
       }
 
@@ -111,14 +112,38 @@ namespace pcl
                            std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> >& out_ray,
                            const Eigen::Vector3i& in_target_voxel);
 
+      /** \brief Computes the states (free = 0, occluded = 1) of a batch of
+        * target voxels in (i, j, k) coordinates. The rays are traversed in
+        * parallel, see setNumberOfThreads ().
+        * \param[out] out_states The state of each target voxel, -1 if its ray
+        * does not intersect the voxel grid.
+        * \param[in] in_target_voxels The target voxel coordinates (i, j, k).
+        * \return 0 upon success and -1 if an error occurs
+        */
+      int
+      occlusionEstimation (std::vector<int>& out_states,
+                           const std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> >& in_target_voxels);
+
       /** \brief Computes the voxel coordinates (i, j, k) of all occluded
-        * voxels in the voxel grid.
+        * voxels in the voxel grid. The rays are traversed in parallel, see
+        * setNumberOfThreads ().
         * \param[out] occluded_voxels the coordinates (i, j, k) of all occluded voxels
         * \return 0 upon success and -1 if an error occurs
         */
       int
       occlusionEstimationAll (std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> >& occluded_voxels);
 
+      /** \brief Set the number of threads used to traverse the rays of the
+        * batch occlusion estimation.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads = 0);
+
+      /** \brief Get the number of threads used by the batch occlusion estimation. */
+      inline unsigned int
+      getNumberOfThreads () const { return (threads_); }
+
       /** \brief Returns the voxel grid filtered point cloud
         * \return The voxel grid filtered point cloud
         */
@@ -242,6 +267,9 @@ namespace pcl
 
       // voxel grid filtered cloud
       PointCloud filtered_cloud_;
+
+      // number of threads used by the batch occlusion estimation
+      unsigned int threads_;
   };
 }
 
@@ -41,6 +41,139 @@
 
 #include <pcl/filters/impl/morphological_filter.hpp>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+namespace
+{
+  /** \brief Running minimum (erosion) or maximum (dilation) over windows of 2 * half_size + 1 values of a line of
+    * the grid, with the van Herk/Gil-Werman algorithm: the padded line is cut into blocks of the window size, and
+    * every window is covered by the suffix of one block and the prefix of the next one.
+    * \param[in] in first value of the line, NaN values are replaced by fill
+    * \param[in] stride distance between two consecutive values of the line
+    * \param[in] n the number of values of the line
+    * \param[in] half_size half the window size
+    * \param[in] fill the value used for the empty cells and the padding (the identity of the operation)
+    * \param[out] out first value of the output line, with the same stride
+    * \param prefix, suffix buffers for the running extremum of the blocks
+    */
+  template <typename Compare> void
+  runningExtremum (const float *in, Eigen::Index stride, Eigen::Index n, int half_size, float fill,
+                   float *out, std::vector<float> &prefix, std::vector<float> &suffix, Compare compare)
+  {
+    const Eigen::Index window = 2 * half_size + 1;
+    const Eigen::Index padded = ((n + 2 * half_size + window - 1) / window) * window;
+    prefix.resize (padded);
+    suffix.resize (padded);
+
+    for (Eigen::Index k = 0; k < padded; ++k)
+    {
+      const Eigen::Index i = k - half_size;
+      float value = fill;
+      if (i >= 0 && i < n && !std::isnan (in[i * stride]))
+        value = in[i * stride];
+      prefix[k] = (k % window == 0) ? value : std::min (prefix[k - 1], value, compare);
+      suffix[k] = value;
+    }
+    for (Eigen::Index k = padded - 2; k >= 0; --k)
+      if (k % window != window - 1)
+        suffix[k] = std::min (suffix[k + 1], suffix[k], compare);
+
+    // The window centered on i covers [i, i + 2 * half_size] in the padded line
+    for (Eigen::Index i = 0; i < n; ++i)
+      out[i * stride] = std::min (suffix[i], prefix[i + 2 * half_size], compare);
+  }
+
+  /** \brief Separable erosion or dilation of a whole grid, empty windows are set to NaN */
+  template <typename Compare> void
+  applyExtremumFilter (const Eigen::MatrixXf &grid_in, int half_size, float fill, Eigen::MatrixXf &grid_out,
+                       unsigned int nr_threads, Compare compare)
+  {
+    const Eigen::Index rows = grid_in.rows ();
+    const Eigen::Index cols = grid_in.cols ();
+    Eigen::MatrixXf tmp (rows, cols);
+    grid_out.resize (rows, cols);
+
+    // Along the rows first (the grid is column major, so these are strided)...
+#pragma omp parallel num_threads(nr_threads)
+    {
+      std::vector<float> prefix, suffix;
+#pragma omp for schedule(static)
+      for (Eigen::Index row = 0; row < rows; ++row)
+        runningExtremum (grid_in.data () + row, rows, cols, half_size, fill, tmp.data () + row, prefix, suffix, compare);
+    }
+
+    // ...then along the columns, the fill values of the first pass are kept as they are
+#pragma omp parallel num_threads(nr_threads)
+    {
+      std::vector<float> prefix, suffix;
+#pragma omp for schedule(static)
+      for (Eigen::Index col = 0; col < cols; ++col)
+      {
+        float *column = grid_out.data () + col * rows;
+        runningExtremum (tmp.data () + col * rows, 1, rows, half_size, fill, column, prefix, suffix, compare);
+        for (Eigen::Index row = 0; row < rows; ++row)
+          if (column[row] == fill)
+            column[row] = std::numeric_limits<float>::quiet_NaN ();
+      }
+    }
+  }
+}
+
+void
+pcl::applyMorphologicalOperator (const Eigen::MatrixXf &grid_in, int half_size,
+                                 const int morphological_operator, Eigen::MatrixXf &grid_out,
+                                 unsigned int nr_threads)
+{
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    nr_threads = omp_get_num_procs ();
+#else
+    nr_threads = 1;
+#endif
+  if (half_size < 0)
+    half_size = 0;
+
+  const float infinity = std::numeric_limits<float>::infinity ();
+  const auto erode = [&] (const Eigen::MatrixXf &in, Eigen::MatrixXf &out)
+  {
+    applyExtremumFilter (in, half_size, infinity, out, nr_threads, std::less<float> ());
+  };
+  const auto dilate = [&] (const Eigen::MatrixXf &in, Eigen::MatrixXf &out)
+  {
+    applyExtremumFilter (in, half_size, -infinity, out, nr_threads, std::greater<float> ());
+  };
+
+  Eigen::MatrixXf tmp;
+  switch (morphological_operator)
+  {
+    case MORPH_ERODE:
+      erode (grid_in, grid_out);
+      break;
+    case MORPH_DILATE:
+      dilate (grid_in, grid_out);
+      break;
+    case MORPH_OPEN:
+      erode (grid_in, tmp);
+      dilate (tmp, grid_out);
+      break;
+    case MORPH_CLOSE:
+      dilate (grid_in, tmp);
+      erode (tmp, grid_out);
+      break;
+    default:
+      PCL_ERROR ("[pcl::applyMorphologicalOperator] Unknown morphological operator %d!\n", morphological_operator);
+      grid_out = grid_in;
+      break;
+  }
+}
+
 #ifndef PCL_NO_PRECOMPILE
 #include <pcl/impl/instantiate.hpp>
 #include <pcl/point_types.h>
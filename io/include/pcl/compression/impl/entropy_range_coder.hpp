@@ -620,5 +620,207 @@ pcl::StaticRangeCoder::decodeStreamToCharVector (std::istream& inputByteStream_a
   return (streamByteCount);
 }
 
-#endif
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned long
+pcl::InterleavedRansCoder::encodeCharVectorToStream (const std::vector<char>& inputByteVector_arg,
+                                                     std::ostream& outputByteStream_arg)
+{
+  const DWord totalFreq = static_cast<DWord> (1) << scale_bits_;
+
+  DWord freq[256];
+  DWord start[256];
+  std::uint8_t symbolMask[32];
+
+  std::size_t input_size = inputByteVector_arg.size ();
+
+  // calculate frequency table
+  std::uint64_t FreqHist[256];
+  memset (FreqHist, 0, sizeof(FreqHist));
+  for (std::size_t readPos = 0; readPos < input_size; readPos++)
+    FreqHist[static_cast<std::uint8_t> (inputByteVector_arg[readPos])]++;
+
+  memset (symbolMask, 0, sizeof(symbolMask));
+  memset (freq, 0, sizeof(freq));
+
+  if (!input_size)
+  {
+    // an empty symbol mask marks an empty input
+    outputByteStream_arg.write (reinterpret_cast<const char*> (&symbolMask[0]), sizeof(symbolMask));
+    return (sizeof(symbolMask));
+  }
+
+  // normalize frequencies to totalFreq, every present symbol keeps a non-zero frequency
+  DWord freqSum = 0;
+  for (int f = 0; f < 256; f++)
+  {
+    if (FreqHist[f])
+    {
+      freq[f] = std::max<DWord> (1, static_cast<DWord> (FreqHist[f] * totalFreq / input_size));
+      freqSum += freq[f];
+      symbolMask[f >> 3] = static_cast<std::uint8_t> (symbolMask[f >> 3] | (1 << (f & 7)));
+    }
+  }
+
+  // correct rounding errors on the most frequent symbols
+  while (freqSum != totalFreq)
+  {
+    int maxSymbol = static_cast<int> (std::max_element (freq, freq + 256) - freq);
+    if (freqSum < totalFreq)
+    {
+      freq[maxSymbol] += totalFreq - freqSum;
+      freqSum = totalFreq;
+    }
+    else
+    {
+      DWord delta = std::min (freqSum - totalFreq, std::max<DWord> (1, freq[maxSymbol] / 8));
+      freq[maxSymbol] -= delta;
+      freqSum -= delta;
+    }
+  }
 
+  // convert to cumulative frequency table
+  start[0] = 0;
+  for (int f = 1; f < 256; f++)
+    start[f] = start[f - 1] + freq[f - 1];
+
+  // write symbol mask and frequencies of present symbols to output stream
+  outputByteStream_arg.write (reinterpret_cast<const char*> (&symbolMask[0]), sizeof(symbolMask));
+  unsigned long streamByteCount = sizeof(symbolMask);
+  for (int f = 0; f < 256; f++)
+  {
+    if (freq[f])
+    {
+      Word symbolFreq = static_cast<Word> (freq[f]);
+      outputByteStream_arg.write (reinterpret_cast<const char*> (&symbolFreq), sizeof(symbolFreq));
+      streamByteCount += sizeof(symbolFreq);
+    }
+  }
+
+  // init output vector
+  outputWordVector_.clear ();
+  outputWordVector_.reserve (input_size / 2 + number_of_states_);
+
+  DWord states[number_of_states_];
+  for (unsigned int j = 0; j < number_of_states_; j++)
+    states[j] = lower_bound_;
+
+  // rANS encodes in reverse order; symbol i is coded by state i % number_of_states_
+  for (std::size_t readPos = input_size; readPos > 0;)
+  {
+    --readPos;
+    const std::uint8_t symbol = static_cast<std::uint8_t> (inputByteVector_arg[readPos]);
+    DWord& x = states[readPos % number_of_states_];
+
+    // renormalize, a single word suffices for 32 bit states and 16 bit words
+    const std::uint64_t x_max = static_cast<std::uint64_t> ((lower_bound_ >> scale_bits_) << 16) * freq[symbol];
+    if (x >= x_max)
+    {
+      outputWordVector_.push_back (static_cast<Word> (x & 0xffff));
+      x >>= 16;
+    }
+
+    x = ((x / freq[symbol]) << scale_bits_) + (x % freq[symbol]) + start[symbol];
+  }
+
+  // words are read in the opposite order by the decoder
+  std::reverse (outputWordVector_.begin (), outputWordVector_.end ());
+
+  DWord wordCount = static_cast<DWord> (outputWordVector_.size ());
+  outputByteStream_arg.write (reinterpret_cast<const char*> (&wordCount), sizeof(wordCount));
+  outputByteStream_arg.write (reinterpret_cast<const char*> (&states[0]), sizeof(states));
+  streamByteCount += sizeof(wordCount) + sizeof(states);
+
+  // write encoded data to stream
+  if (wordCount)
+    outputByteStream_arg.write (reinterpret_cast<const char*> (&outputWordVector_[0]), wordCount * sizeof(Word));
+  streamByteCount += static_cast<unsigned long> (wordCount * sizeof(Word));
+
+  return (streamByteCount);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned long
+pcl::InterleavedRansCoder::decodeStreamToCharVector (std::istream& inputByteStream_arg,
+                                                     std::vector<char>& outputByteVector_arg)
+{
+  const DWord totalFreq = static_cast<DWord> (1) << scale_bits_;
+
+  DWord freq[256];
+  DWord start[256];
+  std::uint8_t symbolMask[32];
+
+  std::size_t output_size = outputByteVector_arg.size ();
+
+  // read symbol mask
+  inputByteStream_arg.read (reinterpret_cast<char*> (&symbolMask[0]), sizeof(symbolMask));
+  unsigned long streamByteCount = sizeof(symbolMask);
+
+  // read frequencies of present symbols
+  bool emptyInput = true;
+  for (int f = 0; f < 256; f++)
+  {
+    freq[f] = 0;
+    if (symbolMask[f >> 3] & (1 << (f & 7)))
+    {
+      Word symbolFreq;
+      inputByteStream_arg.read (reinterpret_cast<char*> (&symbolFreq), sizeof(symbolFreq));
+      streamByteCount += sizeof(symbolFreq);
+      freq[f] = symbolFreq;
+      emptyInput = false;
+    }
+  }
+
+  if (emptyInput)
+    return (streamByteCount);
+
+  // build cumulative frequency table and slot lookup table
+  slotToSymbol_.resize (totalFreq);
+  start[0] = 0;
+  for (int f = 0; f < 256; f++)
+  {
+    if (f > 0)
+      start[f] = start[f - 1] + freq[f - 1];
+    for (DWord slot = start[f]; (slot < start[f] + freq[f]) && (slot < totalFreq); slot++)
+      slotToSymbol_[slot] = static_cast<std::uint8_t> (f);
+  }
+
+  // read coder states and encoded data
+  DWord wordCount;
+  DWord states[number_of_states_];
+  inputByteStream_arg.read (reinterpret_cast<char*> (&wordCount), sizeof(wordCount));
+  inputByteStream_arg.read (reinterpret_cast<char*> (&states[0]), sizeof(states));
+  streamByteCount += sizeof(wordCount) + sizeof(states);
+
+  outputWordVector_.resize (wordCount);
+  if (wordCount)
+    inputByteStream_arg.read (reinterpret_cast<char*> (&outputWordVector_[0]), wordCount * sizeof(Word));
+  streamByteCount += static_cast<unsigned long> (wordCount * sizeof(Word));
+
+  const Word* words = outputWordVector_.data ();
+  DWord wordPos = 0;
+
+  // decode a single symbol with coder state x
+  auto decodeSymbol = [&] (DWord& x) -> char
+  {
+    const DWord slot = x & (totalFreq - 1);
+    const std::uint8_t symbol = slotToSymbol_[slot];
+    x = freq[symbol] * (x >> scale_bits_) + slot - start[symbol];
+    if ((x < lower_bound_) && (wordPos < wordCount))
+      x = (x << 16) | words[wordPos++];
+    return (static_cast<char> (symbol));
+  };
+
+  // decoding, one symbol per state and iteration
+  std::size_t outputBufPos = 0;
+  for (; outputBufPos + number_of_states_ <= output_size; outputBufPos += number_of_states_)
+  {
+    for (unsigned int j = 0; j < number_of_states_; j++)
+      outputByteVector_arg[outputBufPos + j] = decodeSymbol (states[j]);
+  }
+  for (; outputBufPos < output_size; outputBufPos++)
+    outputByteVector_arg[outputBufPos] = decodeSymbol (states[outputBufPos % number_of_states_]);
+
+  return (streamByteCount);
+}
+
+#endif
@@ -39,12 +39,21 @@
 #define OCTREE_COMPRESSION_HPP
 
 #include <pcl/common/io.h> // for getFieldIndex
+#include <pcl/common/point_tests.h> // for pcl::isFinite
 #include <pcl/compression/entropy_range_coder.h>
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
 #include <vector>
 #include <cstring>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace pcl
 {
   namespace io
@@ -247,6 +256,291 @@ namespace pcl
       }
     }
 
+    //////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename PointT, typename LeafT, typename BranchT, typename OctreeT> void
+    OctreePointCloudCompression<PointT, LeafT, BranchT, OctreeT>::setNumberOfThreads (unsigned int nr_threads)
+    {
+      if (nr_threads == 0)
+#ifdef _OPENMP
+        threads_ = omp_get_num_procs();
+#else
+        threads_ = 1;
+#endif
+      else
+        threads_ = nr_threads;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename PointT, typename LeafT, typename BranchT, typename OctreeT> void
+    OctreePointCloudCompression<PointT, LeafT, BranchT, OctreeT>::encodePointCloudChunked (
+        const PointCloudConstPtr &cloud_arg,
+        std::ostream& compressed_tree_data_out_arg)
+    {
+      // bounding box of the finite points
+      Eigen::Vector3d min_pt = Eigen::Vector3d::Constant (std::numeric_limits<double>::max ());
+      Eigen::Vector3d max_pt = Eigen::Vector3d::Constant (std::numeric_limits<double>::lowest ());
+      for (const auto& point : cloud_arg->points)
+      {
+        if (!isFinite (point))
+          continue;
+        min_pt = min_pt.cwiseMin (point.getVector3fMap ().template cast<double> ());
+        max_pt = max_pt.cwiseMax (point.getVector3fMap ().template cast<double> ());
+      }
+
+      std::vector<ChunkInfo> chunks;
+      std::vector<std::vector<int> > chunk_indices;
+      std::vector<std::string> chunk_data;
+      if (min_pt.x () <= max_pt.x ())
+      {
+        // octree grid of the whole cloud, the chunks are the subtrees at the chunk depth
+        const double min_value = std::numeric_limits<float>::epsilon () * 512.0;
+        OctreePointCloud<PointT, LeafT, BranchT, OctreeBase<LeafT, BranchT> > grid (this->getResolution ());
+        grid.defineBoundingBox (min_pt.x (), min_pt.y (), min_pt.z (),
+                                max_pt.x () + min_value, max_pt.y () + min_value, max_pt.z () + min_value);
+        grid.getBoundingBox (min_pt.x (), min_pt.y (), min_pt.z (), max_pt.x (), max_pt.y (), max_pt.z ());
+        const unsigned int tree_depth = grid.getTreeDepth ();
+        const unsigned int chunk_depth = tree_depth > 1 ? std::min (chunk_depth_, tree_depth - 1) : 0;
+        const unsigned int chunk_shift = tree_depth - chunk_depth;
+        const std::uint32_t max_key = (1u << tree_depth) - 1;
+        const std::uint32_t chunks_per_axis = 1u << chunk_depth;
+
+        // distribute the points to the chunks, in the order of the input
+        std::vector<int> chunk_of_cell (static_cast<std::size_t> (chunks_per_axis) * chunks_per_axis * chunks_per_axis, -1);
+        for (std::size_t i = 0; i < cloud_arg->size (); ++i)
+        {
+          const PointT& point = (*cloud_arg)[i];
+          if (!isFinite (point))
+            continue;
+          std::uint32_t key[3];
+          for (int d = 0; d < 3; ++d)
+          {
+            const double coordinate = (point.getVector3fMap ()[d] - min_pt[d]) / this->getResolution ();
+            key[d] = static_cast<std::uint32_t> (std::min (std::max (coordinate, 0.0), static_cast<double> (max_key))) >> chunk_shift;
+          }
+          int& chunk = chunk_of_cell[(key[0] * chunks_per_axis + key[1]) * chunks_per_axis + key[2]];
+          if (chunk < 0)
+          {
+            chunk = static_cast<int> (chunks.size ());
+            chunks.push_back ({{key[0], key[1], key[2]}, 0, 0, 0});
+            chunk_indices.emplace_back ();
+          }
+          chunk_indices[chunk].push_back (static_cast<int> (i));
+        }
+
+        // encode the chunks in parallel, every chunk in its own octree aligned to the grid
+        double chunk_size = static_cast<double> (1u << chunk_shift) * this->getResolution ();
+        chunk_data.resize (chunks.size ());
+        int nr_chunks = static_cast<int> (chunks.size ());
+#pragma omp parallel for \
+  default(none) \
+  shared(cloud_arg, chunks, chunk_indices, chunk_data, chunk_size, min_pt, nr_chunks) \
+  schedule(dynamic, 1) \
+  num_threads(threads_)
+        for (int chunk = 0; chunk < nr_chunks; ++chunk)
+        {
+          PointCloudPtr chunk_cloud (new PointCloud);
+          pcl::copyPointCloud (*cloud_arg, chunk_indices[chunk], *chunk_cloud);
+
+          OctreePointCloudCompression<PointT, LeafT, BranchT, OctreeT> chunk_encoder (
+              MANUAL_CONFIGURATION, false, point_coder_.getPrecision (), this->getResolution (),
+              do_voxel_grid_enDecoding_, i_frame_rate_, do_color_encoding_, color_coder_.getBitDepth (),
+              do_rans_encoding_);
+          Eigen::Vector3d chunk_min;
+          for (int d = 0; d < 3; ++d)
+            chunk_min[d] = min_pt[d] + chunks[chunk].key[d] * chunk_size;
+          chunk_encoder.defineBoundingBox (chunk_min.x (), chunk_min.y (), chunk_min.z (),
+                                           chunk_min.x () + chunk_size, chunk_min.y () + chunk_size, chunk_min.z () + chunk_size);
+
+          std::ostringstream chunk_stream;
+          chunk_encoder.encodePointCloud (chunk_cloud, chunk_stream);
+          chunk_data[chunk] = chunk_stream.str ();
+          chunks[chunk].point_count = chunk_encoder.point_count_;
+          chunks[chunk].size = chunk_data[chunk].size ();
+        }
+      }
+
+      // write the header and the chunk index, the offsets are not stored, the chunks follow the index in its order
+      const auto nr_chunks = static_cast<std::uint32_t> (chunks.size ());
+      compressed_tree_data_out_arg.write (chunked_header_identifier_, strlen (chunked_header_identifier_));
+      compressed_tree_data_out_arg.write (reinterpret_cast<const char*> (&nr_chunks), sizeof (nr_chunks));
+      std::uint64_t offset = 0;
+      for (auto& chunk : chunks)
+      {
+        chunk.offset = offset;
+        offset += chunk.size;
+        compressed_tree_data_out_arg.write (reinterpret_cast<const char*> (chunk.key), sizeof (chunk.key));
+        compressed_tree_data_out_arg.write (reinterpret_cast<const char*> (&chunk.point_count), sizeof (chunk.point_count));
+        compressed_tree_data_out_arg.write (reinterpret_cast<const char*> (&chunk.size), sizeof (chunk.size));
+      }
+
+      // write the compressed chunks
+      point_count_ = 0;
+      for (std::size_t chunk = 0; chunk < chunks.size (); ++chunk)
+      {
+        compressed_tree_data_out_arg.write (chunk_data[chunk].data (), chunk_data[chunk].size ());
+        point_count_ += chunks[chunk].point_count;
+      }
+      compressed_tree_data_out_arg.flush ();
+
+      if (b_show_statistics_)
+      {
+        PCL_INFO ("*** CHUNKED POINTCLOUD ENCODING ***\n");
+        PCL_INFO ("Number of chunks: %u\n", nr_chunks);
+        PCL_INFO ("Number of encoded points: %ld\n", point_count_);
+        PCL_INFO ("Size of compressed point cloud: %f kBytes\n", static_cast<float> (offset) / 1024.0f);
+      }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename PointT, typename LeafT, typename BranchT, typename OctreeT> bool
+    OctreePointCloudCompression<PointT, LeafT, BranchT, OctreeT>::readChunkIndex (
+        std::istream& compressed_tree_data_in_arg,
+        std::vector<ChunkInfo>& chunks)
+    {
+      chunks.clear ();
+
+      // check the header identifier
+      std::string identifier (strlen (chunked_header_identifier_), '\0');
+      compressed_tree_data_in_arg.read (&identifier[0], identifier.size ());
+      if (!compressed_tree_data_in_arg || identifier != chunked_header_identifier_)
+      {
+        PCL_ERROR ("[pcl::io::OctreePointCloudCompression::readChunkIndex] No chunked point cloud found in the input stream!\n");
+        return (false);
+      }
+
+      // the index is read entry by entry, a corrupt number of chunks fails at the end of the stream
+      std::uint32_t nr_chunks = 0;
+      compressed_tree_data_in_arg.read (reinterpret_cast<char*> (&nr_chunks), sizeof (nr_chunks));
+      if (!compressed_tree_data_in_arg.good ())
+      {
+        PCL_ERROR ("[pcl::io::OctreePointCloudCompression::readChunkIndex] Invalid number of chunks in the input stream!\n");
+        return (false);
+      }
+
+      chunks.reserve (std::min<std::uint32_t> (nr_chunks, 4096));
+      for (std::uint32_t chunk_idx = 0; chunk_idx < nr_chunks; ++chunk_idx)
+      {
+        ChunkInfo chunk;
+        compressed_tree_data_in_arg.read (reinterpret_cast<char*> (chunk.key), sizeof (chunk.key));
+        compressed_tree_data_in_arg.read (reinterpret_cast<char*> (&chunk.point_count), sizeof (chunk.point_count));
+        compressed_tree_data_in_arg.read (reinterpret_cast<char*> (&chunk.size), sizeof (chunk.size));
+        if (!compressed_tree_data_in_arg.good ())
+        {
+          PCL_ERROR ("[pcl::io::OctreePointCloudCompression::readChunkIndex] Truncated chunk index in the input stream!\n");
+          chunks.clear ();
+          return (false);
+        }
+        chunks.push_back (chunk);
+      }
+
+      // turn the chunk sizes into positions, the chunks follow the index
+      const std::istream::pos_type index_end = compressed_tree_data_in_arg.tellg ();
+      std::uint64_t offset = (index_end == std::istream::pos_type (-1)) ? 0 : static_cast<std::uint64_t> (index_end);
+      for (auto& chunk : chunks)
+      {
+        chunk.offset = offset;
+        offset += chunk.size;
+      }
+      return (true);
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename PointT, typename LeafT, typename BranchT, typename OctreeT> bool
+    OctreePointCloudCompression<PointT, LeafT, BranchT, OctreeT>::readChunk (
+        std::istream& compressed_tree_data_in_arg,
+        std::uint64_t size,
+        std::string& chunk_data)
+    {
+      // read in pieces, a corrupt size fails at the end of the stream instead of being allocated
+      const std::uint64_t piece_size = 1 << 20;
+      chunk_data.clear ();
+      chunk_data.reserve (static_cast<std::size_t> (std::min (size, piece_size)));
+      while (chunk_data.size () < size)
+      {
+        const std::size_t position = chunk_data.size ();
+        const auto length = static_cast<std::size_t> (std::min (size - position, piece_size));
+        chunk_data.resize (position + length);
+        compressed_tree_data_in_arg.read (&chunk_data[position], length);
+        if (static_cast<std::size_t> (compressed_tree_data_in_arg.gcount ()) != length)
+        {
+          chunk_data.clear ();
+          return (false);
+        }
+      }
+      return (true);
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename PointT, typename LeafT, typename BranchT, typename OctreeT> void
+    OctreePointCloudCompression<PointT, LeafT, BranchT, OctreeT>::decodePointCloudChunk (
+        std::istream& compressed_tree_data_in_arg,
+        const ChunkInfo& chunk,
+        PointCloudPtr &cloud_arg)
+    {
+      std::string chunk_data;
+      compressed_tree_data_in_arg.seekg (static_cast<std::streamoff> (chunk.offset));
+      if (!compressed_tree_data_in_arg || !readChunk (compressed_tree_data_in_arg, chunk.size, chunk_data))
+      {
+        PCL_ERROR ("[pcl::io::OctreePointCloudCompression::decodePointCloudChunk] Could not read the chunk from the input stream!\n");
+        return;
+      }
+
+      std::istringstream chunk_stream (chunk_data);
+      OctreePointCloudCompression<PointT, LeafT, BranchT, OctreeT> chunk_decoder;
+      chunk_decoder.decodePointCloud (chunk_stream, cloud_arg);
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename PointT, typename LeafT, typename BranchT, typename OctreeT> void
+    OctreePointCloudCompression<PointT, LeafT, BranchT, OctreeT>::decodePointCloudChunked (
+        std::istream& compressed_tree_data_in_arg,
+        PointCloudPtr &cloud_arg)
+    {
+      std::vector<ChunkInfo> chunks;
+      if (!readChunkIndex (compressed_tree_data_in_arg, chunks))
+        return;
+
+      // read all chunks, they follow the index
+      std::vector<std::string> chunk_data (chunks.size ());
+      for (std::size_t chunk = 0; chunk < chunks.size (); ++chunk)
+      {
+        if (!readChunk (compressed_tree_data_in_arg, chunks[chunk].size, chunk_data[chunk]))
+        {
+          PCL_ERROR ("[pcl::io::OctreePointCloudCompression::decodePointCloudChunked] Could not read the chunks from the input stream!\n");
+          return;
+        }
+      }
+
+      // decode the chunks in parallel
+      std::vector<PointCloudPtr> chunk_clouds (chunks.size ());
+      int nr_chunks = static_cast<int> (chunks.size ());
+#pragma omp parallel for \
+  default(none) \
+  shared(chunk_data, chunk_clouds, nr_chunks) \
+  schedule(dynamic, 1) \
+  num_threads(threads_)
+      for (int chunk = 0; chunk < nr_chunks; ++chunk)
+      {
+        std::istringstream chunk_stream (chunk_data[chunk]);
+        chunk_clouds[chunk].reset (new PointCloud);
+        OctreePointCloudCompression<PointT, LeafT, BranchT, OctreeT> chunk_decoder;
+        chunk_decoder.decodePointCloud (chunk_stream, chunk_clouds[chunk]);
+      }
+
+      // concatenate the chunks in the order of the index
+      std::size_t nr_points = 0;
+      for (const auto& chunk_cloud : chunk_clouds)
+        nr_points += chunk_cloud->size ();
+      cloud_arg->points.clear ();
+      cloud_arg->points.reserve (nr_points);
+      for (const auto& chunk_cloud : chunk_clouds)
+        cloud_arg->points.insert (cloud_arg->points.end (), chunk_cloud->points.begin (), chunk_cloud->points.end ());
+      cloud_arg->height = 1;
+      cloud_arg->width = cloud_arg->size ();
+      cloud_arg->is_dense = false;
+      point_count_ = nr_points;
+    }
+
     //////////////////////////////////////////////////////////////////////////////////////////////
     template<typename PointT, typename LeafT, typename BranchT, typename OctreeT> void
     OctreePointCloudCompression<PointT, LeafT, BranchT, OctreeT>::entropyEncoding (std::ostream& compressed_tree_data_out_arg)
@@ -260,8 +554,7 @@ namespace pcl
       // encode binary octree structure
       binary_tree_data_vector_size = binary_tree_data_vector_.size ();
       compressed_tree_data_out_arg.write (reinterpret_cast<const char*> (&binary_tree_data_vector_size), sizeof (binary_tree_data_vector_size));
-      compressed_point_data_len_ += entropy_coder_.encodeCharVectorToStream (binary_tree_data_vector_,
-                                                                             compressed_tree_data_out_arg);
+      compressed_point_data_len_ += encodeByteVector (binary_tree_data_vector_, compressed_tree_data_out_arg);
 
       if (cloud_with_color_)
       {
@@ -270,8 +563,7 @@ namespace pcl
         point_avg_color_data_vector_size = pointAvgColorDataVector.size ();
         compressed_tree_data_out_arg.write (reinterpret_cast<const char*> (&point_avg_color_data_vector_size),
                                             sizeof (point_avg_color_data_vector_size));
-        compressed_color_data_len_ += entropy_coder_.encodeCharVectorToStream (pointAvgColorDataVector,
-                                                                               compressed_tree_data_out_arg);
+        compressed_color_data_len_ += encodeByteVector (pointAvgColorDataVector, compressed_tree_data_out_arg);
       }
 
       if (!do_voxel_grid_enDecoding_)
@@ -290,8 +582,7 @@ namespace pcl
         std::vector<char>& point_diff_data_vector = point_coder_.getDifferentialDataVector ();
         point_diff_data_vector_size = point_diff_data_vector.size ();
         compressed_tree_data_out_arg.write (reinterpret_cast<const char*> (&point_diff_data_vector_size), sizeof (point_diff_data_vector_size));
-        compressed_point_data_len_ += entropy_coder_.encodeCharVectorToStream (point_diff_data_vector,
-                                                                               compressed_tree_data_out_arg);
+        compressed_point_data_len_ += encodeByteVector (point_diff_data_vector, compressed_tree_data_out_arg);
         if (cloud_with_color_)
         {
           // encode differential color information
@@ -299,8 +590,7 @@ namespace pcl
           point_diff_color_data_vector_size = point_diff_color_data_vector.size ();
           compressed_tree_data_out_arg.write (reinterpret_cast<const char*> (&point_diff_color_data_vector_size),
                                            sizeof (point_diff_color_data_vector_size));
-          compressed_color_data_len_ += entropy_coder_.encodeCharVectorToStream (point_diff_color_data_vector,
-                                                                                 compressed_tree_data_out_arg);
+          compressed_color_data_len_ += encodeByteVector (point_diff_color_data_vector, compressed_tree_data_out_arg);
         }
       }
       // flush output stream
@@ -320,8 +610,7 @@ namespace pcl
       // decode binary octree structure
       compressed_tree_data_in_arg.read (reinterpret_cast<char*> (&binary_tree_data_vector_size), sizeof (binary_tree_data_vector_size));
       binary_tree_data_vector_.resize (static_cast<std::size_t> (binary_tree_data_vector_size));
-      compressed_point_data_len_ += entropy_coder_.decodeStreamToCharVector (compressed_tree_data_in_arg,
-                                                                         binary_tree_data_vector_);
+      compressed_point_data_len_ += decodeByteVector (compressed_tree_data_in_arg, binary_tree_data_vector_);
 
       if (data_with_color_)
       {
@@ -329,8 +618,7 @@ namespace pcl
         std::vector<char>& point_avg_color_data_vector = color_coder_.getAverageDataVector ();
         compressed_tree_data_in_arg.read (reinterpret_cast<char*> (&point_avg_color_data_vector_size), sizeof (point_avg_color_data_vector_size));
         point_avg_color_data_vector.resize (static_cast<std::size_t> (point_avg_color_data_vector_size));
-        compressed_color_data_len_ += entropy_coder_.decodeStreamToCharVector (compressed_tree_data_in_arg,
-                                                                           point_avg_color_data_vector);
+        compressed_color_data_len_ += decodeByteVector (compressed_tree_data_in_arg, point_avg_color_data_vector);
       }
 
       if (!do_voxel_grid_enDecoding_)
@@ -349,8 +637,7 @@ namespace pcl
         std::vector<char>& pointDiffDataVector = point_coder_.getDifferentialDataVector ();
         compressed_tree_data_in_arg.read (reinterpret_cast<char*> (&point_diff_data_vector_size), sizeof (point_diff_data_vector_size));
         pointDiffDataVector.resize (static_cast<std::size_t> (point_diff_data_vector_size));
-        compressed_point_data_len_ += entropy_coder_.decodeStreamToCharVector (compressed_tree_data_in_arg,
-                                                                           pointDiffDataVector);
+        compressed_point_data_len_ += decodeByteVector (compressed_tree_data_in_arg, pointDiffDataVector);
 
         if (data_with_color_)
         {
@@ -358,8 +645,7 @@ namespace pcl
           std::vector<char>& pointDiffColorDataVector = color_coder_.getDifferentialDataVector ();
           compressed_tree_data_in_arg.read (reinterpret_cast<char*> (&point_diff_color_data_vector_size), sizeof (point_diff_color_data_vector_size));
           pointDiffColorDataVector.resize (static_cast<std::size_t> (point_diff_color_data_vector_size));
-          compressed_color_data_len_ += entropy_coder_.decodeStreamToCharVector (compressed_tree_data_in_arg,
-                                                                             pointDiffColorDataVector);
+          compressed_color_data_len_ += decodeByteVector (compressed_tree_data_in_arg, pointDiffColorDataVector);
         }
       }
     }
@@ -372,8 +658,9 @@ namespace pcl
       compressed_tree_data_out_arg.write (reinterpret_cast<const char*> (frame_header_identifier_), strlen (frame_header_identifier_));
       // encode point cloud header id
       compressed_tree_data_out_arg.write (reinterpret_cast<const char*> (&frame_ID_), sizeof (frame_ID_));
-      // encode frame type (I/P-frame)
-      compressed_tree_data_out_arg.write (reinterpret_cast<const char*> (&i_frame_), sizeof (i_frame_));
+      // encode frame type (bit 0: I/P-frame, bit 1: rANS/static range coding)
+      unsigned char frame_type = static_cast<unsigned char> ((i_frame_ ? 1 : 0) | (do_rans_encoding_ ? 2 : 0));
+      compressed_tree_data_out_arg.write (reinterpret_cast<const char*> (&frame_type), sizeof (frame_type));
       if (i_frame_)
       {
         double min_x, min_y, min_z, max_x, max_y, max_z;
@@ -432,7 +719,10 @@ namespace pcl
     {
       // read header
       compressed_tree_data_in_arg.read (reinterpret_cast<char*> (&frame_ID_), sizeof (frame_ID_));
-      compressed_tree_data_in_arg.read (reinterpret_cast<char*>(&i_frame_), sizeof (i_frame_));
+      unsigned char frame_type;
+      compressed_tree_data_in_arg.read (reinterpret_cast<char*> (&frame_type), sizeof (frame_type));
+      i_frame_ = (frame_type & 1) != 0;
+      data_with_rans_encoding_ = (frame_type & 2) != 0;
       if (i_frame_)
       {
         double min_x, min_y, min_z, max_x, max_y, max_z;
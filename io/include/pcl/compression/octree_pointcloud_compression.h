@@ -45,7 +45,9 @@
 
 #include "compression_profiles.h"
 
+#include <cstdint>
 #include <iostream>
+#include <string>
 #include <vector>
 
 using namespace pcl::octree;
@@ -82,6 +84,20 @@ namespace pcl
         using RealTimeStreamCompression = OctreePointCloudCompression<PointT, LeafT, BranchT, Octree2BufBase<LeafT, BranchT> >;
         using SinglePointCloudCompressionLowMemory = OctreePointCloudCompression<PointT, LeafT, BranchT, OctreeBase<LeafT, BranchT> >;
 
+        /** \brief Entry of the chunk index of the chunked format, see encodePointCloudChunked (). */
+        struct ChunkInfo
+        {
+          /** \brief Key of the subtree of the chunk, at the chunk depth. */
+          std::uint32_t key[3];
+          /** \brief Number of encoded points of the chunk. */
+          std::uint64_t point_count;
+          /** \brief Position of the compressed chunk in the stream, or from the end of the
+            * index if the stream does not report its position. */
+          std::uint64_t offset;
+          /** \brief Size of the compressed chunk in bytes. */
+          std::uint64_t size;
+        };
+
 
         /** \brief Constructor
           * \param compressionProfile_arg:  define compression profile
@@ -92,6 +108,7 @@ namespace pcl
           * \param doColorEncoding_arg:  enable/disable color coding
           * \param colorBitResolution_arg:  color bit depth
           * \param showStatistics_arg:  output compression statistics
+          * \param doRansEncoding_arg:  use interleaved rANS instead of static range coding for the byte streams
           */
         OctreePointCloudCompression (compression_Profiles_e compressionProfile_arg = MED_RES_ONLINE_COMPRESSION_WITH_COLOR,
                                bool showStatistics_arg = false,
@@ -100,7 +117,8 @@ namespace pcl
                                bool doVoxelGridDownDownSampling_arg = false,
                                const unsigned int iFrameRate_arg = 30,
                                bool doColorEncoding_arg = true,
-                               const unsigned char colorBitResolution_arg = 6) :
+                               const unsigned char colorBitResolution_arg = 6,
+                               bool doRansEncoding_arg = false) :
           OctreePointCloud<PointT, LeafT, BranchT, OctreeT> (octreeResolution_arg),
           output_ (PointCloudPtr ()),
           color_coder_ (),
@@ -108,11 +126,12 @@ namespace pcl
           do_voxel_grid_enDecoding_ (doVoxelGridDownDownSampling_arg), i_frame_rate_ (iFrameRate_arg),
           i_frame_counter_ (0), frame_ID_ (0), point_count_ (0), i_frame_ (true),
           do_color_encoding_ (doColorEncoding_arg), cloud_with_color_ (false), data_with_color_ (false),
+          do_rans_encoding_ (doRansEncoding_arg), data_with_rans_encoding_ (false),
           point_color_offset_ (0), b_show_statistics_ (showStatistics_arg), 
           compressed_point_data_len_ (), compressed_color_data_len_ (), selected_profile_(compressionProfile_arg),
           point_resolution_(pointResolution_arg), octree_resolution_(octreeResolution_arg),
           color_bit_resolution_(colorBitResolution_arg),
-          object_count_(0)
+          object_count_(0), chunk_depth_ (2), threads_ (1)
         {
           initialization();
         }
@@ -139,6 +158,7 @@ namespace pcl
             point_coder_.setPrecision (static_cast<float> (selectedProfile.pointResolution));
             do_color_encoding_ = selectedProfile.doColorEncoding;
             color_coder_.setBitDepth (selectedProfile.colorBitResolution);
+            do_rans_encoding_ = selectedProfile.doRansEncoding;
 
           }
           else 
@@ -199,6 +219,81 @@ namespace pcl
         void
         decodePointCloud (std::istream& compressed_tree_data_in_arg, PointCloudPtr &cloud_arg);
 
+        /** \brief Encode a point cloud to the output stream in the chunked format.
+          * The octree is split at the chunk depth (see setChunkDepth ()) into subtrees,
+          * which are encoded in parallel as independent intra frames, each with its own
+          * point, color and entropy coders. The frame starts with an index of the chunks,
+          * so that they can be decoded in parallel or one by one.
+          * \note Chunked frames do not reference previous frames, and the settings of the
+          * compression profile are used for all chunks.
+          * \param cloud_arg:  point cloud to be compressed
+          * \param compressed_tree_data_out_arg:  binary output stream containing compressed data
+          */
+        void
+        encodePointCloudChunked (const PointCloudConstPtr &cloud_arg, std::ostream& compressed_tree_data_out_arg);
+
+        /** \brief Decode a point cloud in the chunked format from the input stream,
+          * decoding the chunks in parallel.
+          * \param compressed_tree_data_in_arg: binary input stream containing compressed
+          * data, the chunks are read one after the other so it does not have to be seekable
+          * \param cloud_arg: reference to decoded point cloud
+          */
+        void
+        decodePointCloudChunked (std::istream& compressed_tree_data_in_arg, PointCloudPtr &cloud_arg);
+
+        /** \brief Read the chunk index of a point cloud in the chunked format. The
+          * stream is left at the first chunk.
+          * \note The index is read sequentially and reading fails on truncated indices. The
+          * chunk sizes can only be checked when the chunks are read.
+          * \param compressed_tree_data_in_arg: binary input stream containing compressed data
+          * \param chunks: the index of the chunks
+          * \return true if a valid chunk index was read
+          */
+        bool
+        readChunkIndex (std::istream& compressed_tree_data_in_arg, std::vector<ChunkInfo>& chunks);
+
+        /** \brief Decode a single chunk of a point cloud in the chunked format.
+          * \param compressed_tree_data_in_arg: binary input stream containing compressed
+          * data, it has to be seekable
+          * \param chunk: the chunk to decode, as read by readChunkIndex ()
+          * \param cloud_arg: reference to decoded point cloud
+          */
+        void
+        decodePointCloudChunk (std::istream& compressed_tree_data_in_arg, const ChunkInfo& chunk, PointCloudPtr &cloud_arg);
+
+        /** \brief Set the depth at which the octree is split into chunks, the octree is
+          * split into up to 8^chunk_depth chunks.
+          * \param chunk_depth: the chunk depth
+          */
+        inline void
+        setChunkDepth (unsigned int chunk_depth) { chunk_depth_ = chunk_depth; }
+
+        /** \brief Get the depth at which the octree is split into chunks. */
+        inline unsigned int
+        getChunkDepth () const { return (chunk_depth_); }
+
+        /** \brief Set the number of threads used to encode and decode the chunks.
+          * \param nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+          */
+        void
+        setNumberOfThreads (unsigned int nr_threads = 0);
+
+        /** \brief Get the number of threads used to encode and decode the chunks. */
+        inline unsigned int
+        getNumberOfThreads () const { return (threads_); }
+
+        /** \brief Enable/disable interleaved rANS coding of the byte streams of encoded frames. rANS
+          * decodes considerably faster than static range coding at about the same compression ratio.
+          * The decoder detects the coder from the frame header.
+          * \param doRansEncoding_arg: enable/disable rANS coding
+          */
+        inline void
+        setRansEncoding (bool doRansEncoding_arg) { do_rans_encoding_ = doRansEncoding_arg; }
+
+        /** \brief Get whether the byte streams of encoded frames are rANS coded. */
+        inline bool
+        getRansEncoding () const { return (do_rans_encoding_); }
+
       protected:
 
         /** \brief Write frame information to output stream
@@ -213,6 +308,15 @@ namespace pcl
         void
         readFrameHeader (std::istream& compressed_tree_data_in_arg);
 
+        /** \brief Read a compressed chunk of the chunked format from the current position of the stream
+          * \param compressed_tree_data_in_arg: binary input stream
+          * \param size: size of the chunk in bytes
+          * \param chunk_data: the data of the chunk
+          * \return true if the whole chunk was read
+          */
+        bool
+        readChunk (std::istream& compressed_tree_data_in_arg, std::uint64_t size, std::string& chunk_data);
+
         /** \brief Synchronize to frame header
           * \param compressed_tree_data_in_arg: binary input stream
           */
@@ -231,6 +335,32 @@ namespace pcl
         void
         entropyDecoding (std::istream& compressed_tree_data_in_arg);
 
+        /** \brief Entropy encode a byte vector with the selected coder
+          * \param byte_vector_arg: input vector
+          * \param compressed_tree_data_out_arg: binary output stream
+          * \return amount of bytes written to output stream
+          */
+        inline unsigned long
+        encodeByteVector (const std::vector<char>& byte_vector_arg, std::ostream& compressed_tree_data_out_arg)
+        {
+          if (do_rans_encoding_)
+            return (rans_coder_.encodeCharVectorToStream (byte_vector_arg, compressed_tree_data_out_arg));
+          return (entropy_coder_.encodeCharVectorToStream (byte_vector_arg, compressed_tree_data_out_arg));
+        }
+
+        /** \brief Entropy decode a byte vector with the coder of the current frame
+          * \param compressed_tree_data_in_arg: binary input stream
+          * \param byte_vector_arg: output vector, resized to the amount of encoded symbols
+          * \return amount of bytes read from input stream
+          */
+        inline unsigned long
+        decodeByteVector (std::istream& compressed_tree_data_in_arg, std::vector<char>& byte_vector_arg)
+        {
+          if (data_with_rans_encoding_)
+            return (rans_coder_.decodeStreamToCharVector (compressed_tree_data_in_arg, byte_vector_arg));
+          return (entropy_coder_.decodeStreamToCharVector (compressed_tree_data_in_arg, byte_vector_arg));
+        }
+
         /** \brief Encode leaf node information during serialization
           * \param leaf_arg: reference to new leaf node
           * \param key_arg: octree key of new leaf node
@@ -270,6 +400,9 @@ namespace pcl
         /** \brief Static range coder instance */
         StaticRangeCoder entropy_coder_;
 
+        /** \brief Interleaved rANS coder instance */
+        InterleavedRansCoder rans_coder_;
+
         bool do_voxel_grid_enDecoding_;
         std::uint32_t i_frame_rate_;
         std::uint32_t i_frame_counter_;
@@ -280,6 +413,11 @@ namespace pcl
         bool do_color_encoding_;
         bool cloud_with_color_;
         bool data_with_color_;
+
+        // use rANS for the byte streams when encoding / of the frame being decoded
+        bool do_rans_encoding_;
+        bool data_with_rans_encoding_;
+
         unsigned char point_color_offset_;
 
         //bool activating statistics
@@ -297,11 +435,24 @@ namespace pcl
 
         std::size_t object_count_;
 
+        /** \brief Depth at which the octree is split into chunks. */
+        unsigned int chunk_depth_;
+
+        /** \brief Number of threads used to encode and decode the chunks. */
+        unsigned int threads_;
+
+        // chunked frame header identifier
+        static const char* chunked_header_identifier_;
+
       };
 
     // define frame identifier
     template<typename PointT, typename LeafT, typename BranchT, typename OctreeT>
       const char* OctreePointCloudCompression<PointT, LeafT, BranchT, OctreeT>::frame_header_identifier_ = "<PCL-OCT-COMPRESSED>";
+
+    // define chunked frame identifier
+    template<typename PointT, typename LeafT, typename BranchT, typename OctreeT>
+      const char* OctreePointCloudCompression<PointT, LeafT, BranchT, OctreeT>::chunked_header_identifier_ = "<PCL-OCT-CHUNKED>";
   }
 
 }
@@ -133,6 +133,21 @@ public:
   void
   getFeatures(int idx, std::vector<float>& features);
 
+  /** Set the number of threads used by the mean field inference and by the pairwise
+   * potentials, including the ones already added.
+   * \param[in] nr_threads the number of hardware threads to use (0 sets the value
+   * back to automatic)
+   */
+  void
+  setNumberOfThreads(unsigned int nr_threads = 0);
+
+  /** Get the number of threads used by the mean field inference. */
+  inline unsigned int
+  getNumberOfThreads() const
+  {
+    return threads_;
+  }
+
 protected:
   /** Number of variables and labels */
   int N_, M_;
@@ -157,6 +172,9 @@ protected:
   /** Input types */
   bool xyz_, rgb_, normal_;
 
+  /** Number of threads */
+  unsigned int threads_;
+
 public:
   PCL_MAKE_ALIGNED_OPERATOR_NEW
 };
@@ -47,11 +47,14 @@ namespace pcl {
 
 class PairwisePotential {
 public:
-  /** Constructor for PairwisePotential class. */
+  /** Constructor for PairwisePotential class.
+   * \param[in] nr_threads the number of threads used to build and apply the lattice
+   */
   PairwisePotential(const std::vector<float>& feature,
                     const int D,
                     const int N,
-                    const float w);
+                    const float w,
+                    unsigned int nr_threads = 1);
 
   /** Deconstructor for PairwisePotential class. */
   ~PairwisePotential(){};
@@ -62,6 +65,13 @@ public:
           std::vector<float>& tmp,
           int value_size) const;
 
+  /** Set the number of threads used by compute.
+   * \param[in] nr_threads the number of hardware threads to use (0 sets the value
+   * back to automatic)
+   */
+  void
+  setNumberOfThreads(unsigned int nr_threads = 0);
+
 protected:
   /// Permutohedral lattice
   Permutohedral lattice_;
@@ -81,6 +81,9 @@ public:
   void
   init(const std::vector<float>& feature, const int feature_dimension, const int N);
 
+  /** Filter values with the lattice. Splatting, blurring and slicing run on the
+   * number of threads set with setNumberOfThreads, the result does not depend on it.
+   */
   void
   compute(std::vector<float>& out,
           const std::vector<float>& in,
@@ -105,6 +108,20 @@ public:
   void
   debug();
 
+  /** Set the number of threads used by init and compute.
+   * \param[in] nr_threads the number of hardware threads to use (0 sets the value
+   * back to automatic)
+   */
+  void
+  setNumberOfThreads(unsigned int nr_threads = 0);
+
+  /** Get the number of threads used by init and compute. */
+  inline unsigned int
+  getNumberOfThreads() const
+  {
+    return threads_;
+  }
+
   /** Pseudo radnom generator. */
   inline std::size_t
   generateHashKey(const std::vector<short>& k)
@@ -134,11 +151,19 @@ public:
   std::vector<float> offsetTMP_;
   std::vector<float> barycentric_;
 
+  /// Entries of offset_ splatted on each lattice point, lattice point i owns
+  /// splat_entries_[splat_offsets_[i]] to splat_entries_[splat_offsets_[i + 1] - 1]
+  std::vector<int> splat_offsets_;
+  std::vector<int> splat_entries_;
+
   Neighbors* blur_neighborsOLD_;
   int* offsetOLD_;
   float* barycentricOLD_;
   std::vector<float> baryOLD_;
 
+  /// Number of threads used by init and compute
+  unsigned int threads_;
+
 public:
   PCL_MAKE_ALIGNED_OPERATOR_NEW
 };
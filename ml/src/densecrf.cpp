@@ -39,8 +39,12 @@
 
 #include <pcl/ml/densecrf.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 pcl::DenseCrf::DenseCrf(int N, int m)
-: N_(N), M_(m), xyz_(false), rgb_(false), normal_(false)
+: N_(N), M_(m), xyz_(false), rgb_(false), normal_(false), threads_(1)
 {
   current_.resize(N_ * M_, 0.0f);
   next_.resize(N_ * M_, 0.0f);
@@ -81,7 +85,7 @@ pcl::DenseCrf::addPairwiseEnergy(const std::vector<float>& feature,
                                  const float w)
 {
   pairwise_potential_.push_back(
-      new PairwisePotential(feature, feature_dimension, N_, w));
+      new PairwisePotential(feature, feature_dimension, N_, w, threads_));
 }
 
 void
@@ -237,29 +241,36 @@ pcl::DenseCrf::expAndNormalize(std::vector<float>& out,
                                float scale,
                                float relax) const
 {
-  std::vector<float> V(N_ + 10);
-  for (int i = 0; i < N_; i++) {
-    int b_idx = i * M_;
-    // Find the max and subtract it so that the std::exp doesn't explode
-    float mx = scale * in[b_idx];
-    for (int j = 1; j < M_; j++)
-      if (mx < scale * in[b_idx + j])
-        mx = scale * in[b_idx + j];
-    float tt = 0;
-    for (int j = 0; j < M_; j++) {
-      V[j] = std::exp(scale * in[b_idx + j] - mx);
-      tt += V[j];
+#pragma omp parallel \
+  default(none) \
+  shared(out, in, scale, relax) \
+  num_threads(threads_)
+  {
+    std::vector<float> V(M_);
+#pragma omp for schedule(static)
+    for (int i = 0; i < N_; i++) {
+      int b_idx = i * M_;
+      // Find the max and subtract it so that the std::exp doesn't explode
+      float mx = scale * in[b_idx];
+      for (int j = 1; j < M_; j++)
+        if (mx < scale * in[b_idx + j])
+          mx = scale * in[b_idx + j];
+      float tt = 0;
+      for (int j = 0; j < M_; j++) {
+        V[j] = std::exp(scale * in[b_idx + j] - mx);
+        tt += V[j];
+      }
+      // Make it a probability
+      for (int j = 0; j < M_; j++)
+        V[j] /= tt;
+
+      int a_idx = i * M_;
+      for (int j = 0; j < M_; j++)
+        if (relax == 1)
+          out[a_idx + j] = V[j];
+        else
+          out[a_idx + j] = (1 - relax) * out[a_idx + j] + relax * V[j];
     }
-    // Make it a probability
-    for (int j = 0; j < M_; j++)
-      V[j] /= tt;
-
-    int a_idx = i * M_;
-    for (int j = 0; j < M_; j++)
-      if (relax == 1)
-        out[a_idx + j] = V[j];
-      else
-        out[a_idx + j] = (1 - relax) * out[a_idx + j] + relax * V[j];
   }
 }
 
@@ -289,3 +300,19 @@ pcl::DenseCrf::getFeatures(int idx, std::vector<float>& features)
 {
   features = pairwise_potential_[idx]->features_;
 }
+
+void
+pcl::DenseCrf::setNumberOfThreads(unsigned int nr_threads)
+{
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    threads_ = omp_get_num_procs();
+#else
+    threads_ = 1;
+#endif
+  else
+    threads_ = nr_threads;
+
+  for (auto& p : pairwise_potential_)
+    p->setNumberOfThreads(threads_);
+}
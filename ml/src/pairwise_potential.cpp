@@ -42,11 +42,13 @@
 pcl::PairwisePotential::PairwisePotential(const std::vector<float>& feature,
                                           const int feature_dimension,
                                           const int N,
-                                          const float w)
+                                          const float w,
+                                          unsigned int nr_threads)
 : N_(N), w_(w)
 {
   // lattice_.init (feature, feature_dimension, N);
   // std::cout << "0---------" << std::endl;
+  lattice_.setNumberOfThreads(nr_threads);
   lattice_.init(feature, feature_dimension, N);
 
   // std::cout << "1---------" << std::endl;
@@ -117,7 +119,18 @@ pcl::PairwisePotential::compute(std::vector<float>& out,
                                 int value_size) const
 {
   lattice_.compute(tmp, in, value_size);
-  for (int i = 0, k = 0; i < N_; i++)
-    for (int j = 0; j < value_size; j++, k++)
+#pragma omp parallel for \
+  default(none) \
+  shared(out, tmp, value_size) \
+  schedule(static) \
+  num_threads(lattice_.getNumberOfThreads())
+  for (int i = 0; i < N_; i++)
+    for (int j = 0, k = i * value_size; j < value_size; j++, k++)
       out[k] += w_ * norm_[i] * tmp[k];
 }
+
+void
+pcl::PairwisePotential::setNumberOfThreads(unsigned int nr_threads)
+{
+  lattice_.setNumberOfThreads(nr_threads);
+}
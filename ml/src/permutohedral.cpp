@@ -38,7 +38,12 @@
 #include <pcl/ml/permutohedral.h>
 #include <pcl/pcl_macros.h> // for pcl_round
 
-#include <map> // for multimap
+#include <algorithm> // for std::equal, std::min
+#include <cstdint>   // for std::uint64_t
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 pcl::Permutohedral::Permutohedral()
 : N_(0)
@@ -47,8 +52,58 @@ pcl::Permutohedral::Permutohedral()
 , blur_neighborsOLD_(nullptr)
 , offsetOLD_(nullptr)
 , barycentricOLD_(nullptr)
+, threads_(1)
 {}
 
+void
+pcl::Permutohedral::setNumberOfThreads(unsigned int nr_threads)
+{
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    threads_ = omp_get_num_procs();
+#else
+    threads_ = 1;
+#endif
+  else
+    threads_ = nr_threads;
+}
+
+namespace {
+/** Same hash as Permutohedral::generateHashKey, on the d first coordinates of key. */
+inline std::size_t
+hashLatticeKey(const short* key, int d)
+{
+  std::size_t r = 0;
+  for (int i = 0; i < d; i++) {
+    r += key[i];
+    r *= 1664525;
+  }
+  return r;
+}
+
+/** Find a lattice key in an open addressing (linear probing) hash table holding the
+ * indices of the keys. Returns the slot with the index of the key, or the empty slot
+ * where it belongs. The size of the table is a power of two. */
+inline std::size_t
+findLatticeKey(const std::vector<int>& table,
+               const std::vector<short>& keys,
+               const short* key,
+               int d)
+{
+  const std::size_t mask = table.size() - 1;
+  // Spread the hash over all bits, the lattice coordinates are small
+  std::size_t slot =
+      static_cast<std::size_t>((static_cast<std::uint64_t>(hashLatticeKey(key, d)) *
+                                0x9E3779B97F4A7C15ULL) >>
+                               32) &
+      mask;
+  while (table[slot] >= 0 &&
+         !std::equal(key, key + d, keys.begin() + std::size_t(table[slot]) * d))
+    slot = (slot + 1) & mask;
+  return slot;
+}
+} // namespace
+
 void
 pcl::Permutohedral::init(const std::vector<float>& feature,
                          const int feature_dimension,
@@ -57,10 +112,14 @@ pcl::Permutohedral::init(const std::vector<float>& feature,
   N_ = N;
   d_ = feature_dimension;
 
-  // Create hash table
-  std::vector<std::vector<short>> keys;
-  keys.reserve((d_ + 1) * N_);
-  std::multimap<std::size_t, int> hash_table;
+  // Lattice keys (d_ coordinates each) in the order in which they are first seen, and
+  // the hash table of their indices
+  std::vector<short> keys;
+  keys.reserve(std::size_t(d_) * N_);
+  std::size_t table_size = 1024;
+  while (table_size < 2 * std::size_t(N_))
+    table_size *= 2;
+  std::vector<int> hash_table(table_size, -1);
 
   // reserve class memory
   if (!offset_.empty())
@@ -73,14 +132,8 @@ pcl::Permutohedral::init(const std::vector<float>& feature,
 
   // create vectors and matrices
   Eigen::VectorXf scale_factor = Eigen::VectorXf::Zero(d_);
-  Eigen::VectorXf elevated = Eigen::VectorXf::Zero(d_ + 1);
-  Eigen::VectorXf rem0 = Eigen::VectorXf::Zero(d_ + 1);
-  Eigen::VectorXf barycentric = Eigen::VectorXf::Zero(d_ + 2);
-  Eigen::VectorXi rank = Eigen::VectorXi::Zero(d_ + 1);
   Eigen::Matrix<int, Eigen::Dynamic, Eigen::Dynamic> canonical;
   canonical = Eigen::Matrix<int, Eigen::Dynamic, Eigen::Dynamic>::Zero(d_ + 1, d_ + 1);
-  // short * key = new short[d_+1];
-  std::vector<short> key(d_ + 1);
 
   // Compute the canonical simple
   for (int i = 0; i <= d_; i++) {
@@ -99,160 +152,167 @@ pcl::Permutohedral::init(const std::vector<float>& feature,
                       std::sqrt(static_cast<float>(i + 2) * static_cast<float>(i + 1)) *
                       inv_std_dev;
 
-  // Compute the simplex each feature lies in
-  for (int k = 0; k < N_; k++)
-  // for (int k = 0; k < 5; k++)
-  {
-
-    // Elevate the feature  (y = Ep, see p.5 in [Adams etal 2010])
-    int index = k * feature_dimension;
-    // sm contains the sum of 1..n of our faeture vector
-    float sm = 0;
-    for (int j = d_; j > 0; j--) {
-      float cf = feature[index + j - 1] * scale_factor(j - 1);
-      elevated(j) = sm - static_cast<float>(j) * cf;
-      sm += cf;
-    }
-    elevated(0) = sm;
-
-    // Find the closest 0-colored simplex through rounding
-    float down_factor = 1.0f / static_cast<float>(d_ + 1);
-    float up_factor = static_cast<float>(d_ + 1);
-    int sum = 0;
-    for (int j = 0; j <= d_; j++) {
-      float rd = std::floor(0.5f + (down_factor * elevated(j)));
-      rem0(j) = rd * up_factor;
-      sum += static_cast<int>(rd);
-    }
-
-    // rank differential to find the permutation between this simplex and the canonical
-    // one. (See pg. 3-4 in paper.)
-    rank.setZero();
-    Eigen::VectorXf tmp = elevated - rem0;
-    for (int i = 0; i < d_; i++) {
-      for (int j = i + 1; j <= d_; j++)
-        if (tmp(i) < tmp(j))
-          rank(i)++;
-        else
-          rank(j)++;
-    }
-
-    // If the point doesn't lie on the plane (sum != 0) bring it back
-    for (int j = 0; j <= d_; j++) {
-      rank(j) += sum;
-      if (rank(j) < 0) {
-        rank(j) += d_ + 1;
-        rem0(j) += static_cast<float>(d_ + 1);
-      }
-      else if (rank(j) > d_) {
-        rank(j) -= d_ + 1;
-        rem0(j) -= static_cast<float>(d_ + 1);
-      }
-    }
+  // The simplices are computed in parallel, one block of features at a time. Their
+  // vertices are then inserted in the hash table serially, so that the lattice points
+  // are numbered in the same order as with a single thread.
+  const int block_size = 4096;
+  std::vector<short> block_keys(std::size_t(block_size) * (d_ + 1) * d_);
+  for (int block_begin = 0; block_begin < N_; block_begin += block_size) {
+    int block_end = std::min(N_, block_begin + block_size);
+
+#pragma omp parallel \
+  default(none) \
+  shared(feature, scale_factor, canonical, block_keys, block_begin, block_end) \
+  num_threads(threads_)
+    {
+      Eigen::VectorXf elevated = Eigen::VectorXf::Zero(d_ + 1);
+      Eigen::VectorXf rem0 = Eigen::VectorXf::Zero(d_ + 1);
+      Eigen::VectorXf barycentric = Eigen::VectorXf::Zero(d_ + 2);
+      Eigen::VectorXi rank = Eigen::VectorXi::Zero(d_ + 1);
+
+#pragma omp for schedule(static)
+      for (int k = block_begin; k < block_end; k++) {
+        // Elevate the feature  (y = Ep, see p.5 in [Adams etal 2010])
+        int index = k * d_;
+        // sm contains the sum of 1..n of our faeture vector
+        float sm = 0;
+        for (int j = d_; j > 0; j--) {
+          float cf = feature[index + j - 1] * scale_factor(j - 1);
+          elevated(j) = sm - static_cast<float>(j) * cf;
+          sm += cf;
+        }
+        elevated(0) = sm;
+
+        // Find the closest 0-colored simplex through rounding
+        float down_factor = 1.0f / static_cast<float>(d_ + 1);
+        float up_factor = static_cast<float>(d_ + 1);
+        int sum = 0;
+        for (int j = 0; j <= d_; j++) {
+          float rd = std::floor(0.5f + (down_factor * elevated(j)));
+          rem0(j) = rd * up_factor;
+          sum += static_cast<int>(rd);
+        }
 
-    // Compute the barycentric coordinates (p.10 in [Adams etal 2010])
-    barycentric.setZero();
-    Eigen::VectorXf v = (elevated - rem0) * down_factor;
-    for (int j = 0; j <= d_; j++) {
-      barycentric(d_ - rank(j)) += v(j);
-      barycentric(d_ + 1 - rank(j)) -= v(j);
-    }
-    // Wrap around
-    barycentric(0) += 1.0f + barycentric(d_ + 1);
+        // rank differential to find the permutation between this simplex and the
+        // canonical one. (See pg. 3-4 in paper.)
+        rank.setZero();
+        for (int i = 0; i < d_; i++) {
+          for (int j = i + 1; j <= d_; j++)
+            if (elevated(i) - rem0(i) < elevated(j) - rem0(j))
+              rank(i)++;
+            else
+              rank(j)++;
+        }
 
-    // Compute all vertices and their offset
-    for (int remainder = 0; remainder <= d_; remainder++) {
-      for (int j = 0; j < d_; j++)
-        key[j] = static_cast<short>(rem0(j) +
-                                    static_cast<float>(canonical(rank(j), remainder)));
-
-      // insert key in hash table
-      std::size_t hash_key = generateHashKey(key);
-      auto it = hash_table.find(hash_key);
-      int key_index = -1;
-      if (it != hash_table.end()) {
-        // check if key is the right one
-        int tmp_key_index = -1;
-        // for (int ii = key_index; ii < keys.size (); ii++)
-        for (; it != hash_table.end(); ++it) {
-          int ii = it->second;
-          bool same = true;
-          std::vector<short> k = keys[ii];
-          for (std::size_t i_k = 0; i_k < k.size(); i_k++) {
-            if (key[i_k] != k[i_k]) {
-              same = false;
-              break;
-            }
+        // If the point doesn't lie on the plane (sum != 0) bring it back
+        for (int j = 0; j <= d_; j++) {
+          rank(j) += sum;
+          if (rank(j) < 0) {
+            rank(j) += d_ + 1;
+            rem0(j) += static_cast<float>(d_ + 1);
           }
-
-          if (same) {
-            tmp_key_index = ii;
-            break;
+          else if (rank(j) > d_) {
+            rank(j) -= d_ + 1;
+            rem0(j) -= static_cast<float>(d_ + 1);
           }
         }
 
-        if (tmp_key_index == -1) {
-          key_index = static_cast<int>(keys.size());
-          keys.push_back(key);
-          hash_table.insert(std::pair<std::size_t, int>(hash_key, key_index));
+        // Compute the barycentric coordinates (p.10 in [Adams etal 2010])
+        barycentric.setZero();
+        for (int j = 0; j <= d_; j++) {
+          float v = (elevated(j) - rem0(j)) * down_factor;
+          barycentric(d_ - rank(j)) += v;
+          barycentric(d_ + 1 - rank(j)) -= v;
+        }
+        // Wrap around
+        barycentric(0) += 1.0f + barycentric(d_ + 1);
+
+        // Compute all vertices of the simplex
+        short* key = &block_keys[std::size_t(k - block_begin) * (d_ + 1) * d_];
+        for (int remainder = 0; remainder <= d_; remainder++, key += d_) {
+          for (int j = 0; j < d_; j++)
+            key[j] = static_cast<short>(
+                rem0(j) + static_cast<float>(canonical(rank(j), remainder)));
+          barycentric_[k * (d_ + 1) + remainder] = barycentric(remainder);
         }
-        else
-          key_index = tmp_key_index;
       }
+    }
 
-      else {
-        key_index = static_cast<int>(keys.size());
-        keys.push_back(key);
-        hash_table.insert(std::pair<std::size_t, int>(hash_key, key_index));
+    // Insert the vertices in the hash table and store their offset
+    const short* key = block_keys.data();
+    for (int e = block_begin * (d_ + 1); e < block_end * (d_ + 1); e++, key += d_) {
+      std::size_t slot = findLatticeKey(hash_table, keys, key, d_);
+      if (hash_table[slot] < 0) {
+        hash_table[slot] = static_cast<int>(keys.size() / d_);
+        keys.insert(keys.end(), key, key + d_);
+        // Keep the table at most half full
+        if (keys.size() / d_ * 2 >= hash_table.size()) {
+          std::vector<int> old_table(2 * hash_table.size(), -1);
+          old_table.swap(hash_table);
+          for (const int key_index : old_table)
+            if (key_index >= 0)
+              hash_table[findLatticeKey(
+                  hash_table, keys, &keys[std::size_t(key_index) * d_], d_)] =
+                  key_index;
+          slot = findLatticeKey(hash_table, keys, key, d_);
+        }
       }
-      offset_[k * (d_ + 1) + remainder] = static_cast<float>(key_index);
-
-      barycentric_[k * (d_ + 1) + remainder] = barycentric(remainder);
+      offset_[e] = static_cast<float>(hash_table[slot]);
     }
   }
 
   // Find the Neighbors of each lattice point
 
   // Get the number of vertices in the lattice
-  M_ = static_cast<int>(hash_table.size());
+  M_ = d_ > 0 ? static_cast<int>(keys.size() / d_) : 0;
 
   // Create the neighborhood structure
   if (!blur_neighbors_.empty())
     blur_neighbors_.clear();
   blur_neighbors_.resize((d_ + 1) * M_);
 
-  std::vector<short> n1(d_ + 1);
-  std::vector<short> n2(d_ + 1);
+#pragma omp parallel \
+  default(none) \
+  shared(keys, hash_table) \
+  num_threads(threads_)
+  {
+    std::vector<short> n1(d_ + 1);
+    std::vector<short> n2(d_ + 1);
 
-  // For each of d+1 axes,
-  for (int j = 0; j <= d_; j++) {
+#pragma omp for schedule(static)
     for (int i = 0; i < M_; i++) {
-      std::vector<short> key = keys[i];
+      const short* key = &keys[std::size_t(i) * d_];
 
-      for (int k = 0; k < d_; k++) {
-        n1[k] = static_cast<short>(key[k] - 1);
-        n2[k] = static_cast<short>(key[k] + 1);
+      // For each of d+1 axes,
+      for (int j = 0; j <= d_; j++) {
+        for (int k = 0; k < d_; k++) {
+          n1[k] = static_cast<short>(key[k] - 1);
+          n2[k] = static_cast<short>(key[k] + 1);
+        }
+        if (j < d_) {
+          n1[j] = static_cast<short>(key[j] + d_);
+          n2[j] = static_cast<short>(key[j] - d_);
+        }
+
+        blur_neighbors_[j * M_ + i].n1 =
+            hash_table[findLatticeKey(hash_table, keys, n1.data(), d_)];
+        blur_neighbors_[j * M_ + i].n2 =
+            hash_table[findLatticeKey(hash_table, keys, n2.data(), d_)];
       }
-      n1[j] = static_cast<short>(key[j] + d_);
-      n2[j] = static_cast<short>(key[j] - d_);
-
-      std::multimap<std::size_t, int>::iterator it;
-      std::size_t hash_key;
-      int key_index = -1;
-      hash_key = generateHashKey(n1);
-      it = hash_table.find(hash_key);
-      if (it != hash_table.end())
-        key_index = it->second;
-      blur_neighbors_[j * M_ + i].n1 = key_index;
-
-      key_index = -1;
-      hash_key = generateHashKey(n2);
-      it = hash_table.find(hash_key);
-      if (it != hash_table.end())
-        key_index = it->second;
-      blur_neighbors_[j * M_ + i].n2 = key_index;
     }
   }
+
+  // Index the features splatted on each lattice point, in increasing order, so that
+  // the splatting can run in parallel over the lattice points
+  splat_offsets_.assign(M_ + 1, 0);
+  for (const float o : offset_)
+    splat_offsets_[static_cast<int>(o) + 1]++;
+  for (int i = 0; i < M_; i++)
+    splat_offsets_[i + 1] += splat_offsets_[i];
+  splat_entries_.resize(offset_.size());
+  std::vector<int> next(splat_offsets_.begin(), splat_offsets_.end() - 1);
+  for (std::size_t e = 0; e < offset_.size(); e++)
+    splat_entries_[next[static_cast<int>(offset_[e])]++] = static_cast<int>(e);
 }
 
 void
@@ -273,17 +333,34 @@ pcl::Permutohedral::compute(std::vector<float>& out,
   std::vector<float> values((M_ + 2) * value_size, 0.0f);
   std::vector<float> new_values((M_ + 2) * value_size, 0.0f);
 
-  // Splatting
-  for (int i = 0; i < in_size; i++) {
-    for (int j = 0; j <= d_; j++) {
-      int o = static_cast<int>(offset_[(in_offset + i) * (d_ + 1) + j]) + 1;
-      float w = barycentric_[(in_offset + i) * (d_ + 1) + j];
+  // Splatting, gathered per lattice point. The features are added in the same order
+  // as when scattering them one after the other.
+  int in_begin = in_offset * (d_ + 1);
+  int in_end = (in_offset + in_size) * (d_ + 1);
+#pragma omp parallel for \
+  default(none) \
+  shared(in, values, value_size, in_offset, in_begin, in_end) \
+  schedule(static) \
+  num_threads(threads_)
+  for (int o = 0; o < M_; o++) {
+    float* value = &values[(o + 1) * value_size];
+    for (int s = splat_offsets_[o]; s < splat_offsets_[o + 1]; s++) {
+      const int e = splat_entries_[s];
+      if (e < in_begin || e >= in_end)
+        continue;
+      int i = e / (d_ + 1) - in_offset;
+      float w = barycentric_[e];
       for (int k = 0; k < value_size; k++)
-        values[o * value_size + k] += w * in[i * value_size + k];
+        value[k] += w * in[i * value_size + k];
     }
   }
 
   for (int j = 0; j <= d_; j++) {
+#pragma omp parallel for \
+  default(none) \
+  shared(values, new_values, value_size, j) \
+  schedule(static) \
+  num_threads(threads_)
     for (int i = 0; i < M_; i++) {
       int old_val_idx = (i + 1) * value_size;
       int new_val_idx = (i + 1) * value_size;
@@ -306,6 +383,11 @@ pcl::Permutohedral::compute(std::vector<float>& out,
   float alpha = 1.0f / (1.0f + static_cast<float>(pow(2.0f, -d_)));
 
   // Slicing
+#pragma omp parallel for \
+  default(none) \
+  shared(out, values, value_size, out_offset, out_size, alpha) \
+  schedule(static) \
+  num_threads(threads_)
   for (int i = 0; i < out_size; i++) {
     for (int k = 0; k < value_size; k++)
       out[i * value_size + k] = 0;
@@ -40,6 +40,16 @@
 #include <pcl/common/point_tests.h> // for pcl::isFinite
 #include <pcl/console/print.h>
 
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <numeric>
+#include <tuple>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 /*
  * OctreePointCloudAdjacency is not precompiled, since it's used in other
  * parts of PCL with custom LeafContainers. So if PCL_NO_PRECOMPILE is NOT
@@ -57,6 +67,8 @@ pcl::octree::OctreePointCloudAdjacency<PointT, LeafContainerT, BranchContainerT>
                    LeafContainerT,
                    BranchContainerT,
                    OctreeBase<LeafContainerT, BranchContainerT>>(resolution_arg)
+, store_container_neighbors_(true)
+, threads_(1)
 {}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -97,21 +109,165 @@ pcl::octree::OctreePointCloudAdjacency<PointT, LeafContainerT, BranchContainerT>
 
   OctreePointCloud<PointT, LeafContainerT, BranchContainerT>::addPointsFromInputCloud();
 
+  std::vector<OctreeKey> leaf_keys;
+  leaf_keys.reserve(this->getLeafCount());
+  leaf_vector_.clear();
   leaf_vector_.reserve(this->getLeafCount());
   for (auto leaf_itr = this->leaf_depth_begin(); leaf_itr != this->leaf_depth_end();
        ++leaf_itr) {
-    OctreeKey leaf_key = leaf_itr.getCurrentOctreeKey();
-    LeafContainerT* leaf_container = &(leaf_itr.getLeafContainer());
+    leaf_keys.push_back(leaf_itr.getCurrentOctreeKey());
+    leaf_vector_.push_back(&(leaf_itr.getLeafContainer()));
+  }
+  // Make sure our leaf vector is correctly sized
+  assert(leaf_vector_.size() == this->getLeafCount());
+
+  computeNeighborIndices(leaf_keys);
+
+  std::ptrdiff_t nr_leaves = static_cast<std::ptrdiff_t>(leaf_vector_.size());
+#pragma omp parallel for \
+  default(none) \
+  shared(nr_leaves) \
+  schedule(dynamic, 256) \
+  num_threads(threads_)
+  for (std::ptrdiff_t i = 0; i < nr_leaves; ++i) {
+    LeafContainerT* leaf_container = leaf_vector_[i];
 
     // Run the leaf's compute function
     leaf_container->computeData();
 
-    computeNeighbors(leaf_key, leaf_container);
+    leaf_container->setNeighbors(typename LeafContainerT::NeighborListT());
+    if (store_container_neighbors_) {
+      for (std::size_t n = neighbor_offsets_[i]; n < neighbor_offsets_[i + 1]; ++n)
+        leaf_container->addNeighbor(leaf_vector_[neighbor_indices_[n]]);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+void
+pcl::octree::OctreePointCloudAdjacency<PointT, LeafContainerT, BranchContainerT>::
+    setNumberOfThreads(unsigned int nr_threads)
+{
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    threads_ = omp_get_num_procs();
+#else
+    threads_ = 1;
+#endif
+  else
+    threads_ = nr_threads;
+}
 
-    leaf_vector_.push_back(leaf_container);
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+void
+pcl::octree::OctreePointCloudAdjacency<PointT, LeafContainerT, BranchContainerT>::
+    computeNeighborIndices(const std::vector<OctreeKey>& leaf_keys)
+{
+  // Sort the leaves by key, the neighbors of a leaf are then found in the nine rows
+  // along z around it, at positions which only grow from one leaf to the next
+  std::vector<SortedLeaf> sorted_leaves(leaf_keys.size());
+  for (std::size_t i = 0; i < leaf_keys.size(); ++i)
+    sorted_leaves[i] = SortedLeaf(leaf_keys[i], static_cast<index_t>(i));
+  std::sort(sorted_leaves.begin(),
+            sorted_leaves.end(),
+            [](const SortedLeaf& a, const SortedLeaf& b) {
+              return (std::tie(a.first.x, a.first.y, a.first.z) <
+                      std::tie(b.first.x, b.first.y, b.first.z));
+            });
+
+  // Count the neighbors first, then write them to their final position
+  std::size_t chunk_size = 4096;
+  std::ptrdiff_t nr_chunks =
+      static_cast<std::ptrdiff_t>((sorted_leaves.size() + chunk_size - 1) / chunk_size);
+  neighbor_offsets_.assign(leaf_keys.size() + 1, 0);
+#pragma omp parallel for \
+  default(none) \
+  shared(sorted_leaves, nr_chunks, chunk_size) \
+  schedule(dynamic) \
+  num_threads(threads_)
+  for (std::ptrdiff_t chunk = 0; chunk < nr_chunks; ++chunk)
+    joinNeighbors(sorted_leaves,
+                  chunk * chunk_size,
+                  std::min((chunk + 1) * chunk_size, sorted_leaves.size()),
+                  true);
+
+  std::partial_sum(
+      neighbor_offsets_.begin(), neighbor_offsets_.end(), neighbor_offsets_.begin());
+  neighbor_indices_.resize(neighbor_offsets_.back());
+
+#pragma omp parallel for \
+  default(none) \
+  shared(sorted_leaves, nr_chunks, chunk_size) \
+  schedule(dynamic) \
+  num_threads(threads_)
+  for (std::ptrdiff_t chunk = 0; chunk < nr_chunks; ++chunk)
+    joinNeighbors(sorted_leaves,
+                  chunk * chunk_size,
+                  std::min((chunk + 1) * chunk_size, sorted_leaves.size()),
+                  false);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+void
+pcl::octree::OctreePointCloudAdjacency<PointT, LeafContainerT, BranchContainerT>::
+    joinNeighbors(const std::vector<SortedLeaf>& sorted_leaves,
+                  std::size_t begin,
+                  std::size_t end,
+                  bool count_only)
+{
+  const auto key_less = [](const SortedLeaf& a, const OctreeKey& b) {
+    return (std::tie(a.first.x, a.first.y, a.first.z) < std::tie(b.x, b.y, b.z));
+  };
+
+  // Position in sorted_leaves of the row of every (dx, dy), placed with a binary
+  // search for the first leaf and then only moved forward
+  std::array<std::size_t, 9> row_itr;
+  row_itr.fill(std::numeric_limits<std::size_t>::max());
+
+  for (std::size_t leaf_idx = begin; leaf_idx < end; ++leaf_idx) {
+    const OctreeKey& key_arg = sorted_leaves[leaf_idx].first;
+    const index_t leaf = sorted_leaves[leaf_idx].second;
+
+    int dx_min = (key_arg.x > 0) ? -1 : 0;
+    int dy_min = (key_arg.y > 0) ? -1 : 0;
+    int dx_max = (key_arg.x == this->max_key_.x) ? 0 : 1;
+    int dy_max = (key_arg.y == this->max_key_.y) ? 0 : 1;
+    const std::uint32_t z_min = (key_arg.z > 0) ? key_arg.z - 1 : 0;
+    const std::uint32_t z_max =
+        (key_arg.z == this->max_key_.z) ? key_arg.z : key_arg.z + 1;
+
+    // Same order as computeNeighbors: by x, then y, then z
+    std::size_t nr_neighbors = 0;
+    for (int dx = dx_min; dx <= dx_max; ++dx) {
+      for (int dy = dy_min; dy <= dy_max; ++dy) {
+        const OctreeKey row_key(static_cast<std::uint32_t>(key_arg.x + dx),
+                                static_cast<std::uint32_t>(key_arg.y + dy),
+                                z_min);
+        std::size_t& itr = row_itr[(dx + 1) * 3 + dy + 1];
+        if (itr == std::numeric_limits<std::size_t>::max())
+          itr = std::lower_bound(
+                    sorted_leaves.begin(), sorted_leaves.end(), row_key, key_less) -
+                sorted_leaves.begin();
+        while (itr < sorted_leaves.size() && key_less(sorted_leaves[itr], row_key))
+          ++itr;
+
+        for (std::size_t neighbor = itr; neighbor < sorted_leaves.size() &&
+                                         sorted_leaves[neighbor].first.x == row_key.x &&
+                                         sorted_leaves[neighbor].first.y == row_key.y &&
+                                         sorted_leaves[neighbor].first.z <= z_max;
+             ++neighbor, ++nr_neighbors) {
+          if (!count_only)
+            neighbor_indices_[neighbor_offsets_[leaf] + nr_neighbors] =
+                sorted_leaves[neighbor].second;
+        }
+      }
+    }
+    if (count_only)
+      neighbor_offsets_[leaf + 1] = nr_neighbors;
   }
-  // Make sure our leaf vector is correctly sized
-  assert(leaf_vector_.size() == this->getLeafCount());
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -248,19 +404,21 @@ pcl::octree::OctreePointCloudAdjacency<PointT, LeafContainerT, BranchContainerT>
     leaf_vertex_id_map[leaf_container] = node_id;
   }
 
-  // Iterate through and add edges to adjacency graph
-  for (typename std::vector<LeafContainerT*>::iterator leaf_itr = leaf_vector_.begin();
-       leaf_itr != leaf_vector_.end();
-       ++leaf_itr) {
-    VoxelID u = (leaf_vertex_id_map.find(*leaf_itr))->second;
+  // Add the edges from the neighbor indices, they are filled whether or not the leaf
+  // containers store their neighbors
+  std::vector<VoxelID> leaf_vertex_ids(leaf_vector_.size());
+  for (std::size_t leaf = 0; leaf < leaf_vector_.size(); ++leaf)
+    leaf_vertex_ids[leaf] = leaf_vertex_id_map.find(leaf_vector_[leaf])->second;
+  if (neighbor_offsets_.size() != leaf_vector_.size() + 1)
+    return;
+
+  for (std::size_t leaf = 0; leaf < leaf_vector_.size(); ++leaf) {
+    VoxelID u = leaf_vertex_ids[leaf];
     PointT p_u = voxel_adjacency_graph[u];
-    for (auto neighbor_itr = (*leaf_itr)->cbegin(), neighbor_end = (*leaf_itr)->cend();
-         neighbor_itr != neighbor_end;
-         ++neighbor_itr) {
-      LeafContainerT* neighbor_container = *neighbor_itr;
+    for (std::size_t n = neighbor_offsets_[leaf]; n < neighbor_offsets_[leaf + 1]; ++n) {
       EdgeID edge;
       bool edge_added;
-      VoxelID v = (leaf_vertex_id_map.find(neighbor_container))->second;
+      VoxelID v = leaf_vertex_ids[neighbor_indices_[n]];
       boost::tie(edge, edge_added) = add_edge(u, v, voxel_adjacency_graph);
 
       PointT p_v = voxel_adjacency_graph[v];
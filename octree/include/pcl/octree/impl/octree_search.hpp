@@ -39,7 +39,16 @@
 #ifndef PCL_OCTREE_SEARCH_IMPL_H_
 #define PCL_OCTREE_SEARCH_IMPL_H_
 
+#include <pcl/common/point_tests.h> // for pcl::isFinite
+#include <pcl/console/print.h>
+
+#include <algorithm>
 #include <cassert>
+#include <limits>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace pcl {
 
@@ -55,6 +64,26 @@ OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::voxelSearch(
   OctreeKey key;
   bool b_success = false;
 
+  if (!linear_nodes_.empty()) {
+    if (!this->isPointWithinBoundingBox(point))
+      return (false);
+    this->genOctreeKeyforPoint(point, key);
+
+    // descend from the root, one key bit per level
+    std::int64_t node = 0;
+    for (unsigned int depth = this->octree_depth_; depth > 0 && node >= 0; depth--)
+      node = getLinearChild(linear_nodes_[node],
+                            key.getChildIdxWithDepthMask(1u << (depth - 1)));
+    if (node < 0)
+      return (false);
+
+    const LinearNode& leaf = linear_nodes_[node];
+    point_idx_data.insert(point_idx_data.end(),
+                          linear_indices_.begin() + leaf.points_begin,
+                          linear_indices_.begin() + leaf.points_end);
+    return (true);
+  }
+
   // generate key
   this->genOctreeKeyforPoint(point, key);
 
@@ -85,7 +114,7 @@ OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::nearestKSearch
     std::vector<int>& k_indices,
     std::vector<float>& k_sqr_distances)
 {
-  assert(this->leaf_count_ > 0);
+  assert((this->leaf_count_ > 0 || !linear_nodes_.empty()));
   assert(isFinite(p_q) &&
          "Invalid (NaN, Inf) point coordinates given to nearestKSearch!");
 
@@ -104,8 +133,11 @@ OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::nearestKSearch
   // initialize smallest point distance in search with high value
   double smallest_dist = std::numeric_limits<double>::max();
 
-  getKNearestNeighborRecursive(
-      p_q, k, this->root_node_, key, 1, smallest_dist, point_candidates);
+  if (!linear_nodes_.empty())
+    getKNearestNeighborLinear(p_q, k, 0, key, 1, smallest_dist, point_candidates);
+  else
+    getKNearestNeighborRecursive(
+        p_q, k, this->root_node_, key, 1, smallest_dist, point_candidates);
 
   unsigned int result_count = static_cast<unsigned int>(point_candidates.size());
 
@@ -134,15 +166,18 @@ void
 OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::approxNearestSearch(
     const PointT& p_q, int& result_index, float& sqr_distance)
 {
-  assert(this->leaf_count_ > 0);
+  assert((this->leaf_count_ > 0 || !linear_nodes_.empty()));
   assert(isFinite(p_q) &&
          "Invalid (NaN, Inf) point coordinates given to nearestKSearch!");
 
   OctreeKey key;
   key.x = key.y = key.z = 0;
 
-  approxNearestSearchRecursive(
-      p_q, this->root_node_, key, 1, result_index, sqr_distance);
+  if (!linear_nodes_.empty())
+    approxNearestSearchLinear(p_q, 0, key, 1, result_index, sqr_distance);
+  else
+    approxNearestSearchRecursive(
+        p_q, this->root_node_, key, 1, result_index, sqr_distance);
 
   return;
 }
@@ -174,14 +209,18 @@ OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::radiusSearch(
   k_indices.clear();
   k_sqr_distances.clear();
 
-  getNeighborsWithinRadiusRecursive(p_q,
-                                    radius * radius,
-                                    this->root_node_,
-                                    key,
-                                    1,
-                                    k_indices,
-                                    k_sqr_distances,
-                                    max_nn);
+  if (!linear_nodes_.empty())
+    getNeighborsWithinRadiusLinear(
+        p_q, radius * radius, 0, key, 1, k_indices, k_sqr_distances, max_nn);
+  else
+    getNeighborsWithinRadiusRecursive(p_q,
+                                      radius * radius,
+                                      this->root_node_,
+                                      key,
+                                      1,
+                                      k_indices,
+                                      k_sqr_distances,
+                                      max_nn);
 
   return (static_cast<int>(k_indices.size()));
 }
@@ -213,11 +252,70 @@ OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::boxSearch(
 
   k_indices.clear();
 
-  boxSearchRecursive(min_pt, max_pt, this->root_node_, key, 1, k_indices);
+  if (!linear_nodes_.empty())
+    boxSearchLinear(min_pt, max_pt, 0, key, 1, k_indices);
+  else
+    boxSearchRecursive(min_pt, max_pt, this->root_node_, key, 1, k_indices);
 
   return (static_cast<int>(k_indices.size()));
 }
 
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+std::size_t
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::frustumSearch(
+    const std::vector<Eigen::Vector4f>& planes, std::vector<IndexRange>& ranges) const
+{
+  ranges.clear();
+  if (linear_nodes_.empty()) {
+    PCL_ERROR("[pcl::octree::OctreePointCloudSearch::frustumSearch] Index ranges "
+              "require a linear octree!\n");
+    return (0);
+  }
+  return (frustumSearchParallel(planes, nullptr, 0.0f, 0.0f, ranges));
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+int
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::frustumSearch(
+    const std::vector<Eigen::Vector4f>& planes, std::vector<int>& k_indices) const
+{
+  k_indices.clear();
+
+  if (!linear_nodes_.empty()) {
+    std::vector<IndexRange> ranges;
+    k_indices.reserve(frustumSearchParallel(planes, nullptr, 0.0f, 0.0f, ranges));
+    for (const IndexRange& range : ranges)
+      k_indices.insert(k_indices.end(),
+                       linear_indices_.begin() + range.first,
+                       linear_indices_.begin() + range.second);
+  }
+  else if (this->root_node_) {
+    OctreeKey key;
+    key.x = key.y = key.z = 0;
+    frustumSearchRecursive(planes, this->root_node_, key, 0, false, k_indices);
+  }
+
+  return (static_cast<int>(k_indices.size()));
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+std::size_t
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::frustumSearchLOD(
+    const std::vector<Eigen::Vector4f>& planes,
+    const Eigen::Vector3f& eye,
+    float focal_length,
+    float max_pixel_size,
+    std::vector<IndexRange>& ranges) const
+{
+  ranges.clear();
+  if (linear_nodes_.empty()) {
+    PCL_ERROR("[pcl::octree::OctreePointCloudSearch::frustumSearchLOD] Index ranges "
+              "require a linear octree!\n");
+    return (0);
+  }
+  return (frustumSearchParallel(planes, &eye, focal_length, max_pixel_size, ranges));
+}
+
 template <typename PointT, typename LeafContainerT, typename BranchContainerT>
 double
 OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::
@@ -609,6 +707,19 @@ OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::
 
   initIntersectedVoxel(origin, direction, min_x, min_y, min_z, max_x, max_y, max_z, a);
 
+  if (std::max(std::max(min_x, min_y), min_z) < std::min(std::min(max_x, max_y), max_z) &&
+      !linear_nodes_.empty()) {
+    std::vector<std::pair<std::uint32_t, OctreeKey>> leaves;
+    const int voxel_count = getIntersectedVoxelsLinear(
+        min_x, min_y, min_z, max_x, max_y, max_z, a, 0, key, 0, leaves, max_voxel_count);
+    for (const auto& leaf : leaves) {
+      PointT center;
+      this->genLeafNodeCenterFromOctreeKey(leaf.second, center);
+      voxel_center_list.push_back(center);
+    }
+    return (voxel_count);
+  }
+
   if (std::max(std::max(min_x, min_y), min_z) < std::min(std::min(max_x, max_y), max_z))
     return getIntersectedVoxelCentersRecursive(min_x,
                                                min_y,
@@ -644,6 +755,18 @@ OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::
 
   initIntersectedVoxel(origin, direction, min_x, min_y, min_z, max_x, max_y, max_z, a);
 
+  if (std::max(std::max(min_x, min_y), min_z) < std::min(std::min(max_x, max_y), max_z) &&
+      !linear_nodes_.empty()) {
+    std::vector<std::pair<std::uint32_t, OctreeKey>> leaves;
+    const int voxel_count = getIntersectedVoxelsLinear(
+        min_x, min_y, min_z, max_x, max_y, max_z, a, 0, key, 0, leaves, max_voxel_count);
+    for (const auto& leaf : leaves)
+      k_indices.insert(k_indices.end(),
+                       linear_indices_.begin() + linear_nodes_[leaf.first].points_begin,
+                       linear_indices_.begin() + linear_nodes_[leaf.first].points_end);
+    return (voxel_count);
+  }
+
   if (std::max(std::max(min_x, min_y), min_z) < std::min(std::min(max_x, max_y), max_z))
     return getIntersectedVoxelIndicesRecursive(min_x,
                                                min_y,
@@ -659,6 +782,170 @@ OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::
   return (0);
 }
 
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+int
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::
+    getIntersectedVoxelCentersBatch(const std::vector<Eigen::Vector3f>& origins,
+                                    const std::vector<Eigen::Vector3f>& directions,
+                                    std::vector<AlignedPointTVector>& voxel_center_lists,
+                                    int max_voxel_count) const
+{
+  assert(origins.size() == directions.size());
+  voxel_center_lists.resize(origins.size());
+
+  std::vector<std::size_t> order;
+  getCoherentRayOrder(directions, order);
+
+  // chunks of consecutive rays keep the coherence of the order on every thread
+  std::ptrdiff_t nr_rays = static_cast<std::ptrdiff_t>(order.size());
+  int voxel_count = 0;
+#pragma omp parallel for \
+  default(none) \
+  shared(origins, directions, voxel_center_lists, order, max_voxel_count, nr_rays) \
+  reduction(+: voxel_count) \
+  schedule(dynamic, 64) \
+  num_threads(threads_)
+  for (std::ptrdiff_t i = 0; i < nr_rays; i++) {
+    const std::size_t ray = order[i];
+    voxel_count += getIntersectedVoxelCenters(
+        origins[ray], directions[ray], voxel_center_lists[ray], max_voxel_count);
+  }
+  return (voxel_count);
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+int
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::
+    getIntersectedVoxelIndicesBatch(const std::vector<Eigen::Vector3f>& origins,
+                                    const std::vector<Eigen::Vector3f>& directions,
+                                    std::vector<std::vector<int>>& k_indices,
+                                    int max_voxel_count) const
+{
+  assert(origins.size() == directions.size());
+  k_indices.resize(origins.size());
+
+  std::vector<std::size_t> order;
+  getCoherentRayOrder(directions, order);
+
+  // chunks of consecutive rays keep the coherence of the order on every thread
+  std::ptrdiff_t nr_rays = static_cast<std::ptrdiff_t>(order.size());
+  int voxel_count = 0;
+#pragma omp parallel for \
+  default(none) \
+  shared(origins, directions, k_indices, order, max_voxel_count, nr_rays) \
+  reduction(+: voxel_count) \
+  schedule(dynamic, 64) \
+  num_threads(threads_)
+  for (std::ptrdiff_t i = 0; i < nr_rays; i++) {
+    const std::size_t ray = order[i];
+    voxel_count += getIntersectedVoxelIndices(
+        origins[ray], directions[ray], k_indices[ray], max_voxel_count);
+  }
+  return (voxel_count);
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+std::size_t
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::
+    getPointIndicesFromNewVoxels(const OctreePointCloudSearch& previous,
+                                 std::vector<int>& indices,
+                                 int min_points_per_leaf) const
+{
+  if (linear_nodes_.empty() || previous.linear_nodes_.empty()) {
+    PCL_ERROR("[pcl::octree::OctreePointCloudSearch::getPointIndicesFromNewVoxels] "
+              "Both octrees have to be linear octrees!\n");
+    return (indices.size());
+  }
+  if (this->octree_depth_ != previous.octree_depth_ ||
+      this->min_x_ != previous.min_x_ || this->min_y_ != previous.min_y_ ||
+      this->min_z_ != previous.min_z_ || this->max_x_ != previous.max_x_ ||
+      this->max_y_ != previous.max_y_ || this->max_z_ != previous.max_z_) {
+    PCL_ERROR("[pcl::octree::OctreePointCloudSearch::getPointIndicesFromNewVoxels] "
+              "The octrees have different bounding boxes or depths!\n");
+    return (indices.size());
+  }
+
+  getNewVoxelPointsLinear(previous, 0, 0, 0, indices, min_points_per_leaf);
+  return (indices.size());
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+void
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::
+    getNewVoxelPointsLinear(const OctreePointCloudSearch& previous,
+                            std::int64_t previous_node,
+                            std::uint32_t node,
+                            unsigned int tree_depth,
+                            std::vector<int>& indices,
+                            int min_points_per_leaf) const
+{
+  const LinearNode& branch = linear_nodes_[node];
+
+  if (tree_depth >= this->octree_depth_) {
+    // leaf, new if it does not exist in the previous octree
+    if (previous_node < 0 &&
+        static_cast<int>(branch.points_end - branch.points_begin) >=
+            min_points_per_leaf)
+      indices.insert(indices.end(),
+                     linear_indices_.begin() + branch.points_begin,
+                     linear_indices_.begin() + branch.points_end);
+    return;
+  }
+
+  // a new branch without leaf size limit contributes all its points at once
+  if (previous_node < 0 && min_points_per_leaf <= 1) {
+    indices.insert(indices.end(),
+                   linear_indices_.begin() + branch.points_begin,
+                   linear_indices_.begin() + branch.points_end);
+    return;
+  }
+
+  std::uint32_t child_node = branch.first_child;
+  for (unsigned char child_idx = 0; child_idx < 8; child_idx++) {
+    if (!(branch.child_mask & (1 << child_idx)))
+      continue;
+
+    const std::int64_t previous_child =
+        previous_node < 0
+            ? -1
+            : previous.getLinearChild(previous.linear_nodes_[previous_node], child_idx);
+    getNewVoxelPointsLinear(previous,
+                            previous_child,
+                            child_node,
+                            tree_depth + 1,
+                            indices,
+                            min_points_per_leaf);
+    child_node++;
+  }
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+void
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::getCoherentRayOrder(
+    const std::vector<Eigen::Vector3f>& directions, std::vector<std::size_t>& order)
+{
+  // octant in the upper bits, the direction projected on the octant's face of the
+  // unit octahedron and quantized to 8 bits per coordinate in the lower ones
+  std::vector<std::uint32_t> keys(directions.size());
+  for (std::size_t i = 0; i < directions.size(); i++) {
+    const Eigen::Vector3f& direction = directions[i];
+    const Eigen::Vector3f abs_direction = direction.cwiseAbs();
+    const float norm = std::max(abs_direction.sum(), std::numeric_limits<float>::min());
+    const auto u = static_cast<std::uint32_t>(255.0f * abs_direction.x() / norm);
+    const auto v = static_cast<std::uint32_t>(255.0f * abs_direction.y() / norm);
+    const std::uint32_t octant = ((direction.x() < 0.0f) << 2) |
+                                 ((direction.y() < 0.0f) << 1) | (direction.z() < 0.0f);
+    keys[i] = (octant << 16) | (u << 8) | v;
+  }
+
+  order.resize(directions.size());
+  for (std::size_t i = 0; i < order.size(); i++)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), [&keys](std::size_t a, std::size_t b) {
+    return (keys[a] < keys[b]);
+  });
+}
+
 template <typename PointT, typename LeafContainerT, typename BranchContainerT>
 int
 OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::
@@ -1048,6 +1335,896 @@ OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::
   return (voxel_count);
 }
 
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+void
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::setNumberOfThreads(
+    unsigned int nr_threads)
+{
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    threads_ = omp_get_num_procs();
+#else
+    threads_ = 1;
+#endif
+  else
+    threads_ = nr_threads;
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+void
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::addPointIdx(
+    const int point_idx_arg)
+{
+  if (!linear_nodes_.empty()) {
+    // the pointer based octree is empty, it takes over the points of the linear octree
+    std::vector<int> indices;
+    indices.swap(linear_indices_);
+    deleteLinearOctree();
+    std::sort(indices.begin(), indices.end());
+    for (const int& index : indices)
+      OctreeT::addPointIdx(index);
+  }
+  OctreeT::addPointIdx(point_idx_arg);
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+void
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::buildLinearOctree()
+{
+  if (this->leaf_count_ > 0) {
+    PCL_ERROR("[pcl::octree::OctreePointCloudSearch::buildLinearOctree] The octree "
+              "already contains points, call deleteTree () first!\n");
+    return;
+  }
+  deleteLinearOctree();
+
+  // Collect the finite points and their bounds
+  std::vector<int> indices;
+  indices.reserve(this->indices_ ? this->indices_->size() : this->input_->size());
+  Eigen::Vector3f min_pt = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+  Eigen::Vector3f max_pt =
+      Eigen::Vector3f::Constant(std::numeric_limits<float>::lowest());
+  const auto add_point = [&](int index) {
+    const PointT& point = (*this->input_)[index];
+    if (!isFinite(point))
+      return;
+    indices.push_back(index);
+    min_pt = min_pt.cwiseMin(point.getVector3fMap());
+    max_pt = max_pt.cwiseMax(point.getVector3fMap());
+  };
+  if (this->indices_)
+    for (const int& index : *this->indices_)
+      add_point(index);
+  else
+    for (std::size_t i = 0; i < this->input_->size(); i++)
+      add_point(static_cast<int>(i));
+
+  // Define the bounding box, or grow it until all points fit
+  if (!indices.empty()) {
+    const float minValue = std::numeric_limits<float>::epsilon() * 512.0f;
+    if (!this->bounding_box_defined_ || min_pt.x() < this->min_x_ ||
+        min_pt.y() < this->min_y_ || min_pt.z() < this->min_z_ ||
+        max_pt.x() >= this->max_x_ || max_pt.y() >= this->max_y_ ||
+        max_pt.z() >= this->max_z_) {
+      if (this->bounding_box_defined_) {
+        min_pt = min_pt.cwiseMin(Eigen::Vector3d(this->min_x_, this->min_y_, this->min_z_)
+                                     .cast<float>());
+        max_pt = max_pt.cwiseMax(Eigen::Vector3d(this->max_x_, this->max_y_, this->max_z_)
+                                     .cast<float>());
+      }
+      this->defineBoundingBox(min_pt.x(),
+                              min_pt.y(),
+                              min_pt.z(),
+                              max_pt.x() + minValue,
+                              max_pt.y() + minValue,
+                              max_pt.z() + minValue);
+    }
+  }
+
+  const unsigned int depth = this->octree_depth_;
+  if (depth > 21) {
+    PCL_WARN("[pcl::octree::OctreePointCloudSearch::buildLinearOctree] The octree "
+             "depth %u exceeds the 21 levels of the linear octree, building a pointer "
+             "based octree instead.\n",
+             depth);
+    this->addPointsFromInputCloud();
+    return;
+  }
+
+  // Morton codes of the leaf keys
+  std::ptrdiff_t nr_points = static_cast<std::ptrdiff_t>(indices.size());
+  std::vector<std::uint64_t> codes(nr_points);
+#pragma omp parallel for \
+  default(none) \
+  shared(indices, codes, nr_points) \
+  schedule(static) \
+  num_threads(threads_)
+  for (std::ptrdiff_t i = 0; i < nr_points; i++) {
+    OctreeKey key;
+    this->genOctreeKeyforPoint((*this->input_)[indices[i]], key);
+    codes[i] = getMortonCode(key);
+  }
+
+  // Stable LSD radix sort of the codes, 8 bits per pass. Every thread counts and then
+  // scatters one chunk of the points, so the points of a leaf keep their input order.
+  int nr_chunks = static_cast<int>(std::max(1u, threads_));
+  std::vector<std::uint64_t> sorted_codes(nr_points);
+  std::vector<int> sorted_indices(nr_points);
+  std::vector<std::size_t> offsets(nr_chunks * 256);
+  for (unsigned int shift = 0; shift < 3 * depth; shift += 8) {
+    std::fill(offsets.begin(), offsets.end(), 0);
+#pragma omp parallel for \
+  default(none) \
+  shared(codes, offsets, nr_chunks, nr_points, shift) \
+  schedule(static, 1) \
+  num_threads(threads_)
+    for (int chunk = 0; chunk < nr_chunks; chunk++) {
+      const std::ptrdiff_t begin = nr_points * chunk / nr_chunks;
+      const std::ptrdiff_t end = nr_points * (chunk + 1) / nr_chunks;
+      for (std::ptrdiff_t i = begin; i < end; i++)
+        offsets[chunk * 256 + ((codes[i] >> shift) & 0xFF)]++;
+    }
+
+    std::size_t offset = 0;
+    for (int digit = 0; digit < 256; digit++)
+      for (int chunk = 0; chunk < nr_chunks; chunk++) {
+        const std::size_t count = offsets[chunk * 256 + digit];
+        offsets[chunk * 256 + digit] = offset;
+        offset += count;
+      }
+
+#pragma omp parallel for \
+  default(none) \
+  shared(codes, indices, sorted_codes, sorted_indices, offsets, nr_chunks, nr_points, shift) \
+  schedule(static, 1) \
+  num_threads(threads_)
+    for (int chunk = 0; chunk < nr_chunks; chunk++) {
+      const std::ptrdiff_t begin = nr_points * chunk / nr_chunks;
+      const std::ptrdiff_t end = nr_points * (chunk + 1) / nr_chunks;
+      for (std::ptrdiff_t i = begin; i < end; i++) {
+        const std::size_t pos = offsets[chunk * 256 + ((codes[i] >> shift) & 0xFF)]++;
+        sorted_codes[pos] = codes[i];
+        sorted_indices[pos] = indices[i];
+      }
+    }
+    codes.swap(sorted_codes);
+    indices.swap(sorted_indices);
+  }
+
+  // Emit the nodes bottom-up. Every run of equal codes is a leaf, every run of equal
+  // parent codes (code >> 3) on a level is a node of the level above.
+  std::vector<std::vector<LinearNode>> levels(depth + 1);
+  std::vector<std::uint64_t> level_codes;
+  for (std::ptrdiff_t i = 0; i < nr_points;) {
+    std::ptrdiff_t j = i + 1;
+    while (j < nr_points && codes[j] == codes[i])
+      j++;
+    levels[depth].push_back({0,
+                             static_cast<std::uint32_t>(i),
+                             static_cast<std::uint32_t>(j),
+                             static_cast<std::uint8_t>(0)});
+    level_codes.push_back(codes[i]);
+    i = j;
+  }
+  std::vector<std::uint64_t> parent_codes;
+  for (unsigned int level = depth; level > 0; level--) {
+    const std::vector<LinearNode>& children = levels[level];
+    std::vector<LinearNode>& parents = levels[level - 1];
+    parent_codes.clear();
+    for (std::size_t c = 0; c < children.size(); c++) {
+      const std::uint64_t parent_code = level_codes[c] >> 3;
+      const auto child_bit = static_cast<std::uint8_t>(1 << (level_codes[c] & 7));
+      if (parent_codes.empty() || parent_codes.back() != parent_code) {
+        parents.push_back({static_cast<std::uint32_t>(c),
+                           children[c].points_begin,
+                           children[c].points_end,
+                           child_bit});
+        parent_codes.push_back(parent_code);
+      }
+      else {
+        parents.back().points_end = children[c].points_end;
+        parents.back().child_mask |= child_bit;
+      }
+    }
+    level_codes.swap(parent_codes);
+  }
+  // Empty root of an empty cloud
+  if (levels[0].empty())
+    levels[0].push_back({0, 0, 0, static_cast<std::uint8_t>(0)});
+
+  // Store the levels one after the other, root first
+  std::size_t nr_nodes = 0;
+  for (const auto& level : levels)
+    nr_nodes += level.size();
+  linear_nodes_.reserve(nr_nodes);
+  for (unsigned int level = 0; level <= depth; level++) {
+    const auto first_child = static_cast<std::uint32_t>(
+        linear_nodes_.size() + levels[level].size());
+    for (LinearNode node : levels[level]) {
+      if (level < depth)
+        node.first_child += first_child;
+      linear_nodes_.push_back(node);
+    }
+  }
+  linear_indices_.swap(indices);
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+double
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::
+    getKNearestNeighborLinear(const PointT& point,
+                              unsigned int K,
+                              std::uint32_t node,
+                              const OctreeKey& key,
+                              unsigned int tree_depth,
+                              const double squared_search_radius,
+                              std::vector<prioPointQueueEntry>& point_candidates) const
+{
+  std::vector<prioBranchQueueEntry> search_heap;
+  search_heap.resize(8);
+
+  double smallest_squared_dist = squared_search_radius;
+
+  // get spatial voxel information
+  double voxelSquaredDiameter = this->getVoxelSquaredDiameter(tree_depth);
+
+  // iterate over all children
+  for (unsigned char child_idx = 0; child_idx < 8; child_idx++) {
+    search_heap[child_idx].key.x = (key.x << 1) + (!!(child_idx & (1 << 2)));
+    search_heap[child_idx].key.y = (key.y << 1) + (!!(child_idx & (1 << 1)));
+    search_heap[child_idx].key.z = (key.z << 1) + (!!(child_idx & (1 << 0)));
+
+    if (linear_nodes_[node].child_mask & (1 << child_idx)) {
+      PointT voxel_center;
+
+      // generate voxel center point for voxel at key
+      this->genVoxelCenterFromOctreeKey(
+          search_heap[child_idx].key, tree_depth, voxel_center);
+
+      search_heap[child_idx].point_distance = pointSquaredDist(voxel_center, point);
+    }
+    else {
+      search_heap[child_idx].point_distance = std::numeric_limits<float>::infinity();
+    }
+  }
+
+  std::sort(search_heap.begin(), search_heap.end());
+
+  // iterate over all children in priority queue
+  // check if the distance to search candidate is smaller than the best point distance
+  // (smallest_squared_dist)
+  while ((!search_heap.empty()) &&
+         (search_heap.back().point_distance <
+          smallest_squared_dist + voxelSquaredDiameter / 4.0 +
+              sqrt(smallest_squared_dist * voxelSquaredDiameter) - this->epsilon_)) {
+    // read from priority queue element
+    const OctreeKey& new_key = search_heap.back().key;
+    const auto child_idx = static_cast<unsigned char>(
+        ((new_key.x & 1) << 2) | ((new_key.y & 1) << 1) | (new_key.z & 1));
+    const auto child_node =
+        static_cast<std::uint32_t>(getLinearChild(linear_nodes_[node], child_idx));
+
+    if (tree_depth < this->octree_depth_) {
+      // we have not reached maximum tree depth
+      smallest_squared_dist = getKNearestNeighborLinear(point,
+                                                        K,
+                                                        child_node,
+                                                        new_key,
+                                                        tree_depth + 1,
+                                                        smallest_squared_dist,
+                                                        point_candidates);
+    }
+    else {
+      // we reached leaf node level, iterate over its points
+      const LinearNode& leaf = linear_nodes_[child_node];
+      for (std::uint32_t i = leaf.points_begin; i < leaf.points_end; i++) {
+        int point_index = linear_indices_[i];
+        const PointT& candidate_point = this->getPointByIndex(point_index);
+
+        // calculate point distance to search point
+        float squared_dist = pointSquaredDist(candidate_point, point);
+
+        // check if a closer match is found
+        if (squared_dist < smallest_squared_dist) {
+          prioPointQueueEntry point_entry;
+
+          point_entry.point_distance_ = squared_dist;
+          point_entry.point_idx_ = point_index;
+          point_candidates.push_back(point_entry);
+        }
+      }
+
+      std::sort(point_candidates.begin(), point_candidates.end());
+
+      if (point_candidates.size() > K)
+        point_candidates.resize(K);
+
+      if (point_candidates.size() == K)
+        smallest_squared_dist = point_candidates.back().point_distance_;
+    }
+    // pop element from priority queue
+    search_heap.pop_back();
+  }
+
+  return (smallest_squared_dist);
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+void
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::
+    getNeighborsWithinRadiusLinear(const PointT& point,
+                                   const double radiusSquared,
+                                   std::uint32_t node,
+                                   const OctreeKey& key,
+                                   unsigned int tree_depth,
+                                   std::vector<int>& k_indices,
+                                   std::vector<float>& k_sqr_distances,
+                                   unsigned int max_nn) const
+{
+  // get spatial voxel information
+  double voxel_squared_diameter = this->getVoxelSquaredDiameter(tree_depth);
+
+  const LinearNode& branch = linear_nodes_[node];
+  std::uint32_t child_node = branch.first_child;
+
+  // iterate over all children
+  for (unsigned char child_idx = 0; child_idx < 8; child_idx++) {
+    if (!(branch.child_mask & (1 << child_idx)))
+      continue;
+
+    OctreeKey new_key;
+    PointT voxel_center;
+    float squared_dist;
+
+    // generate new key for current branch voxel
+    new_key.x = (key.x << 1) + (!!(child_idx & (1 << 2)));
+    new_key.y = (key.y << 1) + (!!(child_idx & (1 << 1)));
+    new_key.z = (key.z << 1) + (!!(child_idx & (1 << 0)));
+
+    // generate voxel center point for voxel at key
+    this->genVoxelCenterFromOctreeKey(new_key, tree_depth, voxel_center);
+
+    // calculate distance to search point
+    squared_dist = pointSquaredDist(static_cast<const PointT&>(voxel_center), point);
+
+    // if distance is smaller than search radius
+    if (squared_dist + this->epsilon_ <=
+        voxel_squared_diameter / 4.0 + radiusSquared +
+            sqrt(voxel_squared_diameter * radiusSquared)) {
+
+      if (tree_depth < this->octree_depth_) {
+        // we have not reached maximum tree depth
+        getNeighborsWithinRadiusLinear(point,
+                                       radiusSquared,
+                                       child_node,
+                                       new_key,
+                                       tree_depth + 1,
+                                       k_indices,
+                                       k_sqr_distances,
+                                       max_nn);
+        if (max_nn != 0 && k_indices.size() == static_cast<unsigned int>(max_nn))
+          return;
+      }
+      else {
+        // we reached leaf node level, iterate over its points
+        const LinearNode& leaf = linear_nodes_[child_node];
+        for (std::uint32_t i = leaf.points_begin; i < leaf.points_end; i++) {
+          const int index = linear_indices_[i];
+          const PointT& candidate_point = this->getPointByIndex(index);
+
+          // calculate point distance to search point
+          squared_dist = pointSquaredDist(candidate_point, point);
+
+          // check if a match is found
+          if (squared_dist > radiusSquared)
+            continue;
+
+          // add point to result vector
+          k_indices.push_back(index);
+          k_sqr_distances.push_back(squared_dist);
+
+          if (max_nn != 0 && k_indices.size() == static_cast<unsigned int>(max_nn))
+            return;
+        }
+      }
+    }
+    child_node++;
+  }
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+void
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::
+    approxNearestSearchLinear(const PointT& point,
+                              std::uint32_t node,
+                              const OctreeKey& key,
+                              unsigned int tree_depth,
+                              int& result_index,
+                              float& sqr_distance) const
+{
+  OctreeKey minChildKey;
+  OctreeKey new_key;
+
+  // set minimum voxel distance to maximum value
+  double min_voxel_center_distance = std::numeric_limits<double>::max();
+
+  unsigned char min_child_idx = 0xFF;
+
+  // iterate over all children
+  for (unsigned char child_idx = 0; child_idx < 8; child_idx++) {
+    if (!(linear_nodes_[node].child_mask & (1 << child_idx)))
+      continue;
+
+    PointT voxel_center;
+    double voxelPointDist;
+
+    new_key.x = (key.x << 1) + (!!(child_idx & (1 << 2)));
+    new_key.y = (key.y << 1) + (!!(child_idx & (1 << 1)));
+    new_key.z = (key.z << 1) + (!!(child_idx & (1 << 0)));
+
+    // generate voxel center point for voxel at key
+    this->genVoxelCenterFromOctreeKey(new_key, tree_depth, voxel_center);
+
+    voxelPointDist = pointSquaredDist(voxel_center, point);
+
+    // search for child voxel with shortest distance to search point
+    if (voxelPointDist >= min_voxel_center_distance)
+      continue;
+
+    min_voxel_center_distance = voxelPointDist;
+    min_child_idx = child_idx;
+    minChildKey = new_key;
+  }
+
+  // an empty cloud has an empty root
+  if (min_child_idx == 0xFF)
+    return;
+
+  const auto child_node =
+      static_cast<std::uint32_t>(getLinearChild(linear_nodes_[node], min_child_idx));
+
+  if (tree_depth < this->octree_depth_) {
+    // we have not reached maximum tree depth
+    approxNearestSearchLinear(
+        point, child_node, minChildKey, tree_depth + 1, result_index, sqr_distance);
+  }
+  else {
+    // we reached leaf node level, iterate over its points
+    double smallest_squared_dist = std::numeric_limits<double>::max();
+
+    const LinearNode& leaf = linear_nodes_[child_node];
+    for (std::uint32_t i = leaf.points_begin; i < leaf.points_end; i++) {
+      const int index = linear_indices_[i];
+      const PointT& candidate_point = this->getPointByIndex(index);
+
+      // calculate point distance to search point
+      double squared_dist = pointSquaredDist(candidate_point, point);
+
+      // check if a closer match is found
+      if (squared_dist >= smallest_squared_dist)
+        continue;
+
+      result_index = index;
+      smallest_squared_dist = squared_dist;
+      sqr_distance = static_cast<float>(squared_dist);
+    }
+  }
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+void
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::boxSearchLinear(
+    const Eigen::Vector3f& min_pt,
+    const Eigen::Vector3f& max_pt,
+    std::uint32_t node,
+    const OctreeKey& key,
+    unsigned int tree_depth,
+    std::vector<int>& k_indices) const
+{
+  const LinearNode& branch = linear_nodes_[node];
+  std::uint32_t child_node = branch.first_child;
+
+  // iterate over all children
+  for (unsigned char child_idx = 0; child_idx < 8; child_idx++) {
+    if (!(branch.child_mask & (1 << child_idx)))
+      continue;
+
+    OctreeKey new_key;
+    // generate new key for current branch voxel
+    new_key.x = (key.x << 1) + (!!(child_idx & (1 << 2)));
+    new_key.y = (key.y << 1) + (!!(child_idx & (1 << 1)));
+    new_key.z = (key.z << 1) + (!!(child_idx & (1 << 0)));
+
+    // voxel corners
+    Eigen::Vector3f lower_voxel_corner;
+    Eigen::Vector3f upper_voxel_corner;
+    // get voxel coordinates
+    this->genVoxelBoundsFromOctreeKey(
+        new_key, tree_depth, lower_voxel_corner, upper_voxel_corner);
+
+    // test if search region overlap with voxel space
+    if (!((lower_voxel_corner(0) > max_pt(0)) || (min_pt(0) > upper_voxel_corner(0)) ||
+          (lower_voxel_corner(1) > max_pt(1)) || (min_pt(1) > upper_voxel_corner(1)) ||
+          (lower_voxel_corner(2) > max_pt(2)) || (min_pt(2) > upper_voxel_corner(2)))) {
+
+      if (tree_depth < this->octree_depth_) {
+        // we have not reached maximum tree depth
+        boxSearchLinear(min_pt, max_pt, child_node, new_key, tree_depth + 1, k_indices);
+      }
+      else {
+        // we reached leaf node level, iterate over its points
+        const LinearNode& leaf = linear_nodes_[child_node];
+        for (std::uint32_t i = leaf.points_begin; i < leaf.points_end; i++) {
+          const int index = linear_indices_[i];
+          const PointT& candidate_point = this->getPointByIndex(index);
+
+          // check if point falls within search box
+          bool bInBox =
+              ((candidate_point.x >= min_pt(0)) && (candidate_point.x <= max_pt(0)) &&
+               (candidate_point.y >= min_pt(1)) && (candidate_point.y <= max_pt(1)) &&
+               (candidate_point.z >= min_pt(2)) && (candidate_point.z <= max_pt(2)));
+
+          if (bInBox)
+            // add to result vector
+            k_indices.push_back(index);
+        }
+      }
+    }
+    child_node++;
+  }
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+int
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::intersectPlanes(
+    const std::vector<Eigen::Vector4f>& planes,
+    const Eigen::Vector3f& min_pt,
+    const Eigen::Vector3f& max_pt)
+{
+  const Eigen::Vector3f center = 0.5f * (min_pt + max_pt);
+  const Eigen::Vector3f radius = 0.5f * (max_pt - min_pt);
+
+  int result = 0;
+  for (const Eigen::Vector4f& plane : planes) {
+    // signed distance of the center and projected radius of the box on the normal
+    const float m = plane.head<3>().dot(center) + plane(3);
+    const float n = radius.dot(plane.head<3>().cwiseAbs());
+    if (m + n < 0)
+      return (2);
+    if (m - n < 0)
+      result = 1;
+  }
+  return (result);
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+bool
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::isInsidePlanes(
+    const std::vector<Eigen::Vector4f>& planes, const PointT& point)
+{
+  for (const Eigen::Vector4f& plane : planes)
+    if (plane.head<3>().dot(point.getVector3fMap()) + plane(3) < 0)
+      return (false);
+  return (true);
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+bool
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::
+    isBelowScreenSpaceError(const Eigen::Vector3f& eye,
+                            float focal_length,
+                            float max_pixel_size,
+                            const Eigen::Vector3f& min_pt,
+                            const Eigen::Vector3f& max_pt)
+{
+  // distance of the eye to the closest point of the voxel, 0 if it is inside
+  const float distance = (eye - eye.cwiseMax(min_pt).cwiseMin(max_pt)).norm();
+  return (focal_length * (max_pt(0) - min_pt(0)) <= max_pixel_size * distance);
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+void
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::getFrustumTasks(
+    const std::vector<Eigen::Vector4f>& planes,
+    const Eigen::Vector3f* eye,
+    float focal_length,
+    float max_pixel_size,
+    const FrustumTask& task,
+    unsigned int split_depth,
+    std::vector<FrustumTask>& tasks) const
+{
+  if (task.tree_depth >= split_depth || task.tree_depth == this->octree_depth_) {
+    tasks.push_back(task);
+    return;
+  }
+
+  Eigen::Vector3f lower_voxel_corner;
+  Eigen::Vector3f upper_voxel_corner;
+  this->genVoxelBoundsFromOctreeKey(
+      task.key, task.tree_depth, lower_voxel_corner, upper_voxel_corner);
+
+  const int result = intersectPlanes(planes, lower_voxel_corner, upper_voxel_corner);
+  if (result == 2)
+    return;
+
+  // subtrees which are accepted as a whole are not worth splitting
+  if ((!eye && result == 0) ||
+      (eye && isBelowScreenSpaceError(*eye,
+                                      focal_length,
+                                      max_pixel_size,
+                                      lower_voxel_corner,
+                                      upper_voxel_corner))) {
+    tasks.push_back(task);
+    return;
+  }
+
+  const LinearNode& branch = linear_nodes_[task.node];
+  FrustumTask child;
+  child.node = branch.first_child;
+  child.tree_depth = task.tree_depth + 1;
+  for (unsigned char child_idx = 0; child_idx < 8; child_idx++) {
+    if (!(branch.child_mask & (1 << child_idx)))
+      continue;
+
+    child.key.x = (task.key.x << 1) + (!!(child_idx & (1 << 2)));
+    child.key.y = (task.key.y << 1) + (!!(child_idx & (1 << 1)));
+    child.key.z = (task.key.z << 1) + (!!(child_idx & (1 << 0)));
+    getFrustumTasks(
+        planes, eye, focal_length, max_pixel_size, child, split_depth, tasks);
+    child.node++;
+  }
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+void
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::frustumSearchLinear(
+    const std::vector<Eigen::Vector4f>& planes,
+    const Eigen::Vector3f* eye,
+    float focal_length,
+    float max_pixel_size,
+    const FrustumTask& task,
+    bool inside,
+    std::vector<IndexRange>& ranges) const
+{
+  const LinearNode& node = linear_nodes_[task.node];
+
+  Eigen::Vector3f lower_voxel_corner;
+  Eigen::Vector3f upper_voxel_corner;
+  this->genVoxelBoundsFromOctreeKey(
+      task.key, task.tree_depth, lower_voxel_corner, upper_voxel_corner);
+
+  const int result =
+      inside ? 0 : intersectPlanes(planes, lower_voxel_corner, upper_voxel_corner);
+  if (result == 2)
+    return;
+
+  const bool is_leaf = (task.tree_depth == this->octree_depth_);
+  if (eye && !is_leaf &&
+      isBelowScreenSpaceError(*eye,
+                              focal_length,
+                              max_pixel_size,
+                              lower_voxel_corner,
+                              upper_voxel_corner)) {
+    // the node is represented by its first point inside the frustum
+    for (std::uint32_t i = node.points_begin; i < node.points_end; i++) {
+      if (result == 0 || isInsidePlanes(planes, this->getPointByIndex(linear_indices_[i]))) {
+        appendRange(i, i + 1, ranges);
+        break;
+      }
+    }
+    return;
+  }
+
+  if (result == 0 && (!eye || is_leaf)) {
+    // accept all points of the subtree at once
+    appendRange(node.points_begin, node.points_end, ranges);
+    return;
+  }
+
+  if (is_leaf) {
+    // the leaf crosses a plane, test its points
+    for (std::uint32_t i = node.points_begin; i < node.points_end; i++)
+      if (isInsidePlanes(planes, this->getPointByIndex(linear_indices_[i])))
+        appendRange(i, i + 1, ranges);
+    return;
+  }
+
+  FrustumTask child;
+  child.node = node.first_child;
+  child.tree_depth = task.tree_depth + 1;
+  for (unsigned char child_idx = 0; child_idx < 8; child_idx++) {
+    if (!(node.child_mask & (1 << child_idx)))
+      continue;
+
+    child.key.x = (task.key.x << 1) + (!!(child_idx & (1 << 2)));
+    child.key.y = (task.key.y << 1) + (!!(child_idx & (1 << 1)));
+    child.key.z = (task.key.z << 1) + (!!(child_idx & (1 << 0)));
+    frustumSearchLinear(
+        planes, eye, focal_length, max_pixel_size, child, result == 0, ranges);
+    child.node++;
+  }
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+std::size_t
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::frustumSearchParallel(
+    const std::vector<Eigen::Vector4f>& planes,
+    const Eigen::Vector3f* eye,
+    float focal_length,
+    float max_pixel_size,
+    std::vector<IndexRange>& ranges) const
+{
+  // split the octree into enough subtrees to balance the load of the threads
+  unsigned int split_depth = 0;
+  if (threads_ > 1)
+    while (split_depth < this->octree_depth_ &&
+           (std::size_t(1) << (3 * split_depth)) < 16 * std::size_t(threads_))
+      split_depth++;
+
+  FrustumTask root;
+  root.node = 0;
+  root.key.x = root.key.y = root.key.z = 0;
+  root.tree_depth = 0;
+  std::vector<FrustumTask> tasks;
+  getFrustumTasks(planes, eye, focal_length, max_pixel_size, root, split_depth, tasks);
+
+  // the tasks are in Morton order, so are their ranges
+  std::vector<std::vector<IndexRange>> task_ranges(tasks.size());
+  std::ptrdiff_t nr_tasks = static_cast<std::ptrdiff_t>(tasks.size());
+#pragma omp parallel for \
+  default(none) \
+  shared(planes, eye, focal_length, max_pixel_size, tasks, task_ranges, nr_tasks) \
+  schedule(dynamic, 1) \
+  num_threads(threads_)
+  for (std::ptrdiff_t i = 0; i < nr_tasks; i++)
+    frustumSearchLinear(
+        planes, eye, focal_length, max_pixel_size, tasks[i], false, task_ranges[i]);
+
+  std::size_t nr_points = 0;
+  for (const std::vector<IndexRange>& task_range : task_ranges)
+    for (const IndexRange& range : task_range) {
+      appendRange(range.first, range.second, ranges);
+      nr_points += range.second - range.first;
+    }
+  return (nr_points);
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+void
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::frustumSearchRecursive(
+    const std::vector<Eigen::Vector4f>& planes,
+    const OctreeNode* node,
+    const OctreeKey& key,
+    unsigned int tree_depth,
+    bool inside,
+    std::vector<int>& k_indices) const
+{
+  if (!inside) {
+    Eigen::Vector3f lower_voxel_corner;
+    Eigen::Vector3f upper_voxel_corner;
+    this->genVoxelBoundsFromOctreeKey(
+        key, tree_depth, lower_voxel_corner, upper_voxel_corner);
+
+    const int result = intersectPlanes(planes, lower_voxel_corner, upper_voxel_corner);
+    if (result == 2)
+      return;
+    inside = (result == 0);
+  }
+
+  if (node->getNodeType() == LEAF_NODE) {
+    const LeafNode* leaf = static_cast<const LeafNode*>(node);
+    if (inside) {
+      (**leaf).getPointIndices(k_indices);
+      return;
+    }
+
+    // the leaf crosses a plane, test its points
+    std::vector<int> decoded_point_vector;
+    (**leaf).getPointIndices(decoded_point_vector);
+    for (const int& index : decoded_point_vector)
+      if (isInsidePlanes(planes, this->getPointByIndex(index)))
+        k_indices.push_back(index);
+    return;
+  }
+
+  const BranchNode* branch = static_cast<const BranchNode*>(node);
+  for (unsigned char child_idx = 0; child_idx < 8; child_idx++) {
+    const OctreeNode* child_node = this->getBranchChildPtr(*branch, child_idx);
+    if (!child_node)
+      continue;
+
+    OctreeKey new_key;
+    new_key.x = (key.x << 1) + (!!(child_idx & (1 << 2)));
+    new_key.y = (key.y << 1) + (!!(child_idx & (1 << 1)));
+    new_key.z = (key.z << 1) + (!!(child_idx & (1 << 0)));
+    frustumSearchRecursive(
+        planes, child_node, new_key, tree_depth + 1, inside, k_indices);
+  }
+}
+
+template <typename PointT, typename LeafContainerT, typename BranchContainerT>
+int
+OctreePointCloudSearch<PointT, LeafContainerT, BranchContainerT>::
+    getIntersectedVoxelsLinear(
+        double min_x,
+        double min_y,
+        double min_z,
+        double max_x,
+        double max_y,
+        double max_z,
+        unsigned char a,
+        std::uint32_t node,
+        const OctreeKey& key,
+        unsigned int tree_depth,
+        std::vector<std::pair<std::uint32_t, OctreeKey>>& leaves,
+        int max_voxel_count) const
+{
+  if (max_x < 0.0 || max_y < 0.0 || max_z < 0.0)
+    return (0);
+
+  // If leaf node, store it and increment intersection count
+  if (tree_depth > 0 && tree_depth >= this->octree_depth_) {
+    leaves.emplace_back(node, key);
+    return (1);
+  }
+
+  // Voxel intersection count for branches children
+  int voxel_count = 0;
+
+  // Voxel mid lines
+  double mid_x = 0.5 * (min_x + max_x);
+  double mid_y = 0.5 * (min_y + max_y);
+  double mid_z = 0.5 * (min_z + max_z);
+
+  // First voxel node ray will intersect
+  int curr_node = getFirstIntersectedNode(min_x, min_y, min_z, mid_x, mid_y, mid_z);
+
+  do {
+    const auto child_idx = static_cast<unsigned char>(curr_node ^ a);
+
+    // Bounds of the current child, along every axis the lower or upper half
+    const double child_min_x = (curr_node & 4) ? mid_x : min_x;
+    const double child_max_x = (curr_node & 4) ? max_x : mid_x;
+    const double child_min_y = (curr_node & 2) ? mid_y : min_y;
+    const double child_max_y = (curr_node & 2) ? max_y : mid_y;
+    const double child_min_z = (curr_node & 1) ? mid_z : min_z;
+    const double child_max_z = (curr_node & 1) ? max_z : mid_z;
+
+    // Recursively call each intersected child node, children that do not exist are
+    // skipped
+    const std::int64_t child_node = getLinearChild(linear_nodes_[node], child_idx);
+    if (child_node >= 0) {
+      OctreeKey child_key;
+      child_key.x = (key.x << 1) | (!!(child_idx & (1 << 2)));
+      child_key.y = (key.y << 1) | (!!(child_idx & (1 << 1)));
+      child_key.z = (key.z << 1) | (!!(child_idx & (1 << 0)));
+
+      voxel_count += getIntersectedVoxelsLinear(child_min_x,
+                                                child_min_y,
+                                                child_min_z,
+                                                child_max_x,
+                                                child_max_y,
+                                                child_max_z,
+                                                a,
+                                                static_cast<std::uint32_t>(child_node),
+                                                child_key,
+                                                tree_depth + 1,
+                                                leaves,
+                                                max_voxel_count);
+    }
+
+    // Select the next node intersected by the ray, 8 when it leaves this node
+    curr_node = getNextIntersectedNode(child_max_x,
+                                       child_max_y,
+                                       child_max_z,
+                                       (curr_node & 4) ? 8 : curr_node | 4,
+                                       (curr_node & 2) ? 8 : curr_node | 2,
+                                       (curr_node & 1) ? 8 : curr_node | 1);
+  } while ((curr_node < 8) && (max_voxel_count <= 0 || voxel_count < max_voxel_count));
+
+  return (voxel_count);
+}
+
 } // namespace octree
 } // namespace pcl
 
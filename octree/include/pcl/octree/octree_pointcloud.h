@@ -113,7 +113,7 @@ public:
    * \param[in] indices_arg the point indices subset that is to be used from \a cloud -
    * if 0 the whole point cloud is used
    */
-  inline void
+  virtual void
   setInputCloud(const PointCloudConstPtr& cloud_arg,
                 const IndicesConstPtr& indices_arg = IndicesConstPtr())
   {
@@ -232,7 +232,7 @@ public:
 
   /** \brief Delete the octree structure and its leaf nodes.
    * */
-  void
+  virtual void
   deleteTree()
   {
     // reset bounding box
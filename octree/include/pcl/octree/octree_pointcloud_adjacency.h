@@ -41,9 +41,12 @@
 
 #include <pcl/octree/octree_pointcloud.h>
 #include <pcl/octree/octree_pointcloud_adjacency_container.h>
+#include <pcl/types.h> // for pcl::Indices
 
 #include <boost/graph/adjacency_list.hpp> // for adjacency_list
 
+#include <utility> // for std::pair
+
 namespace pcl {
 
 namespace octree {
@@ -62,6 +65,12 @@ namespace octree {
  * in distance from the origin (camera). \note See SupervoxelClustering for an example
  * of how to provide a transform function.
  *
+ * Besides the neighbor lists of the leaf containers, the adjacency is stored as one
+ * flat array of leaf indices (see \ref getNeighborIndices), which is cheaper to
+ * traverse. The leaf data and the neighbors are computed in parallel (see \ref
+ * setNumberOfThreads), by joining the leaves sorted by key instead of looking up each
+ * of the 26 neighbor keys in the octree.
+ *
  * If used in academic work, please cite:
  *
  * - J. Papon, A. Abramov, M. Schoeler, F. Woergoetter
@@ -142,6 +151,56 @@ public:
   void
   addPointsFromInputCloud();
 
+  /** \brief Set the number of threads used by \ref addPointsFromInputCloud to compute
+   * the data and the neighbors of the leaves.
+   * \param[in] nr_threads the number of hardware threads to use (0 sets the value
+   * back to automatic) */
+  void
+  setNumberOfThreads(unsigned int nr_threads = 0);
+
+  /** \brief Get the number of threads used by \ref addPointsFromInputCloud. */
+  inline unsigned int
+  getNumberOfThreads() const
+  {
+    return (threads_);
+  }
+
+  /** \brief Set whether \ref addPointsFromInputCloud also fills the neighbor lists of
+   * the leaf containers (the default). Without them the neighbors are only available
+   * from \ref getNeighborIndices, which saves an allocation per neighbor.
+   * \param[in] store_container_neighbors whether to fill the neighbor lists */
+  inline void
+  setStoreContainerNeighbors(bool store_container_neighbors)
+  {
+    store_container_neighbors_ = store_container_neighbors;
+  }
+
+  /** \brief Get whether \ref addPointsFromInputCloud fills the neighbor lists of the
+   * leaf containers. */
+  inline bool
+  getStoreContainerNeighbors() const
+  {
+    return (store_container_neighbors_);
+  }
+
+  /** \brief Get the neighbors of all leaves, as indices into the leaf vector (see \ref
+   * at), one leaf after the other. The neighbors of leaf i are the ones in
+   * [getNeighborOffsets()[i], getNeighborOffsets()[i + 1]), in the same order as in the
+   * neighbor list of its container, the leaf itself included. */
+  inline const Indices&
+  getNeighborIndices() const
+  {
+    return (neighbor_indices_);
+  }
+
+  /** \brief Get the position of the neighbors of every leaf in \ref
+   * getNeighborIndices, followed by their total number. */
+  inline const std::vector<std::size_t>&
+  getNeighborOffsets() const
+  {
+    return (neighbor_offsets_);
+  }
+
   /** \brief Gets the leaf container for a given point.
    *
    * \param[in] point_arg Point to search for
@@ -155,6 +214,9 @@ public:
    * \warning This slows down rapidly as cloud size increases due to the number of
    * edges.
    *
+   * The edges are built from \ref getNeighborIndices, so the graph does not depend on
+   * \ref setStoreContainerNeighbors.
+   *
    * \param[out] voxel_adjacency_graph Boost Graph Library Adjacency graph of the voxel
    * touching relationships. Vertices are PointT, edges represent touching, and edge
    * lengths are the distance between the points. */
@@ -205,6 +267,30 @@ protected:
   void
   computeNeighbors(OctreeKey& key_arg, LeafContainerT* leaf_container);
 
+  /** \brief A leaf key and the index of the leaf in the leaf vector */
+  using SortedLeaf = std::pair<OctreeKey, index_t>;
+
+  /** \brief Sorts the leaves by key and computes the flat neighbor arrays of all
+   * leaves.
+   *
+   * \param[in] leaf_keys Keys of the leaves, in the order of the leaf vector */
+  void
+  computeNeighborIndices(const std::vector<OctreeKey>& leaf_keys);
+
+  /** \brief Finds the neighbors of a range of leaves with a merge join of the leaves
+   * sorted by key.
+   *
+   * \param[in] sorted_leaves All leaves, sorted by x, then y, then z
+   * \param[in] begin First leaf in sorted_leaves to find the neighbors of
+   * \param[in] end Past the last leaf in sorted_leaves to find the neighbors of
+   * \param[in] count_only Only count the neighbors into the offsets (first pass), or
+   * write them to their position (second pass) */
+  void
+  joinNeighbors(const std::vector<SortedLeaf>& sorted_leaves,
+                std::size_t begin,
+                std::size_t end,
+                bool count_only);
+
   /** \brief Generates octree key for specified point (uses transform if provided).
    *
    * \param[in] point_arg Point to generate key for
@@ -237,6 +323,18 @@ private:
   LeafVectorT leaf_vector_;
 
   std::function<void(PointT& p)> transform_func_;
+
+  /// Neighbors of all leaves as indices into leaf_vector_, see getNeighborIndices().
+  Indices neighbor_indices_;
+
+  /// Position of the neighbors of every leaf in neighbor_indices_.
+  std::vector<std::size_t> neighbor_offsets_;
+
+  /// Whether addPointsFromInputCloud() fills the neighbor lists of the containers.
+  bool store_container_neighbors_;
+
+  /// The number of threads used by addPointsFromInputCloud().
+  unsigned int threads_;
 };
 
 } // namespace octree
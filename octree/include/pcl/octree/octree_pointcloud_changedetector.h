@@ -40,8 +40,12 @@
 
 #include <pcl/octree/octree2buf_base.h>
 #include <pcl/octree/octree_pointcloud.h>
+#include <pcl/octree/octree_search.h>
 #include <pcl/memory.h>
 
+#include <memory>
+#include <vector>
+
 namespace pcl {
 namespace octree {
 
@@ -106,6 +110,200 @@ public:
     return (indicesVector_arg.size());
   }
 };
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/** \brief @b Octree pointcloud change detector for point cloud streams
+ *  \note Every frame of the stream is stored in its own linear octree (see
+ * OctreePointCloudSearch::buildLinearOctree), which is built in parallel and never
+ * modified once published. A new frame can thus be built while the previous ones are
+ * still searched by other threads, and the published frames are swapped atomically,
+ * without locks on the reading side. The leaves that are new in the current frame are
+ * found by walking the linear octrees of the current and the previous frame together.
+ *  \note All frames share the bounding box given to defineBoundingBox (), points
+ * outside of it are ignored.
+ * \tparam PointT type of point used in pointcloud
+ * \ingroup octree
+ */
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT>
+class OctreePointCloudStreamChangeDetector {
+public:
+  using Ptr = shared_ptr<OctreePointCloudStreamChangeDetector<PointT>>;
+  using ConstPtr = shared_ptr<const OctreePointCloudStreamChangeDetector<PointT>>;
+
+  using OctreeT = OctreePointCloudSearch<PointT>;
+  using OctreePtr = typename OctreeT::Ptr;
+  using PointCloudConstPtr = typename OctreeT::PointCloudConstPtr;
+  using IndicesPtr = typename OctreeT::IndicesPtr;
+
+  /** \brief Constructor.
+   *  \param resolution_arg:  octree resolution at lowest octree level
+   * */
+  OctreePointCloudStreamChangeDetector(const double resolution_arg)
+  : resolution_(resolution_arg)
+  , threads_(1)
+  , min_pt_(Eigen::Vector3d::Zero())
+  , max_pt_(Eigen::Vector3d::Zero())
+  , bounding_box_defined_(false)
+  , frames_(std::make_shared<const Frames>())
+  {}
+
+  /** \brief Define the bounding box shared by the octrees of all frames. Has to be
+   * called before the first frame is built.
+   * \param[in] min_pt lower corner of the bounding box
+   * \param[in] max_pt upper corner of the bounding box
+   */
+  void
+  defineBoundingBox(const Eigen::Vector3d& min_pt, const Eigen::Vector3d& max_pt)
+  {
+    min_pt_ = min_pt;
+    max_pt_ = max_pt;
+    bounding_box_defined_ = true;
+  }
+
+  /** \brief Set the number of threads used to build the octree of a frame.
+   * \param[in] nr_threads the number of hardware threads to use (0 sets the value
+   * back to automatic)
+   */
+  inline void
+  setNumberOfThreads(unsigned int nr_threads = 0)
+  {
+    threads_ = nr_threads;
+  }
+
+  /** \brief Build the octree of a frame, without publishing it. This does not touch
+   * the published frames, so it can run while they are searched.
+   * \param[in] cloud the point cloud of the frame
+   * \return the octree of the frame, or a null pointer if no bounding box is defined
+   */
+  OctreePtr
+  buildFrame(const PointCloudConstPtr& cloud) const
+  {
+    if (!bounding_box_defined_) {
+      PCL_ERROR("[pcl::octree::OctreePointCloudStreamChangeDetector::buildFrame] No "
+                "bounding box defined, call defineBoundingBox () first!\n");
+      return (OctreePtr());
+    }
+
+    OctreePtr octree(new OctreeT(resolution_));
+    octree->setNumberOfThreads(threads_);
+    octree->defineBoundingBox(min_pt_.x(),
+                              min_pt_.y(),
+                              min_pt_.z(),
+                              max_pt_.x(),
+                              max_pt_.y(),
+                              max_pt_.z());
+
+    // keep the points within the bounding box, so that all frames share it
+    double min_x, min_y, min_z, max_x, max_y, max_z;
+    octree->getBoundingBox(min_x, min_y, min_z, max_x, max_y, max_z);
+    IndicesPtr indices(new std::vector<int>);
+    indices->reserve(cloud->size());
+    for (std::size_t i = 0; i < cloud->size(); ++i) {
+      const PointT& point = (*cloud)[i];
+      if (point.x >= min_x && point.y >= min_y && point.z >= min_z &&
+          point.x < max_x && point.y < max_y && point.z < max_z)
+        indices->push_back(static_cast<int>(i));
+    }
+
+    octree->setInputCloud(cloud, indices);
+    octree->buildLinearOctree();
+    return (octree);
+  }
+
+  /** \brief Publish the octree of a frame, it becomes the current frame and the
+   * current frame becomes the previous one.
+   * \param[in] frame the octree of the frame, as returned by buildFrame ()
+   */
+  void
+  publishFrame(const OctreePtr& frame)
+  {
+    std::shared_ptr<const Frames> frames = std::atomic_load(&frames_);
+    std::shared_ptr<const Frames> next_frames;
+    do {
+      next_frames = std::make_shared<const Frames>(Frames{frames->current, frame});
+    } while (!std::atomic_compare_exchange_weak(&frames_, &frames, next_frames));
+  }
+
+  /** \brief Build the octree of a frame and publish it.
+   * \param[in] cloud the point cloud of the frame
+   */
+  inline void
+  addFrame(const PointCloudConstPtr& cloud)
+  {
+    OctreePtr frame = buildFrame(cloud);
+    if (frame)
+      publishFrame(frame);
+  }
+
+  /** \brief Get the octree of the current frame. It stays valid, and is not modified,
+   * while the returned pointer is held. */
+  inline OctreePtr
+  getCurrentFrame() const
+  {
+    return (std::atomic_load(&frames_)->current);
+  }
+
+  /** \brief Get the octree of the previous frame. */
+  inline OctreePtr
+  getPreviousFrame() const
+  {
+    return (std::atomic_load(&frames_)->previous);
+  }
+
+  /** \brief Get the indices of the points of the current frame in all leaf nodes
+   * that did not exist in the previous frame.
+   * \param indicesVector_arg: results are written to this vector of int indices
+   * \param minPointsPerLeaf_arg: minimum amount of points required within leaf node to
+   * become serialized.
+   * \return number of point indices
+   */
+  std::size_t
+  getPointIndicesFromNewVoxels(std::vector<int>& indicesVector_arg,
+                               const int minPointsPerLeaf_arg = 0) const
+  {
+    // both frames are read from one consistent snapshot
+    const std::shared_ptr<const Frames> frames = std::atomic_load(&frames_);
+    if (!frames->current)
+      return (indicesVector_arg.size());
+    if (!frames->previous) {
+      // all voxels of the first frame are new
+      OctreeT empty(resolution_);
+      empty.defineBoundingBox(
+          min_pt_.x(), min_pt_.y(), min_pt_.z(), max_pt_.x(), max_pt_.y(), max_pt_.z());
+      empty.setInputCloud(frames->current->getInputCloud(), IndicesPtr(new std::vector<int>));
+      empty.buildLinearOctree();
+      return (frames->current->getPointIndicesFromNewVoxels(
+          empty, indicesVector_arg, minPointsPerLeaf_arg));
+    }
+    return (frames->current->getPointIndicesFromNewVoxels(
+        *frames->previous, indicesVector_arg, minPointsPerLeaf_arg));
+  }
+
+protected:
+  /** \brief The published frames, swapped as a whole. */
+  struct Frames {
+    OctreePtr previous;
+    OctreePtr current;
+  };
+
+  /** \brief Octree resolution at lowest octree level. */
+  double resolution_;
+
+  /** \brief The number of threads used to build the octree of a frame. */
+  unsigned int threads_;
+
+  /** \brief The bounding box shared by all frames. */
+  Eigen::Vector3d min_pt_;
+  Eigen::Vector3d max_pt_;
+  bool bounding_box_defined_;
+
+  /** \brief The previous and the current frame. */
+  std::shared_ptr<const Frames> frames_;
+
+public:
+  PCL_MAKE_ALIGNED_OPERATOR_NEW
+};
 } // namespace octree
 } // namespace pcl
 
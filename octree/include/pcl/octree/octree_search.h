@@ -41,12 +41,21 @@
 #include <pcl/octree/octree_pointcloud.h>
 #include <pcl/point_cloud.h>
 
+#include <cstdint>
+#include <utility>
+#include <vector>
+
 namespace pcl {
 namespace octree {
 
 /** \brief @b Octree pointcloud search class
  * \note This class provides several methods for spatial neighbor search based on octree
  * structure
+ *
+ * Besides the pointer based octree of @ref OctreePointCloud, the search methods can
+ * run on a linear octree built with \ref buildLinearOctree. Its nodes are stored
+ * in a single array, and the point indices of every node form a contiguous range of
+ * an index array sorted by Morton code.
  * \tparam PointT type of point used in pointcloud
  * \ingroup octree
  * \author Julius Kammerl (julius@kammerl.de)
@@ -82,9 +91,89 @@ public:
    * \param[in] resolution octree resolution at lowest octree level
    */
   OctreePointCloudSearch(const double resolution)
-  : OctreePointCloud<PointT, LeafContainerT, BranchContainerT>(resolution)
+  : OctreePointCloud<PointT, LeafContainerT, BranchContainerT>(resolution), threads_(1)
   {}
 
+  /** \brief Build a linear octree from the input cloud, a bulk alternative to
+   * \ref addPointsFromInputCloud.
+   *
+   * The Morton codes of the leaf voxel keys of all (finite) input points are computed
+   * in parallel and radix sorted. The nodes are then emitted bottom-up into a single
+   * array, level by level from the root, where the children of every node are stored
+   * next to each other. The search methods of this class run on the linear octree
+   * from then on, with the same results as on the pointer based octree. The linear
+   * octree is deleted by \ref setInputCloud and \ref deleteTree. Adding points
+   * moves all points to the pointer based octree and deletes the linear octree.
+   * \note The pointer based octree is left empty, so the methods of @ref
+   * OctreePointCloud working on it (iterators, isVoxelOccupiedAtPoint, ...) do not see
+   * the points. Dynamic depth is not supported, all leaves are at the maximum depth.
+   * \note The linear octree supports depths up to 21, for finer resolutions the
+   * pointer based octree is built instead.
+   */
+  void
+  buildLinearOctree();
+
+  /** \brief Check whether the search methods run on a linear octree, see \ref
+   * buildLinearOctree. */
+  inline bool
+  isLinearOctree() const
+  {
+    return (!linear_nodes_.empty());
+  }
+
+  /** \brief Get the indices of the points in all leaves that do not exist in a
+   * previous linear octree. Both octrees have to be linear octrees with the same
+   * bounding box and depth, as built by \ref buildLinearOctree on two frames of a
+   * stream. The two trees are walked together, and the points of a branch that is
+   * missing in the previous octree are appended as one contiguous range.
+   * \param[in] previous the linear octree of the previous frame
+   * \param[out] indices the point indices are appended to this vector
+   * \param[in] min_points_per_leaf minimum amount of points required within a leaf
+   * for its points to be returned
+   * \return the size of indices
+   */
+  std::size_t
+  getPointIndicesFromNewVoxels(const OctreePointCloudSearch& previous,
+                               std::vector<int>& indices,
+                               int min_points_per_leaf = 0) const;
+
+  /** \brief Provide a pointer to the input data set. A linear octree built on the
+   * previous input is deleted.
+   * \param[in] cloud_arg the const boost shared pointer to a PointCloud message
+   * \param[in] indices_arg the point indices subset that is to be used from \a cloud -
+   * if 0 the whole point cloud is used
+   */
+  void
+  setInputCloud(const PointCloudConstPtr& cloud_arg,
+                const IndicesConstPtr& indices_arg = IndicesConstPtr()) override
+  {
+    deleteLinearOctree();
+    OctreeT::setInputCloud(cloud_arg, indices_arg);
+  }
+
+  /** \brief Delete the octree structure, linear or pointer based. */
+  void
+  deleteTree() override
+  {
+    deleteLinearOctree();
+    OctreeT::deleteTree();
+  }
+
+  /** \brief Set the number of threads used by \ref buildLinearOctree, the batch
+   * ray casting methods and the frustum searches on the linear octree.
+   * \param[in] nr_threads the number of hardware threads to use (0 sets the value
+   * back to automatic)
+   */
+  void
+  setNumberOfThreads(unsigned int nr_threads = 0);
+
+  /** \brief Get the number of threads used by \ref buildLinearOctree. */
+  inline unsigned int
+  getNumberOfThreads() const
+  {
+    return (threads_);
+  }
+
   /** \brief Search for neighbors within a voxel at given point
    * \param[in] point point addressing a leaf node voxel
    * \param[out] point_idx_data the resultant indices of the neighboring voxel points
@@ -273,6 +362,39 @@ public:
                              std::vector<int>& k_indices,
                              int max_voxel_count = 0) const;
 
+  /** \brief Get the centers of all voxels that are intersected by each of a batch of
+   * rays, see \ref getIntersectedVoxelCenters. The rays are traced in parallel (see
+   * \ref setNumberOfThreads), grouped by direction so that the rays traced one after
+   * the other by a thread visit the same branches.
+   * \param[in] origins ray origins
+   * \param[in] directions ray direction vectors, one per origin
+   * \param[out] voxel_center_lists the voxel centers intersected by each ray
+   * \param[in] max_voxel_count stop raycasting a ray when this many voxels intersected
+   * (0: disable)
+   * \return total number of intersected voxels
+   */
+  int
+  getIntersectedVoxelCentersBatch(const std::vector<Eigen::Vector3f>& origins,
+                                  const std::vector<Eigen::Vector3f>& directions,
+                                  std::vector<AlignedPointTVector>& voxel_center_lists,
+                                  int max_voxel_count = 0) const;
+
+  /** \brief Get the indices of all voxels that are intersected by each of a batch of
+   * rays, see \ref getIntersectedVoxelIndices and \ref
+   * getIntersectedVoxelCentersBatch.
+   * \param[in] origins ray origins
+   * \param[in] directions ray direction vectors, one per origin
+   * \param[out] k_indices the point indices of the voxels intersected by each ray
+   * \param[in] max_voxel_count stop raycasting a ray when this many voxels intersected
+   * (0: disable)
+   * \return total number of intersected voxels
+   */
+  int
+  getIntersectedVoxelIndicesBatch(const std::vector<Eigen::Vector3f>& origins,
+                                  const std::vector<Eigen::Vector3f>& directions,
+                                  std::vector<std::vector<int>>& k_indices,
+                                  int max_voxel_count = 0) const;
+
   /** \brief Search for points within rectangular search area
    * Points exactly on the edges of the search rectangle are included.
    * \param[in] min_pt lower corner of search area
@@ -285,6 +407,71 @@ public:
             const Eigen::Vector3f& max_pt,
             std::vector<int>& k_indices) const;
 
+  /** \brief Range [first, second) of positions in the point indices of the linear
+   * octree, see \ref getLinearIndices. */
+  using IndexRange = std::pair<std::uint32_t, std::uint32_t>;
+
+  /** \brief Get the point indices of the linear octree, sorted by the Morton code of
+   * their leaf. The ranges returned by \ref frustumSearch and \ref frustumSearchLOD
+   * are positions in this vector. */
+  inline const std::vector<int>&
+  getLinearIndices() const
+  {
+    return (linear_indices_);
+  }
+
+  /** \brief Search for the points inside a convex region bounded by planes, such as
+   * a view frustum, on the linear octree.
+   * A point p is inside if planes[i].dot (p, 1) >= 0 for all planes, as the planes
+   * computed by pcl::visualization::getViewFrustum. Subtrees completely inside the
+   * region are accepted and subtrees completely outside of one plane are rejected at
+   * once, only the points of leaves crossing a plane are tested. The subtrees below
+   * the first levels of the octree are traversed in parallel, see \ref
+   * setNumberOfThreads.
+   * \param[in] planes the planes bounding the region
+   * \param[out] ranges ranges of the points inside the region in \ref
+   * getLinearIndices, in increasing order and without adjacent ranges
+   * \return number of points found within the region
+   */
+  std::size_t
+  frustumSearch(const std::vector<Eigen::Vector4f>& planes,
+                std::vector<IndexRange>& ranges) const;
+
+  /** \brief Search for the points inside a convex region bounded by planes, such as
+   * a view frustum. See the overload returning index ranges, which is used on the
+   * linear octree. On the pointer based octree the traversal is sequential.
+   * \param[in] planes the planes bounding the region
+   * \param[out] k_indices the resultant point indices
+   * \return number of points found within the region
+   */
+  int
+  frustumSearch(const std::vector<Eigen::Vector4f>& planes,
+                std::vector<int>& k_indices) const;
+
+  /** \brief Level of detail search for the points inside a view frustum on the linear
+   * octree, for rendering or simulating a sensor with a given angular resolution.
+   * The traversal of \ref frustumSearch stops at the nodes whose voxel edge projects
+   * to at most max_pixel_size pixels, i.e. focal_length * edge <= max_pixel_size *
+   * distance, where distance is the distance of the voxel to the eye. Such a node is
+   * represented by its first point, a range of length one; the leaves which are
+   * still larger than max_pixel_size return all their points inside the frustum.
+   * \param[in] planes the planes bounding the frustum
+   * \param[in] eye the position of the camera
+   * \param[in] focal_length focal length in pixels, the image height divided by
+   * 2 * tan (vertical field of view / 2)
+   * \param[in] max_pixel_size the screen space error in pixels up to which the
+   * points of a node are merged
+   * \param[out] ranges ranges of the selected points in \ref getLinearIndices, in
+   * increasing order and without adjacent ranges
+   * \return number of points selected
+   */
+  std::size_t
+  frustumSearchLOD(const std::vector<Eigen::Vector4f>& planes,
+                   const Eigen::Vector3f& eye,
+                   float focal_length,
+                   float max_pixel_size,
+                   std::vector<IndexRange>& ranges) const;
+
 protected:
   //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   // Octree-based search routines & helpers
@@ -361,6 +548,101 @@ protected:
     float point_distance_;
   };
 
+  /** \brief Add a point to the pointer based octree. If the octree is a linear
+   * octree, its points are first added to the pointer based octree, in the order of
+   * the input cloud, and the linear octree is deleted.
+   * \param[in] point_idx_arg the index representing the point in the dataset given by
+   * \a setInputCloud to be added
+   */
+  void
+  addPointIdx(const int point_idx_arg) override;
+
+  /** \brief Delete the linear octree, the searches run on the pointer based octree
+   * again. */
+  inline void
+  deleteLinearOctree()
+  {
+    linear_nodes_.clear();
+    linear_indices_.clear();
+  }
+
+  /** \brief @b Node of the linear octree. */
+  struct LinearNode {
+    /** \brief Index of the first child in linear_nodes_. The children of a node are
+     * stored consecutively, in increasing order of their child index. */
+    std::uint32_t first_child;
+
+    /** \brief Range of the points of the node in linear_indices_. */
+    std::uint32_t points_begin;
+    std::uint32_t points_end;
+
+    /** \brief Bit i is set if the node has child i. */
+    std::uint8_t child_mask;
+  };
+
+  /** \brief Recursively collect the points of the leaves of a linear octree node
+   * that do not exist in a previous linear octree.
+   * \param[in] previous the linear octree of the previous frame
+   * \param[in] previous_node the matching node of the previous octree, -1 if it does
+   * not exist
+   * \param[in] node the node of this octree
+   * \param[in] tree_depth the depth of the node
+   * \param[out] indices the point indices are appended to this vector
+   * \param[in] min_points_per_leaf minimum amount of points required within a leaf
+   */
+  void
+  getNewVoxelPointsLinear(const OctreePointCloudSearch& previous,
+                          std::int64_t previous_node,
+                          std::uint32_t node,
+                          unsigned int tree_depth,
+                          std::vector<int>& indices,
+                          int min_points_per_leaf) const;
+
+  /** \brief Order a batch of rays by direction octant, and within an octant by their
+   * quantized direction, so that consecutive rays traverse similar branches.
+   * \param[in] directions ray direction vectors
+   * \param[out] order the ray indices in traversal order
+   */
+  static void
+  getCoherentRayOrder(const std::vector<Eigen::Vector3f>& directions,
+                      std::vector<std::size_t>& order);
+
+  /** \brief Interleave the bits of an octree key into a Morton code, with the x bit
+   * of every level first as in the child indices.
+   * \param[in] key the octree key, with at most 21 bits per coordinate
+   * \return the Morton code
+   */
+  static inline std::uint64_t
+  getMortonCode(const OctreeKey& key)
+  {
+    const auto spread = [](std::uint64_t v) {
+      v &= 0x1fffff;
+      v = (v | v << 32) & 0x1f00000000ffffULL;
+      v = (v | v << 16) & 0x1f0000ff0000ffULL;
+      v = (v | v << 8) & 0x100f00f00f00f00fULL;
+      v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+      v = (v | v << 2) & 0x1249249249249249ULL;
+      return v;
+    };
+    return ((spread(key.x) << 2) | (spread(key.y) << 1) | spread(key.z));
+  }
+
+  /** \brief Get the position of a child of a linear octree node.
+   * \param[in] node the linear octree node
+   * \param[in] child_idx the child index
+   * \return the index of the child in linear_nodes_, or -1 if it does not exist
+   */
+  inline std::int64_t
+  getLinearChild(const LinearNode& node, unsigned char child_idx) const
+  {
+    if (!(node.child_mask & (1 << child_idx)))
+      return (-1);
+    int rank = 0;
+    for (unsigned char i = 0; i < child_idx; ++i)
+      rank += (node.child_mask >> i) & 1;
+    return (node.first_child + rank);
+  }
+
   /** \brief Helper function to calculate the squared distance between two points
    * \param[in] point_a point A
    * \param[in] point_b point B
@@ -479,6 +761,235 @@ protected:
                      unsigned int tree_depth,
                      std::vector<int>& k_indices) const;
 
+  /** \brief getKNearestNeighborRecursive on the linear octree.
+   * \param[in] point query point
+   * \param[in] K amount of nearest neighbors to be found
+   * \param[in] node index of the current node in linear_nodes_
+   * \param[in] key octree key addressing a leaf node.
+   * \param[in] tree_depth current depth/level in the octree
+   * \param[in] squared_search_radius squared search radius distance
+   * \param[out] point_candidates priority queue of nearest neigbor point candidates
+   * \return squared search radius based on current point candidate set found
+   */
+  double
+  getKNearestNeighborLinear(const PointT& point,
+                            unsigned int K,
+                            std::uint32_t node,
+                            const OctreeKey& key,
+                            unsigned int tree_depth,
+                            const double squared_search_radius,
+                            std::vector<prioPointQueueEntry>& point_candidates) const;
+
+  /** \brief getNeighborsWithinRadiusRecursive on the linear octree.
+   * \param[in] point query point
+   * \param[in] radiusSquared squared search radius
+   * \param[in] node index of the current node in linear_nodes_
+   * \param[in] key octree key addressing a leaf node.
+   * \param[in] tree_depth current depth/level in the octree
+   * \param[out] k_indices vector of indices found to be neighbors of query point
+   * \param[out] k_sqr_distances squared distances of neighbors to query point
+   * \param[in] max_nn maximum of neighbors to be found
+   */
+  void
+  getNeighborsWithinRadiusLinear(const PointT& point,
+                                 const double radiusSquared,
+                                 std::uint32_t node,
+                                 const OctreeKey& key,
+                                 unsigned int tree_depth,
+                                 std::vector<int>& k_indices,
+                                 std::vector<float>& k_sqr_distances,
+                                 unsigned int max_nn) const;
+
+  /** \brief approxNearestSearchRecursive on the linear octree.
+   * \param[in] point query point
+   * \param[in] node index of the current node in linear_nodes_
+   * \param[in] key octree key addressing a leaf node.
+   * \param[in] tree_depth current depth/level in the octree
+   * \param[out] result_index result index is written to this reference
+   * \param[out] sqr_distance squared distance to search
+   */
+  void
+  approxNearestSearchLinear(const PointT& point,
+                            std::uint32_t node,
+                            const OctreeKey& key,
+                            unsigned int tree_depth,
+                            int& result_index,
+                            float& sqr_distance) const;
+
+  /** \brief boxSearchRecursive on the linear octree.
+   * \param[in] min_pt lower corner of search area
+   * \param[in] max_pt upper corner of search area
+   * \param[in] node index of the current node in linear_nodes_
+   * \param[in] key octree key addressing a leaf node.
+   * \param[in] tree_depth current depth/level in the octree
+   * \param[out] k_indices the resultant point indices
+   */
+  void
+  boxSearchLinear(const Eigen::Vector3f& min_pt,
+                  const Eigen::Vector3f& max_pt,
+                  std::uint32_t node,
+                  const OctreeKey& key,
+                  unsigned int tree_depth,
+                  std::vector<int>& k_indices) const;
+
+  /** \brief Subtree of the linear octree traversed by one thread of \ref
+   * frustumSearch. */
+  struct FrustumTask {
+    std::uint32_t node;
+    OctreeKey key;
+    unsigned int tree_depth;
+  };
+
+  /** \brief Test an axis aligned box against the planes of a frustum search.
+   * \param[in] planes the planes bounding the search region
+   * \param[in] min_pt lower corner of the box
+   * \param[in] max_pt upper corner of the box
+   * \return 0 if the box is inside of all planes, 2 if it is completely outside of
+   * one plane, 1 otherwise
+   */
+  static int
+  intersectPlanes(const std::vector<Eigen::Vector4f>& planes,
+                  const Eigen::Vector3f& min_pt,
+                  const Eigen::Vector3f& max_pt);
+
+  /** \brief Test a point against the planes of a frustum search.
+   * \param[in] planes the planes bounding the search region
+   * \param[in] point the point to test
+   * \return true if the point is inside of all planes
+   */
+  static bool
+  isInsidePlanes(const std::vector<Eigen::Vector4f>& planes, const PointT& point);
+
+  /** \brief Check whether a node of a level of detail search is small enough on
+   * screen to stop the traversal.
+   * \param[in] eye the position of the camera
+   * \param[in] focal_length focal length in pixels
+   * \param[in] max_pixel_size the screen space error in pixels
+   * \param[in] min_pt lower corner of the voxel
+   * \param[in] max_pt upper corner of the voxel
+   */
+  static bool
+  isBelowScreenSpaceError(const Eigen::Vector3f& eye,
+                          float focal_length,
+                          float max_pixel_size,
+                          const Eigen::Vector3f& min_pt,
+                          const Eigen::Vector3f& max_pt);
+
+  /** \brief Collect the subtrees of a frustum search down to split_depth, rejecting
+   * the nodes outside of the region on the way.
+   * \param[in] planes the planes bounding the search region
+   * \param[in] eye the position of the camera, nullptr if no level of detail is used
+   * \param[in] focal_length focal length in pixels
+   * \param[in] max_pixel_size the screen space error in pixels
+   * \param[in] task the current subtree
+   * \param[in] split_depth depth of the subtrees traversed in parallel
+   * \param[out] tasks the subtrees, in Morton order
+   */
+  void
+  getFrustumTasks(const std::vector<Eigen::Vector4f>& planes,
+                  const Eigen::Vector3f* eye,
+                  float focal_length,
+                  float max_pixel_size,
+                  const FrustumTask& task,
+                  unsigned int split_depth,
+                  std::vector<FrustumTask>& tasks) const;
+
+  /** \brief Frustum and level of detail search on a subtree of the linear octree.
+   * \param[in] planes the planes bounding the search region
+   * \param[in] eye the position of the camera, nullptr if no level of detail is used
+   * \param[in] focal_length focal length in pixels
+   * \param[in] max_pixel_size the screen space error in pixels
+   * \param[in] task the current subtree
+   * \param[in] inside true if the subtree is known to be inside of all planes
+   * \param[out] ranges the ranges of the selected points are appended to this vector
+   */
+  void
+  frustumSearchLinear(const std::vector<Eigen::Vector4f>& planes,
+                      const Eigen::Vector3f* eye,
+                      float focal_length,
+                      float max_pixel_size,
+                      const FrustumTask& task,
+                      bool inside,
+                      std::vector<IndexRange>& ranges) const;
+
+  /** \brief Frustum and level of detail search on the linear octree, with the
+   * subtrees below split_depth traversed in parallel.
+   * \param[in] planes the planes bounding the search region
+   * \param[in] eye the position of the camera, nullptr if no level of detail is used
+   * \param[in] focal_length focal length in pixels
+   * \param[in] max_pixel_size the screen space error in pixels
+   * \param[out] ranges ranges of the selected points in linear_indices_
+   * \return number of points selected
+   */
+  std::size_t
+  frustumSearchParallel(const std::vector<Eigen::Vector4f>& planes,
+                        const Eigen::Vector3f* eye,
+                        float focal_length,
+                        float max_pixel_size,
+                        std::vector<IndexRange>& ranges) const;
+
+  /** \brief Frustum search on the pointer based octree.
+   * \param[in] planes the planes bounding the search region
+   * \param[in] node current octree node to be explored
+   * \param[in] key octree key addressing the current node
+   * \param[in] tree_depth current depth/level in the octree
+   * \param[in] inside true if the node is known to be inside of all planes
+   * \param[out] k_indices the resultant point indices
+   */
+  void
+  frustumSearchRecursive(const std::vector<Eigen::Vector4f>& planes,
+                         const OctreeNode* node,
+                         const OctreeKey& key,
+                         unsigned int tree_depth,
+                         bool inside,
+                         std::vector<int>& k_indices) const;
+
+  /** \brief Append a range to the result of a frustum search, merging it with the
+   * last range if they are adjacent.
+   * \param[in] begin first position of the range
+   * \param[in] end position past the end of the range
+   * \param[in,out] ranges the ranges of the search
+   */
+  static inline void
+  appendRange(std::uint32_t begin, std::uint32_t end, std::vector<IndexRange>& ranges)
+  {
+    if (!ranges.empty() && ranges.back().second == begin)
+      ranges.back().second = end;
+    else
+      ranges.emplace_back(begin, end);
+  }
+
+  /** \brief Ray traversal of getIntersectedVoxelCentersRecursive and
+   * getIntersectedVoxelIndicesRecursive on the linear octree.
+   * \param[in] min_x octree nodes X coordinate of lower bounding box corner
+   * \param[in] min_y octree nodes Y coordinate of lower bounding box corner
+   * \param[in] min_z octree nodes Z coordinate of lower bounding box corner
+   * \param[in] max_x octree nodes X coordinate of upper bounding box corner
+   * \param[in] max_y octree nodes Y coordinate of upper bounding box corner
+   * \param[in] max_z octree nodes Z coordinate of upper bounding box corner
+   * \param[in] a voxel child index remapping of the ray direction
+   * \param[in] node index of the current node in linear_nodes_
+   * \param[in] key octree key addressing a leaf node.
+   * \param[in] tree_depth current depth/level in the octree
+   * \param[out] leaves index and key of the intersected leaf nodes, in ray order
+   * \param[in] max_voxel_count stop raycasting when this many voxels intersected (0:
+   * disable)
+   * \return number of voxels found
+   */
+  int
+  getIntersectedVoxelsLinear(double min_x,
+                             double min_y,
+                             double min_z,
+                             double max_x,
+                             double max_y,
+                             double max_z,
+                             unsigned char a,
+                             std::uint32_t node,
+                             const OctreeKey& key,
+                             unsigned int tree_depth,
+                             std::vector<std::pair<std::uint32_t, OctreeKey>>& leaves,
+                             int max_voxel_count) const;
+
   /** \brief Recursively search the tree for all intersected leaf nodes and return a
    * vector of indices. This algorithm is based off the paper An Efficient Parametric
    * Algorithm for Octree Traversal: http://wscg.zcu.cz/wscg2000/Papers_2000/X31.pdf
@@ -649,6 +1160,17 @@ protected:
       return b;
     return c;
   }
+
+  /** \brief Nodes of the linear octree, the root first, then level by level. Empty if
+   * the searches run on the pointer based octree. */
+  std::vector<LinearNode> linear_nodes_;
+
+  /** \brief Point indices of the linear octree, sorted by the Morton code of their
+   * leaf. Within a leaf they keep the order of the input. */
+  std::vector<int> linear_indices_;
+
+  /** \brief The number of threads used by buildLinearOctree. */
+  unsigned int threads_;
 };
 } // namespace octree
 } // namespace pcl
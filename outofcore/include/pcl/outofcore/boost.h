@@ -44,3 +44,4 @@
 
 #include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
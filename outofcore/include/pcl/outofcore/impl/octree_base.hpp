@@ -48,13 +48,24 @@
 
 #include <pcl/filters/random_sample.h>
 #include <pcl/filters/extract_indices.h>
+#include <pcl/io/pcd_io.h>
 
 // C++
+#include <algorithm>
+#include <cstdio>
+#include <deque>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <exception>
+#include <map>
+#include <memory>
+#include <numeric>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace pcl
 {
@@ -80,6 +91,8 @@ namespace pcl
       , metadata_ (new OutofcoreOctreeBaseMetadata ())
       , sample_percent_ (0.125)
       , lod_filter_ptr_ (new pcl::RandomSample<pcl::PCLPointCloud2> ())
+      , threads_ (1)
+      , bulk_load_partition_size_ (1 << 22)
     {
       //validate the root filename
       if (!this->checkExtension (root_name))
@@ -108,6 +121,8 @@ namespace pcl
       , metadata_ (new OutofcoreOctreeBaseMetadata ())
       , sample_percent_ (0.125)
       , lod_filter_ptr_ (new pcl::RandomSample<pcl::PCLPointCloud2> ())
+      , threads_ (1)
+      , bulk_load_partition_size_ (1 << 22)
     {
       //Enlarge the bounding box to a cube so our voxels will be cubes
       Eigen::Vector3d tmp_min = min;
@@ -130,6 +145,8 @@ namespace pcl
       , metadata_ (new OutofcoreOctreeBaseMetadata ())
       , sample_percent_ (0.125)
       , lod_filter_ptr_ (new pcl::RandomSample<pcl::PCLPointCloud2> ())
+      , threads_ (1)
+      , bulk_load_partition_size_ (1 << 22)
     {
       //Create a new outofcore tree
       this->init (max_depth, min, max, root_node_name, coord_sys);
@@ -208,6 +225,7 @@ namespace pcl
     OutofcoreOctreeBase<ContainerT, PointT>::addDataToLeaf (const AlignedPointTVector& p)
     {
       std::unique_lock < std::shared_timed_mutex > lock (read_write_mutex_);
+      invalidatePayloadCache ();
 
       const bool _FORCE_BB_CHECK = true;
       
@@ -231,6 +249,9 @@ namespace pcl
     template<typename ContainerT, typename PointT> std::uint64_t
     OutofcoreOctreeBase<ContainerT, PointT>::addPointCloud (pcl::PCLPointCloud2::Ptr &input_cloud, const bool skip_bb_check)
     {
+      // Lock the tree while writing
+      std::unique_lock < std::shared_timed_mutex > lock (read_write_mutex_);
+      invalidatePayloadCache ();
       std::uint64_t pt_added = this->root_node_->addPointCloud (input_cloud, skip_bb_check) ;
 //      assert (input_cloud->width*input_cloud->height == pt_added);
       return (pt_added);
@@ -244,6 +265,7 @@ namespace pcl
     {
       // Lock the tree while writing
       std::unique_lock < std::shared_timed_mutex > lock (read_write_mutex_);
+      invalidatePayloadCache ();
       std::uint64_t pt_added = root_node_->addDataToLeaf_and_genLOD (point_cloud->points, false);
       return (pt_added);
     }
@@ -255,6 +277,7 @@ namespace pcl
     {
       // Lock the tree while writing
       std::unique_lock < std::shared_timed_mutex > lock (read_write_mutex_);
+      invalidatePayloadCache ();
       std::uint64_t pt_added = root_node_->addPointCloud_and_genLOD (input_cloud);
       
       PCL_DEBUG ("[pcl::outofcore::OutofcoreOctreeBase::%s] Points added %lu, points in input cloud, %lu\n",__FUNCTION__, pt_added, input_cloud->width*input_cloud->height );
@@ -271,6 +294,7 @@ namespace pcl
     {
       // Lock the tree while writing
       std::unique_lock < std::shared_timed_mutex > lock (read_write_mutex_);
+      invalidatePayloadCache ();
       std::uint64_t pt_added = root_node_->addDataToLeaf_and_genLOD (src, false);
       return (pt_added);
     }
@@ -309,13 +333,156 @@ namespace pcl
 
     ////////////////////////////////////////////////////////////////////////////////
 
+    template<typename Container, typename PointT> void
+    OutofcoreOctreeBase<Container, PointT>::queryFrustum (const double *planes, const std::uint32_t query_depth, AlignedPointTVector& dst) const
+    {
+      std::shared_lock < std::shared_timed_mutex > lock (read_write_mutex_);
+      dst.clear ();
+
+      // collect the nodes in the frustum breadth first; nodes completely inside are not tested again
+      std::vector<OutofcoreNodeType*> nodes;
+      std::deque<std::pair<OutofcoreNodeType*, bool> > node_queue;
+      node_queue.emplace_back (root_node_, false);
+      while (!node_queue.empty ())
+      {
+        OutofcoreNodeType* node = node_queue.front ().first;
+        int result = node_queue.front ().second ? 0 : intersectFrustum (planes, *node);
+        node_queue.pop_front ();
+
+        if (result == 2)
+          continue;
+
+        if (node->getDepth () == query_depth)
+        {
+          if (node->size () > 0)
+            nodes.push_back (node);
+          continue;
+        }
+
+        if (node->hasUnloadedChildren ())
+          node->loadChildren (false);
+
+        for (std::size_t i = 0; i < 8; i++)
+        {
+          if (node->children_[i])
+            node_queue.emplace_back (node->children_[i], result == 0);
+        }
+      }
+
+      readNodePayloads (nodes, [&dst] (std::size_t, const AlignedPointTVector& payload)
+      {
+        dst.insert (dst.end (), payload.begin (), payload.end ());
+      });
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename Container, typename PointT> void
+    OutofcoreOctreeBase<Container, PointT>::queryFrustumLOD (const double *planes, const Eigen::Vector3d &eye, const double focal_length, const double max_pixel_size,
+                                                             AlignedPointTVector& dst, std::vector<std::pair<std::size_t, std::size_t> > &ranges) const
+    {
+      std::shared_lock < std::shared_timed_mutex > lock (read_write_mutex_);
+      dst.clear ();
+      ranges.clear ();
+
+      // select the nodes breadth first; nodes completely inside are not tested again
+      std::vector<OutofcoreNodeType*> nodes;
+      std::deque<std::pair<OutofcoreNodeType*, bool> > node_queue;
+      node_queue.emplace_back (root_node_, false);
+      while (!node_queue.empty ())
+      {
+        OutofcoreNodeType* node = node_queue.front ().first;
+        int result = node_queue.front ().second ? 0 : intersectFrustum (planes, *node);
+        node_queue.pop_front ();
+
+        if (result == 2)
+          continue;
+
+        if (node->hasUnloadedChildren ())
+          node->loadChildren (false);
+
+        // stop at the nodes whose edge is at most max_pixel_size pixels on screen
+        Eigen::Vector3d min_bb, max_bb;
+        node->getBoundingBox (min_bb, max_bb);
+        const double distance = (eye - eye.cwiseMax (min_bb).cwiseMin (max_bb)).norm ();
+        if (node->getNumChildren () == 0 || focal_length * (max_bb.x () - min_bb.x ()) <= max_pixel_size * distance)
+        {
+          if (node->size () > 0)
+            nodes.push_back (node);
+          continue;
+        }
+
+        for (std::size_t i = 0; i < 8; i++)
+        {
+          if (node->children_[i])
+            node_queue.emplace_back (node->children_[i], result == 0);
+        }
+      }
+
+      ranges.reserve (nodes.size ());
+      readNodePayloads (nodes, [&dst, &ranges] (std::size_t, const AlignedPointTVector& payload)
+      {
+        ranges.emplace_back (dst.size (), dst.size () + payload.size ());
+        dst.insert (dst.end (), payload.begin (), payload.end ());
+      });
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
     template<typename ContainerT, typename PointT> void
     OutofcoreOctreeBase<ContainerT, PointT>::queryBBIncludes (const Eigen::Vector3d& min, const Eigen::Vector3d& max, const std::uint64_t query_depth, AlignedPointTVector& dst) const
     {
       std::shared_lock < std::shared_timed_mutex > lock (read_write_mutex_);
       dst.clear ();
       PCL_DEBUG ("[pcl::outofcore::OutofcoreOctreeBaseNode] Querying Bounding Box %.2lf %.2lf %.2lf, %.2lf %.2lf %.2lf", min[0], min[1], min[2], max[0], max[1], max[2]);
-      root_node_->queryBBIncludes (min, max, query_depth, dst);
+      if (!async_reader_)
+      {
+        root_node_->queryBBIncludes (min, max, query_depth, dst);
+        return;
+      }
+
+      // collect the nodes at query_depth intersecting the bounding box breadth first, which
+      // visits them in the same order as the recursive query
+      std::vector<OutofcoreNodeType*> nodes;
+      std::deque<OutofcoreNodeType*> node_queue (1, root_node_);
+      while (!node_queue.empty ())
+      {
+        OutofcoreNodeType* node = node_queue.front ();
+        node_queue.pop_front ();
+
+        if (!node->intersectsWithBoundingBox (min, max))
+          continue;
+
+        if (node->getDepth () >= query_depth)
+        {
+          if (node->size () > 0)
+            nodes.push_back (node);
+          continue;
+        }
+
+        if (node->hasUnloadedChildren ())
+          node->loadChildren (false);
+
+        for (std::size_t i = 0; i < 8; i++)
+        {
+          if (node->children_[i])
+            node_queue.push_back (node->children_[i]);
+        }
+      }
+
+      readNodePayloads (nodes, [&] (std::size_t node_idx, const AlignedPointTVector& payload)
+      {
+        if (nodes[node_idx]->inBoundingBox (min, max))
+        {
+          dst.insert (dst.end (), payload.begin (), payload.end ());
+          return;
+        }
+        for (const PointT& p : payload)
+        {
+          if (OutofcoreNodeType::pointInBoundingBox (min, max, p))
+            dst.push_back (p);
+        }
+      });
     }
 
     ////////////////////////////////////////////////////////////////////////////////
@@ -568,6 +735,7 @@ namespace pcl
       }
 
       std::unique_lock < std::shared_timed_mutex > lock (read_write_mutex_);
+      invalidatePayloadCache ();
 
       const int number_of_nodes = 1;
 
@@ -696,6 +864,602 @@ namespace pcl
 
     ////////////////////////////////////////////////////////////////////////////////
 
+    template<typename ContainerT, typename PointT> void
+    OutofcoreOctreeBase<ContainerT, PointT>::setAsyncIO (unsigned int nr_threads, std::size_t cache_size, std::size_t read_ahead)
+    {
+      std::unique_lock < std::shared_timed_mutex > lock (read_write_mutex_);
+      async_reader_.reset ();
+      if (nr_threads > 0)
+        async_reader_.reset (new OutofcoreAsyncReader<PointT> (nr_threads, cache_size, read_ahead));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> void
+    OutofcoreOctreeBase<ContainerT, PointT>::invalidatePayloadCache ()
+    {
+      if (async_reader_)
+        async_reader_->getCache ().clear ();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> void
+    OutofcoreOctreeBase<ContainerT, PointT>::readNodePayloads (const std::vector<OutofcoreNodeType*>& nodes,
+                                                               const std::function<void (std::size_t, const AlignedPointTVector&)>& process) const
+    {
+      if (!async_reader_)
+      {
+        for (std::size_t i = 0; i < nodes.size (); i++)
+        {
+          AlignedPointTVector payload;
+          nodes[i]->payload_->readRange (0, nodes[i]->payload_->size (), payload);
+          process (i, payload);
+        }
+        return;
+      }
+
+      // keep up to read_ahead reads queued ahead of the node being processed; the payloads
+      // are identified by file and size, the writers drop the cache as a rewritten node can
+      // keep both
+      const std::size_t read_ahead = async_reader_->getMaxPending ();
+      std::deque<typename OutofcoreAsyncReader<PointT>::PayloadFuture> pending;
+      std::size_t next_request = 0;
+      for (std::size_t i = 0; i < nodes.size (); i++)
+      {
+        for (; next_request < nodes.size () && next_request <= i + read_ahead; next_request++)
+        {
+          OutofcoreNodeType* node = nodes[next_request];
+          const std::string key = node->getPCDFilename ().string () + ":" + std::to_string (node->size ());
+          pending.push_back (async_reader_->request (key, [node] (AlignedPointTVector& payload)
+          {
+            node->payload_->readRange (0, node->payload_->size (), payload);
+          }));
+        }
+
+        typename OutofcoreAsyncReader<PointT>::PayloadConstPtr payload;
+        try
+        {
+          payload = pending.front ().get ();
+        }
+        catch (...)
+        {
+          // the queued reads reference the nodes, let them finish before giving up the read lock
+          for (const auto &request : pending)
+            request.wait ();
+          throw;
+        }
+        pending.pop_front ();
+        process (i, *payload);
+      }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> int
+    OutofcoreOctreeBase<ContainerT, PointT>::intersectFrustum (const double *planes, const OutofcoreNodeType& node)
+    {
+      Eigen::Vector3d min_bb, max_bb;
+      node.getBoundingBox (min_bb, max_bb);
+      const Eigen::Vector3d center = (min_bb + max_bb) / 2.0;
+      const Eigen::Vector3d radius = (max_bb - min_bb).cwiseAbs () / 2.0;
+
+      // same basic view frustum culling as OutofcoreOctreeBaseNode::queryFrustum
+      int result = 0;
+      for (int i = 0; i < 6; i++)
+      {
+        const double a = planes[i*4], b = planes[i*4 + 1], c = planes[i*4 + 2], d = planes[i*4 + 3];
+        const double m = center.x () * a + center.y () * b + center.z () * c + d;
+        const double n = radius.x () * std::abs (a) + radius.y () * std::abs (b) + radius.z () * std::abs (c);
+
+        if (m + n < 0)
+          return (2);
+        if (m - n < 0)
+          result = 1;
+      }
+      return (result);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> std::uint64_t
+    OutofcoreOctreeBase<ContainerT, PointT>::bulkLoad (const std::vector<boost::filesystem::path>& pcd_files, const bool gen_lod)
+    {
+      std::size_t next_file = 0;
+      return (bulkLoadStream ([&pcd_files, &next_file] (AlignedPointTVector& chunk)
+      {
+        if (next_file == pcd_files.size ())
+          return (false);
+
+        pcl::PointCloud<PointT> cloud;
+        pcl::PCDReader reader;
+        if (reader.read (pcd_files[next_file].string (), cloud) != 0)
+        {
+          PCL_ERROR ("[pcl::outofcore::OutofcoreOctreeBase::bulkLoad] Could not read %s\n", pcd_files[next_file].string ().c_str ());
+          PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcoreOctreeBase::bulkLoad] Could not read input file");
+        }
+        next_file++;
+
+        chunk.swap (cloud.points);
+        return (true);
+      }, gen_lod));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> std::uint64_t
+    OutofcoreOctreeBase<ContainerT, PointT>::bulkLoad (const PointCloudConstPtr& point_cloud, const bool gen_lod)
+    {
+      std::size_t next_point = 0;
+      return (bulkLoadStream ([this, &point_cloud, &next_point] (AlignedPointTVector& chunk)
+      {
+        if (next_point >= point_cloud->size ())
+          return (false);
+
+        const std::size_t count = static_cast<std::size_t> (std::min<std::uint64_t> (bulk_load_partition_size_, point_cloud->size () - next_point));
+        chunk.assign (point_cloud->points.begin () + next_point, point_cloud->points.begin () + next_point + count);
+        next_point += count;
+        return (true);
+      }, gen_lod));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> void
+    OutofcoreOctreeBase<ContainerT, PointT>::setNumberOfThreads (unsigned int nr_threads)
+    {
+      if (nr_threads == 0)
+#ifdef _OPENMP
+        threads_ = omp_get_num_procs ();
+#else
+        threads_ = 1;
+#endif
+      else
+        threads_ = nr_threads;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> std::uint64_t
+    OutofcoreOctreeBase<ContainerT, PointT>::bulkLoadStream (const BulkLoadReader& reader, const bool gen_lod)
+    {
+      std::unique_lock < std::shared_timed_mutex > lock (read_write_mutex_);
+      invalidatePayloadCache ();
+
+      if (root_node_->getNumChildren () > 0 || root_node_->hasUnloadedChildren () || root_node_->payload_->size () > 0)
+      {
+        PCL_ERROR ("[pcl::outofcore::OutofcoreOctreeBase::bulkLoad] The tree already holds points; only empty trees can be bulk loaded.\n");
+        return (0);
+      }
+
+      // the Morton codes use 3 bits per level of a 64 bit integer
+      if (this->getDepth () > 21)
+      {
+        PCL_ERROR ("[pcl::outofcore::OutofcoreOctreeBase::bulkLoad] Trees deeper than 21 levels can not be bulk loaded (depth %lu).\n", this->getDepth ());
+        return (0);
+      }
+
+      const boost::filesystem::path spill_dir = root_node_->node_metadata_->getDirectoryPathname () / boost::filesystem::unique_path ("bulk_load_%%%%-%%%%-%%%%-%%%%");
+      boost::filesystem::create_directory (spill_dir);
+
+      std::vector<std::uint64_t> lod_points (this->getDepth () + 1, 0);
+      try
+      {
+        bulkLoadPartition (*root_node_, reader, gen_lod, spill_dir, lod_points);
+      }
+      catch (...)
+      {
+        boost::filesystem::remove_all (spill_dir);
+        throw;
+      }
+      boost::filesystem::remove_all (spill_dir);
+
+      for (std::size_t depth = 0; depth < lod_points.size (); depth++)
+      {
+        if (lod_points[depth] > 0)
+          this->incrementPointsInLOD (depth, lod_points[depth]);
+      }
+
+      return (lod_points.back ());
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> typename OutofcoreOctreeBase<ContainerT, PointT>::AlignedPointTVector
+    OutofcoreOctreeBase<ContainerT, PointT>::bulkLoadPartition (OutofcoreNodeType& node, const BulkLoadReader& reader, const bool gen_lod,
+                                                                const boost::filesystem::path& spill_dir, std::vector<std::uint64_t>& lod_points)
+    {
+      const unsigned int levels = static_cast<unsigned int> (this->getDepth () - node.getDepth ());
+      Eigen::Vector3d min_bb, max_bb;
+      node.getBoundingBox (min_bb, max_bb);
+
+      // only the input of the root is checked against the bounding box, the points of the
+      // spill files are in their node by construction (up to rounding of the child boxes)
+      bool check_bb = (&node == root_node_);
+
+      std::mt19937 rng (std::random_device {} ());
+
+      // a leaf can not be partitioned any further, all of its points go into a single file anyway
+      if (levels == 0)
+      {
+        AlignedPointTVector points, chunk;
+        while (reader (chunk))
+        {
+          for (const PointT &point : chunk)
+          {
+            if (!check_bb || OutofcoreNodeType::pointInBoundingBox (min_bb, max_bb, point))
+              points.push_back (point);
+          }
+        }
+        const std::vector<std::uint64_t> codes (points.size (), 0);
+        return (bulkLoadSubtree (node, points, codes, 0, points.size (), gen_lod, rng, lod_points));
+      }
+
+      // streaming pass distributing the points into one spill file per descendant split_levels below node
+      unsigned int split_levels = std::min (levels, 3u);
+      std::size_t nr_partitions = std::size_t (1) << (3 * split_levels);
+
+      const boost::filesystem::path node_spill_dir = boost::filesystem::unique_path (spill_dir / "%%%%-%%%%-%%%%-%%%%");
+      boost::filesystem::create_directory (node_spill_dir);
+      auto spill_path = [&node_spill_dir] (std::size_t partition)
+      {
+        return ((node_spill_dir / std::to_string (partition)).string ());
+      };
+
+      using FilePtr = std::unique_ptr<std::FILE, int (*) (std::FILE*)>;
+      std::vector<FilePtr> spill_files;
+      for (std::size_t i = 0; i < nr_partitions; i++)
+        spill_files.emplace_back (nullptr, &std::fclose);
+      std::vector<std::uint64_t> partition_sizes (nr_partitions, 0);
+
+      AlignedPointTVector chunk, sorted_chunk;
+      std::vector<std::size_t> keys;
+      std::vector<std::size_t> offsets (nr_partitions + 1);
+      while (reader (chunk))
+      {
+        keys.resize (chunk.size ());
+#pragma omp parallel for \
+  default(none) \
+  shared(chunk, keys, min_bb, max_bb, check_bb, split_levels, nr_partitions) \
+  num_threads(threads_)
+        for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t> (chunk.size ()); i++)
+        {
+          if (check_bb && !OutofcoreNodeType::pointInBoundingBox (min_bb, max_bb, chunk[i]))
+            keys[i] = nr_partitions;
+          else
+            keys[i] = static_cast<std::size_t> (computeMortonCode (chunk[i], min_bb, max_bb, split_levels));
+        }
+
+        // counting sort of the chunk by partition
+        std::fill (offsets.begin (), offsets.end (), 0);
+        for (const std::size_t &key : keys)
+        {
+          if (key < nr_partitions)
+            offsets[key + 1]++;
+        }
+        std::partial_sum (offsets.begin (), offsets.end (), offsets.begin ());
+
+        sorted_chunk.resize (offsets.back ());
+        std::vector<std::size_t> next (offsets.begin (), offsets.end () - 1);
+        for (std::size_t i = 0; i < chunk.size (); i++)
+        {
+          if (keys[i] < nr_partitions)
+            sorted_chunk[next[keys[i]]++] = chunk[i];
+        }
+
+        // append the partitions of the chunk to their spill files, each one written by a single thread
+        bool write_failed = false;
+#pragma omp parallel for \
+  default(none) \
+  shared(sorted_chunk, offsets, spill_files, partition_sizes, spill_path, nr_partitions, write_failed) \
+  schedule(dynamic) \
+  num_threads(threads_)
+        for (std::ptrdiff_t partition = 0; partition < static_cast<std::ptrdiff_t> (nr_partitions); partition++)
+        {
+          const std::size_t count = offsets[partition + 1] - offsets[partition];
+          if (count == 0)
+            continue;
+
+          if (!spill_files[partition])
+            spill_files[partition].reset (std::fopen (spill_path (partition).c_str (), "wb"));
+          if (!spill_files[partition] || std::fwrite (&sorted_chunk[offsets[partition]], sizeof (PointT), count, spill_files[partition].get ()) != count)
+          {
+#pragma omp critical
+            write_failed = true;
+          }
+          partition_sizes[partition] += count;
+        }
+
+        if (write_failed)
+        {
+          PCL_ERROR ("[pcl::outofcore::OutofcoreOctreeBase::bulkLoad] Could not write spill file in %s\n", node_spill_dir.string ().c_str ());
+          PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcoreOctreeBase::bulkLoad] Could not write spill file");
+        }
+      }
+
+      for (FilePtr &spill_file : spill_files)
+      {
+        if (spill_file && std::fflush (spill_file.get ()) != 0)
+        {
+          PCL_ERROR ("[pcl::outofcore::OutofcoreOctreeBase::bulkLoad] Could not write spill file in %s\n", node_spill_dir.string ().c_str ());
+          PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcoreOctreeBase::bulkLoad] Could not write spill file");
+        }
+        spill_file.reset ();
+      }
+
+      // create the roots of the partitions up front, their subtrees are then built independently
+      std::vector<OutofcoreNodeType*> partition_nodes (nr_partitions, nullptr);
+      std::vector<std::size_t> in_memory_partitions;
+      for (std::size_t partition = 0; partition < nr_partitions; partition++)
+      {
+        if (partition_sizes[partition] == 0)
+          continue;
+
+        OutofcoreNodeType* partition_node = &node;
+        for (unsigned int level = split_levels; level > 0; level--)
+        {
+          const std::size_t child_idx = (partition >> (3 * (level - 1))) & 7;
+          if (!partition_node->children_[child_idx])
+            partition_node->createChild (child_idx);
+          partition_node = partition_node->children_[child_idx];
+        }
+        partition_nodes[partition] = partition_node;
+
+        if (partition_sizes[partition] <= bulk_load_partition_size_)
+          in_memory_partitions.push_back (partition);
+      }
+
+      std::vector<AlignedPointTVector> partition_samples (nr_partitions);
+
+      // partitions too large to be built in memory are partitioned again, one after the other
+      for (std::size_t partition = 0; partition < nr_partitions; partition++)
+      {
+        if (partition_sizes[partition] <= bulk_load_partition_size_)
+          continue;
+
+        FilePtr spill_file (std::fopen (spill_path (partition).c_str (), "rb"), &std::fclose);
+        if (!spill_file)
+        {
+          PCL_ERROR ("[pcl::outofcore::OutofcoreOctreeBase::bulkLoad] Could not read spill file %s\n", spill_path (partition).c_str ());
+          PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcoreOctreeBase::bulkLoad] Could not read spill file");
+        }
+        std::FILE* file = spill_file.get ();
+        partition_samples[partition] = bulkLoadPartition (*partition_nodes[partition], [this, file] (AlignedPointTVector& spill_chunk)
+        {
+          spill_chunk.resize (static_cast<std::size_t> (bulk_load_partition_size_));
+          spill_chunk.resize (std::fread (spill_chunk.data (), sizeof (PointT), spill_chunk.size (), file));
+          return (!spill_chunk.empty ());
+        }, gen_lod, spill_dir, lod_points);
+
+        spill_file.reset ();
+        boost::filesystem::remove (spill_path (partition));
+      }
+
+      // the other partitions are loaded, sorted and built in memory in parallel
+      std::vector<std::vector<std::uint64_t> > partition_lod_points (in_memory_partitions.size (), std::vector<std::uint64_t> (lod_points.size (), 0));
+      std::vector<std::exception_ptr> partition_errors (in_memory_partitions.size ());
+      bool build_lod = gen_lod;
+#pragma omp parallel for \
+  default(none) \
+  shared(in_memory_partitions, partition_nodes, partition_sizes, partition_samples, partition_lod_points, partition_errors, spill_path, build_lod) \
+  schedule(dynamic) \
+  num_threads(threads_)
+      for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t> (in_memory_partitions.size ()); i++)
+      {
+        try
+        {
+          const std::size_t partition = in_memory_partitions[i];
+          OutofcoreNodeType &partition_node = *partition_nodes[partition];
+
+          AlignedPointTVector points (static_cast<std::size_t> (partition_sizes[partition]));
+          FilePtr spill_file (std::fopen (spill_path (partition).c_str (), "rb"), &std::fclose);
+          if (!spill_file || std::fread (points.data (), sizeof (PointT), points.size (), spill_file.get ()) != points.size ())
+          {
+            PCL_ERROR ("[pcl::outofcore::OutofcoreOctreeBase::bulkLoad] Could not read spill file %s\n", spill_path (partition).c_str ());
+            PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcoreOctreeBase::bulkLoad] Could not read spill file");
+          }
+          spill_file.reset ();
+          boost::filesystem::remove (spill_path (partition));
+
+          // sort the points by their Morton code, such that every node of the subtree is a contiguous range
+          Eigen::Vector3d partition_min_bb, partition_max_bb;
+          partition_node.getBoundingBox (partition_min_bb, partition_max_bb);
+          const unsigned int partition_levels = static_cast<unsigned int> (this->getDepth () - partition_node.getDepth ());
+
+          std::vector<std::uint64_t> point_codes (points.size ());
+          for (std::size_t j = 0; j < points.size (); j++)
+            point_codes[j] = computeMortonCode (points[j], partition_min_bb, partition_max_bb, partition_levels);
+
+          std::vector<std::size_t> order (points.size ());
+          std::iota (order.begin (), order.end (), 0);
+          std::sort (order.begin (), order.end (), [&point_codes] (std::size_t a, std::size_t b) { return (point_codes[a] < point_codes[b]); });
+
+          AlignedPointTVector sorted_points (points.size ());
+          std::vector<std::uint64_t> sorted_codes (points.size ());
+          for (std::size_t j = 0; j < order.size (); j++)
+          {
+            sorted_points[j] = points[order[j]];
+            sorted_codes[j] = point_codes[order[j]];
+          }
+          points.clear ();
+          points.shrink_to_fit ();
+
+          std::mt19937 partition_rng (std::random_device {} ());
+          partition_samples[partition] = bulkLoadSubtree (partition_node, sorted_points, sorted_codes, 0, sorted_points.size (),
+                                                          build_lod, partition_rng, partition_lod_points[i]);
+        }
+        catch (...)
+        {
+          partition_errors[i] = std::current_exception ();
+        }
+      }
+
+      for (const std::exception_ptr &error : partition_errors)
+      {
+        if (error)
+          std::rethrow_exception (error);
+      }
+      for (const std::vector<std::uint64_t> &partition_lod : partition_lod_points)
+      {
+        for (std::size_t depth = 0; depth < lod_points.size (); depth++)
+          lod_points[depth] += partition_lod[depth];
+      }
+      boost::filesystem::remove_all (node_spill_dir);
+
+      if (!gen_lod)
+        return (AlignedPointTVector ());
+
+      // bottom-up LOD of node and of the nodes between it and the partition roots
+      std::map<std::size_t, AlignedPointTVector> level_samples;
+      for (std::size_t partition = 0; partition < nr_partitions; partition++)
+      {
+        if (partition_sizes[partition] > 0)
+          level_samples[partition].swap (partition_samples[partition]);
+      }
+      for (unsigned int level = split_levels; level > 0; level--)
+      {
+        std::map<std::size_t, AlignedPointTVector> parent_samples;
+        for (const auto &sample : level_samples)
+        {
+          AlignedPointTVector &children_samples = parent_samples[sample.first >> 3];
+          children_samples.insert (children_samples.end (), sample.second.begin (), sample.second.end ());
+        }
+
+        level_samples.clear ();
+        for (const auto &children_samples : parent_samples)
+        {
+          OutofcoreNodeType* parent = &node;
+          for (unsigned int parent_level = level - 1; parent_level > 0; parent_level--)
+            parent = parent->children_[(children_samples.first >> (3 * (parent_level - 1))) & 7];
+          level_samples[children_samples.first] = bulkLoadLOD (*parent, children_samples.second, rng, lod_points);
+        }
+      }
+
+      return (level_samples[0]);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> typename OutofcoreOctreeBase<ContainerT, PointT>::AlignedPointTVector
+    OutofcoreOctreeBase<ContainerT, PointT>::bulkLoadSubtree (OutofcoreNodeType& node, const AlignedPointTVector& points, const std::vector<std::uint64_t>& codes,
+                                                              const std::size_t begin, const std::size_t end, const bool gen_lod,
+                                                              std::mt19937& rng, std::vector<std::uint64_t>& lod_points)
+    {
+      const unsigned int levels = static_cast<unsigned int> (this->getDepth () - node.getDepth ());
+
+      if (levels == 0)
+      {
+        const AlignedPointTVector leaf_points (points.begin () + begin, points.begin () + end);
+        if (!leaf_points.empty ())
+        {
+          node.payload_->insertRange (leaf_points);
+          lod_points[node.getDepth ()] += leaf_points.size ();
+        }
+
+        // a leaf contributes sample_percent_ of its points to its parent, which holds
+        // sample_percent_^2 of the points below it (see buildLODRecursive)
+        AlignedPointTVector sample;
+        if (gen_lod)
+          randomSubsample (leaf_points, sample_percent_, rng, sample);
+        return (sample);
+      }
+
+      // the points of each child are a contiguous range of the sorted points
+      const unsigned int shift = 3 * (levels - 1);
+      AlignedPointTVector children_samples;
+      for (std::size_t child_begin = begin; child_begin < end; )
+      {
+        const std::size_t child_idx = static_cast<std::size_t> ((codes[child_begin] >> shift) & 7);
+        std::size_t child_end = child_begin + 1;
+        while (child_end < end && static_cast<std::size_t> ((codes[child_end] >> shift) & 7) == child_idx)
+          child_end++;
+
+        if (!node.children_[child_idx])
+          node.createChild (child_idx);
+        const AlignedPointTVector child_sample = bulkLoadSubtree (*node.children_[child_idx], points, codes, child_begin, child_end, gen_lod, rng, lod_points);
+        children_samples.insert (children_samples.end (), child_sample.begin (), child_sample.end ());
+
+        child_begin = child_end;
+      }
+
+      if (!gen_lod)
+        return (AlignedPointTVector ());
+
+      return (bulkLoadLOD (node, children_samples, rng, lod_points));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> typename OutofcoreOctreeBase<ContainerT, PointT>::AlignedPointTVector
+    OutofcoreOctreeBase<ContainerT, PointT>::bulkLoadLOD (OutofcoreNodeType& node, const AlignedPointTVector& children_samples,
+                                                          std::mt19937& rng, std::vector<std::uint64_t>& lod_points)
+    {
+      AlignedPointTVector lod;
+      randomSubsample (children_samples, sample_percent_, rng, lod);
+      if (!lod.empty ())
+      {
+        node.payload_->insertRange (lod);
+        lod_points[node.getDepth ()] += lod.size ();
+      }
+      return (lod);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> void
+    OutofcoreOctreeBase<ContainerT, PointT>::randomSubsample (const AlignedPointTVector& points, const double percent, std::mt19937& rng, AlignedPointTVector& sample)
+    {
+      sample.clear ();
+      if (points.empty ())
+        return;
+
+      // same sample size as in buildLODRecursive
+      std::size_t sample_size = static_cast<std::size_t> (static_cast<double> (points.size ()) * percent);
+      sample_size = std::min (std::max<std::size_t> (sample_size, 1), points.size ());
+
+      // partial Fisher-Yates shuffle of the indices
+      std::vector<std::size_t> indices (points.size ());
+      std::iota (indices.begin (), indices.end (), 0);
+      for (std::size_t i = 0; i < sample_size; i++)
+      {
+        std::uniform_int_distribution<std::size_t> distribution (i, indices.size () - 1);
+        std::swap (indices[i], indices[distribution (rng)]);
+      }
+      std::sort (indices.begin (), indices.begin () + sample_size);
+
+      sample.reserve (sample_size);
+      for (std::size_t i = 0; i < sample_size; i++)
+        sample.push_back (points[indices[i]]);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename ContainerT, typename PointT> std::uint64_t
+    OutofcoreOctreeBase<ContainerT, PointT>::computeMortonCode (const PointT& point, const Eigen::Vector3d& min_bb, const Eigen::Vector3d& max_bb, const unsigned int levels)
+    {
+      const double cells = static_cast<double> (std::uint64_t (1) << levels);
+      const double coordinates[3] = {point.x, point.y, point.z};
+
+      std::uint64_t cell[3];
+      for (int i = 0; i < 3; i++)
+      {
+        // the maximum boundary belongs to the next node (see pointInBoundingBox), but clamp for
+        // points on the boundary of the tree and the rounding of the child bounding boxes
+        const double c = std::floor ((coordinates[i] - min_bb[i]) / (max_bb[i] - min_bb[i]) * cells);
+        cell[i] = static_cast<std::uint64_t> (std::min (std::max (c, 0.0), cells - 1.0));
+      }
+
+      std::uint64_t code = 0;
+      for (unsigned int level = levels; level > 0; level--)
+      {
+        const unsigned int bit = level - 1;
+        code = (code << 3) | (((cell[2] >> bit) & 1) << 2) | (((cell[1] >> bit) & 1) << 1) | ((cell[0] >> bit) & 1);
+      }
+      return (code);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
     template<typename ContainerT, typename PointT> bool
     OutofcoreOctreeBase<ContainerT, PointT>::checkExtension (const boost::filesystem::path& path_name)
     {
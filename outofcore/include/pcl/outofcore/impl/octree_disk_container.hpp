@@ -534,7 +534,7 @@ namespace pcl
         assert (previous_num_pts == res_pts);
         
         writer.writeBinaryCompressed (disk_storage_filename_, *tmp_cloud);
-            
+        filelen_ = tmp_cloud->width*tmp_cloud->height;
       }
       else //otherwise create the point cloud which will be saved to the pcd file for the first time
       {
@@ -542,6 +542,7 @@ namespace pcl
         int res = writer.writeBinaryCompressed (disk_storage_filename_, *input_cloud);
         pcl::utils::ignore(res);
         assert (res == 0);
+        filelen_ = input_cloud->width*input_cloud->height;
       }            
 
     }
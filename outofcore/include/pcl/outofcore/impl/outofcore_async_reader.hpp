@@ -0,0 +1,219 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2020-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_OUTOFCORE_ASYNC_READER_IMPL_H_
+#define PCL_OUTOFCORE_ASYNC_READER_IMPL_H_
+
+#include <pcl/outofcore/outofcore_async_reader.h>
+
+#include <algorithm>
+
+namespace pcl
+{
+  namespace outofcore
+  {
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // OutofcoreNodeCache
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT>
+    OutofcoreNodeCache<PointT>::OutofcoreNodeCache (std::size_t capacity)
+      : capacity_ (capacity)
+      , cache_ (std::max<std::size_t> (capacity, 1))
+      , timestamp_ (0)
+    {
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT> typename OutofcoreNodeCache<PointT>::PayloadConstPtr
+    OutofcoreNodeCache<PointT>::get (const std::string &key)
+    {
+      std::lock_guard<std::mutex> lock (mutex_);
+      if (!cache_.hasKey (key))
+        return (PayloadConstPtr ());
+      return (cache_.get (key).item);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT> void
+    OutofcoreNodeCache<PointT>::insert (const std::string &key, const PayloadConstPtr &payload)
+    {
+      PayloadCacheItem cache_item;
+      cache_item.item = payload;
+      // LRUCache can not evict its way to room for an item larger than the whole budget
+      if (cache_item.sizeOf () >= capacity_)
+        return;
+
+      std::lock_guard<std::mutex> lock (mutex_);
+      cache_item.timestamp = ++timestamp_;
+      cache_.insert (key, cache_item);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT> void
+    OutofcoreNodeCache<PointT>::clear ()
+    {
+      std::lock_guard<std::mutex> lock (mutex_);
+      cache_.evict (static_cast<int> (cache_.key_index_.size ()));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT> std::size_t
+    OutofcoreNodeCache<PointT>::size () const
+    {
+      std::lock_guard<std::mutex> lock (mutex_);
+      return (cache_.size_);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // OutofcoreAsyncReader
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT>
+    OutofcoreAsyncReader<PointT>::OutofcoreAsyncReader (unsigned int nr_threads, std::size_t cache_size, std::size_t max_pending)
+      : cache_ (cache_size)
+      , max_pending_ (std::max<std::size_t> (max_pending, 1))
+      , stop_ (false)
+    {
+      nr_threads = std::max (nr_threads, 1u);
+      workers_.reserve (nr_threads);
+      for (unsigned int i = 0; i < nr_threads; ++i)
+        workers_.emplace_back (&OutofcoreAsyncReader<PointT>::run, this);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT>
+    OutofcoreAsyncReader<PointT>::~OutofcoreAsyncReader ()
+    {
+      {
+        std::lock_guard<std::mutex> lock (mutex_);
+        stop_ = true;
+      }
+      request_available_.notify_all ();
+      for (auto &worker : workers_)
+        worker.join ();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT> typename OutofcoreAsyncReader<PointT>::PayloadFuture
+    OutofcoreAsyncReader<PointT>::request (const std::string &key, const Loader &loader)
+    {
+      std::unique_lock<std::mutex> lock (mutex_);
+
+      // merge with a read of the same payload that is already in flight
+      const auto in_flight = in_flight_.find (key);
+      if (in_flight != in_flight_.end ())
+        return (in_flight->second);
+
+      // the worker inserts into the cache before it removes the request from in_flight_,
+      // so a payload is always found in one of both
+      const PayloadConstPtr cached = cache_.get (key);
+      if (cached)
+      {
+        std::promise<PayloadConstPtr> ready;
+        ready.set_value (cached);
+        return (ready.get_future ().share ());
+      }
+
+      slot_available_.wait (lock, [this] { return (queue_.size () < max_pending_); });
+
+      ReadRequest read_request;
+      read_request.key = key;
+      read_request.loader = loader;
+      read_request.promise.reset (new std::promise<PayloadConstPtr> ());
+      PayloadFuture future = read_request.promise->get_future ().share ();
+
+      queue_.push_back (read_request);
+      in_flight_[key] = future;
+      lock.unlock ();
+
+      request_available_.notify_one ();
+      return (future);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT> void
+    OutofcoreAsyncReader<PointT>::run ()
+    {
+      while (true)
+      {
+        ReadRequest read_request;
+        {
+          std::unique_lock<std::mutex> lock (mutex_);
+          request_available_.wait (lock, [this] { return (stop_ || !queue_.empty ()); });
+          if (queue_.empty ())
+            return;
+          read_request = queue_.front ();
+          queue_.pop_front ();
+        }
+        slot_available_.notify_one ();
+
+        shared_ptr<AlignedPointTVector> payload (new AlignedPointTVector);
+        bool success = true;
+        try
+        {
+          read_request.loader (*payload);
+        }
+        catch (...)
+        {
+          success = false;
+          read_request.promise->set_exception (std::current_exception ());
+        }
+
+        if (success)
+          cache_.insert (read_request.key, payload);
+
+        {
+          std::lock_guard<std::mutex> lock (mutex_);
+          in_flight_.erase (read_request.key);
+        }
+
+        if (success)
+          read_request.promise->set_value (payload);
+      }
+    }
+  }
+}
+
+#endif //PCL_OUTOFCORE_ASYNC_READER_IMPL_H_
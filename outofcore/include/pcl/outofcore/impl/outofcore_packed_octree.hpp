@@ -0,0 +1,434 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2020-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_OUTOFCORE_PACKED_OCTREE_IMPL_H_
+#define PCL_OUTOFCORE_PACKED_OCTREE_IMPL_H_
+
+#include <pcl/outofcore/outofcore_packed_octree.h>
+
+#include <pcl/common/io.h>
+#include <pcl/io/lzf.h>
+#include <pcl/exceptions.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+
+namespace pcl
+{
+  namespace outofcore
+  {
+    namespace detail
+    {
+      /** \brief Signature at the start of packed outofcore octree files */
+      static const char OUTOFCORE_PACKED_MAGIC[8] = { 'P', 'C', 'L', 'O', 'C', 'P', 'A', 'K' };
+
+      /** \brief Round \c offset up to the alignment of the node table and the point chunks */
+      inline std::uint64_t
+      alignPackedOffset (const std::uint64_t offset)
+      {
+        return ((offset + 15) & ~static_cast<std::uint64_t> (15));
+      }
+
+      /** \brief Size of the words the points are split into to store them column-wise */
+      template<typename PointT> inline std::size_t
+      packedWordSize ()
+      {
+        return ((sizeof (PointT) % 4 == 0) ? 4 : 1);
+      }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT>
+    OutofcorePackedOctree<PointT>::OutofcorePackedOctree (const boost::filesystem::path& file)
+      : header_ (nullptr)
+      , nodes_ (nullptr)
+    {
+      try
+      {
+        file_.open (file.string ());
+      }
+      catch (const std::exception &e)
+      {
+        PCL_ERROR ("[pcl::outofcore::OutofcorePackedOctree] Could not map %s: %s\n", file.string ().c_str (), e.what ());
+        PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcorePackedOctree] Could not map the packed tree");
+      }
+
+      if (file_.size () < sizeof (OutofcorePackedHeader))
+      {
+        PCL_ERROR ("[pcl::outofcore::OutofcorePackedOctree] %s is too small to be a packed tree\n", file.string ().c_str ());
+        PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcorePackedOctree] Not a packed tree");
+      }
+
+      header_ = reinterpret_cast<const OutofcorePackedHeader*> (file_.data ());
+      if (std::memcmp (header_->magic, detail::OUTOFCORE_PACKED_MAGIC, sizeof (header_->magic)) != 0 || header_->version != VERSION)
+      {
+        PCL_ERROR ("[pcl::outofcore::OutofcorePackedOctree] %s is not a packed tree of version %u\n", file.string ().c_str (), VERSION);
+        PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcorePackedOctree] Not a packed tree");
+      }
+
+      const std::string fields = pcl::getFieldsList (pcl::PointCloud<PointT> ());
+      if (header_->point_size != sizeof (PointT) || fields != std::string (header_->fields, strnlen (header_->fields, sizeof (header_->fields))))
+      {
+        PCL_ERROR ("[pcl::outofcore::OutofcorePackedOctree] The points of %s (%.*s) do not match the point type (%s)\n",
+                   file.string ().c_str (), static_cast<int> (sizeof (header_->fields)), header_->fields, fields.c_str ());
+        PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcorePackedOctree] Point type mismatch");
+      }
+
+      if (header_->node_count == 0 || header_->node_table_offset % alignof (OutofcorePackedNode) != 0 ||
+          header_->node_table_offset > file_.size () ||
+          header_->node_count > (file_.size () - header_->node_table_offset) / sizeof (OutofcorePackedNode))
+      {
+        PCL_ERROR ("[pcl::outofcore::OutofcorePackedOctree] The node table of %s is corrupt\n", file.string ().c_str ());
+        PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcorePackedOctree] Corrupt node table");
+      }
+
+      nodes_ = reinterpret_cast<const OutofcorePackedNode*> (file_.data () + header_->node_table_offset);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT> template<typename ContainerT> void
+    OutofcorePackedOctree<PointT>::convert (OutofcoreOctreeBase<ContainerT, PointT>& tree, const boost::filesystem::path& file, const bool compress)
+    {
+      using TreeNode = OutofcoreOctreeBaseNode<ContainerT, PointT>;
+
+      // loading the children modifies the nodes
+      std::unique_lock < std::shared_timed_mutex > lock (tree.read_write_mutex_);
+
+      OutofcorePackedHeader header;
+      std::memset (&header, 0, sizeof (header));
+      std::memcpy (header.magic, detail::OUTOFCORE_PACKED_MAGIC, sizeof (header.magic));
+      header.version = VERSION;
+      header.point_size = static_cast<std::uint32_t> (sizeof (PointT));
+      header.depth = tree.getDepth ();
+
+      const std::string fields = pcl::getFieldsList (pcl::PointCloud<PointT> ());
+      if (fields.size () >= sizeof (header.fields))
+      {
+        PCL_ERROR ("[pcl::outofcore::OutofcorePackedOctree::convert] The field list of the point type is too long (%s)\n", fields.c_str ());
+        PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcorePackedOctree::convert] Unsupported point type");
+      }
+      std::copy (fields.begin (), fields.end (), header.fields);
+
+      // number the nodes breadth first; the metadata of every node is read once here
+      std::vector<TreeNode*> tree_nodes (1, tree.root_node_);
+      std::vector<OutofcorePackedNode> nodes;
+      for (std::size_t i = 0; i < tree_nodes.size (); i++)
+      {
+        TreeNode* tree_node = tree_nodes[i];
+        if (tree_node->hasUnloadedChildren ())
+          tree_node->loadChildren (false);
+
+        OutofcorePackedNode node;
+        std::memset (&node, 0, sizeof (node));
+
+        Eigen::Vector3d min_bb, max_bb;
+        tree_node->getBoundingBox (min_bb, max_bb);
+        for (int k = 0; k < 3; k++)
+        {
+          node.bb_min[k] = min_bb[k];
+          node.bb_max[k] = max_bb[k];
+        }
+        node.depth = static_cast<std::uint32_t> (tree_node->getDepth ());
+
+        for (std::size_t child_idx = 0; child_idx < 8; child_idx++)
+        {
+          if (tree_node->children_[child_idx])
+          {
+            if (tree_nodes.size () >= std::numeric_limits<std::uint32_t>::max ())
+            {
+              PCL_ERROR ("[pcl::outofcore::OutofcorePackedOctree::convert] The tree has too many nodes\n");
+              PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcorePackedOctree::convert] Too many nodes");
+            }
+            node.children[child_idx] = static_cast<std::uint32_t> (tree_nodes.size ());
+            tree_nodes.push_back (tree_node->children_[child_idx]);
+          }
+        }
+        nodes.push_back (node);
+      }
+
+      std::ofstream out (file.string ().c_str (), std::ios::binary | std::ios::trunc);
+      if (!out)
+      {
+        PCL_ERROR ("[pcl::outofcore::OutofcorePackedOctree::convert] Could not open %s for writing\n", file.string ().c_str ());
+        PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcorePackedOctree::convert] Could not write the packed tree");
+      }
+
+      header.node_count = nodes.size ();
+      header.node_table_offset = detail::alignPackedOffset (sizeof (OutofcorePackedHeader));
+      std::uint64_t offset = detail::alignPackedOffset (header.node_table_offset + nodes.size () * sizeof (OutofcorePackedNode));
+
+      // the header and the node table are written once the offsets of the points are known
+      const std::vector<char> zeros (16, 0);
+      out.seekp (static_cast<std::streamoff> (offset));
+
+      const std::size_t word_size = detail::packedWordSize<PointT> ();
+      const std::size_t words_per_point = sizeof (PointT) / word_size;
+      AlignedPointTVector points;
+      std::vector<char> columns, compressed;
+      for (std::size_t i = 0; i < tree_nodes.size (); i++)
+      {
+        points.clear ();
+        if (tree_nodes[i]->payload_->size () > 0)
+          tree_nodes[i]->payload_->readRange (0, tree_nodes[i]->payload_->size (), points);
+
+        OutofcorePackedNode &node = nodes[i];
+        node.point_count = points.size ();
+        if (points.empty ())
+          continue;
+
+        const std::uint64_t raw_size = points.size () * sizeof (PointT);
+        const char* data = reinterpret_cast<const char*> (points.data ());
+        node.size = raw_size;
+
+        if (compress && raw_size < UINT_MAX / 2)
+        {
+          // store the fields column-wise, which compresses a lot better
+          const char* src = reinterpret_cast<const char*> (points.data ());
+          columns.resize (static_cast<std::size_t> (raw_size));
+          for (std::size_t p = 0; p < points.size (); p++)
+          {
+            for (std::size_t w = 0; w < words_per_point; w++)
+              std::memcpy (&columns[(w * points.size () + p) * word_size], src + p * sizeof (PointT) + w * word_size, word_size);
+          }
+
+          // incompressible data grows, see PCDWriter::writeBinaryCompressed
+          compressed.resize (static_cast<std::size_t> (raw_size * 3 / 2 + 8));
+          const unsigned int compressed_size = pcl::lzfCompress (columns.data (), static_cast<unsigned int> (raw_size),
+                                                                 compressed.data (), static_cast<unsigned int> (compressed.size ()));
+          if (compressed_size > 0 && compressed_size < raw_size)
+          {
+            data = compressed.data ();
+            node.size = compressed_size;
+            node.flags |= OutofcorePackedNode::COMPRESSED;
+          }
+        }
+
+        node.offset = offset;
+        out.write (data, static_cast<std::streamsize> (node.size));
+        const std::uint64_t next_offset = detail::alignPackedOffset (offset + node.size);
+        out.write (zeros.data (), static_cast<std::streamsize> (next_offset - offset - node.size));
+        offset = next_offset;
+      }
+
+      out.seekp (0);
+      out.write (reinterpret_cast<const char*> (&header), sizeof (header));
+      out.write (zeros.data (), static_cast<std::streamsize> (header.node_table_offset - sizeof (header)));
+      out.write (reinterpret_cast<const char*> (nodes.data ()), static_cast<std::streamsize> (nodes.size () * sizeof (OutofcorePackedNode)));
+      out.close ();
+
+      if (!out)
+      {
+        PCL_ERROR ("[pcl::outofcore::OutofcorePackedOctree::convert] Could not write %s\n", file.string ().c_str ());
+        PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcorePackedOctree::convert] Could not write the packed tree");
+      }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT> void
+    OutofcorePackedOctree<PointT>::getBoundingBox (Eigen::Vector3d& min_bb, Eigen::Vector3d& max_bb) const
+    {
+      min_bb = Eigen::Vector3d (nodes_[0].bb_min[0], nodes_[0].bb_min[1], nodes_[0].bb_min[2]);
+      max_bb = Eigen::Vector3d (nodes_[0].bb_max[0], nodes_[0].bb_max[1], nodes_[0].bb_max[2]);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT> std::uint64_t
+    OutofcorePackedOctree<PointT>::getNumPointsAtDepth (const std::uint64_t depth_index) const
+    {
+      std::uint64_t point_count = 0;
+      for (std::size_t i = 0; i < getNumberOfNodes (); i++)
+      {
+        if (nodes_[i].depth == depth_index)
+          point_count += nodes_[i].point_count;
+      }
+      return (point_count);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT> const PointT*
+    OutofcorePackedOctree<PointT>::getNodePoints (const std::size_t index) const
+    {
+      const OutofcorePackedNode &node = nodes_[index];
+      if (node.point_count == 0 || (node.flags & OutofcorePackedNode::COMPRESSED))
+        return (nullptr);
+
+      if (node.offset % alignof (PointT) != 0 || node.size != node.point_count * sizeof (PointT) ||
+          node.offset > file_.size () || node.size > file_.size () - node.offset)
+      {
+        PCL_ERROR ("[pcl::outofcore::OutofcorePackedOctree] The points of node %zu are corrupt\n", index);
+        PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcorePackedOctree] Corrupt node");
+      }
+      return (reinterpret_cast<const PointT*> (file_.data () + node.offset));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT> void
+    OutofcorePackedOctree<PointT>::readNode (const std::size_t index, AlignedPointTVector& dst) const
+    {
+      const OutofcorePackedNode &node = nodes_[index];
+      if (node.point_count == 0)
+        return;
+
+      if (!(node.flags & OutofcorePackedNode::COMPRESSED))
+      {
+        const PointT* points = getNodePoints (index);
+        dst.insert (dst.end (), points, points + node.point_count);
+        return;
+      }
+
+      const std::uint64_t raw_size = node.point_count * sizeof (PointT);
+      std::vector<char> columns (static_cast<std::size_t> (raw_size));
+      if (node.offset > file_.size () || node.size > file_.size () - node.offset ||
+          pcl::lzfDecompress (file_.data () + node.offset, static_cast<unsigned int> (node.size),
+                              columns.data (), static_cast<unsigned int> (raw_size)) != raw_size)
+      {
+        PCL_ERROR ("[pcl::outofcore::OutofcorePackedOctree] The points of node %zu are corrupt\n", index);
+        PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcorePackedOctree] Corrupt node");
+      }
+
+      // transpose the columns back into points
+      const std::size_t word_size = detail::packedWordSize<PointT> ();
+      const std::size_t words_per_point = sizeof (PointT) / word_size;
+      const std::size_t first = dst.size ();
+      dst.resize (first + node.point_count);
+      char* out = reinterpret_cast<char*> (&dst[first]);
+      for (std::size_t p = 0; p < node.point_count; p++)
+      {
+        for (std::size_t w = 0; w < words_per_point; w++)
+          std::memcpy (out + p * sizeof (PointT) + w * word_size, &columns[(w * node.point_count + p) * word_size], word_size);
+      }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<typename PointT> void
+    OutofcorePackedOctree<PointT>::queryBBIncludes (const Eigen::Vector3d& min, const Eigen::Vector3d& max, const std::uint64_t query_depth, AlignedPointTVector& dst) const
+    {
+      dst.clear ();
+
+      // same tests as OutofcoreOctreeBaseNode::intersectsWithBoundingBox, inBoundingBox and pointInBoundingBox
+      auto intersects = [&min, &max] (const OutofcorePackedNode &node)
+      {
+        for (int k = 0; k < 3; k++)
+        {
+          if (!((node.bb_min[k] <= min[k] && min[k] <= node.bb_max[k]) || (min[k] <= node.bb_min[k] && node.bb_min[k] <= max[k])))
+            return (false);
+        }
+        return (true);
+      };
+      auto inside = [&min, &max] (const OutofcorePackedNode &node)
+      {
+        for (int k = 0; k < 3; k++)
+        {
+          if (!(min[k] <= node.bb_min[k] && node.bb_max[k] <= max[k]))
+            return (false);
+        }
+        return (true);
+      };
+
+      // the children are checked as the nodes are reached: in the breadth first node table the
+      // children of the visited nodes follow each other, which rules out cycles and nodes reached twice
+      std::size_t last_child = 0;
+
+      AlignedPointTVector decompressed;
+      std::deque<std::size_t> node_queue (1, 0);
+      while (!node_queue.empty ())
+      {
+        const std::size_t index = node_queue.front ();
+        node_queue.pop_front ();
+
+        const OutofcorePackedNode &node = nodes_[index];
+        if (!intersects (node))
+          continue;
+
+        if (node.depth < query_depth)
+        {
+          for (const std::uint32_t &child : node.children)
+          {
+            if (child == 0)
+              continue;
+            if (child <= last_child || child >= header_->node_count)
+            {
+              PCL_ERROR ("[pcl::outofcore::OutofcorePackedOctree::queryBBIncludes] The children of node %lu are corrupt\n",
+                         static_cast<unsigned long> (index));
+              PCL_THROW_EXCEPTION (PCLException, "[pcl::outofcore::OutofcorePackedOctree::queryBBIncludes] Corrupt node table");
+            }
+            last_child = child;
+            node_queue.push_back (child);
+          }
+          continue;
+        }
+
+        if (node.point_count == 0)
+          continue;
+
+        const PointT* points = getNodePoints (index);
+        if (!points)
+        {
+          decompressed.clear ();
+          readNode (index, decompressed);
+          points = decompressed.data ();
+        }
+
+        if (inside (node))
+        {
+          dst.insert (dst.end (), points, points + node.point_count);
+          continue;
+        }
+        for (std::size_t i = 0; i < node.point_count; i++)
+        {
+          const PointT &p = points[i];
+          if (min[0] <= p.x && p.x < max[0] && min[1] <= p.y && p.y < max[1] && min[2] <= p.z && p.z < max[2])
+            dst.push_back (p);
+        }
+      }
+    }
+  }
+}
+
+#endif //PCL_OUTOFCORE_PACKED_OCTREE_IMPL_H_
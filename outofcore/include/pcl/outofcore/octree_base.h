@@ -58,11 +58,16 @@
 #include <pcl/outofcore/metadata.h>
 #include <pcl/outofcore/outofcore_base_data.h>
 
+//outofcore asynchronous payload reader
+#include <pcl/outofcore/outofcore_async_reader.h>
+
 #include <pcl/filters/filter.h>
 #include <pcl/filters/random_sample.h>
 
 #include <pcl/PCLPointCloud2.h>
 
+#include <functional>
+#include <random>
 #include <shared_mutex>
 
 namespace pcl
@@ -151,6 +156,7 @@ namespace pcl
     {
       friend class OutofcoreOctreeBaseNode<ContainerT, PointT>;
       friend class pcl::outofcore::OutofcoreIteratorBase<PointT, ContainerT>;
+      friend class pcl::outofcore::OutofcorePackedOctree<PointT>;
 
       public:
 
@@ -306,6 +312,38 @@ namespace pcl
 	      void
         queryFrustum (const double *planes, const Eigen::Vector3d &eye, const Eigen::Matrix4d &view_projection_matrix,
                       std::list<std::string>& file_names, const std::uint32_t query_depth) const;
+
+        /** \brief Get the points of the nodes at \c query_depth that intersect with the view frustum.
+         *  Like the file name queries, this returns the complete payload of every node in
+         *  the frustum, nodes are visited breadth first. With asynchronous I/O enabled (see
+         *  \ref setAsyncIO) the payloads are read ahead of the traversal by the I/O threads.
+         *
+         * \param[in] planes The six frustum planes (a, b, c, d), points inside fulfill a*x + b*y + c*z + d >= 0
+         * \param[in] query_depth The depth from which point data will be taken
+         * \param[out] dst The destination vector of points
+         */
+        void
+        queryFrustum (const double *planes, const std::uint32_t query_depth, AlignedPointTVector &dst) const;
+
+        /** \brief Screen space error level of detail query of the view frustum. Starting at the
+         *  root, the nodes outside of the frustum are rejected with their subtrees and the
+         *  traversal stops at the nodes whose bounding box edge projects to at most \c
+         *  max_pixel_size pixels, or at the leaves. As every node holds a subsample of its
+         *  subtree, the payloads of these nodes are a level of detail of the points in the
+         *  frustum which is finer close to the eye. Like the other frustum queries, the complete
+         *  payload of every selected node is returned. With asynchronous I/O enabled (see \ref
+         *  setAsyncIO) the payloads are read ahead of the traversal by the I/O threads.
+         *
+         * \param[in] planes The six frustum planes (a, b, c, d), points inside fulfill a*x + b*y + c*z + d >= 0
+         * \param[in] eye The position of the camera
+         * \param[in] focal_length The focal length in pixels, the image height divided by 2 * tan (vertical field of view / 2)
+         * \param[in] max_pixel_size The screen space error in pixels up to which a node is not refined
+         * \param[out] dst The destination vector of points
+         * \param[out] ranges The range [first, second) of the points of every selected node in \c dst, in breadth first order
+         */
+        void
+        queryFrustumLOD (const double *planes, const Eigen::Vector3d &eye, const double focal_length, const double max_pixel_size,
+                         AlignedPointTVector &dst, std::vector<std::pair<std::size_t, std::size_t> > &ranges) const;
         
         //--------------------------------------------------------------------------------
         //templated PointT methods
@@ -332,6 +370,10 @@ namespace pcl
          * \param[in] query_depth The depth from which point data will be taken
          *   \note If the LODs of the tree have not been built, you must specify the maximum depth in order to retrieve any data
          * \param[out] dst The destination vector of points
+         *
+         * \note With asynchronous I/O enabled (see \ref setAsyncIO), the tree is traversed
+         * breadth first and the payloads of the nodes are read ahead of the traversal by
+         * the I/O threads. The result is the same.
          */
         void
         queryBBIncludes (const Eigen::Vector3d &min, const Eigen::Vector3d &max, const std::uint64_t query_depth, AlignedPointTVector &dst) const;
@@ -566,7 +608,86 @@ namespace pcl
         {
           this->sample_percent_ = std::fabs (sample_percent_arg) > 1.0 ? 1.0 : std::fabs (sample_percent_arg);
         }
-	
+
+        /** \brief Enable asynchronous, prefetching reads of the node payloads for \ref queryBBIncludes,
+         *  \ref queryFrustum and \ref queryFrustumLOD. The queries collect the nodes they need in breadth first
+         *  order and keep up to \c read_ahead reads queued ahead of the node they are
+         *  processing, which are served by a pool of \c nr_threads I/O threads. Payloads are
+         *  kept in a least recently used cache of \c cache_size bytes shared by all queries.
+         *
+         * \param[in] nr_threads number of I/O threads, 0 disables asynchronous I/O (default)
+         * \param[in] cache_size budget of the payload cache in bytes
+         * \param[in] read_ahead maximum number of reads queued ahead of the traversal
+         */
+        void
+        setAsyncIO (unsigned int nr_threads, std::size_t cache_size = 256 * 1024 * 1024, std::size_t read_ahead = 64);
+
+        /** \brief Returns the number of I/O threads used by the queries, 0 if asynchronous I/O is disabled */
+        inline unsigned int
+        getAsyncIOThreads () const
+        {
+          return (async_reader_ ? async_reader_->getNumberOfThreads () : 0);
+        }
+
+        // Bulk loading
+        // -----------------------------------------------------------------------
+
+        /** \brief Build an empty tree from the points of a set of PCD files with the external memory bulk loader.
+         *
+         * Instead of pushing the points down the tree one batch at a time, the input is
+         * streamed through the tree in partitioning passes: every pass distributes the points
+         * of a node into temporary spill files, one per Morton code prefix (i.e. per
+         * descendant a few levels below the node), computing the codes in parallel. Partitions
+         * which hold at most \ref getBulkLoadPartitionSize points are then loaded, sorted by
+         * Morton code in memory and turned into their subtree in parallel; larger partitions
+         * are partitioned again. Each node file is written exactly once, and the LODs are
+         * subsampled bottom-up while the subtrees are built, such that every internal node
+         * holds a uniform random sample of sample_percent^(depth - node_depth + 1) of the points
+         * below it, as with \ref buildLOD.
+         *
+         * \param[in] pcd_files the files to load, they are read one at a time
+         * \param[in] gen_lod whether to generate the LODs of the internal nodes
+         * \return number of points added to the tree; points outside of its bounding box are dropped
+         * \note The points are read as PointT, fields of the files which are not part of PointT are dropped.
+         */
+        std::uint64_t
+        bulkLoad (const std::vector<boost::filesystem::path> &pcd_files, const bool gen_lod = true);
+
+        /** \brief Build an empty tree from the points of \c point_cloud with the external memory bulk loader.
+         *  See \ref bulkLoad (const std::vector<boost::filesystem::path>&, const bool).
+         */
+        std::uint64_t
+        bulkLoad (const PointCloudConstPtr &point_cloud, const bool gen_lod = true);
+
+        /** \brief Set the number of threads used by \ref bulkLoad
+         * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+         */
+        void
+        setNumberOfThreads (unsigned int nr_threads = 0);
+
+        /** \brief Returns the number of threads used by \ref bulkLoad */
+        inline unsigned int
+        getNumberOfThreads () const
+        {
+          return (threads_);
+        }
+
+        /** \brief Set the maximum number of points of a partition which is built in memory by
+         *  \ref bulkLoad. Up to one partition per thread is held in memory at a time.
+         */
+        inline void
+        setBulkLoadPartitionSize (const std::uint64_t partition_size)
+        {
+          bulk_load_partition_size_ = std::max<std::uint64_t> (partition_size, 1);
+        }
+
+        /** \brief Returns the maximum number of points of a partition which is built in memory by \ref bulkLoad */
+        inline std::uint64_t
+        getBulkLoadPartitionSize () const
+        {
+          return (bulk_load_partition_size_);
+        }
+
       protected:
         void
         init (const std::uint64_t& depth, const Eigen::Vector3d& min, const Eigen::Vector3d& max, const boost::filesystem::path& root_name, const std::string& coord_sys);
@@ -604,6 +725,73 @@ namespace pcl
         inline void
         incrementPointsInLOD (std::uint64_t depth, std::uint64_t inc);
 
+        /** \brief Drop the payloads cached by the asynchronous reader; called by the
+         *  writers while they hold the write lock, as rewritten nodes may keep their file
+         *  and their number of points.
+         */
+        void
+        invalidatePayloadCache ();
+
+        /** \brief Read the payloads of \c nodes in the given order and pass them to \c
+         *  process together with their index; reads are issued ahead of \c process through
+         *  the asynchronous reader when it is enabled.
+         */
+        void
+        readNodePayloads (const std::vector<OutofcoreNodeType*> &nodes,
+                          const std::function<void (std::size_t, const AlignedPointTVector&)> &process) const;
+
+        /** \brief Classify the bounding box of \c node against the six frustum \c planes
+         *  \return 0 if the node is inside, 1 if it intersects and 2 if it is outside of the frustum
+         */
+        static int
+        intersectFrustum (const double *planes, const OutofcoreNodeType &node);
+
+        /** \brief Reads the next chunk of the bulk load input into its argument; returns false once the input is exhausted */
+        using BulkLoadReader = std::function<bool (AlignedPointTVector&)>;
+
+        /** \brief Bulk load the points of \c reader into the (empty) tree */
+        std::uint64_t
+        bulkLoadStream (const BulkLoadReader &reader, const bool gen_lod);
+
+        /** \brief Distribute the points of \c reader, which all fall into \c node, into spill
+         *  files in \c spill_dir by Morton code prefix and build the subtrees of the partitions.
+         *  \param[out] lod_points number of points added at each depth
+         *  \return the LOD sample \c node contributes to its parent
+         */
+        AlignedPointTVector
+        bulkLoadPartition (OutofcoreNodeType &node, const BulkLoadReader &reader, const bool gen_lod,
+                           const boost::filesystem::path &spill_dir, std::vector<std::uint64_t> &lod_points);
+
+        /** \brief Build the subtree of \c node from \c points, which are sorted by their Morton
+         *  \c codes relative to \c node; writes every node of the subtree once.
+         *  \return the LOD sample \c node contributes to its parent
+         */
+        AlignedPointTVector
+        bulkLoadSubtree (OutofcoreNodeType &node, const AlignedPointTVector &points, const std::vector<std::uint64_t> &codes,
+                         const std::size_t begin, const std::size_t end, const bool gen_lod,
+                         std::mt19937 &rng, std::vector<std::uint64_t> &lod_points);
+
+        /** \brief Subsample the LOD of the internal \c node from the samples its children
+         *  contribute, write it and return the sample \c node contributes to its parent
+         */
+        AlignedPointTVector
+        bulkLoadLOD (OutofcoreNodeType &node, const AlignedPointTVector &children_samples,
+                     std::mt19937 &rng, std::vector<std::uint64_t> &lod_points);
+
+        /** \brief Draw a uniform random sample of \c percent of \c points, at least one point
+         *  unless \c points is empty; the sample keeps the order of \c points.
+         */
+        static void
+        randomSubsample (const AlignedPointTVector &points, const double percent, std::mt19937 &rng, AlignedPointTVector &sample);
+
+        /** \brief Returns the Morton code of \c point in the grid of 2^levels cells per axis
+         *  spanning the box \c min_bb, \c max_bb. The octant of each level is encoded as the
+         *  child index of the tree, (z << 2) | (y << 1) | x, with the first level in the most
+         *  significant bits.
+         */
+        static std::uint64_t
+        computeMortonCode (const PointT &point, const Eigen::Vector3d &min_bb, const Eigen::Vector3d &max_bb, const unsigned int levels);
+
         /** \brief Auxiliary function to validate path_name extension is .octree
          *  
          *  \return 0 if bad; 1 if extension is .oct_idx
@@ -639,6 +827,9 @@ namespace pcl
 
         const static std::uint64_t LOAD_COUNT_ = static_cast<std::uint64_t>(2e9);
 
+        /** \brief Asynchronous payload reader used by the queries, null if disabled */
+        typename OutofcoreAsyncReader<PointT>::Ptr async_reader_;
+
       private:    
 
         /** \brief Auxiliary function to enlarge a bounding box to a cube. */
@@ -652,6 +843,12 @@ namespace pcl
         double sample_percent_;
 
         pcl::RandomSample<pcl::PCLPointCloud2>::Ptr lod_filter_ptr_;
+
+        /** \brief Number of threads used by the bulk loader */
+        unsigned int threads_;
+
+        /** \brief Maximum number of points of a partition the bulk loader builds in memory */
+        std::uint64_t bulk_load_partition_size_;
         
     };
   }
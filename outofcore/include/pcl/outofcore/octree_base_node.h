@@ -64,6 +64,9 @@ namespace pcl
     template<typename ContainerT, typename PointT>
     class OutofcoreOctreeBase;
 
+    template<typename PointT>
+    class OutofcorePackedOctree;
+
     /** \brief Non-class function which creates a single child leaf; used with \ref queryBBIntersects_noload to avoid loading the data from disk */
     template<typename ContainerT, typename PointT> OutofcoreOctreeBaseNode<ContainerT, PointT>*
     makenode_norec (const boost::filesystem::path &path, OutofcoreOctreeBaseNode<ContainerT, PointT>* super);
@@ -95,6 +98,7 @@ namespace pcl
     class OutofcoreOctreeBaseNode : public pcl::octree::OctreeNode
     {
       friend class OutofcoreOctreeBase<ContainerT, PointT> ;
+      friend class OutofcorePackedOctree<PointT>;
 
       //these methods can be rewritten with the iterators. 
       friend OutofcoreOctreeBaseNode<ContainerT, PointT>*
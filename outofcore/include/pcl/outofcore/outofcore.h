@@ -50,6 +50,9 @@
 #include <pcl/outofcore/octree_disk_container.h>
 #include <pcl/outofcore/octree_ram_container.h>
 
+#include <pcl/outofcore/outofcore_async_reader.h>
+#include <pcl/outofcore/outofcore_packed_octree.h>
+
 #include <pcl/outofcore/outofcore_iterator_base.h>
 #include <pcl/outofcore/outofcore_breadth_first_iterator.h>
 #include <pcl/outofcore/outofcore_depth_first_iterator.h>
@@ -0,0 +1,245 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2020-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <pcl/memory.h>
+#include <pcl/outofcore/impl/lru_cache.hpp>
+
+#include <Eigen/StdVector>
+
+// C++
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pcl
+{
+  namespace outofcore
+  {
+    /** \class OutofcoreNodeCache
+     *
+     *  \brief Thread safe, least recently used cache of node payloads with a
+     *  budget in bytes, built on \ref LRUCache. Payloads are shared read-only
+     *  between the cache and its users, so evicting a payload never invalidates
+     *  data a query is still working on.
+     *
+     *  \ingroup outofcore
+     */
+    template<typename PointT>
+    class OutofcoreNodeCache
+    {
+      public:
+        using AlignedPointTVector = std::vector<PointT, Eigen::aligned_allocator<PointT> >;
+        using PayloadConstPtr = shared_ptr<const AlignedPointTVector>;
+
+        /** \brief Constructor
+         *  \param[in] capacity budget of the cache in bytes, 0 disables caching
+         */
+        explicit
+        OutofcoreNodeCache (std::size_t capacity);
+
+        /** \brief Returns the cached payload of \c key, or a null pointer if it is not cached */
+        PayloadConstPtr
+        get (const std::string &key);
+
+        /** \brief Inserts \c payload under \c key, evicting the least recently
+         *  used payloads to stay within the budget. Payloads larger than the
+         *  whole budget are not cached.
+         */
+        void
+        insert (const std::string &key, const PayloadConstPtr &payload);
+
+        /** \brief Removes all payloads from the cache */
+        void
+        clear ();
+
+        /** \brief Returns the amount of bytes held by the cache */
+        std::size_t
+        size () const;
+
+        /** \brief Returns the budget of the cache in bytes */
+        inline std::size_t
+        getCapacity () const
+        {
+          return (capacity_);
+        }
+
+      protected:
+        /** \brief Cache item accounting for the size of the payload it holds */
+        class PayloadCacheItem : public LRUCacheItem<PayloadConstPtr>
+        {
+          public:
+            std::size_t
+            sizeOf () const override
+            {
+              return (sizeof (PayloadCacheItem) + (this->item ? this->item->size () * sizeof (PointT) : 0));
+            }
+        };
+
+        /** \brief Budget of the cache in bytes */
+        std::size_t capacity_;
+
+        /** \brief Underlying (not thread safe) LRU cache */
+        LRUCache<std::string, PayloadCacheItem> cache_;
+
+        /** \brief Insertion counter used as cache item timestamp */
+        std::size_t timestamp_;
+
+        /** \brief Mutex guarding the cache */
+        mutable std::mutex mutex_;
+    };
+
+    /** \class OutofcoreAsyncReader
+     *
+     *  \brief Asynchronous reader of node payloads for the outofcore octree.
+     *
+     *  Read requests are queued in a bounded queue and served by a pool of
+     *  worker threads, so that a traversal can issue the reads of the nodes it
+     *  is going to visit next while it processes the current one, and cold
+     *  queries keep several reads in flight instead of reading one file at a
+     *  time. Payloads which have been read are kept in a \ref OutofcoreNodeCache
+     *  shared by all requests, and concurrent requests of the same payload are
+     *  merged into a single read.
+     *
+     *  \ingroup outofcore
+     */
+    template<typename PointT>
+    class OutofcoreAsyncReader
+    {
+      public:
+        using Ptr = shared_ptr<OutofcoreAsyncReader<PointT> >;
+        using ConstPtr = shared_ptr<const OutofcoreAsyncReader<PointT> >;
+
+        using AlignedPointTVector = typename OutofcoreNodeCache<PointT>::AlignedPointTVector;
+        using PayloadConstPtr = typename OutofcoreNodeCache<PointT>::PayloadConstPtr;
+        using PayloadFuture = std::shared_future<PayloadConstPtr>;
+
+        /** \brief Function reading a payload from disk into its argument */
+        using Loader = std::function<void (AlignedPointTVector&)>;
+
+        /** \brief Constructor, starts the worker threads
+         *  \param[in] nr_threads number of worker threads (at least one is started)
+         *  \param[in] cache_size budget of the payload cache in bytes
+         *  \param[in] max_pending maximum number of queued requests; \ref request blocks while the queue is full
+         */
+        OutofcoreAsyncReader (unsigned int nr_threads, std::size_t cache_size, std::size_t max_pending);
+
+        /** \brief Destructor, serves the queued requests and joins the worker threads */
+        ~OutofcoreAsyncReader ();
+
+        /** \brief Request the payload identified by \c key.
+         *
+         *  If the payload is cached the returned future is ready; otherwise
+         *  \c loader is run by one of the worker threads, unless a read of the
+         *  same payload is already in flight. Exceptions thrown by \c loader are
+         *  rethrown by the future.
+         *
+         *  \param[in] key unique identifier of the payload (and of its version)
+         *  \param[in] loader function reading the payload
+         */
+        PayloadFuture
+        request (const std::string &key, const Loader &loader);
+
+        /** \brief Returns the number of worker threads */
+        inline unsigned int
+        getNumberOfThreads () const
+        {
+          return (static_cast<unsigned int> (workers_.size ()));
+        }
+
+        /** \brief Returns the maximum number of queued requests */
+        inline std::size_t
+        getMaxPending () const
+        {
+          return (max_pending_);
+        }
+
+        /** \brief Returns the payload cache */
+        inline OutofcoreNodeCache<PointT>&
+        getCache ()
+        {
+          return (cache_);
+        }
+
+      protected:
+        /** \brief Queued read request */
+        struct ReadRequest
+        {
+          std::string key;
+          Loader loader;
+          shared_ptr<std::promise<PayloadConstPtr> > promise;
+        };
+
+        /** \brief Worker thread loop */
+        void
+        run ();
+
+        /** \brief Cache of the payloads which have been read */
+        OutofcoreNodeCache<PointT> cache_;
+
+        /** \brief Maximum number of queued requests */
+        std::size_t max_pending_;
+
+        /** \brief Queued requests, served in order */
+        std::deque<ReadRequest> queue_;
+
+        /** \brief Requests which are queued or being read, by key */
+        std::map<std::string, PayloadFuture> in_flight_;
+
+        /** \brief Mutex guarding the queue and the in flight requests */
+        std::mutex mutex_;
+
+        /** \brief Signaled when a request is queued or the reader is stopped */
+        std::condition_variable request_available_;
+
+        /** \brief Signaled when a request is taken from the queue */
+        std::condition_variable slot_available_;
+
+        /** \brief Set when the reader is destroyed */
+        bool stop_;
+
+        /** \brief Worker threads */
+        std::vector<std::thread> workers_;
+    };
+  }
+}
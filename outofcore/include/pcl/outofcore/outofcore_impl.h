@@ -42,9 +42,12 @@
 #include <pcl/outofcore/outofcore.h>
 
 #include <pcl/outofcore/impl/monitor_queue.hpp>
+#include <pcl/outofcore/impl/outofcore_async_reader.hpp>
 
 #include <pcl/outofcore/impl/octree_base.hpp>
 #include <pcl/outofcore/impl/octree_base_node.hpp>
 
 #include <pcl/outofcore/impl/octree_disk_container.hpp>
 #include <pcl/outofcore/impl/octree_ram_container.hpp>
+
+#include <pcl/outofcore/impl/outofcore_packed_octree.hpp>
@@ -0,0 +1,224 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2020-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <pcl/memory.h>
+#include <pcl/point_cloud.h>
+#include <pcl/outofcore/boost.h>
+#include <pcl/outofcore/octree_base.h>
+
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+#include <cstdint>
+#include <vector>
+
+namespace pcl
+{
+  namespace outofcore
+  {
+    /** \brief Header of a packed outofcore octree file, see \ref OutofcorePackedOctree */
+    struct OutofcorePackedHeader
+    {
+      /** \brief File signature, "PCLOCPAK" */
+      char magic[8];
+      /** \brief Version of the packed format */
+      std::uint32_t version;
+      /** \brief sizeof (PointT) of the stored points */
+      std::uint32_t point_size;
+      /** \brief Depth of the tree */
+      std::uint64_t depth;
+      /** \brief Number of nodes in the node table */
+      std::uint64_t node_count;
+      /** \brief Offset of the node table in bytes from the start of the file */
+      std::uint64_t node_table_offset;
+      /** \brief Fields of PointT (see pcl::getFieldsList), zero terminated */
+      char fields[256];
+    };
+
+    /** \brief Record of a node in the node table of a packed outofcore octree file */
+    struct OutofcorePackedNode
+    {
+      /** \brief Flag set if the points of the node are LZF compressed */
+      static const std::uint32_t COMPRESSED = 1;
+
+      /** \brief Bounding box of the node */
+      double bb_min[3];
+      double bb_max[3];
+      /** \brief Depth of the node, 0 for the root */
+      std::uint32_t depth;
+      /** \brief Combination of the node flags */
+      std::uint32_t flags;
+      /** \brief Index of each child in the node table, 0 if the child does not exist (the root is never a child) */
+      std::uint32_t children[8];
+      /** \brief Number of points of the node */
+      std::uint64_t point_count;
+      /** \brief Offset of the points in bytes from the start of the file */
+      std::uint64_t offset;
+      /** \brief Number of bytes the (compressed) points take in the file */
+      std::uint64_t size;
+    };
+
+    /** \class OutofcorePackedOctree
+     *
+     *  \brief Read-only outofcore octree stored in a single, memory mapped file.
+     *
+     *  The directory layout of \ref OutofcoreOctreeBase keeps a JSON metadata file
+     *  and a PCD file per node, so opening and traversing a large tree costs a file
+     *  open and a JSON parse per node. The packed format stores the whole tree in one
+     *  file: a fixed size header, a table of fixed size node records in breadth first
+     *  order (root first) and the points of the nodes.
+     *
+     *  Opening a packed tree maps the file and checks its header, which takes constant
+     *  time regardless of the size of the tree; nodes are then read straight from the
+     *  mapped node table. The points of a node are stored either as a plain array of
+     *  PointT, which \ref getNodePoints returns without copying, or LZF compressed with
+     *  the point fields stored column-wise (as in binary_compressed PCD files), which
+     *  \ref readNode decompresses. A node is only stored compressed if that makes it
+     *  smaller.
+     *
+     *  Packed trees are created from an existing tree with \ref convert:
+     *  \code
+     *  OutofcoreOctreeBase<> tree ("tree/tree.oct_idx", false);
+     *  OutofcorePackedOctree<>::convert (tree, "tree.pack");
+     *
+     *  OutofcorePackedOctree<> packed ("tree.pack");
+     *  packed.queryBBIncludes (min, max, packed.getDepth (), points);
+     *  \endcode
+     *
+     *  The file is stored in the native byte order. All methods are const and can be
+     *  called concurrently.
+     *
+     *  \ingroup outofcore
+     */
+    template<typename PointT = pcl::PointXYZ>
+    class OutofcorePackedOctree
+    {
+      public:
+        using Ptr = shared_ptr<OutofcorePackedOctree<PointT> >;
+        using ConstPtr = shared_ptr<const OutofcorePackedOctree<PointT> >;
+
+        using AlignedPointTVector = std::vector<PointT, Eigen::aligned_allocator<PointT> >;
+
+        /** \brief Open a packed tree. Only the header is checked, the children of the nodes
+         *  are checked by \ref queryBBIncludes when it reaches them.
+         *  \param[in] file path of the packed tree
+         *  \throws PCLException if the file can not be mapped, is not a packed tree of PointT
+         *  or its node table does not fit into the file
+         */
+        explicit
+        OutofcorePackedOctree (const boost::filesystem::path &file);
+
+        /** \brief Write \c tree to a packed tree file
+         *  \param[in] tree the tree to convert; all of its nodes are loaded in the process
+         *  \param[in] file path of the packed tree, overwritten if it exists
+         *  \param[in] compress whether to LZF compress the points of the nodes
+         *  \throws PCLException if the file can not be written
+         */
+        template<typename ContainerT> static void
+        convert (OutofcoreOctreeBase<ContainerT, PointT> &tree, const boost::filesystem::path &file, const bool compress = true);
+
+        /** \brief Returns the depth of the tree */
+        inline std::uint64_t
+        getDepth () const
+        {
+          return (header_->depth);
+        }
+
+        /** \brief Returns the number of nodes of the tree */
+        inline std::size_t
+        getNumberOfNodes () const
+        {
+          return (static_cast<std::size_t> (header_->node_count));
+        }
+
+        /** \brief Returns the record of the node at \c index in the node table; the root is at index 0
+         *  and \c index has to be smaller than \ref getNumberOfNodes. The children of the record
+         *  are read from the file as they are, they have to be checked before they are followed.
+         */
+        inline const OutofcorePackedNode&
+        getNode (const std::size_t index) const
+        {
+          return (nodes_[index]);
+        }
+
+        /** \brief Get the bounding box of the tree */
+        void
+        getBoundingBox (Eigen::Vector3d &min_bb, Eigen::Vector3d &max_bb) const;
+
+        /** \brief Returns the number of points stored in the nodes at \c depth_index */
+        std::uint64_t
+        getNumPointsAtDepth (const std::uint64_t depth_index) const;
+
+        /** \brief Returns the points of the node at \c index directly from the mapped
+         *  file, or a null pointer if they are stored compressed (see \ref readNode).
+         *  The pointer is valid as long as this object lives.
+         */
+        const PointT*
+        getNodePoints (const std::size_t index) const;
+
+        /** \brief Append the points of the node at \c index to \c dst */
+        void
+        readNode (const std::size_t index, AlignedPointTVector &dst) const;
+
+        /** \brief Get the points of the nodes at \c query_depth which fall into the
+         *  bounding box \c min, \c max, like \ref OutofcoreOctreeBase::queryBBIncludes
+         *  \param[in] min minimum corner of the query bounding box
+         *  \param[in] max maximum corner of the query bounding box
+         *  \param[in] query_depth depth of the nodes to query
+         *  \param[out] dst the points found
+         *  \throws PCLException if a child of a node on the way is not a later node of the
+         *  breadth first node table
+         */
+        void
+        queryBBIncludes (const Eigen::Vector3d &min, const Eigen::Vector3d &max, const std::uint64_t query_depth, AlignedPointTVector &dst) const;
+
+        /** \brief Version of the packed format written by \ref convert */
+        static const std::uint32_t VERSION = 1;
+
+      protected:
+        /** \brief Mapping of the whole file */
+        boost::iostreams::mapped_file_source file_;
+
+        /** \brief Header at the start of the mapping */
+        const OutofcorePackedHeader* header_;
+
+        /** \brief Node table in the mapping */
+        const OutofcorePackedNode* nodes_;
+    };
+  }
+}
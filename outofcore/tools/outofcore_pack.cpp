@@ -0,0 +1,147 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2020-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pcl/common/time.h>
+#include <pcl/point_types.h>
+
+#include <pcl/console/print.h>
+#include <pcl/console/parse.h>
+
+#include <pcl/outofcore/outofcore.h>
+#include <pcl/outofcore/outofcore_impl.h>
+
+using PointT = pcl::PointXYZ;
+
+using namespace pcl;
+using namespace pcl::outofcore;
+
+using pcl::console::find_switch;
+using pcl::console::parse_file_extension_argument;
+using pcl::console::print_error;
+using pcl::console::print_info;
+
+using OctreeDisk = OutofcoreOctreeBase<>;
+using OctreeDiskNode = OutofcoreOctreeBaseNode<>;
+using PackedOctree = OutofcorePackedOctree<PointT>;
+
+int
+outofcorePack (const boost::filesystem::path &tree_root, const boost::filesystem::path &output_file, bool compress)
+{
+  pcl::StopWatch timer;
+  try
+  {
+    OctreeDisk octree (tree_root, true);
+    PackedOctree::convert (octree, output_file, compress);
+
+    PackedOctree packed (output_file);
+    std::size_t compressed_nodes = 0;
+    for (std::size_t i = 0; i < packed.getNumberOfNodes (); i++)
+    {
+      if (packed.getNode (i).flags & OutofcorePackedNode::COMPRESSED)
+        compressed_nodes++;
+    }
+
+    print_info ("Packed %zu nodes (%zu compressed) of depth %lu into %s (%lu bytes) in %.3f s\n",
+                packed.getNumberOfNodes (), compressed_nodes, packed.getDepth (), output_file.string ().c_str (),
+                static_cast<unsigned long> (boost::filesystem::file_size (output_file)), timer.getTimeSeconds ());
+  }
+  catch (const pcl::PCLException &e)
+  {
+    print_error ("Could not pack %s: %s\n", tree_root.string ().c_str (), e.detailedMessage ());
+    return (-1);
+  }
+
+  return (0);
+}
+
+void
+printHelp (int, char **argv)
+{
+  print_info ("This program is used to pack an outofcore tree into a single, memory mappable file\n\n");
+  print_info ("The points are packed as PointXYZ, other fields of the tree (e.g. the colors of trees\n");
+  print_info ("built by pcl_outofcore_process from colored clouds) are dropped\n\n");
+  print_info ("%s <options> <input_tree_dir> <output_file.pack>\n", argv[0]);
+  print_info ("\n");
+  print_info ("Options:\n");
+  print_info ("\t -no_compression               \t Store the points of all nodes uncompressed\n");
+  print_info ("\t -h                            \t Display help\n");
+  print_info ("\n");
+}
+
+int
+main (int argc, char* argv[])
+{
+  if (find_switch (argc, argv, "-h"))
+  {
+    printHelp (argc, argv);
+    return (-1);
+  }
+
+  std::vector<int> pack_arg_indices = parse_file_extension_argument (argc, argv, ".pack");
+  if (argc - 1 < 2 || pack_arg_indices.size () != 1 || pack_arg_indices[0] != argc - 1)
+  {
+    printHelp (argc, argv);
+    return (-1);
+  }
+
+  if (find_switch (argc, argv, "-v"))
+    console::setVerbosityLevel (console::L_DEBUG);
+
+  bool compress = !find_switch (argc, argv, "-no_compression");
+
+  boost::filesystem::path tree_root (argv[argc - 2]);
+  boost::filesystem::path output_file (argv[argc - 1]);
+
+  // Check if a root directory was specified, use the root node index in it
+  if (boost::filesystem::is_directory (tree_root))
+  {
+    boost::filesystem::directory_iterator diterend;
+    for (boost::filesystem::directory_iterator diter (tree_root); diter != diterend; ++diter)
+    {
+      const boost::filesystem::path& file = *diter;
+      if (!boost::filesystem::is_directory (file) && boost::filesystem::extension (file) == OctreeDiskNode::node_index_extension)
+        tree_root = file;
+    }
+  }
+
+  if (!boost::filesystem::exists (tree_root))
+  {
+    print_error ("Could not find the tree %s\n", tree_root.string ().c_str ());
+    return (-1);
+  }
+
+  return (outofcorePack (tree_root, output_file, compress));
+}
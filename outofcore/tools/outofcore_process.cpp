@@ -95,7 +95,8 @@ getCloudFromFile (boost::filesystem::path pcd_path)
 
 int
 outofcoreProcess (std::vector<boost::filesystem::path> pcd_paths, boost::filesystem::path root_dir, 
-                  int depth, double resolution, int build_octree_with, bool gen_lod, bool overwrite, bool multiresolution)
+                  int depth, double resolution, int build_octree_with, bool gen_lod, bool overwrite, bool multiresolution,
+                  bool bulk, int threads)
 {
   // Bounding box min/max pts
   PointT min_pt, max_pt;
@@ -178,30 +179,39 @@ outofcoreProcess (std::vector<boost::filesystem::path> pcd_paths, boost::filesys
 
   std::uint64_t total_pts = 0;
 
-  // Iterate over all pcd files adding points to the octree
-  for (const auto &pcd_path : pcd_paths)
+  if (bulk)
   {
+    print_info ("Bulk loading %d clouds\n", pcd_paths.size ());
+    outofcore_octree->setNumberOfThreads (threads);
+    total_pts = outofcore_octree->bulkLoad (pcd_paths, gen_lod && !multiresolution);
+  }
+  else
+  {
+    // Iterate over all pcd files adding points to the octree
+    for (const auto &pcd_path : pcd_paths)
+    {
 
-    PCLPointCloud2::Ptr cloud = getCloudFromFile (pcd_path);
+      PCLPointCloud2::Ptr cloud = getCloudFromFile (pcd_path);
 
-    std::uint64_t pts = 0;
+      std::uint64_t pts = 0;
     
-    if (gen_lod && !multiresolution)
-    {
-      print_info ("  Generating LODs\n");
-      pts = outofcore_octree->addPointCloud_and_genLOD (cloud);
-    }
-    else
-    {
-      pts = outofcore_octree->addPointCloud (cloud, false);
-    }
+      if (gen_lod && !multiresolution)
+      {
+        print_info ("  Generating LODs\n");
+        pts = outofcore_octree->addPointCloud_and_genLOD (cloud);
+      }
+      else
+      {
+        pts = outofcore_octree->addPointCloud (cloud, false);
+      }
     
-    print_info ("Successfully added %lu points\n", pts);
-    print_info ("%lu Points were dropped (probably NaN)\n", cloud->width*cloud->height - pts);
+      print_info ("Successfully added %lu points\n", pts);
+      print_info ("%lu Points were dropped (probably NaN)\n", cloud->width*cloud->height - pts);
     
 //    assert ( pts == cloud->width * cloud->height );
     
-    total_pts += pts;
+      total_pts += pts;
+    }
   }
 
   print_info ("Added a total of %lu from %d clouds\n",total_pts, pcd_paths.size ());
@@ -239,6 +249,8 @@ printHelp (int, char **argv)
   print_info ("\t -gen_lod                      \t Generate octree LODs\n");
   print_info ("\t -overwrite                    \t Overwrite existing octree\n");
   print_info ("\t -multiresolution              \t Generate multiresolutoin LOD\n");
+  print_info ("\t -bulk                         \t Build the octree with the parallel bulk loader (stores x, y, z only)\n");
+  print_info ("\t -threads <threads>            \t Number of threads of the bulk loader (default: all cores)\n");
   print_info ("\t -h                            \t Display help\n");
   print_info ("\n");
 }
@@ -274,6 +286,8 @@ main (int argc, char* argv[])
   bool gen_lod = false;
   bool multiresolution = false;
   bool overwrite = false;
+  bool bulk = false;
+  int threads = 0;
   int build_octree_with = OCTREE_DEPTH;
 
   // If both depth and resolution specified
@@ -292,6 +306,8 @@ main (int argc, char* argv[])
   parse_argument (argc, argv, "-resolution", resolution);
   gen_lod = find_switch (argc, argv, "-gen_lod");
   overwrite = find_switch (argc, argv, "-overwrite");
+  bulk = find_switch (argc, argv, "-bulk");
+  parse_argument (argc, argv, "-threads", threads);
 
   if (gen_lod && find_switch (argc, argv, "-multiresolution"))
   {
@@ -329,5 +345,6 @@ main (int argc, char* argv[])
   if (root_dir.extension () == ".pcd")
     root_dir = root_dir.parent_path () / (root_dir.stem().string() + "_tree").c_str();
 
-  return outofcoreProcess (pcd_paths, root_dir, depth, resolution, build_octree_with, gen_lod, overwrite, multiresolution);
+  return outofcoreProcess (pcd_paths, root_dir, depth, resolution, build_octree_with, gen_lod, overwrite, multiresolution,
+                           bulk, threads);
 }
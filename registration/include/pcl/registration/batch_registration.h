@@ -0,0 +1,225 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2020-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <pcl/registration/default_convergence_criteria.h>
+#include <pcl/registration/registration.h>
+#include <pcl/memory.h>
+#include <pcl/point_cloud.h>
+
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace pcl {
+namespace registration {
+
+/** \brief @b BatchRegistration aligns a batch of independent (source, target, initial
+ * guess) tasks concurrently, e.g. tiles against a map or the candidates of a place
+ * recognition query.
+ *
+ * @ref Registration objects are not thread safe, so every thread works with its own
+ * instance created through the registration factory. A kd-tree is built only once
+ * for every distinct target cloud of the batch and shared (read-only) by all tasks
+ * aligning against it.
+ *
+ * \code
+ * BatchRegistration<PointXYZ, PointXYZ> batch;
+ * batch.setRegistrationFactory ([] () {
+ *   IterativeClosestPoint<PointXYZ, PointXYZ>::Ptr icp (
+ *       new IterativeClosestPoint<PointXYZ, PointXYZ>);
+ *   icp->setMaxCorrespondenceDistance (0.05);
+ *   return (icp);
+ * });
+ * for (const auto& tile : tiles)
+ *   batch.addTask (tile.cloud, map, tile.guess);
+ *
+ * BatchRegistration<PointXYZ, PointXYZ>::Results results;
+ * batch.compute (results);
+ * \endcode
+ * \ingroup registration
+ */
+template <typename PointSource, typename PointTarget, typename Scalar = float>
+class BatchRegistration {
+public:
+  using Ptr = shared_ptr<BatchRegistration<PointSource, PointTarget, Scalar>>;
+  using ConstPtr =
+      shared_ptr<const BatchRegistration<PointSource, PointTarget, Scalar>>;
+
+  using RegistrationT = pcl::Registration<PointSource, PointTarget, Scalar>;
+  using RegistrationPtr = typename RegistrationT::Ptr;
+  using RegistrationFactory = std::function<RegistrationPtr()>;
+
+  using PointCloudSource = typename RegistrationT::PointCloudSource;
+  using PointCloudSourceConstPtr = typename PointCloudSource::ConstPtr;
+  using PointCloudTarget = typename RegistrationT::PointCloudTarget;
+  using PointCloudTargetConstPtr = typename PointCloudTarget::ConstPtr;
+
+  using KdTree = typename RegistrationT::KdTree;
+  using KdTreePtr = typename RegistrationT::KdTreePtr;
+  using Matrix4 = typename RegistrationT::Matrix4;
+  using ConvergenceState =
+      typename DefaultConvergenceCriteria<Scalar>::ConvergenceState;
+
+  /** \brief A single registration problem of the batch. */
+  struct Task {
+    /** \brief The cloud to align. */
+    PointCloudSourceConstPtr source;
+    /** \brief The cloud to align the source to. Tasks sharing the same target cloud
+     * (the same pointer) share its kd-tree. */
+    PointCloudTargetConstPtr target;
+    /** \brief The initial guess of the transformation. */
+    Matrix4 guess;
+    PCL_MAKE_ALIGNED_OPERATOR_NEW
+  };
+  using Tasks = std::vector<Task, Eigen::aligned_allocator<Task>>;
+
+  /** \brief The outcome of a single task. */
+  struct Result {
+    Result()
+    : final_transformation(Matrix4::Identity())
+    , converged(false)
+    , convergence_state(
+          DefaultConvergenceCriteria<Scalar>::CONVERGENCE_CRITERIA_NOT_CONVERGED)
+    , fitness_score(std::numeric_limits<double>::max())
+    , time(0.0)
+    {}
+
+    /** \brief The final transformation, the initial guess for invalid tasks. */
+    Matrix4 final_transformation;
+    /** \brief Whether the registration converged. */
+    bool converged;
+    /** \brief Why the registration stopped. Only known for methods based on
+     * IterativeClosestPoint, CONVERGENCE_CRITERIA_NOT_CONVERGED otherwise. */
+    ConvergenceState convergence_state;
+    /** \brief Mean squared distance between the aligned source and the target. */
+    double fitness_score;
+    /** \brief Time spent on the task in milliseconds. */
+    double time;
+    PCL_MAKE_ALIGNED_OPERATOR_NEW
+  };
+  using Results = std::vector<Result, Eigen::aligned_allocator<Result>>;
+
+  /** \brief Empty constructor. */
+  BatchRegistration() : threads_(1) { setNumberOfThreads(0); }
+
+  /** \brief Empty destructor */
+  virtual ~BatchRegistration() {}
+
+  /** \brief Set the function creating the registration objects, it is called once per
+   * thread before the batch is processed. All objects should be configured the same.
+   * \param[in] factory the registration factory
+   */
+  inline void
+  setRegistrationFactory(const RegistrationFactory& factory)
+  {
+    factory_ = factory;
+  }
+
+  /** \brief Set the number of threads the tasks are distributed to. Only used if
+   * compiled with OpenMP.
+   * \param[in] nr_threads the number of threads to use (0 sets the value back to
+   * automatic)
+   */
+  void
+  setNumberOfThreads(unsigned int nr_threads = 0);
+
+  /** \brief Get the number of threads the tasks are distributed to. */
+  inline unsigned int
+  getNumberOfThreads() const
+  {
+    return (threads_);
+  }
+
+  /** \brief Add a task to the batch.
+   * \param[in] source the cloud to align
+   * \param[in] target the cloud to align the source to
+   * \param[in] guess the initial guess of the transformation
+   * \return the index of the task, which is also the index of its result
+   */
+  std::size_t
+  addTask(const PointCloudSourceConstPtr& source,
+          const PointCloudTargetConstPtr& target,
+          const Matrix4& guess = Matrix4::Identity());
+
+  /** \brief Remove all tasks from the batch. */
+  inline void
+  clearTasks()
+  {
+    tasks_.clear();
+  }
+
+  /** \brief Get the tasks of the batch. */
+  inline const Tasks&
+  getTasks() const
+  {
+    return (tasks_);
+  }
+
+  /** \brief Align all tasks of the batch.
+   * \param[out] results one result per task, in the order the tasks were added
+   */
+  void
+  compute(Results& results);
+
+protected:
+  /** \brief Run a single task with the given registration object.
+   * \param[in] registration the registration object of the calling thread
+   * \param[in] task the task to align
+   * \param[in] tree the search tree of the task target
+   * \param[out] result the outcome of the task
+   */
+  void
+  computeTask(RegistrationT& registration,
+              const Task& task,
+              const KdTreePtr& tree,
+              Result& result) const;
+
+  /** \brief The function creating a registration object per thread. */
+  RegistrationFactory factory_;
+
+  /** \brief The tasks of the batch. */
+  Tasks tasks_;
+
+  /** \brief The number of threads the tasks are distributed to. */
+  unsigned int threads_;
+};
+
+} // namespace registration
+} // namespace pcl
+
+#include <pcl/registration/impl/batch_registration.hpp>
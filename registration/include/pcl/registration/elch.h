@@ -92,7 +92,11 @@ public:
   , loop_end_(0)
   , reg_(new pcl::IterativeClosestPoint<PointT, PointT>)
   , compute_loop_(true)
-  , vd_(){};
+  , vd_()
+  , threads_(1)
+  {
+    setNumberOfThreads(0);
+  };
 
   /** \brief Empty destructor */
   ~ELCH() {}
@@ -194,6 +198,21 @@ public:
     compute_loop_ = false;
   }
 
+  /** \brief Set the number of threads used to compute the loop weights and to
+   * transform the point clouds. Only used if compiled with OpenMP.
+   * \param[in] nr_threads the number of threads to use (0 sets the value back to
+   * automatic)
+   */
+  void
+  setNumberOfThreads(unsigned int nr_threads = 0);
+
+  /** \brief Getter for the number of threads. */
+  inline unsigned int
+  getNumberOfThreads() const
+  {
+    return (threads_);
+  }
+
   /** \brief Computes new poses for all point clouds by closing the loop
    * between start and end point cloud. This will transform all given point
    * clouds for now!
@@ -245,6 +264,9 @@ private:
   /** \brief previously added node in the loop_graph_. */
   typename boost::graph_traits<LoopGraph>::vertex_descriptor vd_;
 
+  /** \brief The number of threads used by compute (). */
+  unsigned int threads_;
+
 public:
   PCL_MAKE_ALIGNED_OPERATOR_NEW
 };
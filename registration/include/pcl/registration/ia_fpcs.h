@@ -275,6 +275,28 @@ public:
     return (max_runtime_);
   };
 
+  /** \brief Set the maximum number of source point pairs stored in the pair index.
+   *
+   * Before the base trials start, all source point pairs that are short enough to
+   * match a base diagonal are collected once and bucketed by their length, so that
+   * the candidate pairs of a base diagonal are looked up instead of searched among
+   * all source pairs. If more pairs than this limit are found, the index is dropped
+   * and the pairs are searched exhaustively for every base.
+   * \param[in] max_size the maximum number of indexed pairs (0 disables the index)
+   */
+  inline void
+  setMaxPairIndexSize(std::size_t max_size)
+  {
+    max_pair_index_size_ = max_size;
+  };
+
+  /** \return the maximum number of source point pairs stored in the pair index. */
+  inline std::size_t
+  getMaxPairIndexSize() const
+  {
+    return (max_pair_index_size_);
+  };
+
   /** \return the fitness score of the best scored four-point match. */
   inline float
   getFitnessScore() const
@@ -348,8 +370,16 @@ protected:
   float
   segmentToSegmentDist(const std::vector<int>& base_indices, float (&ratio)[2]);
 
+  /** \brief Collect all source point pairs that can correspond to a base diagonal and
+   * store them bucketed by their length (see \ref setMaxPairIndexSize). Called once
+   * per alignment after \ref initCompute, the index is only read afterwards and
+   * shared by all threads.
+   */
+  void
+  buildPairIndex();
+
   /** \brief Search for corresponding point pairs given the distance between two base
-   * points.
+   * points. Uses the pair index if available, otherwise all source pairs are tested.
    *
    * \param[in] idx1 first index of current base segment (in source cloud)
    * \param[in] idx2 second index of current base segment (in source cloud)
@@ -553,6 +583,24 @@ protected:
 
   /** \brief Definition of a small error. */
   const float small_error_;
+
+  /** \brief Maximum number of source point pairs in the pair index (standard = 2^24).
+   */
+  std::size_t max_pair_index_size_;
+
+  /** \brief Source point pairs (index_query < index_match) with their length, sorted by
+   * length bucket and within a bucket by their indices. */
+  pcl::Correspondences pair_index_;
+
+  /** \brief Offsets of the length buckets in pair_index_; bucket i holds the pairs
+   * with a length in [i, i + 1) * pair_index_bucket_size_. Empty if no index exists. */
+  std::vector<std::size_t> pair_index_buckets_;
+
+  /** \brief Length range covered by a single bucket of the pair index. */
+  float pair_index_bucket_size_;
+
+  /** \brief Maximum pair length stored in the pair index. */
+  float pair_index_max_dist_;
 };
 }; // namespace registration
 }; // namespace pcl
@@ -44,6 +44,8 @@
 #include <pcl/registration/transformation_estimation_svd.h>
 #include <pcl/memory.h>
 
+#include <random>
+
 namespace pcl {
 /** \brief @b SampleConsensusInitialAlignment is an implementation of the initial
  * alignment algorithm described in section IV of "Fast Point Feature Histograms (FPFH)
@@ -147,6 +149,7 @@ public:
   , k_correspondences_(10)
   , feature_tree_(new pcl::KdTreeFLANN<FeatureT>)
   , error_functor_()
+  , threads_(-1)
   {
     reg_name_ = "SampleConsensusInitialAlignment";
     max_iterations_ = 1000;
@@ -257,6 +260,29 @@ public:
     return (error_functor_);
   }
 
+  /** \brief Set the number of threads to use or turn off parallelization.
+   * In parallel mode the feature correspondences of all source points are computed
+   * up front, every thread draws its samples from its own random number generator
+   * (seeded from std::rand ()) and the error of a hypothesis stops being accumulated
+   * as soon as it exceeds the lowest error found so far.
+   * \param[in] nr_threads the number of hardware threads to use (0 sets the value
+   * automatically, a negative number turns parallelization off)
+   * \note The early termination assumes that the error function is non-negative,
+   * which holds for HuberPenalty and TruncatedError.
+   */
+  inline void
+  setNumberOfThreads(int nr_threads = -1)
+  {
+    threads_ = nr_threads;
+  }
+
+  /** \brief Get the number of threads, as set by the user. */
+  inline int
+  getNumberOfThreads() const
+  {
+    return (threads_);
+  }
+
 protected:
   /** \brief Choose a random index between 0 and n-1
    * \param n the number of possible indices to choose from
@@ -267,6 +293,16 @@ protected:
     return (static_cast<int>(n * (rand() / (RAND_MAX + 1.0))));
   };
 
+  /** \brief Choose a random index between 0 and n-1
+   * \param n the number of possible indices to choose from
+   * \param rng the random number generator to draw from
+   */
+  inline int
+  getRandomIndex(int n, std::mt19937& rng) const
+  {
+    return (std::uniform_int_distribution<int>(0, n - 1)(rng));
+  };
+
   /** \brief Select \a nr_samples sample points from cloud while making sure that their
    * pairwise distances are greater than a user-defined minimum distance, \a
    * min_sample_distance. \param cloud the input point cloud \param nr_samples the
@@ -279,6 +315,22 @@ protected:
                 float min_sample_distance,
                 std::vector<int>& sample_indices);
 
+  /** \brief Select \a nr_samples sample points from cloud while making sure that their
+   * pairwise distances are greater than \a min_sample_distance, drawing from the given
+   * generator instead of std::rand (). \param cloud the input point cloud \param
+   * nr_samples the number of samples to select \param min_sample_distance the minimum
+   * distance between any two samples, relaxed in place if no valid sample can be found
+   * \param sample_indices the resulting sample indices \param random_index functor
+   * returning a random index in [0, n-1] for a given n
+   */
+  template <typename RandomIndex>
+  void
+  selectSamples(const PointCloudSource& cloud,
+                int nr_samples,
+                float& min_sample_distance,
+                std::vector<int>& sample_indices,
+                RandomIndex&& random_index) const;
+
   /** \brief For each of the sample points, find a list of points in the target cloud
    * whose features are similar to the sample points' features. From these, select one
    * randomly which will be considered that sample point's correspondence. \param
@@ -298,6 +350,26 @@ protected:
   float
   computeErrorMetric(const PointCloudSource& cloud, float threshold);
 
+  /** \brief Compute the error metric of the input cloud transformed by the given
+   * transformation, stopping as soon as the error reaches \a max_error.
+   * \param transformation the transformation applied to the input cloud
+   * \param max_error the error to beat
+   * \return the error, or a value not lower than \a max_error if the computation was
+   * stopped early
+   */
+  float
+  computeErrorMetric(const Eigen::Matrix4f& transformation, float max_error) const;
+
+  /** \brief Generate and verify pose hypotheses in parallel, updating
+   * \b final_transformation_ and \b converged_ if a better hypothesis than
+   * \a lowest_error is found.
+   * \param threads the number of threads to use
+   * \param nr_hypotheses the number of hypotheses to generate
+   * \param lowest_error the error to beat, updated with the best error found
+   */
+  void
+  computeHypothesesParallel(int threads, int nr_hypotheses, float& lowest_error);
+
   /** \brief Rigid transformation computation method.
    * \param output the transformed input point cloud dataset using the rigid
    * transformation found \param guess The computed transforamtion
@@ -327,6 +399,10 @@ protected:
 
   ErrorFunctorPtr error_functor_;
 
+  /** \brief The number of threads the scheduler should use, or a negative number if
+   * no parallelization is wanted. */
+  int threads_;
+
 public:
   PCL_MAKE_ALIGNED_OPERATOR_NEW
 };
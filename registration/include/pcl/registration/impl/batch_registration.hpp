@@ -0,0 +1,190 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2020-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_REGISTRATION_IMPL_BATCH_REGISTRATION_HPP_
+#define PCL_REGISTRATION_IMPL_BATCH_REGISTRATION_HPP_
+
+#include <pcl/common/time.h>
+#include <pcl/registration/icp.h>
+
+#include <map>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl {
+
+namespace registration {
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+BatchRegistration<PointSource, PointTarget, Scalar>::setNumberOfThreads(
+    unsigned int nr_threads)
+{
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    threads_ = omp_get_num_procs();
+#else
+    threads_ = 1;
+#endif
+  else
+    threads_ = nr_threads;
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+std::size_t
+BatchRegistration<PointSource, PointTarget, Scalar>::addTask(
+    const PointCloudSourceConstPtr& source,
+    const PointCloudTargetConstPtr& target,
+    const Matrix4& guess)
+{
+  Task task;
+  task.source = source;
+  task.target = target;
+  task.guess = guess;
+  tasks_.push_back(task);
+  return (tasks_.size() - 1);
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+BatchRegistration<PointSource, PointTarget, Scalar>::compute(Results& results)
+{
+  results.assign(tasks_.size(), Result());
+  for (std::size_t i = 0; i < tasks_.size(); ++i)
+    results[i].final_transformation = tasks_[i].guess;
+  if (tasks_.empty())
+    return;
+
+  if (!factory_) {
+    PCL_ERROR("[pcl::registration::BatchRegistration::compute] No registration "
+              "factory given!\n");
+    return;
+  }
+
+  // Registration objects are not thread safe, create one per thread up front since
+  // the factory does not need to be thread safe either
+  std::vector<RegistrationPtr> registrations(threads_);
+  for (auto& registration : registrations) {
+    registration = factory_();
+    if (!registration) {
+      PCL_ERROR("[pcl::registration::BatchRegistration::compute] The registration "
+                "factory returned an invalid object!\n");
+      return;
+    }
+  }
+
+  // Collect the distinct targets, every one of them is indexed only once
+  std::vector<PointCloudTargetConstPtr> targets;
+  std::vector<int> target_ids(tasks_.size(), -1);
+  std::map<const PointCloudTarget*, int> target_map;
+  for (std::size_t i = 0; i < tasks_.size(); ++i) {
+    const Task& task = tasks_[i];
+    if (!task.source || task.source->empty() || !task.target || task.target->empty())
+      continue;
+    const auto it =
+        target_map.emplace(task.target.get(), static_cast<int>(targets.size()));
+    if (it.second)
+      targets.push_back(task.target);
+    target_ids[i] = it.first->second;
+  }
+
+  std::vector<KdTreePtr> trees(targets.size());
+  int nr_targets = static_cast<int>(targets.size());
+#pragma omp parallel for default(none) shared(targets, trees, nr_targets)              \
+    schedule(dynamic) num_threads(threads_)
+  for (int i = 0; i < nr_targets; ++i) {
+    trees[i].reset(new KdTree);
+    trees[i]->setInputCloud(targets[i]);
+  }
+
+  // The trees are only read from now on, larger batches than threads are balanced
+  // dynamically since the cost of a task varies a lot
+  int nr_tasks = static_cast<int>(tasks_.size());
+#pragma omp parallel for default(none)                                                 \
+    shared(registrations, trees, target_ids, results, nr_tasks) schedule(dynamic)      \
+        num_threads(threads_)
+  for (int i = 0; i < nr_tasks; ++i) {
+    if (target_ids[i] < 0) {
+      PCL_ERROR("[pcl::registration::BatchRegistration::compute] Task %d has an "
+                "empty source or target cloud!\n",
+                i);
+      continue;
+    }
+#ifdef _OPENMP
+    RegistrationT& registration = *registrations[omp_get_thread_num()];
+#else
+    RegistrationT& registration = *registrations[0];
+#endif
+    computeTask(registration, tasks_[i], trees[target_ids[i]], results[i]);
+  }
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+BatchRegistration<PointSource, PointTarget, Scalar>::computeTask(
+    RegistrationT& registration,
+    const Task& task,
+    const KdTreePtr& tree,
+    Result& result) const
+{
+  pcl::StopWatch watch;
+
+  registration.setInputSource(task.source);
+  registration.setInputTarget(task.target);
+  // The tree already indexes the target, never let align () rebuild it
+  registration.setSearchMethodTarget(tree, true);
+
+  PointCloudSource output;
+  registration.align(output, task.guess);
+
+  result.converged = registration.hasConverged();
+  result.final_transformation = registration.getFinalTransformation();
+  result.fitness_score = registration.getFitnessScore();
+
+  using ICP = IterativeClosestPoint<PointSource, PointTarget, Scalar>;
+  ICP* icp = dynamic_cast<ICP*>(&registration);
+  if (icp && icp->getConvergeCriteria())
+    result.convergence_state = icp->getConvergeCriteria()->getConvergenceState();
+
+  result.time = watch.getTime();
+}
+
+} // namespace registration
+} // namespace pcl
+
+#endif // PCL_REGISTRATION_IMPL_BATCH_REGISTRATION_HPP_
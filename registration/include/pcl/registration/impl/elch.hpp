@@ -49,6 +49,25 @@
 #include <list>
 #include <tuple>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT>
+void
+pcl::registration::ELCH<PointT>::setNumberOfThreads(unsigned int nr_threads)
+{
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    threads_ = omp_get_num_procs();
+#else
+    threads_ = 1;
+#endif
+  else
+    threads_ = nr_threads;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT>
 void
@@ -230,11 +249,14 @@ pcl::registration::ELCH<PointT>::compute()
                j); // TODO add variance
   }
 
+  // the weights of the three translation axes and the rotation are independent
   double* weights[4];
-  for (int i = 0; i < 4; i++) {
-    weights[i] = new double[num_vertices(*loop_graph_)];
+  for (auto& weight : weights)
+    weight = new double[num_vertices(*loop_graph_)];
+
+#pragma omp parallel for default(none) shared(grb, weights) num_threads(threads_)
+  for (int i = 0; i < 4; i++)
     loopOptimizerAlgorithm(grb[i], weights[i]);
-  }
 
   // TODO use pose
   // Eigen::Vector4f cend;
@@ -247,14 +269,19 @@ pcl::registration::ELCH<PointT>::compute()
   // typename boost::graph_traits<LoopGraph>::vertex_iterator vertex_it, vertex_it_end;
   // for (std::tie (vertex_it, vertex_it_end) = vertices (*loop_graph_); vertex_it !=
   // vertex_it_end; vertex_it++)
-  for (std::size_t i = 0; i < num_vertices(*loop_graph_); i++) {
+  Eigen::Affine3f bl(loop_transform_);
+  Eigen::Quaternionf q(bl.rotation());
+  int nr_vertices = static_cast<int>(num_vertices(*loop_graph_));
+
+  // every vertex only touches its own cloud
+#pragma omp parallel for default(none) shared(weights, bl, q, nr_vertices)             \
+    schedule(dynamic) num_threads(threads_)
+  for (int i = 0; i < nr_vertices; i++) {
     Eigen::Vector3f t2;
     t2[0] = loop_transform_(0, 3) * static_cast<float>(weights[0][i]);
     t2[1] = loop_transform_(1, 3) * static_cast<float>(weights[1][i]);
     t2[2] = loop_transform_(2, 3) * static_cast<float>(weights[2][i]);
 
-    Eigen::Affine3f bl(loop_transform_);
-    Eigen::Quaternionf q(bl.rotation());
     Eigen::Quaternionf q2;
     q2 = Eigen::Quaternionf::Identity().slerp(static_cast<float>(weights[3][i]), q);
 
@@ -45,6 +45,8 @@
 #include <pcl/registration/transformation_estimation_3point.h>
 #include <pcl/sample_consensus/sac_model_plane.h>
 
+#include <algorithm>
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT>
 inline float
@@ -152,6 +154,9 @@ pcl::registration::FPCSInitialAlignment<PointSource, PointTarget, NormalT, Scala
 , max_mse_()
 , max_inlier_dist_sqr_()
 , small_error_(0.00001f)
+, max_pair_index_size_(1 << 24)
+, pair_index_bucket_size_()
+, pair_index_max_dist_()
 {
   reg_name_ = "pcl::registration::FPCSInitialAlignment";
   max_iterations_ = 0;
@@ -169,6 +174,9 @@ pcl::registration::FPCSInitialAlignment<PointSource, PointTarget, NormalT, Scala
   if (!initCompute())
     return;
 
+  // index the source pairs once, the base trials only read it
+  buildPairIndex();
+
   final_transformation_ = guess;
   bool abort = false;
   std::vector<MatchingCandidates> all_candidates(max_iterations_);
@@ -571,6 +579,121 @@ pcl::registration::FPCSInitialAlignment<PointSource, PointTarget, NormalT, Scala
   return (x.norm());
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointSource, typename PointTarget, typename NormalT, typename Scalar>
+void
+pcl::registration::FPCSInitialAlignment<PointSource, PointTarget, NormalT, Scalar>::
+    buildPairIndex()
+{
+  pair_index_.clear();
+  pair_index_buckets_.clear();
+
+  int nr_points = static_cast<int>(source_indices_->size());
+  if (max_pair_index_size_ == 0 || max_pair_diff_ <= 0.f || nr_points < 2)
+    return;
+
+  // base diagonals are bounded by the maximum base diameter (see selectBase), so longer
+  // source pairs can never be a candidate
+  pair_index_bucket_size_ = max_pair_diff_;
+  pair_index_max_dist_ = std::sqrt(max_base_diameter_sqr_) + max_pair_diff_;
+  const std::size_t nr_buckets =
+      static_cast<std::size_t>(pair_index_max_dist_ / pair_index_bucket_size_) + 1;
+  if (nr_buckets > max_pair_index_size_)
+    return;
+
+  KdTreeReciprocal tree;
+  tree.setInputCloud(input_, source_indices_);
+
+  float radius = pair_index_max_dist_;
+  std::size_t nr_pairs = 0;
+  bool overflow = false;
+
+  // collect the pairs in parallel, each unordered pair is only stored once
+#pragma omp parallel default(none) shared(tree, radius, nr_pairs, overflow, nr_points) \
+    num_threads(nr_threads_)
+  {
+    pcl::Correspondences pairs;
+    std::vector<int> ids;
+    std::vector<float> dists_sqr;
+
+#pragma omp for schedule(dynamic, 64)
+    for (int i = 0; i < nr_points; i++) {
+      bool stop;
+#pragma omp atomic read
+      stop = overflow;
+      if (stop)
+        continue;
+
+      const int index = (*source_indices_)[i];
+      tree.radiusSearch((*input_)[index], radius, ids, dists_sqr);
+
+      std::size_t nr_added = 0;
+      for (std::size_t j = 0; j < ids.size(); j++) {
+        if (ids[j] > index) {
+          pairs.push_back(pcl::Correspondence(index, ids[j], std::sqrt(dists_sqr[j])));
+          nr_added++;
+        }
+      }
+
+      std::size_t nr_total;
+#pragma omp atomic capture
+      nr_total = nr_pairs += nr_added;
+      if (nr_total > max_pair_index_size_) {
+#pragma omp atomic write
+        overflow = true;
+      }
+    }
+
+    if (!overflow) {
+#pragma omp critical(pair_index)
+      pair_index_.insert(pair_index_.end(), pairs.begin(), pairs.end());
+    }
+  }
+
+  if (overflow) {
+    PCL_DEBUG("[%s::buildPairIndex] More than %zu source pairs, falling back to the "
+              "exhaustive pair search.\n",
+              reg_name_.c_str(),
+              max_pair_index_size_);
+    pcl::Correspondences().swap(pair_index_);
+    return;
+  }
+
+  // counting sort of the pairs into their length buckets
+  const auto bucket_of = [&](const pcl::Correspondence& pair) {
+    return (std::min(static_cast<std::size_t>(pair.distance / pair_index_bucket_size_),
+                     nr_buckets - 1));
+  };
+
+  std::vector<std::size_t> buckets(nr_buckets + 1, 0);
+  for (const auto& pair : pair_index_)
+    buckets[bucket_of(pair) + 1]++;
+  for (std::size_t i = 1; i <= nr_buckets; i++)
+    buckets[i] += buckets[i - 1];
+
+  pcl::Correspondences sorted(pair_index_.size());
+  std::vector<std::size_t> offsets(buckets.begin(), buckets.end() - 1);
+  for (const auto& pair : pair_index_)
+    sorted[offsets[bucket_of(pair)]++] = pair;
+
+  // the collection order depends on the thread scheduling, make the buckets
+  // deterministic
+  int nr_sort = static_cast<int>(nr_buckets);
+#pragma omp parallel for default(none) shared(sorted, buckets, nr_sort)                \
+    schedule(dynamic, 16) num_threads(nr_threads_)
+  for (int i = 0; i < nr_sort; i++)
+    std::sort(sorted.begin() + buckets[i],
+              sorted.begin() + buckets[i + 1],
+              [](const pcl::Correspondence& a, const pcl::Correspondence& b) {
+                return (a.index_query < b.index_query ||
+                        (a.index_query == b.index_query &&
+                         a.index_match < b.index_match));
+              });
+
+  pair_index_.swap(sorted);
+  pair_index_buckets_.swap(buckets);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointSource, typename PointTarget, typename NormalT, typename Scalar>
 int
@@ -587,6 +710,49 @@ pcl::registration::FPCSInitialAlignment<PointSource, PointTarget, NormalT, Scala
                           .norm()
                     : 0.f);
 
+  // compare the normals of a candidate pair with the ones of the reference segment
+  const auto valid_normals = [&](int src_idx1, int src_idx2) {
+    if (!use_normals_)
+      return (true);
+
+    const NormalT* pt1_n = &((*source_normals_)[src_idx1]);
+    const NormalT* pt2_n = &((*source_normals_)[src_idx2]);
+
+    float norm_angle_1 =
+        (pt1_n->getNormalVector3fMap() - pt2_n->getNormalVector3fMap()).norm();
+    float norm_angle_2 =
+        (pt1_n->getNormalVector3fMap() + pt2_n->getNormalVector3fMap()).norm();
+
+    float norm_diff = std::min<float>(std::abs(norm_angle_1 - ref_norm_angle),
+                                      std::abs(norm_angle_2 - ref_norm_angle));
+    return (norm_diff <= max_norm_diff);
+  };
+
+  // look up the candidates in the buckets overlapping [ref_dist +- max_pair_diff_]
+  if (!pair_index_buckets_.empty() &&
+      ref_dist + max_pair_diff_ <= pair_index_max_dist_) {
+    const std::size_t first_bucket = static_cast<std::size_t>(
+        std::max(0.f, ref_dist - max_pair_diff_) / pair_index_bucket_size_);
+    const std::size_t last_bucket = std::min(
+        static_cast<std::size_t>((ref_dist + max_pair_diff_) / pair_index_bucket_size_),
+        pair_index_buckets_.size() - 2);
+
+    for (std::size_t i = pair_index_buckets_[first_bucket];
+         i < pair_index_buckets_[last_bucket + 1];
+         i++) {
+      const pcl::Correspondence& pair = pair_index_[i];
+      if (std::abs(pair.distance - ref_dist) < max_pair_diff_ &&
+          valid_normals(pair.index_query, pair.index_match)) {
+        pairs.push_back(
+            pcl::Correspondence(pair.index_match, pair.index_query, pair.distance));
+        pairs.push_back(
+            pcl::Correspondence(pair.index_query, pair.index_match, pair.distance));
+      }
+    }
+
+    return (pairs.empty() ? -1 : 0);
+  }
+
   // loop over all pairs of points in source point cloud
   auto it_out = source_indices_->begin(), it_out_e = source_indices_->end() - 1;
   auto it_in_e = source_indices_->end();
@@ -600,20 +766,8 @@ pcl::registration::FPCSInitialAlignment<PointSource, PointTarget, NormalT, Scala
       float dist = pcl::euclideanDistance(*pt1, *pt2);
       if (std::abs(dist - ref_dist) < max_pair_diff_) {
         // add here normal evaluation if normals are given
-        if (use_normals_) {
-          const NormalT* pt1_n = &((*source_normals_)[*it_out]);
-          const NormalT* pt2_n = &((*source_normals_)[*it_in]);
-
-          float norm_angle_1 =
-              (pt1_n->getNormalVector3fMap() - pt2_n->getNormalVector3fMap()).norm();
-          float norm_angle_2 =
-              (pt1_n->getNormalVector3fMap() + pt2_n->getNormalVector3fMap()).norm();
-
-          float norm_diff = std::min<float>(std::abs(norm_angle_1 - ref_norm_angle),
-                                            std::abs(norm_angle_2 - ref_norm_angle));
-          if (norm_diff > max_norm_diff)
-            continue;
-        }
+        if (!valid_normals(*it_out, *it_in))
+          continue;
 
         pairs.push_back(pcl::Correspondence(*it_in, *it_out, dist));
         pairs.push_back(pcl::Correspondence(*it_out, *it_in, dist));
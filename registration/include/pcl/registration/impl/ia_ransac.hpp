@@ -43,6 +43,10 @@
 
 #include <pcl/common/distances.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace pcl {
 
 template <typename PointSource, typename PointTarget, typename FeatureT>
@@ -81,6 +85,28 @@ SampleConsensusInitialAlignment<PointSource, PointTarget, FeatureT>::selectSampl
     int nr_samples,
     float min_sample_distance,
     std::vector<int>& sample_indices)
+{
+  const float initial_min_sample_distance = min_sample_distance;
+  selectSamples(cloud,
+                nr_samples,
+                min_sample_distance,
+                sample_indices,
+                [this](int n) { return getRandomIndex(n); });
+
+  // Keep the relaxed distance requirement for the following iterations
+  if (min_sample_distance < initial_min_sample_distance)
+    min_sample_distance_ = min_sample_distance;
+}
+
+template <typename PointSource, typename PointTarget, typename FeatureT>
+template <typename RandomIndex>
+void
+SampleConsensusInitialAlignment<PointSource, PointTarget, FeatureT>::selectSamples(
+    const PointCloudSource& cloud,
+    int nr_samples,
+    float& min_sample_distance,
+    std::vector<int>& sample_indices,
+    RandomIndex&& random_index) const
 {
   if (nr_samples > static_cast<int>(cloud.size())) {
     PCL_ERROR("[pcl::%s::selectSamples] ", getClassName().c_str());
@@ -97,7 +123,7 @@ SampleConsensusInitialAlignment<PointSource, PointTarget, FeatureT>::selectSampl
   sample_indices.clear();
   while (static_cast<int>(sample_indices.size()) < nr_samples) {
     // Choose a sample at random
-    int sample_index = getRandomIndex(static_cast<int>(cloud.size()));
+    int sample_index = random_index(static_cast<int>(cloud.size()));
 
     // Check to see if the sample is 1) unique and 2) far away from the other samples
     bool valid_sample = true;
@@ -129,8 +155,7 @@ SampleConsensusInitialAlignment<PointSource, PointTarget, FeatureT>::selectSampl
                static_cast<std::size_t>(iterations_without_a_sample),
                0.5 * min_sample_distance);
 
-      min_sample_distance_ *= 0.5f;
-      min_sample_distance = min_sample_distance_;
+      min_sample_distance *= 0.5f;
       iterations_without_a_sample = 0;
     }
   }
@@ -239,32 +264,151 @@ SampleConsensusInitialAlignment<PointSource, PointTarget, FeatureT>::
     i_iter = 1;
   }
 
-  for (; i_iter < max_iterations_; ++i_iter) {
-    // Draw nr_samples_ random samples
-    selectSamples(*input_, nr_samples_, min_sample_distance_, sample_indices);
+  if (threads_ >= 0) {
+    if (i_iter == 0)
+      lowest_error = std::numeric_limits<float>::max();
+    computeHypothesesParallel(threads_, max_iterations_ - i_iter, lowest_error);
+  }
+  else {
+    for (; i_iter < max_iterations_; ++i_iter) {
+      // Draw nr_samples_ random samples
+      selectSamples(*input_, nr_samples_, min_sample_distance_, sample_indices);
+
+      // Find corresponding features in the target cloud
+      findSimilarFeatures(*input_features_, sample_indices, corresponding_indices);
+
+      // Estimate the transform from the samples to their corresponding points
+      transformation_estimation_->estimateRigidTransformation(
+          *input_, sample_indices, *target_, corresponding_indices, transformation_);
+
+      // Transform the data and compute the error
+      transformPointCloud(*input_, input_transformed, transformation_);
+      float error = computeErrorMetric(input_transformed,
+                                       static_cast<float>(corr_dist_threshold_));
+
+      // If the new error is lower, update the final transformation
+      if (i_iter == 0 || error < lowest_error) {
+        lowest_error = error;
+        final_transformation_ = transformation_;
+        converged_ = true;
+      }
+    }
+  }
 
-    // Find corresponding features in the target cloud
-    findSimilarFeatures(*input_features_, sample_indices, corresponding_indices);
+  // Apply the final transformation
+  transformPointCloud(*input_, output, final_transformation_);
+}
 
-    // Estimate the transform from the samples to their corresponding points
-    transformation_estimation_->estimateRigidTransformation(
-        *input_, sample_indices, *target_, corresponding_indices, transformation_);
+template <typename PointSource, typename PointTarget, typename FeatureT>
+float
+SampleConsensusInitialAlignment<PointSource, PointTarget, FeatureT>::computeErrorMetric(
+    const Eigen::Matrix4f& transformation, float max_error) const
+{
+  std::vector<int> nn_index(1);
+  std::vector<float> nn_distance(1);
 
-    // Transform the data and compute the error
-    transformPointCloud(*input_, input_transformed, transformation_);
-    float error =
-        computeErrorMetric(input_transformed, static_cast<float>(corr_dist_threshold_));
+  const ErrorFunctor& compute_error = *error_functor_;
+  const Eigen::Affine3f affine(transformation);
+  float error = 0;
 
-    // If the new error is lower, update the final transformation
-    if (i_iter == 0 || error < lowest_error) {
-      lowest_error = error;
-      final_transformation_ = transformation_;
-      converged_ = true;
-    }
+  for (const auto& point : *input_) {
+    // Find the distance between the transformed point and its nearest neighbor in the
+    // target point cloud
+    tree_->nearestKSearch(pcl::transformPoint(point, affine), 1, nn_index, nn_distance);
+
+    // Compute the error, the hypothesis is lost once it exceeds the one to beat
+    error += compute_error(nn_distance[0]);
+    if (error >= max_error)
+      break;
   }
+  return (error);
+}
 
-  // Apply the final transformation
-  transformPointCloud(*input_, output, final_transformation_);
+template <typename PointSource, typename PointTarget, typename FeatureT>
+void
+SampleConsensusInitialAlignment<PointSource, PointTarget, FeatureT>::
+    computeHypothesesParallel(int threads, int nr_hypotheses, float& lowest_error)
+{
+#ifdef _OPENMP
+  if (threads == 0)
+    threads = omp_get_num_procs();
+#else
+  threads = 1;
+#endif
+  PCL_DEBUG("[pcl::%s::computeTransformation] Computing with %i threads.\n",
+            getClassName().c_str(),
+            threads);
+
+  // Search the similar target features of all the source features up front, the
+  // hypothesis loop below then only reads from this cache
+  const int nr_points = static_cast<int>(input_features_->size());
+  std::vector<std::vector<int>> similar_features(nr_points);
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64)
+  for (int i = 0; i < nr_points; ++i) {
+    std::vector<float> nn_distances(k_correspondences_);
+    feature_tree_->nearestKSearch(
+        *input_features_, i, k_correspondences_, similar_features[i], nn_distances);
+  }
+
+  // One random number generator per thread, seeded from the global one so that
+  // std::srand () still controls the outcome
+  std::vector<unsigned int> seeds(threads);
+  for (auto& seed : seeds)
+    seed = static_cast<unsigned int>(std::rand());
+
+#pragma omp parallel num_threads(threads)
+  {
+#ifdef _OPENMP
+    std::mt19937 rng(seeds[omp_get_thread_num()]);
+#else
+    std::mt19937 rng(seeds[0]);
+#endif
+    const auto random_index = [this, &rng](int n) { return getRandomIndex(n, rng); };
+
+    float min_sample_distance = min_sample_distance_;
+    std::vector<int> sample_indices(nr_samples_);
+    std::vector<int> corresponding_indices(nr_samples_);
+    Eigen::Matrix4f transformation;
+
+#pragma omp for schedule(static)
+    for (int i = 0; i < nr_hypotheses; ++i) {
+      // Draw nr_samples_ random samples
+      selectSamples(
+          *input_, nr_samples_, min_sample_distance, sample_indices, random_index);
+      if (static_cast<int>(sample_indices.size()) != nr_samples_)
+        continue;
+
+      // Pick one of the similar target features of each sample at random
+      for (int j = 0; j < nr_samples_; ++j) {
+        const std::vector<int>& similar = similar_features[sample_indices[j]];
+        corresponding_indices[j] =
+            similar[random_index(static_cast<int>(similar.size()))];
+      }
+
+      // Estimate the transform from the samples to their corresponding points
+      transformation_estimation_->estimateRigidTransformation(
+          *input_, sample_indices, *target_, corresponding_indices, transformation);
+
+      // Compute the error, giving up as soon as it can not beat the best one
+      float best_error;
+#pragma omp atomic read
+      best_error = lowest_error;
+      const float error = computeErrorMetric(transformation, best_error);
+
+      if (error < best_error) {
+#pragma omp critical(update)
+        {
+          // Another thread may have found a better hypothesis in the meantime
+          if (error < lowest_error) {
+#pragma omp atomic write
+            lowest_error = error;
+            final_transformation_ = transformation;
+            converged_ = true;
+          }
+        }
+      }
+    }
+  }
 }
 
 } // namespace pcl
@@ -41,7 +41,16 @@
 #ifndef PCL_REGISTRATION_IMPL_LUM_HPP_
 #define PCL_REGISTRATION_IMPL_LUM_HPP_
 
+#include <Eigen/SparseCholesky>
+#include <Eigen/SparseLU>
+
+#include <algorithm>
 #include <tuple>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace pcl {
 
@@ -96,6 +105,27 @@ LUM<PointT>::getConvergenceThreshold() const
   return (convergence_threshold_);
 }
 
+template <typename PointT>
+void
+LUM<PointT>::setNumberOfThreads(unsigned int nr_threads)
+{
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    threads_ = omp_get_num_procs();
+#else
+    threads_ = 1;
+#endif
+  else
+    threads_ = nr_threads;
+}
+
+template <typename PointT>
+inline unsigned int
+LUM<PointT>::getNumberOfThreads() const
+{
+  return (threads_);
+}
+
 template <typename PointT>
 typename LUM<PointT>::Vertex
 LUM<PointT>::addPointCloud(const PointCloudPtr& cloud, const Eigen::Vector6f& pose)
@@ -226,44 +256,103 @@ LUM<PointT>::compute()
               "vertices.\n");
     return;
   }
+  // The graph is not modified during the computation, collect its edges once
+  std::vector<Edge> graph_edges;
+  graph_edges.reserve(num_edges(*slam_graph_));
+  typename SLAMGraph::edge_iterator edge_it, edge_it_end;
+  for (std::tie(edge_it, edge_it_end) = edges(*slam_graph_); edge_it != edge_it_end;
+       ++edge_it)
+    graph_edges.push_back(*edge_it);
+  int nr_edges = static_cast<int>(graph_edges.size());
+
+  std::vector<Eigen::Triplet<float>> triplets;
+  std::vector<Vertex> neighbors;
+
   for (int i = 0; i < max_iterations_; ++i) {
     // Linearized computation of C^-1 and C^-1*D and convergence checking for all edges
-    // in the graph (results stored in slam_graph_)
-    typename SLAMGraph::edge_iterator e, e_end;
-    for (std::tie(e, e_end) = edges(*slam_graph_); e != e_end; ++e)
-      computeEdge(*e);
-
-    // Declare matrices G and B
-    Eigen::MatrixXf G = Eigen::MatrixXf::Zero(6 * (n - 1), 6 * (n - 1));
+    // in the graph (results stored in slam_graph_); every edge only writes its own
+    // properties
+#pragma omp parallel for default(none) shared(graph_edges, nr_edges)                   \
+    schedule(dynamic) num_threads(threads_)
+    for (int ei = 0; ei < nr_edges; ++ei)
+      computeEdge(graph_edges[ei]);
+
+    // Declare matrices G and B, G only has non-zero blocks for linked vertices
+    triplets.clear();
     Eigen::VectorXf B = Eigen::VectorXf::Zero(6 * (n - 1));
+    bool symmetric = true;
 
     // Start at 1 because 0 is the reference pose
     for (int vi = 1; vi != n; ++vi) {
-      for (int vj = 0; vj != n; ++vj) {
-        // Attempt to use the forward edge, otherwise use backward edge, otherwise there
-        // was no edge
+      // Gather the linked vertices in ascending order
+      neighbors.clear();
+      typename SLAMGraph::out_edge_iterator oe, oe_end;
+      for (std::tie(oe, oe_end) = out_edges(vi, *slam_graph_); oe != oe_end; ++oe)
+        neighbors.push_back(target(*oe, *slam_graph_));
+      typename SLAMGraph::in_edge_iterator ie, ie_end;
+      for (std::tie(ie, ie_end) = in_edges(vi, *slam_graph_); ie != ie_end; ++ie)
+        neighbors.push_back(source(*ie, *slam_graph_));
+      std::sort(neighbors.begin(), neighbors.end());
+      neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+
+      Eigen::Matrix6f G_ii = Eigen::Matrix6f::Zero();
+      for (const Vertex& vj : neighbors) {
+        if (static_cast<int>(vj) == vi)
+          continue;
+
+        // Attempt to use the forward edge, otherwise use backward edge
         Edge e;
         bool present1;
         std::tie(e, present1) = edge(vi, vj, *slam_graph_);
-        if (!present1) {
-          bool present2;
-          std::tie(e, present2) = edge(vj, vi, *slam_graph_);
-          if (!present2)
-            continue;
-        }
+        if (!present1)
+          std::tie(e, std::ignore) = edge(vj, vi, *slam_graph_);
+        else if (edge(vj, vi, *slam_graph_).second)
+          symmetric = false;
 
         // Fill in elements of G and B
+        const Eigen::Matrix6f& cinv = (*slam_graph_)[e].cinv_;
         if (vj > 0)
-          G.block(6 * (vi - 1), 6 * (vj - 1), 6, 6) = -(*slam_graph_)[e].cinv_;
-        G.block(6 * (vi - 1), 6 * (vi - 1), 6, 6) += (*slam_graph_)[e].cinv_;
+          for (int r = 0; r < 6; ++r)
+            for (int c = 0; c < 6; ++c)
+              triplets.emplace_back(
+                  6 * (vi - 1) + r, 6 * (static_cast<int>(vj) - 1) + c, -cinv(r, c));
+        G_ii += cinv;
         B.segment(6 * (vi - 1), 6) += (present1 ? 1 : -1) * (*slam_graph_)[e].cinvd_;
       }
+      for (int r = 0; r < 6; ++r)
+        for (int c = 0; c < 6; ++c)
+          triplets.emplace_back(6 * (vi - 1) + r, 6 * (vi - 1) + c, G_ii(r, c));
     }
 
+    Eigen::SparseMatrix<float> G(6 * (n - 1), 6 * (n - 1));
+    G.setFromTriplets(triplets.begin(), triplets.end());
+
     // Computation of the linear equation system: GX = B
-    // TODO investigate accuracy vs. speed tradeoff and find the best solving method for
-    // our type of linear equation (sparse)
-    Eigen::VectorXf X = G.colPivHouseholderQr().solve(B);
+    // G is symmetric positive semi-definite unless two vertices are linked in both
+    // directions with different correspondences
+    Eigen::VectorXf X;
+    bool solved = false;
+    if (symmetric) {
+      Eigen::SimplicialLDLT<Eigen::SparseMatrix<float>> solver(G);
+      if (solver.info() == Eigen::Success) {
+        X = solver.solve(B);
+        solved = solver.info() == Eigen::Success && X.allFinite();
+      }
+    }
+    else {
+      Eigen::SparseLU<Eigen::SparseMatrix<float>> solver(G);
+      if (solver.info() == Eigen::Success) {
+        X = solver.solve(B);
+        solved = solver.info() == Eigen::Success && X.allFinite();
+      }
+    }
+    if (!solved) {
+      // A rank deficient G (e.g. a disconnected graph) is still solved in the least
+      // squares sense, as before
+      PCL_DEBUG("[pcl::registration::LUM::compute] The sparse decomposition failed, "
+                "falling back to a dense solver.\n");
+      X = Eigen::MatrixXf(G).colPivHouseholderQr().solve(B);
+    }
 
     // Update the poses
     float sum = 0.0;
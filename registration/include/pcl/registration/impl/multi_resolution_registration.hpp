@@ -0,0 +1,172 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2020-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_REGISTRATION_IMPL_MULTI_RESOLUTION_REGISTRATION_HPP_
+#define PCL_REGISTRATION_IMPL_MULTI_RESOLUTION_REGISTRATION_HPP_
+
+#include <pcl/common/io.h>
+#include <pcl/common/transforms.h>
+#include <pcl/filters/voxel_grid.h>
+
+namespace pcl {
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+MultiResolutionRegistration<PointSource, PointTarget, Scalar>::addLevel(
+    double leaf_size, double max_correspondence_distance, int max_iterations)
+{
+  levels_.push_back({leaf_size, max_correspondence_distance, max_iterations});
+  source_pyramid_valid_ = target_pyramid_valid_ = false;
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+MultiResolutionRegistration<PointSource, PointTarget, Scalar>::buildPyramids()
+{
+  if (!source_pyramid_valid_ || source_pyramid_indices_ != indices_) {
+    source_clouds_.resize(levels_.size());
+    for (std::size_t i = 0; i < levels_.size(); ++i) {
+      PointCloudSourcePtr cloud(new PointCloudSource);
+      const float leaf_size = static_cast<float>(levels_[i].leaf_size);
+      if (leaf_size > 0) {
+        pcl::VoxelGrid<PointSource> grid;
+        grid.setInputCloud(input_);
+        grid.setIndices(indices_);
+        grid.setLeafSize(leaf_size, leaf_size, leaf_size);
+        grid.filter(*cloud);
+      }
+      else if (indices_->size() != input_->size())
+        pcl::copyPointCloud(*input_, *indices_, *cloud);
+      else
+        *cloud = *input_;
+      source_clouds_[i] = cloud;
+    }
+    source_pyramid_indices_ = indices_;
+    source_pyramid_valid_ = true;
+  }
+
+  if (!target_pyramid_valid_) {
+    target_clouds_.resize(levels_.size());
+    target_trees_.resize(levels_.size());
+    for (std::size_t i = 0; i < levels_.size(); ++i) {
+      const float leaf_size = static_cast<float>(levels_[i].leaf_size);
+      if (leaf_size <= 0) {
+        // The full resolution target is already indexed by tree_ (see initCompute)
+        target_clouds_[i] = target_;
+        target_trees_[i] = tree_;
+        continue;
+      }
+      PointCloudTargetPtr cloud(new PointCloudTarget);
+      pcl::VoxelGrid<PointTarget> grid;
+      grid.setInputCloud(target_);
+      grid.setLeafSize(leaf_size, leaf_size, leaf_size);
+      grid.filter(*cloud);
+      KdTreePtr tree(new KdTree);
+      tree->setInputCloud(cloud);
+      target_clouds_[i] = cloud;
+      target_trees_[i] = tree;
+    }
+    target_pyramid_valid_ = true;
+  }
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+MultiResolutionRegistration<PointSource, PointTarget, Scalar>::computeTransformation(
+    PointCloudSource& output, const Matrix4& guess)
+{
+  converged_ = false;
+  final_transformation_ = guess;
+
+  if (!registration_) {
+    PCL_ERROR("[pcl::%s::computeTransformation] No registration method given!\n",
+              getClassName().c_str());
+    return;
+  }
+  if (levels_.empty()) {
+    PCL_ERROR("[pcl::%s::computeTransformation] No pyramid level given!\n",
+              getClassName().c_str());
+    return;
+  }
+
+  buildPyramids();
+
+  // Remember the settings of the wrapped registration, they are restored afterwards
+  const double max_correspondence_distance =
+      registration_->getMaxCorrespondenceDistance();
+  const int max_iterations = registration_->getMaximumIterations();
+  const KdTreePtr search_method = registration_->getSearchMethodTarget();
+
+  PointCloudSource level_output;
+  for (std::size_t i = 0; i < levels_.size(); ++i) {
+    if (source_clouds_[i]->empty() || target_clouds_[i]->empty()) {
+      PCL_WARN("[pcl::%s::computeTransformation] Level %zu is empty, skipping it.\n",
+               getClassName().c_str(),
+               i);
+      continue;
+    }
+    registration_->setInputSource(source_clouds_[i]);
+    registration_->setInputTarget(target_clouds_[i]);
+    // The tree already indexes the level target, never let align () rebuild it
+    registration_->setSearchMethodTarget(target_trees_[i], true);
+    registration_->setMaxCorrespondenceDistance(levels_[i].max_correspondence_distance);
+    registration_->setMaximumIterations(
+        levels_[i].max_iterations > 0 ? levels_[i].max_iterations : max_iterations);
+
+    registration_->align(level_output, final_transformation_);
+
+    converged_ = registration_->hasConverged();
+    if (converged_)
+      final_transformation_ = registration_->getFinalTransformation();
+    else
+      PCL_DEBUG("[pcl::%s::computeTransformation] Level %zu (leaf size %g) did not "
+                "converge, keeping the previous estimate.\n",
+                getClassName().c_str(),
+                i,
+                levels_[i].leaf_size);
+  }
+
+  registration_->setMaxCorrespondenceDistance(max_correspondence_distance);
+  registration_->setMaximumIterations(max_iterations);
+  registration_->setSearchMethodTarget(search_method);
+
+  // output already holds the (indexed) input points, see Registration::align
+  pcl::transformPointCloud(output, output, final_transformation_);
+}
+
+} // namespace pcl
+
+#endif // PCL_REGISTRATION_IMPL_MULTI_RESOLUTION_REGISTRATION_HPP_
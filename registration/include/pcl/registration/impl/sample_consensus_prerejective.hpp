@@ -41,6 +41,10 @@
 #ifndef PCL_REGISTRATION_SAMPLE_CONSENSUS_PREREJECTIVE_HPP_
 #define PCL_REGISTRATION_SAMPLE_CONSENSUS_PREREJECTIVE_HPP_
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace pcl {
 
 template <typename PointSource, typename PointTarget, typename FeatureT>
@@ -76,6 +80,19 @@ template <typename PointSource, typename PointTarget, typename FeatureT>
 void
 SampleConsensusPrerejective<PointSource, PointTarget, FeatureT>::selectSamples(
     const PointCloudSource& cloud, int nr_samples, std::vector<int>& sample_indices)
+{
+  selectSamples(
+      cloud, nr_samples, sample_indices, [this](int n) { return getRandomIndex(n); });
+}
+
+template <typename PointSource, typename PointTarget, typename FeatureT>
+template <typename RandomIndex>
+void
+SampleConsensusPrerejective<PointSource, PointTarget, FeatureT>::selectSamples(
+    const PointCloudSource& cloud,
+    int nr_samples,
+    std::vector<int>& sample_indices,
+    RandomIndex&& random_index) const
 {
   if (nr_samples > static_cast<int>(cloud.size())) {
     PCL_ERROR("[pcl::%s::selectSamples] ", getClassName().c_str());
@@ -92,7 +109,7 @@ SampleConsensusPrerejective<PointSource, PointTarget, FeatureT>::selectSamples(
   // Draw random samples until n samples is reached
   for (int i = 0; i < nr_samples; i++) {
     // Select a random number
-    sample_indices[i] = getRandomIndex(static_cast<int>(cloud.size()) - i);
+    sample_indices[i] = random_index(static_cast<int>(cloud.size()) - i);
 
     // Run trough list of numbers, starting at the lowest, to avoid duplicates
     for (int j = 0; j < i; j++) {
@@ -239,54 +256,59 @@ SampleConsensusPrerejective<PointSource, PointTarget, FeatureT>::computeTransfor
     }
   }
 
-  // Feature correspondence cache
-  std::vector<std::vector<int>> similar_features(input_->size());
-
-  // Start
-  for (int i = 0; i < max_iterations_; ++i) {
-    // Temporary containers
-    std::vector<int> sample_indices;
-    std::vector<int> corresponding_indices;
-
-    // Draw nr_samples_ random samples
-    selectSamples(*input_, nr_samples_, sample_indices);
-
-    // Find corresponding features in the target cloud
-    findSimilarFeatures(sample_indices, similar_features, corresponding_indices);
-
-    // Apply prerejection
-    if (!correspondence_rejector_poly_->thresholdPolygon(sample_indices,
-                                                         corresponding_indices)) {
-      ++num_rejections;
-      continue;
-    }
+  if (threads_ >= 0)
+    num_rejections = computeHypothesesParallel(threads_, lowest_error);
+  else {
+    // Feature correspondence cache
+    std::vector<std::vector<int>> similar_features(input_->size());
+
+    // Start
+    for (int i = 0; i < max_iterations_; ++i) {
+      // Temporary containers
+      std::vector<int> sample_indices;
+      std::vector<int> corresponding_indices;
+
+      // Draw nr_samples_ random samples
+      selectSamples(*input_, nr_samples_, sample_indices);
+
+      // Find corresponding features in the target cloud
+      findSimilarFeatures(sample_indices, similar_features, corresponding_indices);
+
+      // Apply prerejection
+      if (!correspondence_rejector_poly_->thresholdPolygon(sample_indices,
+                                                           corresponding_indices)) {
+        ++num_rejections;
+        continue;
+      }
 
-    // Estimate the transform from the correspondences, write to transformation_
-    transformation_estimation_->estimateRigidTransformation(
-        *input_, sample_indices, *target_, corresponding_indices, transformation_);
+      // Estimate the transform from the correspondences, write to transformation_
+      transformation_estimation_->estimateRigidTransformation(
+          *input_, sample_indices, *target_, corresponding_indices, transformation_);
 
-    // Take a backup of previous result
-    const Matrix4 final_transformation_prev = final_transformation_;
+      // Take a backup of previous result
+      const Matrix4 final_transformation_prev = final_transformation_;
 
-    // Set final result to current transformation
-    final_transformation_ = transformation_;
+      // Set final result to current transformation
+      final_transformation_ = transformation_;
 
-    // Transform the input and compute the error (uses input_ and final_transformation_)
-    getFitness(inliers, error);
+      // Transform the input and compute the error (uses input_ and
+      // final_transformation_)
+      getFitness(inliers, error);
 
-    // Restore previous result
-    final_transformation_ = final_transformation_prev;
+      // Restore previous result
+      final_transformation_ = final_transformation_prev;
 
-    // If the new fit is better, update results
-    inlier_fraction =
-        static_cast<float>(inliers.size()) / static_cast<float>(input_->size());
+      // If the new fit is better, update results
+      inlier_fraction =
+          static_cast<float>(inliers.size()) / static_cast<float>(input_->size());
 
-    // Update result if pose hypothesis is better
-    if (inlier_fraction >= inlier_fraction_ && error < lowest_error) {
-      inliers_ = inliers;
-      lowest_error = error;
-      converged_ = true;
-      final_transformation_ = transformation_;
+      // Update result if pose hypothesis is better
+      if (inlier_fraction >= inlier_fraction_ && error < lowest_error) {
+        inliers_ = inliers;
+        lowest_error = error;
+        converged_ = true;
+        final_transformation_ = transformation_;
+      }
     }
   }
 
@@ -344,6 +366,161 @@ SampleConsensusPrerejective<PointSource, PointTarget, FeatureT>::getFitness(
     fitness_score = std::numeric_limits<float>::max();
 }
 
+template <typename PointSource, typename PointTarget, typename FeatureT>
+bool
+SampleConsensusPrerejective<PointSource, PointTarget, FeatureT>::getFitness(
+    const Matrix4& transformation,
+    float min_inlier_fraction,
+    float max_fitness_score,
+    std::vector<int>& inliers,
+    float& fitness_score) const
+{
+  // Initialize variables
+  inliers.clear();
+  inliers.reserve(input_->size());
+  fitness_score = 0.0f;
+
+  // Use squared distance for comparison with NN search results
+  const float max_range = corr_dist_threshold_ * corr_dist_threshold_;
+
+  const std::size_t nr_points = input_->size();
+  const Eigen::Affine3f affine(transformation);
+  std::vector<int> nn_indices(1);
+  std::vector<float> nn_dists(1);
+
+  for (std::size_t i = 0; i < nr_points; ++i) {
+    // Find the nearest neighbor of the transformed point in the target
+    const PointSource point = pcl::transformPoint((*input_)[i], affine);
+    tree_->nearestKSearch(point, 1, nn_indices, nn_dists);
+
+    // Check if point is an inlier
+    if (nn_dists[0] < max_range) {
+      inliers.push_back(static_cast<int>(i));
+      fitness_score += nn_dists[0];
+    }
+
+    // Every now and then, check whether the hypothesis could still be accepted if all
+    // the remaining points were inliers with a zero distance
+    if (i % 64 == 63) {
+      const std::size_t max_inliers = inliers.size() + nr_points - i - 1;
+      if (static_cast<float>(max_inliers) / static_cast<float>(nr_points) <
+              min_inlier_fraction ||
+          fitness_score >= max_fitness_score * static_cast<float>(max_inliers)) {
+        fitness_score = std::numeric_limits<float>::max();
+        return (false);
+      }
+    }
+  }
+
+  // Calculate MSE
+  if (!inliers.empty())
+    fitness_score /= static_cast<float>(inliers.size());
+  else
+    fitness_score = std::numeric_limits<float>::max();
+  return (true);
+}
+
+template <typename PointSource, typename PointTarget, typename FeatureT>
+int
+SampleConsensusPrerejective<PointSource, PointTarget, FeatureT>::
+    computeHypothesesParallel(int threads, float& lowest_error)
+{
+#ifdef _OPENMP
+  if (threads == 0)
+    threads = omp_get_num_procs();
+#else
+  threads = 1;
+#endif
+  PCL_DEBUG("[pcl::%s::computeTransformation] Computing with %i threads.\n",
+            getClassName().c_str(),
+            threads);
+
+  // Search the similar target features of all the source features up front, the
+  // hypothesis loop below then only reads from this cache
+  const int nr_points = static_cast<int>(input_->size());
+  std::vector<std::vector<int>> similar_features(nr_points);
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64)
+  for (int i = 0; i < nr_points; ++i) {
+    std::vector<float> nn_distances(k_correspondences_);
+    feature_tree_->nearestKSearch(
+        *input_features_, i, k_correspondences_, similar_features[i], nn_distances);
+  }
+
+  // One random number generator per thread, seeded from the global one so that
+  // std::srand () still controls the outcome
+  std::vector<unsigned int> seeds(threads);
+  for (auto& seed : seeds)
+    seed = static_cast<unsigned int>(std::rand());
+
+  int num_rejections = 0;
+#pragma omp parallel num_threads(threads) reduction(+ : num_rejections)
+  {
+#ifdef _OPENMP
+    std::mt19937 rng(seeds[omp_get_thread_num()]);
+#else
+    std::mt19937 rng(seeds[0]);
+#endif
+    const auto random_index = [this, &rng](int n) { return getRandomIndex(n, rng); };
+
+    std::vector<int> sample_indices;
+    std::vector<int> corresponding_indices(nr_samples_);
+    std::vector<int> inliers;
+    Matrix4 transformation;
+    float error;
+
+#pragma omp for schedule(static)
+    for (int i = 0; i < max_iterations_; ++i) {
+      // Draw nr_samples_ random samples
+      selectSamples(*input_, nr_samples_, sample_indices, random_index);
+      if (static_cast<int>(sample_indices.size()) != nr_samples_)
+        continue;
+
+      // Pick one of the similar target features of each sample at random
+      for (int j = 0; j < nr_samples_; ++j) {
+        const std::vector<int>& similar = similar_features[sample_indices[j]];
+        corresponding_indices[j] =
+            similar[random_index(static_cast<int>(similar.size()))];
+      }
+
+      // Apply prerejection
+      if (!correspondence_rejector_poly_->thresholdPolygon(sample_indices,
+                                                           corresponding_indices)) {
+        ++num_rejections;
+        continue;
+      }
+
+      // Estimate the transform from the correspondences
+      transformation_estimation_->estimateRigidTransformation(
+          *input_, sample_indices, *target_, corresponding_indices, transformation);
+
+      // Verify the hypothesis, giving up as soon as it can not beat the best one
+      float best_error;
+#pragma omp atomic read
+      best_error = lowest_error;
+      if (!getFitness(transformation, inlier_fraction_, best_error, inliers, error))
+        continue;
+
+      const float inlier_fraction =
+          static_cast<float>(inliers.size()) / static_cast<float>(input_->size());
+      if (inlier_fraction >= inlier_fraction_ && error < best_error) {
+#pragma omp critical(update)
+        {
+          // Another thread may have found a better hypothesis in the meantime
+          if (error < lowest_error) {
+#pragma omp atomic write
+            lowest_error = error;
+            inliers_ = inliers;
+            final_transformation_ = transformation;
+            converged_ = true;
+          }
+        }
+      }
+    }
+  }
+
+  return (num_rejections);
+}
+
 } // namespace pcl
 
 #endif
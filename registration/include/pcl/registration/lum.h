@@ -140,7 +140,14 @@ public:
 
   /** \brief Empty constructor.
    */
-  LUM() : slam_graph_(new SLAMGraph), max_iterations_(5), convergence_threshold_(0.0) {}
+  LUM()
+  : slam_graph_(new SLAMGraph)
+  , max_iterations_(5)
+  , convergence_threshold_(0.0)
+  , threads_(1)
+  {
+    setNumberOfThreads(0);
+  }
 
   /** \brief Set the internal SLAM graph structure.
    * \details All data used and produced by LUM is stored in this boost::adjacency_list.
@@ -202,6 +209,21 @@ public:
   inline float
   getConvergenceThreshold() const;
 
+  /** \brief Set the number of threads used to linearize the edges of the SLAM graph.
+   * \details The edges are independent of each other, the result does not depend on
+   * the number of threads. Only used if compiled with OpenMP.
+   * \param[in] nr_threads The number of threads to use (0 sets the value back to
+   * automatic, default = 0).
+   */
+  void
+  setNumberOfThreads(unsigned int nr_threads = 0);
+
+  /** \brief Get the number of threads used to linearize the edges of the SLAM graph.
+   * \return The current number of threads.
+   */
+  inline unsigned int
+  getNumberOfThreads() const;
+
   /** \brief Add a new point cloud to the SLAM graph.
    * \details This method will add a new vertex to the SLAM graph and attach a point
    * cloud to that vertex. Optionally you can specify a pose estimate for this point
@@ -301,6 +323,10 @@ public:
    *  <li>The algorithm draws it strength from loops in the graph because it will
    * distribute errors evenly amongst those loops.</li>
    * </ul>
+   * The edges are linearized in parallel (see setNumberOfThreads()) and the resulting
+   * sparse linear system is solved with a sparse Cholesky decomposition, so the cost
+   * of an iteration grows with the number of edges instead of the squared number of
+   * vertices.
    * Computation ends when either of the following conditions hold:
    * <ul>
    *  <li>The number of iterations reaches max_iterations. Use setMaxIterations() to
@@ -348,6 +374,9 @@ private:
 
   /** \brief The convergence threshold for the summed vector lengths of all poses. */
   float convergence_threshold_;
+
+  /** \brief The number of threads used to linearize the edges. */
+  unsigned int threads_;
 };
 } // namespace registration
 } // namespace pcl
@@ -0,0 +1,243 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2020-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <pcl/registration/registration.h>
+#include <pcl/point_cloud.h>
+
+#include <vector>
+
+namespace pcl {
+/** \brief @b MultiResolutionRegistration is a coarse-to-fine driver around any other
+ * @ref Registration method (ICP, GICP, point-to-plane ICP, ...).
+ *
+ * Source and target are down-sampled into a voxel pyramid with @ref VoxelGrid, one
+ * level per call to \ref addLevel. The wrapped registration is run on every level,
+ * from the first (coarsest) to the last (finest) one, with the level specific maximum
+ * correspondence distance and iteration count, and the result of each level is used as
+ * the initial guess of the next one. Most of the iterations are thus spent on small
+ * clouds, and the fine levels only have to polish an already good estimate.
+ *
+ * The down-sampled clouds and the kd-trees built on the target levels are cached: as
+ * long as the same source and target are given, consecutive calls to \ref align only
+ * run the registration itself. The full resolution level shares the kd-tree of this
+ * object (see \ref setSearchMethodTarget).
+ *
+ * \code
+ * IterativeClosestPoint<PointXYZ, PointXYZ>::Ptr icp (new
+ * IterativeClosestPoint<PointXYZ, PointXYZ>); icp->setTransformationEpsilon (1e-8);
+ *
+ * MultiResolutionRegistration<PointXYZ, PointXYZ> reg;
+ * reg.setRegistration (icp);
+ * reg.addLevel (0.04, 0.2, 20);  // 4cm voxels, 20cm correspondence distance
+ * reg.addLevel (0.01, 0.05, 20); // 1cm voxels, 5cm correspondence distance
+ * reg.addLevel (0.0, 0.02, 10);  // full resolution
+ * reg.setInputSource (source);
+ * reg.setInputTarget (target);
+ * reg.align (output, guess);
+ * \endcode
+ *
+ * \note The levels are down-sampled with all fields averaged, so normals of point
+ * types carrying them are the (non normalized) mean normal of the voxel.
+ * \ingroup registration
+ */
+template <typename PointSource, typename PointTarget, typename Scalar = float>
+class MultiResolutionRegistration
+: public Registration<PointSource, PointTarget, Scalar> {
+public:
+  using PointCloudSource =
+      typename Registration<PointSource, PointTarget, Scalar>::PointCloudSource;
+  using PointCloudSourcePtr = typename PointCloudSource::Ptr;
+  using PointCloudSourceConstPtr = typename PointCloudSource::ConstPtr;
+
+  using PointCloudTarget =
+      typename Registration<PointSource, PointTarget, Scalar>::PointCloudTarget;
+  using PointCloudTargetPtr = typename PointCloudTarget::Ptr;
+  using PointCloudTargetConstPtr = typename PointCloudTarget::ConstPtr;
+
+  using KdTree = typename Registration<PointSource, PointTarget, Scalar>::KdTree;
+  using KdTreePtr = typename Registration<PointSource, PointTarget, Scalar>::KdTreePtr;
+
+  using RegistrationPtr = typename Registration<PointSource, PointTarget, Scalar>::Ptr;
+  using Matrix4 = typename Registration<PointSource, PointTarget, Scalar>::Matrix4;
+
+  using Ptr = shared_ptr<MultiResolutionRegistration<PointSource, PointTarget, Scalar>>;
+  using ConstPtr =
+      shared_ptr<const MultiResolutionRegistration<PointSource, PointTarget, Scalar>>;
+
+  using Registration<PointSource, PointTarget, Scalar>::reg_name_;
+  using Registration<PointSource, PointTarget, Scalar>::getClassName;
+  using Registration<PointSource, PointTarget, Scalar>::input_;
+  using Registration<PointSource, PointTarget, Scalar>::indices_;
+  using Registration<PointSource, PointTarget, Scalar>::target_;
+  using Registration<PointSource, PointTarget, Scalar>::tree_;
+  using Registration<PointSource, PointTarget, Scalar>::final_transformation_;
+  using Registration<PointSource, PointTarget, Scalar>::converged_;
+
+  /** \brief Parameters of a single level of the pyramid. */
+  struct Level {
+    /** \brief Voxel size used to down-sample source and target. A value of 0 uses the
+     * clouds at their full resolution. */
+    double leaf_size;
+    /** \brief Maximum correspondence distance used on this level. */
+    double max_correspondence_distance;
+    /** \brief Maximum number of iterations on this level. A value of 0 keeps the
+     * setting of the wrapped registration. */
+    int max_iterations;
+  };
+
+  /** \brief Empty constructor. */
+  MultiResolutionRegistration()
+  : source_pyramid_valid_(false), target_pyramid_valid_(false)
+  {
+    reg_name_ = "MultiResolutionRegistration";
+  }
+
+  /** \brief Empty destructor */
+  ~MultiResolutionRegistration() {}
+
+  /** \brief Set the registration method that is run on every level of the pyramid.
+   * \param[in] registration the registration object, its input clouds are managed by
+   * this class
+   */
+  inline void
+  setRegistration(const RegistrationPtr& registration)
+  {
+    registration_ = registration;
+  }
+
+  /** \brief Get the registration method that is run on every level of the pyramid. */
+  inline RegistrationPtr
+  getRegistration() const
+  {
+    return (registration_);
+  }
+
+  /** \brief Append a level to the pyramid. Levels are processed in the order in which
+   * they were added, so they should go from the coarsest to the finest resolution.
+   * \param[in] leaf_size voxel size of the level (0 for the full resolution clouds)
+   * \param[in] max_correspondence_distance maximum correspondence distance used on
+   * this level
+   * \param[in] max_iterations maximum number of iterations on this level (0 to keep
+   * the setting of the wrapped registration)
+   */
+  void
+  addLevel(double leaf_size,
+           double max_correspondence_distance,
+           int max_iterations = 0);
+
+  /** \brief Remove all the levels of the pyramid. */
+  inline void
+  clearLevels()
+  {
+    levels_.clear();
+    source_pyramid_valid_ = target_pyramid_valid_ = false;
+  }
+
+  /** \brief Get the levels of the pyramid. */
+  inline const std::vector<Level>&
+  getLevels() const
+  {
+    return (levels_);
+  }
+
+  /** \brief Provide a pointer to the input source (e.g., the point cloud that we want
+   * to align to the target). Invalidates the cached source pyramid.
+   * \param[in] cloud the input point cloud source
+   */
+  void
+  setInputSource(const PointCloudSourceConstPtr& cloud) override
+  {
+    Registration<PointSource, PointTarget, Scalar>::setInputSource(cloud);
+    source_pyramid_valid_ = false;
+  }
+
+  /** \brief Provide a pointer to the input target (e.g., the point cloud that we want
+   * to align the input source to). Invalidates the cached target pyramid.
+   * \param[in] cloud the input point cloud target
+   */
+  void
+  setInputTarget(const PointCloudTargetConstPtr& cloud) override
+  {
+    Registration<PointSource, PointTarget, Scalar>::setInputTarget(cloud);
+    target_pyramid_valid_ = false;
+  }
+
+protected:
+  /** \brief Run the wrapped registration on every level of the pyramid.
+   * \param[out] output the transformed input point cloud dataset using the final
+   * transformation
+   * \param[in] guess the initial guess of the transformation
+   */
+  void
+  computeTransformation(PointCloudSource& output, const Matrix4& guess) override;
+
+  /** \brief (Re)build the down-sampled clouds and kd-trees of the source and target
+   * pyramids, if they are out of date. */
+  void
+  buildPyramids();
+
+  /** \brief The registration method run on every level. */
+  RegistrationPtr registration_;
+
+  /** \brief The parameters of the pyramid levels, from coarse to fine. */
+  std::vector<Level> levels_;
+
+  /** \brief Down-sampled source cloud of each level. */
+  std::vector<PointCloudSourceConstPtr> source_clouds_;
+
+  /** \brief Down-sampled target cloud of each level. */
+  std::vector<PointCloudTargetConstPtr> target_clouds_;
+
+  /** \brief Search tree of each level of the target pyramid. */
+  std::vector<KdTreePtr> target_trees_;
+
+  /** \brief Whether the cached source pyramid matches the current input source. */
+  bool source_pyramid_valid_;
+
+  /** \brief The source indices the cached source pyramid was built from. */
+  IndicesPtr source_pyramid_indices_;
+
+  /** \brief Whether the cached target pyramid matches the current input target. */
+  bool target_pyramid_valid_;
+
+public:
+  PCL_MAKE_ALIGNED_OPERATOR_NEW
+};
+} // namespace pcl
+
+#include <pcl/registration/impl/multi_resolution_registration.hpp>
@@ -45,6 +45,8 @@
 #include <pcl/registration/transformation_estimation_svd.h>
 #include <pcl/registration/transformation_validation.h>
 
+#include <random>
+
 namespace pcl {
 /** \brief Pose estimation and alignment class using a prerejective RANSAC routine.
  *
@@ -62,6 +64,9 @@ namespace pcl {
  * using \ref setSimilarityThreshold() in [0,1[, where a value of 0 means disabled,
  * and 1 is maximally rejective.
  *
+ * The pose hypotheses can be generated and verified in parallel, see
+ * \ref setNumberOfThreads().
+ *
  * If you use this in academic work, please cite:
  *
  * A. G. Buch, D. Kraft, J.-K. Kämäräinen, H. G. Petersen and N. Krüger.
@@ -126,6 +131,7 @@ public:
   , feature_tree_(new pcl::KdTreeFLANN<FeatureT>)
   , correspondence_rejector_poly_(new CorrespondenceRejectorPoly)
   , inlier_fraction_(0.0f)
+  , threads_(-1)
   {
     reg_name_ = "SampleConsensusPrerejective";
     correspondence_rejector_poly_->setSimilarityThreshold(0.6f);
@@ -246,6 +252,27 @@ public:
     return inliers_;
   }
 
+  /** \brief Set the number of threads to use or turn off parallelization.
+   * In parallel mode the feature correspondences of all source points are computed
+   * up front, every thread draws its samples from its own random number generator
+   * (seeded from std::rand ()) and hypotheses which can no longer beat the best one
+   * found so far are dropped before all source points are verified.
+   * \param[in] nr_threads the number of hardware threads to use (0 sets the value
+   * automatically, a negative number turns parallelization off)
+   */
+  inline void
+  setNumberOfThreads(int nr_threads = -1)
+  {
+    threads_ = nr_threads;
+  }
+
+  /** \brief Get the number of threads, as set by the user. */
+  inline int
+  getNumberOfThreads() const
+  {
+    return (threads_);
+  }
+
 protected:
   /** \brief Choose a random index between 0 and n-1
    * \param n the number of possible indices to choose from
@@ -256,6 +283,16 @@ protected:
     return (static_cast<int>(n * (rand() / (RAND_MAX + 1.0))));
   };
 
+  /** \brief Choose a random index between 0 and n-1
+   * \param n the number of possible indices to choose from
+   * \param rng the random number generator to draw from
+   */
+  inline int
+  getRandomIndex(int n, std::mt19937& rng) const
+  {
+    return (std::uniform_int_distribution<int>(0, n - 1)(rng));
+  };
+
   /** \brief Select \a nr_samples sample points from cloud while making sure that their
    * pairwise distances are greater than a user-defined minimum distance, \a
    * min_sample_distance. \param cloud the input point cloud \param nr_samples the
@@ -266,6 +303,19 @@ protected:
                 int nr_samples,
                 std::vector<int>& sample_indices);
 
+  /** \brief Select \a nr_samples unique sample points from cloud, drawing from the
+   * given generator instead of std::rand (). \param cloud the input point cloud
+   * \param nr_samples the number of samples to select \param sample_indices the
+   * resulting sample indices \param random_index functor returning a random index in
+   * [0, n-1] for a given n
+   */
+  template <typename RandomIndex>
+  void
+  selectSamples(const PointCloudSource& cloud,
+                int nr_samples,
+                std::vector<int>& sample_indices,
+                RandomIndex&& random_index) const;
+
   /** \brief For each of the sample points, find a list of points in the target cloud
    * whose features are similar to the sample points' features. From these, select one
    * randomly which will be considered that sample point's correspondence. \param
@@ -298,6 +348,34 @@ protected:
   void
   getFitness(std::vector<int>& inliers, float& fitness_score);
 
+  /** \brief Obtain the fitness of a given transformation, stopping as soon as the
+   * hypothesis can no longer be accepted, i.e. when even if all the remaining points
+   * were perfect inliers the inlier fraction would stay below \a min_inlier_fraction or
+   * the MSE would not drop below \a max_fitness_score.
+   * \param transformation the transformation to evaluate
+   * \param min_inlier_fraction the inlier fraction required for acceptance
+   * \param max_fitness_score the fitness score to beat
+   * \param inliers indices of source point cloud inliers
+   * \param fitness_score output fitness score as MSE
+   * \return false if the evaluation was stopped early
+   */
+  bool
+  getFitness(const Matrix4& transformation,
+             float min_inlier_fraction,
+             float max_fitness_score,
+             std::vector<int>& inliers,
+             float& fitness_score) const;
+
+  /** \brief Generate and verify the pose hypotheses in parallel, updating
+   * \b final_transformation_, \b inliers_ and \b converged_ if a better hypothesis
+   * than \a lowest_error is found.
+   * \param threads the number of threads to use
+   * \param lowest_error the error to beat, updated with the best error found
+   * \return the number of prerejected hypotheses
+   */
+  int
+  computeHypothesesParallel(int threads, float& lowest_error);
+
   /** \brief The source point cloud's feature descriptors. */
   FeatureCloudConstPtr input_features_;
 
@@ -323,6 +401,10 @@ protected:
 
   /** \brief Inlier points of final transformation as indices into source */
   std::vector<int> inliers_;
+
+  /** \brief The number of threads the scheduler should use, or a negative number if
+   * no parallelization is wanted. */
+  int threads_;
 };
 } // namespace pcl
 
@@ -0,0 +1,173 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2020-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <pcl/pcl_base.h>
+#include <pcl/point_cloud.h>
+#include <pcl/types.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace pcl
+{
+  /** \brief @b ClusteringGrid is a flat spatial hash of a point cloud with a cell size equal to a fixed search radius,
+    * as used by the grid modes of the Euclidean clustering classes.
+    *
+    * All neighbors of a point within the cell size are in the 27 cells around the cell of the point, so radius
+    * searches and neighbor pair enumerations only visit those. The indexed points are stored sorted by cell, with
+    * their coordinates in separate arrays so that the distance checks of a cell are vectorized by the compiler.
+    * Cells are found through an open addressing hash table keyed by their integer coordinates.
+    *
+    * \note Non-finite points are not indexed, they have no neighbors.
+    * \ingroup segmentation
+    */
+  template <typename PointT>
+  class ClusteringGrid
+  {
+    public:
+      using PointCloud = pcl::PointCloud<PointT>;
+      using PointCloudConstPtr = typename PointCloud::ConstPtr;
+
+      /** \brief Empty constructor. */
+      ClusteringGrid () : cloud_ (nullptr), cell_size_ (0.0f), inverse_cell_size_ (0.0f), min_ (Eigen::Array3f::Zero ()), hash_shift_ (64) {}
+
+      /** \brief Index the given points.
+        * \param[in] cloud the input point cloud
+        * \param[in] indices the indices of the points to index
+        * \param[in] cell_size the edge length of the cells, i.e. the largest search radius
+        * \param[in] nr_threads the number of threads used to compute the cell keys (0 for all cores)
+        * \return false if the cloud is too large to be indexed with this cell size
+        */
+      bool
+      build (const PointCloud &cloud, const Indices &indices, float cell_size, unsigned int nr_threads = 1);
+
+      /** \brief Get the number of non-empty cells. */
+      inline std::size_t
+      getNumberOfCells () const
+      {
+        return (cell_keys_.size ());
+      }
+
+      /** \brief Get the (cloud) indices of the points of a cell. */
+      inline const index_t*
+      getCellPoints (std::size_t cell, std::size_t &size) const
+      {
+        size = cell_start_[cell + 1] - cell_start_[cell];
+        return (&point_indices_[cell_start_[cell]]);
+      }
+
+      /** \brief Get the neighboring cells of a cell, the cell itself included.
+        * \param[in] cell the cell
+        * \param[out] neighbors the non-empty cells among the 27 cells around \a cell
+        * \return the number of neighboring cells written to \a neighbors
+        */
+      int
+      getNeighborCells (std::size_t cell, std::size_t (&neighbors)[27]) const;
+
+      /** \brief Compute the squared distances between a point and all points of a cell.
+        * \param[in] point the query point
+        * \param[in] cell the cell
+        * \param[out] sqr_distances the squared distances, in the order of \ref getCellPoints
+        */
+      void
+      computeSquaredDistances (const Eigen::Vector3f &point, std::size_t cell, std::vector<float> &sqr_distances) const;
+
+      /** \brief Search for all points closer than the cell size to a query point of the cloud.
+        * \param[in] index the (cloud) index of the query point, it is not returned as its own neighbor
+        * \param[out] k_indices the (cloud) indices of the neighbors, in no particular order
+        * \param[out] k_sqr_distances the squared distances to the neighbors
+        * \return the number of neighbors found
+        */
+      int
+      radiusSearch (index_t index, Indices &k_indices, std::vector<float> &k_sqr_distances) const;
+
+    protected:
+      /** \brief Get the integer coordinates of the cell containing a point, or false if the point is further than
+        * one cell away from the grid.
+        */
+      bool
+      getCoordinates (const Eigen::Vector3f &point, std::int64_t (&coordinates)[3]) const;
+
+      /** \brief Get the non-empty cells among the 27 cells around the given cell coordinates. */
+      int
+      getNeighborCells (const std::int64_t (&coordinates)[3], std::size_t (&neighbors)[27]) const;
+
+      /** \brief Find a cell in the hash table, returns -1 if it is empty. */
+      std::int64_t
+      findCell (std::uint64_t key) const;
+
+      /** \brief Hash function of the cell keys. */
+      inline std::size_t
+      hash (std::uint64_t key) const
+      {
+        return (static_cast<std::size_t> ((key * 0x9E3779B97F4A7C15ull) >> hash_shift_));
+      }
+
+      /** \brief The cloud the grid was built for. */
+      const PointCloud *cloud_;
+
+      /** \brief Edge length of the cells and its inverse. */
+      float cell_size_, inverse_cell_size_;
+
+      /** \brief Lower corner of the grid. */
+      Eigen::Array3f min_;
+
+      /** \brief Key of every non-empty cell, ascending. */
+      std::vector<std::uint64_t> cell_keys_;
+
+      /** \brief Position of the first point of every cell in point_indices_, plus the end position. */
+      std::vector<std::size_t> cell_start_;
+
+      /** \brief Indices of the indexed points, sorted by cell. */
+      Indices point_indices_;
+
+      /** \brief Coordinates of the indexed points, sorted by cell. */
+      std::vector<float> x_, y_, z_;
+
+      /** \brief Open addressing hash table mapping keys to cells, a power of two in size. */
+      std::vector<std::int64_t> table_;
+
+      /** \brief Number of bits the hashed key is shifted right to index table_. */
+      int hash_shift_;
+
+    public:
+      PCL_MAKE_ALIGNED_OPERATOR_NEW
+  };
+}
+
+#include <pcl/segmentation/impl/clustering_grid.hpp>
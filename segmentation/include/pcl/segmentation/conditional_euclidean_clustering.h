@@ -103,6 +103,7 @@ namespace pcl
           min_cluster_size_ (1),
           max_cluster_size_ (std::numeric_limits<int>::max ()),
           extract_removed_clusters_ (extract_removed_clusters),
+          use_grid_search_ (false),
           small_clusters_ (new pcl::IndicesClusters),
           large_clusters_ (new pcl::IndicesClusters)
       {
@@ -206,6 +207,26 @@ namespace pcl
         return (max_cluster_size_);
       }
 
+      /** \brief Set whether the neighbors of the points are found with a voxel hash (see \ref ClusteringGrid) instead of
+        * the search method. The hash is built once per call to segment() with cells as large as the cluster tolerance,
+        * and is usually much faster than a search tree for unorganized clouds. The clusters contain the same points,
+        * but the points of a cluster may be listed in a different order. If the cloud spans too many cells for the
+        * hash the search method is used anyway.
+        * \param[in] use_grid_search Whether to use the voxel hash (default = false)
+        */
+      inline void
+      setUseGridSearch (bool use_grid_search)
+      {
+        use_grid_search_ = use_grid_search;
+      }
+
+      /** \brief Get whether the neighbors of the points are found with a voxel hash instead of the search method.*/
+      inline bool
+      getUseGridSearch () const
+      {
+        return (use_grid_search_);
+      }
+
       /** \brief Segment the input into separate clusters.
         * \details The input can be set using setInputCloud() and setIndices().
         * <br>
@@ -254,6 +275,9 @@ namespace pcl
       /** \brief Set to true if you want to be able to extract the clusters that are too large or too small (default = false) */
       bool extract_removed_clusters_;
 
+      /** \brief Set to true to find the neighbors with a voxel hash instead of the search method (default = false) */
+      bool use_grid_search_;
+
       /** \brief The resultant clusters that contain less than min_cluster_size points */
       pcl::IndicesClustersPtr small_clusters_;
 
@@ -59,6 +59,7 @@ namespace pcl
    *  Constrained Planar Cuts - Object Partitioning for Point Clouds
    *  In Proceedings of the IEEE Conference on Computer Vision and Pattern Recognition (CVPR) 2015
    *  Inherits most of its functionality from \ref LCCPSegmentation
+   *  The hypotheses of the weighted RANSAC are scored in parallel, using the number of threads set with \ref setNumberOfThreads.
    *  \author Markus Schoeler (mschoeler@web.de)
    *  \ingroup segmentation
    */
@@ -84,6 +85,7 @@ namespace pcl
       using LCCP::concavity_tolerance_threshold_;
       using LCCP::seed_resolution_;
       using LCCP::supervoxels_set_;
+      using LCCP::threads_;
 
     public:
       CPCSegmentation ();
@@ -163,6 +165,7 @@ namespace pcl
       /** \brief @b WeightedRandomSampleConsensus represents an implementation of the Directionally Weighted RANSAC algorithm, as described in: "Constrained Planar Cuts - Part Segmentation for Point Clouds", CVPR 2015, M. Schoeler, J. Papon, F. Wörgötter.
         *  \note It only uses points with a weight > 0 for the model calculation, but uses all points for the evaluation (scoring of the model)
         *  Only use in conjunction with sac_model_plane
+        *  The hypotheses are drawn serially and scored in parallel (see \ref setNumberOfThreads), so the result does not depend on the number of threads.
         *  If you use this in a scientific work please cite the following paper:
         *  M. Schoeler, J. Papon, F. Woergoetter
         *  Constrained Planar Cuts - Object Partitioning for Point Clouds
@@ -241,6 +244,12 @@ namespace pcl
           }
 
         protected:
+          /** \brief Compute the weighted score of a plane hypothesis, i.e. the mean weight of its inliers
+            * \param[in] model_coefficients the coefficients of the plane
+            */
+          double
+          computeScore (const Eigen::VectorXf &model_coefficients) const;
+
           /** \brief Initialize the model parameters. Called by the constructors. */
           void
           initialize ()
@@ -91,6 +91,17 @@ namespace pcl
       void
       setNumberOfIterations (unsigned int n_iterations = 10) {n_iterations_ = n_iterations;};
 
+      /** \brief Set the number of threads used by the dense CRF, i.e. by the permutohedral
+        * lattice filtering of the pairwise kernels and by the mean field updates.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads = 0);
+
+      /** \brief Get the number of threads used by the dense CRF. */
+      inline unsigned int
+      getNumberOfThreads () const { return (threads_); }
+
       /** \brief This method simply launches the segmentation algorithm */
       void
       segmentPoints (pcl::PointCloud<pcl::PointXYZRGBL> &output);
@@ -195,6 +206,9 @@ namespace pcl
       
       
       unsigned int n_iterations_;
+
+      /** \brief The number of threads the dense CRF should use. */
+      unsigned int threads_;
       
 
       /** \brief Contains normals of the points that will be segmented. */
@@ -82,6 +82,50 @@ namespace pcl
       const typename search::Search<PointT>::Ptr &tree, float tolerance, std::vector<PointIndices> &clusters,
       unsigned int min_pts_per_cluster = 1, unsigned int max_pts_per_cluster = (std::numeric_limits<int>::max) ());
 
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /** \brief Decompose a region of space into clusters based on the Euclidean distance between points, using several
+    * threads. The radius searches of all points run in parallel and the neighboring points are merged with a
+    * concurrent (lock-free) union-find. The resulting clusters are the same as the ones of the serial
+    * \ref extractEuclideanClusters, in the same order.
+    * \param cloud the point cloud message
+    * \param indices a list of point indices to use from \a cloud
+    * \param tree the spatial locator (e.g., kd-tree) used for nearest neighbors searching
+    * \note the tree has to be created as a spatial locator on \a cloud and \a indices, and has to support
+    * concurrent searches
+    * \param tolerance the spatial cluster tolerance as a measure in L2 Euclidean space
+    * \param clusters the resultant clusters containing point indices (as a vector of PointIndices)
+    * \param min_pts_per_cluster minimum number of points that a cluster may contain
+    * \param max_pts_per_cluster maximum number of points that a cluster may contain
+    * \param nr_threads the number of threads to use (0 to use all available cores)
+    * \ingroup segmentation
+    */
+  template <typename PointT> void
+  extractEuclideanClustersParallel (
+      const PointCloud<PointT> &cloud, const Indices &indices,
+      const typename search::Search<PointT>::Ptr &tree, float tolerance, std::vector<PointIndices> &clusters,
+      unsigned int min_pts_per_cluster, unsigned int max_pts_per_cluster, unsigned int nr_threads);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /** \brief Decompose a region of space into clusters based on the Euclidean distance between points, without a
+    * search tree. The points are hashed into a \ref ClusteringGrid with cells as large as the tolerance, and every
+    * cell is only compared with the (up to 26) cells around it. The cells are processed in parallel and the close
+    * points are merged with a concurrent union-find, so the resulting clusters are the same as the ones of
+    * \ref extractEuclideanClusters, in the same order.
+    * \param cloud the point cloud message
+    * \param indices a list of point indices to use from \a cloud
+    * \param tolerance the spatial cluster tolerance as a measure in L2 Euclidean space
+    * \param clusters the resultant clusters containing point indices (as a vector of PointIndices)
+    * \param min_pts_per_cluster minimum number of points that a cluster may contain
+    * \param max_pts_per_cluster maximum number of points that a cluster may contain
+    * \param nr_threads the number of threads to use (0 to use all available cores)
+    * \return false if the points span too many cells to be hashed, \a clusters is left untouched then
+    * \ingroup segmentation
+    */
+  template <typename PointT> bool
+  extractEuclideanClustersGrid (
+      const PointCloud<PointT> &cloud, const Indices &indices, float tolerance, std::vector<PointIndices> &clusters,
+      unsigned int min_pts_per_cluster, unsigned int max_pts_per_cluster, unsigned int nr_threads);
+
   //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   /** \brief Decompose a region of space into clusters based on the euclidean distance between points, and the normal
     * angular deviation between points. Each point added to the cluster is origin to another radius search. Each point
@@ -332,7 +376,9 @@ namespace pcl
       EuclideanClusterExtraction () : tree_ (), 
                                       cluster_tolerance_ (0),
                                       min_pts_per_cluster_ (1), 
-                                      max_pts_per_cluster_ (std::numeric_limits<int>::max ())
+                                      max_pts_per_cluster_ (std::numeric_limits<int>::max ()),
+                                      threads_ (1),
+                                      use_grid_search_ (false)
       {};
 
       /** \brief Provide a pointer to the search object.
@@ -401,6 +447,42 @@ namespace pcl
         return (max_pts_per_cluster_); 
       }
 
+      /** \brief Set the number of threads used by \ref extract. With more than one thread the points are
+        * clustered with \ref extractEuclideanClustersParallel, which gives the same clusters.
+        * \param[in] nr_threads the number of threads to use (0 to use all available cores, default = 1)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 1)
+      {
+        threads_ = nr_threads;
+      }
+
+      /** \brief Get the number of threads used by \ref extract. */
+      inline unsigned int
+      getNumberOfThreads () const
+      {
+        return (threads_);
+      }
+
+      /** \brief Set whether the clusters are extracted with a voxel hash instead of the search method, see
+        * \ref extractEuclideanClustersGrid. This is usually much faster for unorganized clouds and gives the same
+        * clusters. If the cloud is too large for the hash (more than about two million tolerances along an axis)
+        * the search method is used anyway.
+        * \param[in] use_grid_search whether to use the voxel hash (default = false)
+        */
+      inline void
+      setUseGridSearch (bool use_grid_search)
+      {
+        use_grid_search_ = use_grid_search;
+      }
+
+      /** \brief Get whether the clusters are extracted with a voxel hash instead of the search method. */
+      inline bool
+      getUseGridSearch () const
+      {
+        return (use_grid_search_);
+      }
+
       /** \brief Cluster extraction in a PointCloud given by <setInputCloud (), setIndices ()>
         * \param[out] clusters the resultant point clusters
         */
@@ -426,6 +508,12 @@ namespace pcl
       /** \brief The maximum number of points that a cluster needs to contain in order to be considered valid (default = MAXINT). */
       int max_pts_per_cluster_;
 
+      /** \brief The number of threads used to extract the clusters (default = 1). */
+      unsigned int threads_;
+
+      /** \brief Whether the clusters are extracted with a voxel hash instead of the search method (default = false). */
+      bool use_grid_search_;
+
       /** \brief Class getName method. */
       virtual std::string getClassName () const { return ("EuclideanClusterExtraction"); }
 
@@ -47,6 +47,7 @@
 #include <pcl/pcl_macros.h>
 #include <pcl/point_types.h>
 #include <pcl/search/search.h>
+#include <pcl/segmentation/max_flow_graph.h>
 
 namespace pcl
 {
@@ -408,7 +409,7 @@ namespace pcl
       };
       bool
       initCompute ();
-      using vertex_descriptor = pcl::segmentation::grabcut::BoykovKolmogorov::vertex_descriptor;
+      using vertex_descriptor = int;
       /// Compute beta from image
       void
       computeBetaOrganized ();
@@ -432,7 +433,7 @@ namespace pcl
       /// Fit Gaussian Multi Models
       virtual void
       fitGMMs ();
-      /// Build the graph for GraphCut
+      /// Build the graph for GraphCut, the N-links are only added when the graph is empty
       void
       initGraph ();
       /// Add an edge to the graph, graph must be oriented so we add the edge and its reverse
@@ -475,7 +476,7 @@ namespace pcl
       segmentation::grabcut::GMM background_GMM_, foreground_GMM_;
       // Graph part
       /// Graph for Graphcut
-      pcl::segmentation::grabcut::BoykovKolmogorov graph_;
+      pcl::segmentation::MaxFlowGraph graph_;
       /// Graph nodes
       std::vector<vertex_descriptor> graph_nodes_;
   };
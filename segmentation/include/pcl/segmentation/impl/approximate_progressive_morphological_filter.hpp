@@ -116,32 +116,34 @@ pcl::ApproximateProgressiveMorphologicalFilter<PointT>::extract (Indices& ground
   int rows = static_cast<int> (std::floor (yextent / cell_size_) + 1);
   int cols = static_cast<int> (std::floor (xextent / cell_size_) + 1);
 
-  Eigen::MatrixXf A (rows, cols);
-  A.setConstant (std::numeric_limits<float>::quiet_NaN ());
-
-  Eigen::MatrixXf Z (rows, cols);
-  Z.setConstant (std::numeric_limits<float>::quiet_NaN ());
-
-  Eigen::MatrixXf Zf (rows, cols);
-  Zf.setConstant (std::numeric_limits<float>::quiet_NaN ());
-
+  // Cell of every point of the input cloud
+  int num_points = static_cast<int> (input_->size ());
+  std::vector<int> point_cells (num_points);
 #pragma omp parallel for \
   default(none) \
-  shared(A, global_min) \
+  shared(global_min, num_points, point_cells, rows) \
   num_threads(threads_)
-  for (int i = 0; i < (int)input_->size (); ++i)
+  for (int i = 0; i < num_points; ++i)
   {
-    // ...then test for lower points within the cell
-    PointT p = (*input_)[i];
-    int row = std::floor((p.y - global_min.y ()) / cell_size_);
-    int col = std::floor((p.x - global_min.x ()) / cell_size_);
+    const PointT& p = (*input_)[i];
+    int row = static_cast<int> (std::floor ((p.y - global_min.y ()) / cell_size_));
+    int col = static_cast<int> (std::floor ((p.x - global_min.x ()) / cell_size_));
+    point_cells[i] = col * rows + row;
+  }
 
-    if (p.z < A (row, col) || std::isnan (A (row, col)))
-    {
-      A (row, col) = p.z;
-    }
+  // Minimum elevation of every cell. This is not done in parallel, as the
+  // updates of a cell by different points would race.
+  Eigen::MatrixXf A (rows, cols);
+  A.setConstant (std::numeric_limits<float>::quiet_NaN ());
+  for (int i = 0; i < num_points; ++i)
+  {
+    float& cell = A.data ()[point_cells[i]];
+    if ((*input_)[i].z < cell || std::isnan (cell))
+      cell = (*input_)[i].z;
   }
 
+  Eigen::MatrixXf Zf (rows, cols);
+
   // Ground indices are initially limited to those points in the input cloud we
   // wish to process
   ground = *indices_;
@@ -152,94 +154,28 @@ pcl::ApproximateProgressiveMorphologicalFilter<PointT>::extract (Indices& ground
     PCL_DEBUG ("      Iteration %d (height threshold = %f, window size = %f, half size = %d)...",
                i, height_thresholds[i], window_sizes[i], half_sizes[i]);
 
-    // Limit filtering to those points currently considered ground returns
-    typename pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
-    pcl::copyPointCloud<PointT> (*input_, ground, *cloud);
-
     // Apply the morphological opening operation at the current window size.
-#pragma omp parallel for \
-  default(none) \
-  shared(A, cols, half_sizes, i, rows, Z) \
-  num_threads(threads_)
-    for (int row = 0; row < rows; ++row)
-    {
-      int rs, re;
-      rs = ((row - half_sizes[i]) < 0) ? 0 : row - half_sizes[i];
-      re = ((row + half_sizes[i]) > (rows-1)) ? (rows-1) : row + half_sizes[i];
-
-      for (int col = 0; col < cols; ++col)
-      {
-        int cs, ce;
-        cs = ((col - half_sizes[i]) < 0) ? 0 : col - half_sizes[i];
-        ce = ((col + half_sizes[i]) > (cols-1)) ? (cols-1) : col + half_sizes[i];
-
-        float min_coeff = std::numeric_limits<float>::max ();
-
-        for (int j = rs; j < (re + 1); ++j)
-        {
-          for (int k = cs; k < (ce + 1); ++k)
-          {
-            if (A (j, k) != std::numeric_limits<float>::quiet_NaN ())
-            {
-              if (A (j, k) < min_coeff)
-                min_coeff = A (j, k);
-            }
-          }
-        }
-
-        if (min_coeff != std::numeric_limits<float>::max ())
-          Z(row, col) = min_coeff;
-      }
-    }
+    pcl::applyMorphologicalOperator (A, half_sizes[i], MORPH_OPEN, Zf, threads_);
 
+    // Find indices of the points whose difference between the source and
+    // filtered point clouds is less than the current height threshold.
+    int num_ground = static_cast<int> (ground.size ());
+    float height_threshold = height_thresholds[i];
+    std::vector<char> is_ground (num_ground);
 #pragma omp parallel for \
   default(none) \
-  shared(cols, half_sizes, i, rows, Z, Zf) \
+  shared(ground, height_threshold, is_ground, num_ground, point_cells, Zf) \
   num_threads(threads_)
-    for (int row = 0; row < rows; ++row)
+    for (int p_idx = 0; p_idx < num_ground; ++p_idx)
     {
-      int rs, re;
-      rs = ((row - half_sizes[i]) < 0) ? 0 : row - half_sizes[i];
-      re = ((row + half_sizes[i]) > (rows-1)) ? (rows-1) : row + half_sizes[i];
-
-      for (int col = 0; col < cols; ++col)
-      {
-        int cs, ce;
-        cs = ((col - half_sizes[i]) < 0) ? 0 : col - half_sizes[i];
-        ce = ((col + half_sizes[i]) > (cols-1)) ? (cols-1) : col + half_sizes[i];
-
-        float max_coeff = -std::numeric_limits<float>::max ();
-
-        for (int j = rs; j < (re + 1); ++j)
-        {
-          for (int k = cs; k < (ce + 1); ++k)
-          {
-            if (Z (j, k) != std::numeric_limits<float>::quiet_NaN ())
-            {
-              if (Z (j, k) > max_coeff)
-                max_coeff = Z (j, k);
-            }
-          }
-        }
-
-        if (max_coeff != -std::numeric_limits<float>::max ())
-          Zf (row, col) = max_coeff;
-      }
+      float diff = (*input_)[ground[p_idx]].z - Zf.data ()[point_cells[ground[p_idx]]];
+      is_ground[p_idx] = diff < height_threshold;
     }
 
-    // Find indices of the points whose difference between the source and
-    // filtered point clouds is less than the current height threshold.
     Indices pt_indices;
-    for (std::size_t p_idx = 0; p_idx < ground.size (); ++p_idx)
-    {
-      PointT p = (*cloud)[p_idx];
-      int erow = static_cast<int> (std::floor ((p.y - global_min.y ()) / cell_size_));
-      int ecol = static_cast<int> (std::floor ((p.x - global_min.x ()) / cell_size_));
-
-      float diff = p.z - Zf (erow, ecol);
-      if (diff < height_thresholds[i])
+    for (int p_idx = 0; p_idx < num_ground; ++p_idx)
+      if (is_ground[p_idx])
         pt_indices.push_back (ground[p_idx]);
-    }
 
     A.swap (Zf);
 
@@ -0,0 +1,284 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2020-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_SEGMENTATION_IMPL_CLUSTERING_GRID_HPP_
+#define PCL_SEGMENTATION_IMPL_CLUSTERING_GRID_HPP_
+
+#include <pcl/segmentation/clustering_grid.h>
+#include <pcl/common/point_tests.h> // for pcl::isFinite
+#include <pcl/common/utils.h> // for pcl::utils::ignore
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Number of bits of a cell coordinate in the key of a ClusteringGrid cell. */
+    constexpr int clustering_grid_coordinate_bits = 21;
+    constexpr std::int64_t clustering_grid_coordinate_mask = (std::int64_t (1) << clustering_grid_coordinate_bits) - 1;
+
+    inline std::uint64_t
+    packClusteringGridKey (std::int64_t x, std::int64_t y, std::int64_t z)
+    {
+      return (static_cast<std::uint64_t> (x) |
+              (static_cast<std::uint64_t> (y) << clustering_grid_coordinate_bits) |
+              (static_cast<std::uint64_t> (z) << (2 * clustering_grid_coordinate_bits)));
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::ClusteringGrid<PointT>::build (const PointCloud &cloud, const Indices &indices, float cell_size, unsigned int nr_threads)
+{
+  cloud_ = &cloud;
+  cell_keys_.clear ();
+  cell_start_.assign (1, 0);
+  point_indices_.clear ();
+  x_.clear (); y_.clear (); z_.clear ();
+  table_.clear ();
+  hash_shift_ = 64;
+
+  if (!(cell_size > 0.0f))
+    return (false);
+  cell_size_ = cell_size;
+  inverse_cell_size_ = 1.0f / cell_size;
+
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    nr_threads = omp_get_num_procs ();
+#else
+  nr_threads = 1;
+#endif
+
+  // Bounds of the finite points
+  Indices valid;
+  valid.reserve (indices.size ());
+  Eigen::Array3f min_pt = Eigen::Array3f::Constant (std::numeric_limits<float>::max ());
+  Eigen::Array3f max_pt = Eigen::Array3f::Constant (std::numeric_limits<float>::lowest ());
+  for (const auto &index : indices)
+  {
+    if (!isFinite (cloud[index]))
+      continue;
+    valid.push_back (index);
+    const Eigen::Array3f p = cloud[index].getArray3fMap ();
+    min_pt = min_pt.min (p);
+    max_pt = max_pt.max (p);
+  }
+  if (valid.empty ())
+    return (true);
+  min_ = min_pt;
+
+  // Every cell coordinate has to fit in its bits of the key
+  const Eigen::Array3f extent = (max_pt - min_pt) * inverse_cell_size_;
+  if (!(extent.maxCoeff () < static_cast<float> (detail::clustering_grid_coordinate_mask)))
+    return (false);
+
+  // Sort the points by cell, ties by index so that the layout does not depend on the input order
+  std::vector<std::pair<std::uint64_t, index_t> > entries (valid.size ());
+  const int nr_valid = static_cast<int> (valid.size ());
+#pragma omp parallel for num_threads(nr_threads) schedule(static)
+  for (int i = 0; i < nr_valid; ++i)
+  {
+    std::int64_t c[3] = {0, 0, 0};
+    // valid points lie inside the grid, which was sized from them
+    const bool inside = getCoordinates (cloud[valid[i]].getVector3fMap (), c);
+    assert (inside);
+    pcl::utils::ignore (inside);
+    entries[i] = std::make_pair (detail::packClusteringGridKey (c[0], c[1], c[2]), valid[i]);
+  }
+  std::sort (entries.begin (), entries.end ());
+
+  point_indices_.resize (entries.size ());
+  x_.resize (entries.size ()); y_.resize (entries.size ()); z_.resize (entries.size ());
+  for (std::size_t i = 0; i < entries.size (); ++i)
+  {
+    if (i == 0 || entries[i].first != entries[i - 1].first)
+    {
+      if (i != 0)
+        cell_start_.push_back (i);
+      cell_keys_.push_back (entries[i].first);
+    }
+    const PointT &point = cloud[entries[i].second];
+    point_indices_[i] = entries[i].second;
+    x_[i] = point.x; y_[i] = point.y; z_[i] = point.z;
+  }
+  cell_start_.push_back (entries.size ());
+
+  // Hash table with a load factor of at most 1/2
+  int table_bits = 1;
+  while ((std::size_t (1) << table_bits) < 2 * cell_keys_.size ())
+    ++table_bits;
+  hash_shift_ = 64 - table_bits;
+  table_.assign (std::size_t (1) << table_bits, -1);
+  const std::size_t table_mask = table_.size () - 1;
+  for (std::size_t cell = 0; cell < cell_keys_.size (); ++cell)
+  {
+    std::size_t slot = hash (cell_keys_[cell]);
+    while (table_[slot] >= 0)
+      slot = (slot + 1) & table_mask;
+    table_[slot] = static_cast<std::int64_t> (cell);
+  }
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::ClusteringGrid<PointT>::getCoordinates (const Eigen::Vector3f &point, std::int64_t (&coordinates)[3]) const
+{
+  const Eigen::Array3f c = ((point.array () - min_) * inverse_cell_size_).floor ();
+  // One cell of margin, the neighbors of a point just outside of the grid are still in it
+  if ((c < -1.0f).any () || (c > static_cast<float> (detail::clustering_grid_coordinate_mask + 1)).any ())
+    return (false);
+  for (int d = 0; d < 3; ++d)
+    coordinates[d] = static_cast<std::int64_t> (c[d]);
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> std::int64_t
+pcl::ClusteringGrid<PointT>::findCell (std::uint64_t key) const
+{
+  if (table_.empty ())
+    return (-1);
+  const std::size_t table_mask = table_.size () - 1;
+  for (std::size_t slot = hash (key); table_[slot] >= 0; slot = (slot + 1) & table_mask)
+    if (cell_keys_[table_[slot]] == key)
+      return (table_[slot]);
+  return (-1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::ClusteringGrid<PointT>::getNeighborCells (const std::int64_t (&coordinates)[3], std::size_t (&neighbors)[27]) const
+{
+  int nr_neighbors = 0;
+  for (std::int64_t z = coordinates[2] - 1; z <= coordinates[2] + 1; ++z)
+  {
+    if (z < 0 || z > detail::clustering_grid_coordinate_mask)
+      continue;
+    for (std::int64_t y = coordinates[1] - 1; y <= coordinates[1] + 1; ++y)
+    {
+      if (y < 0 || y > detail::clustering_grid_coordinate_mask)
+        continue;
+      for (std::int64_t x = coordinates[0] - 1; x <= coordinates[0] + 1; ++x)
+      {
+        if (x < 0 || x > detail::clustering_grid_coordinate_mask)
+          continue;
+        const std::int64_t cell = findCell (detail::packClusteringGridKey (x, y, z));
+        if (cell >= 0)
+          neighbors[nr_neighbors++] = static_cast<std::size_t> (cell);
+      }
+    }
+  }
+  return (nr_neighbors);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::ClusteringGrid<PointT>::getNeighborCells (std::size_t cell, std::size_t (&neighbors)[27]) const
+{
+  const std::uint64_t key = cell_keys_[cell];
+  const std::int64_t coordinates[3] = {
+    static_cast<std::int64_t> (key) & detail::clustering_grid_coordinate_mask,
+    static_cast<std::int64_t> (key >> detail::clustering_grid_coordinate_bits) & detail::clustering_grid_coordinate_mask,
+    static_cast<std::int64_t> (key >> (2 * detail::clustering_grid_coordinate_bits)) & detail::clustering_grid_coordinate_mask};
+  return (getNeighborCells (coordinates, neighbors));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ClusteringGrid<PointT>::computeSquaredDistances (const Eigen::Vector3f &point, std::size_t cell,
+                                                      std::vector<float> &sqr_distances) const
+{
+  const std::size_t begin = cell_start_[cell];
+  const std::size_t size = cell_start_[cell + 1] - begin;
+  sqr_distances.resize (size);
+
+  // Plain loop over the coordinate arrays, vectorized by the compiler
+  const float px = point[0], py = point[1], pz = point[2];
+  const float *x = &x_[begin], *y = &y_[begin], *z = &z_[begin];
+  float *out = sqr_distances.data ();
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    const float dx = x[i] - px, dy = y[i] - py, dz = z[i] - pz;
+    out[i] = dx * dx + dy * dy + dz * dz;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::ClusteringGrid<PointT>::radiusSearch (index_t index, Indices &k_indices, std::vector<float> &k_sqr_distances) const
+{
+  k_indices.clear ();
+  k_sqr_distances.clear ();
+  if (!cloud_ || cell_keys_.empty () || !isFinite ((*cloud_)[index]))
+    return (0);
+
+  const Eigen::Vector3f point = (*cloud_)[index].getVector3fMap ();
+  std::int64_t coordinates[3];
+  if (!getCoordinates (point, coordinates))
+    return (0);
+
+  std::size_t neighbors[27];
+  const int nr_neighbors = getNeighborCells (coordinates, neighbors);
+  const float sqr_radius = cell_size_ * cell_size_;
+  for (int n = 0; n < nr_neighbors; ++n)
+  {
+    for (std::size_t i = cell_start_[neighbors[n]]; i < cell_start_[neighbors[n] + 1]; ++i)
+    {
+      const float dx = x_[i] - point[0], dy = y_[i] - point[1], dz = z_[i] - point[2];
+      const float sqr_distance = dx * dx + dy * dy + dz * dz;
+      if (sqr_distance < sqr_radius && point_indices_[i] != index)
+      {
+        k_indices.push_back (point_indices_[i]);
+        k_sqr_distances.push_back (sqr_distance);
+      }
+    }
+  }
+  return (static_cast<int> (k_indices.size ()));
+}
+
+#endif // PCL_SEGMENTATION_IMPL_CLUSTERING_GRID_HPP_
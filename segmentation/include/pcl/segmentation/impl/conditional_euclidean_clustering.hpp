@@ -38,6 +38,7 @@
 #define PCL_SEGMENTATION_IMPL_CONDITIONAL_EUCLIDEAN_CLUSTERING_HPP_
 
 #include <pcl/segmentation/conditional_euclidean_clustering.h>
+#include <pcl/segmentation/clustering_grid.h>
 #include <pcl/search/organized.h> // for OrganizedNeighbor
 #include <pcl/search/kdtree.h> // for KdTree
 
@@ -56,15 +57,22 @@ pcl::ConditionalEuclideanClustering<PointT>::segment (pcl::IndicesClusters &clus
   if (!initCompute () || input_->points.empty () || indices_->empty () || !condition_function_)
     return;
 
-  // Initialize the search class
-  if (!searcher_)
+  // Initialize the voxel hash, or the search class if it is not used or the cloud spans too many cells
+  pcl::ClusteringGrid<PointT> grid;
+  const bool use_grid = use_grid_search_ && grid.build (*input_, *indices_, cluster_tolerance_);
+  if (!use_grid)
   {
-    if (input_->isOrganized ())
-      searcher_.reset (new pcl::search::OrganizedNeighbor<PointT> ());
-    else
-      searcher_.reset (new pcl::search::KdTree<PointT> ());
+    if (!searcher_)
+    {
+      if (input_->isOrganized ())
+        searcher_.reset (new pcl::search::OrganizedNeighbor<PointT> ());
+      else
+        searcher_.reset (new pcl::search::KdTree<PointT> ());
+    }
+    searcher_->setInputCloud (input_, indices_);
   }
-  searcher_->setInputCloud (input_, indices_);
+  // The search class returns the seed point itself as first neighbor, the voxel hash does not
+  const int first_neighbor = use_grid ? 0 : 1;
 
   // Temp variables used by search class
   Indices nn_indices;
@@ -93,14 +101,16 @@ pcl::ConditionalEuclideanClustering<PointT>::segment (pcl::IndicesClusters &clus
     while (cii < static_cast<int> (current_cluster.size ()))
     {
       // Search for neighbors around the current seed point of the current cluster
-      if (searcher_->radiusSearch ((*input_)[current_cluster[cii]], cluster_tolerance_, nn_indices, nn_distances) < 1)
+      const int nr_neighbors = use_grid ? grid.radiusSearch (current_cluster[cii], nn_indices, nn_distances) :
+                               searcher_->radiusSearch ((*input_)[current_cluster[cii]], cluster_tolerance_, nn_indices, nn_distances);
+      if (nr_neighbors < 1)
       {
         cii++;
         continue;
       }
 
       // Process the neighbors
-      for (int nii = 1; nii < static_cast<int> (nn_indices.size ()); ++nii)  // nii = neighbor indices iterator
+      for (int nii = first_neighbor; nii < static_cast<int> (nn_indices.size ()); ++nii)  // nii = neighbor indices iterator
       {
         // Has this point been processed before?
         if (nn_indices[nii] == -1 || processed[nn_indices[nii]])
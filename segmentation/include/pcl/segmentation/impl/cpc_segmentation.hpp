@@ -41,6 +41,10 @@
 #include <pcl/sample_consensus/sac_model_plane.h> // for SampleConsensusModelPlane
 #include <pcl/segmentation/cpc_segmentation.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 template <typename PointT>
 pcl::CPCSegmentation<PointT>::CPCSegmentation () :
     max_cuts_ (20),
@@ -162,6 +166,7 @@ pcl::CPCSegmentation<PointT>::applyCuttingPlane (std::uint32_t depth_levels_left
 
     weight_sac.setWeights (weights, use_directed_weights_);
     weight_sac.setMaxIterations (ransac_itrs_);
+    weight_sac.setNumberOfThreads (static_cast<int> (threads_));
 
     // if not enough inliers are found
     if (!weight_sac.computeModel ())
@@ -295,14 +300,16 @@ pcl::CPCSegmentation<PointT>::WeightedRandomSampleConsensus::computeModel (int)
   iterations_ = 0;
   best_score_ = -std::numeric_limits<double>::max ();
 
-  std::vector<int> selection;
+  Indices selection;
   Eigen::VectorXf model_coefficients;
 
   unsigned skipped_count = 0;
   // suppress infinite loops by just allowing 10 x maximum allowed iterations for invalid model parameters!
   const unsigned max_skip = max_iterations_ * 10;
 
-  // Iterate
+  // Draw the hypotheses serially, so that they do not depend on the number of threads
+  std::vector<Indices> selections;
+  std::vector<Eigen::VectorXf> hypotheses;
   while (iterations_ < max_iterations_ && skipped_count < max_skip)
   {
     // Get X samples which satisfy the model criteria and which have a weight > 0
@@ -315,50 +322,51 @@ pcl::CPCSegmentation<PointT>::WeightedRandomSampleConsensus::computeModel (int)
       break;
     }
 
-    // Search for inliers in the point cloud for the current plane model M
     if (!sac_model_->computeModelCoefficients (selection, model_coefficients))
     {
-      //++iterations_;
       ++skipped_count;
       continue;
     }
-    // weight distances to get the score (only using connected inliers)
-    sac_model_->setIndices (full_cloud_pt_indices_);
-
-    pcl::IndicesPtr current_inliers (new pcl::Indices);
-    sac_model_->selectWithinDistance (model_coefficients, threshold_, *current_inliers);
-    double current_score = 0;
-    Eigen::Vector3f plane_normal (model_coefficients[0], model_coefficients[1], model_coefficients[2]);
-    for (const auto &current_index : *current_inliers)
-    {
-      double index_score = weights_[current_index];
-      if (use_directed_weights_)
-        // the sqrt(2) factor was used in the paper and was meant for making the scores better comparable between directed and undirected weights
-        index_score *= 1.414 * (std::abs (plane_normal.dot (point_cloud_ptr_->at (current_index).getNormalVector3fMap ())));
-
-      current_score += index_score;
-    }
-    // normalize by the total number of inliers
-    current_score /= current_inliers->size ();
-    
+    selections.push_back (selection);
+    hypotheses.push_back (model_coefficients);
+    ++iterations_;
+  }
+  // the scores are computed on all points (only using connected inliers)
+  sac_model_->setIndices (full_cloud_pt_indices_);
+
+  int threads = threads_;
+  if (threads == 0)
+#ifdef _OPENMP
+    threads = omp_get_num_procs ();
+#else
+    threads = 1;
+#endif
+  else if (threads < 0)
+    threads = 1;
+
+  // Score the hypotheses in parallel
+  int nr_hypotheses = static_cast<int> (hypotheses.size ());
+  std::vector<double> scores (nr_hypotheses);
+#pragma omp parallel for \
+  default(none) \
+  shared(hypotheses, nr_hypotheses, scores) \
+  schedule(static) \
+  num_threads(threads)
+  for (int i = 0; i < nr_hypotheses; ++i)
+    scores[i] = computeScore (hypotheses[i]);
+
+  for (int i = 0; i < nr_hypotheses; ++i)
+  {
     // Better match ?
-    if (current_score > best_score_)
+    if (scores[i] > best_score_)
     {
-      best_score_ = current_score;
+      best_score_ = scores[i];
       // Save the current model/inlier/coefficients selection as being the best so far
-      model_ = selection;
-      model_coefficients_ = model_coefficients;
-    }
-
-    ++iterations_;
-    PCL_DEBUG ("[pcl::CPCSegmentation<PointT>::WeightedRandomSampleConsensus::computeModel] Trial %d (max %d): score is %f (best is: %f so far).\n", iterations_, max_iterations_, current_score, best_score_);
-    if (iterations_ > max_iterations_)
-    {
-      PCL_DEBUG ("[pcl::CPCSegmentation<PointT>::WeightedRandomSampleConsensus::computeModel] RANSAC reached the maximum number of trials.\n");
-      break;
+      model_ = selections[i];
+      model_coefficients_ = hypotheses[i];
     }
+    PCL_DEBUG ("[pcl::CPCSegmentation<PointT>::WeightedRandomSampleConsensus::computeModel] Trial %d (max %d): score is %f (best is: %f so far).\n", i + 1, max_iterations_, scores[i], best_score_);
   }
-//   std::cout << "Took us " << iterations_ - 1 << " iterations" << std::endl;
   PCL_DEBUG ("[pcl::CPCSegmentation<PointT>::WeightedRandomSampleConsensus::computeModel] Model: %lu size, %f score.\n", model_.size (), best_score_);
 
   if (model_.empty ())
@@ -372,4 +380,31 @@ pcl::CPCSegmentation<PointT>::WeightedRandomSampleConsensus::computeModel (int)
   return (true);
 }
 
+template <typename PointT> double
+pcl::CPCSegmentation<PointT>::WeightedRandomSampleConsensus::computeScore (const Eigen::VectorXf &model_coefficients) const
+{
+  // Same inliers as SampleConsensusModelPlane::selectWithinDistance, which can not be called concurrently
+  double score = 0;
+  std::size_t nr_inliers = 0;
+  Eigen::Vector3f plane_normal (model_coefficients[0], model_coefficients[1], model_coefficients[2]);
+  for (const auto &current_index : *full_cloud_pt_indices_)
+  {
+    const WeightSACPointType &point = (*point_cloud_ptr_)[current_index];
+    Eigen::Vector4f pt (point.x, point.y, point.z, 1.0f);
+    float distance = std::abs (model_coefficients.dot (pt));
+    if (!(distance < threshold_))
+      continue;
+
+    double index_score = weights_[current_index];
+    if (use_directed_weights_)
+      // the sqrt(2) factor was used in the paper and was meant for making the scores better comparable between directed and undirected weights
+      index_score *= 1.414 * (std::abs (plane_normal.dot (point.getNormalVector3fMap ())));
+
+    score += index_score;
+    ++nr_inliers;
+  }
+  // normalize by the total number of inliers
+  return (score / static_cast<double> (nr_inliers));
+}
+
 #endif // PCL_SEGMENTATION_IMPL_CPC_SEGMENTATION_HPP_
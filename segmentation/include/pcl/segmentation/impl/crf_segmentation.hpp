@@ -48,6 +48,10 @@
 #include <cstdlib>
 #include <ctime>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT>
 pcl::CrfSegmentation<PointT>::CrfSegmentation () :
@@ -57,7 +61,8 @@ pcl::CrfSegmentation<PointT>::CrfSegmentation () :
   filtered_cloud_ (new pcl::PointCloud<PointT>),
   filtered_anno_ (new pcl::PointCloud<pcl::PointXYZRGBL>),
   filtered_normal_ (new pcl::PointCloud<pcl::PointNormal>),
-  voxel_grid_leaf_size_ (Eigen::Vector4f (0.001f, 0.001f, 0.001f, 0.0f))
+  voxel_grid_leaf_size_ (Eigen::Vector4f (0.001f, 0.001f, 0.001f, 0.0f)),
+  threads_ (1)
 {
 }
 
@@ -97,6 +102,20 @@ pcl::CrfSegmentation<PointT>::setVoxelGridLeafSize (const float x, const float y
   voxel_grid_leaf_size_.z () = z;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::CrfSegmentation<PointT>::setNumberOfThreads (unsigned int nr_threads)
+{
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    threads_ = omp_get_num_procs ();
+#else
+    threads_ = 1;
+#endif
+  else
+    threads_ = nr_threads;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::CrfSegmentation<PointT>::setSmoothnessKernelParameters (const float sx, const float sy, const float sz, 
@@ -482,6 +501,7 @@ pcl::CrfSegmentation<PointT>::segmentPoints (pcl::PointCloud<pcl::PointXYZRGBL>
 
   // create dense CRF
   DenseCrf crf (N, n_labels);
+  crf.setNumberOfThreads (threads_);
 
   // set the unary potentials
   crf.setUnaryEnergy (unary);
@@ -39,8 +39,139 @@
 #define PCL_SEGMENTATION_IMPL_EXTRACT_CLUSTERS_H_
 
 #include <pcl/segmentation/extract_clusters.h>
+#include <pcl/segmentation/clustering_grid.h>
 #include <pcl/search/organized.h> // for OrganizedNeighbor
 
+#include <atomic>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Lock-free union-find over the indices [0, size), links are only ever made from the larger to the
+      * smaller root, so the root of a set is its smallest element.
+      */
+    class ConcurrentUnionFind
+    {
+      public:
+        ConcurrentUnionFind (std::size_t size) : parent_ (size)
+        {
+          for (std::size_t i = 0; i < size; ++i)
+            parent_[i].store (static_cast<index_t> (i), std::memory_order_relaxed);
+        }
+
+        /** \brief Find the root of the set of x, halving the path on the way. */
+        inline index_t
+        find (index_t x)
+        {
+          index_t parent = parent_[x].load (std::memory_order_relaxed);
+          while (parent != x)
+          {
+            index_t grand_parent = parent_[parent].load (std::memory_order_relaxed);
+            if (grand_parent != parent)
+              parent_[x].compare_exchange_weak (parent, grand_parent, std::memory_order_relaxed);
+            x = parent;
+            parent = parent_[x].load (std::memory_order_relaxed);
+          }
+          return (x);
+        }
+
+        /** \brief Merge the sets of a and b. */
+        inline void
+        unite (index_t a, index_t b)
+        {
+          while (true)
+          {
+            a = find (a);
+            b = find (b);
+            if (a == b)
+              return;
+            if (a < b)
+              std::swap (a, b);
+            // a is the larger root, it fails to link only if it stopped being a root meanwhile
+            index_t expected = a;
+            if (parent_[a].compare_exchange_strong (expected, b, std::memory_order_relaxed))
+              return;
+          }
+        }
+
+      private:
+        std::vector<std::atomic<index_t> > parent_;
+    };
+
+    /** \brief Turn the sets of a union-find over the cloud into clusters: clusters are numbered in the order of
+      * their first point in \a indices, as \ref extractEuclideanClusters does, the ones of invalid size are dropped
+      * and the indices of every cluster are sorted.
+      */
+    inline void
+    extractClustersFromSets (ConcurrentUnionFind &sets, const Indices &indices, const pcl::PCLHeader &header,
+                             std::size_t cloud_size, std::vector<PointIndices> &clusters,
+                             unsigned int min_pts_per_cluster, unsigned int max_pts_per_cluster,
+                             unsigned int nr_threads)
+    {
+      const int nr_indices = static_cast<int> (indices.size ());
+
+      // Number the clusters in the order of their first point in indices, as the serial version does
+      Indices roots (nr_indices);
+#pragma omp parallel for num_threads(nr_threads) schedule(static)
+      for (int i = 0; i < nr_indices; ++i)
+        roots[i] = sets.find (indices[i]);
+
+      std::vector<int> cluster_ids (cloud_size, -1);
+      std::vector<unsigned int> cluster_sizes;
+      std::vector<bool> counted (cloud_size, false);
+      for (int i = 0; i < nr_indices; ++i)
+      {
+        // A point listed several times in indices only counts once
+        if (counted[indices[i]])
+        {
+          roots[i] = -1;
+          continue;
+        }
+        counted[indices[i]] = true;
+
+        const index_t root = roots[i];
+        if (cluster_ids[root] < 0)
+        {
+          cluster_ids[root] = static_cast<int> (cluster_sizes.size ());
+          cluster_sizes.push_back (0);
+        }
+        cluster_sizes[cluster_ids[root]]++;
+      }
+
+      // Drop the clusters of invalid size and compact the others
+      std::vector<int> output_ids (cluster_sizes.size (), -1);
+      const std::size_t first_cluster = clusters.size ();
+      for (std::size_t c = 0; c < cluster_sizes.size (); ++c)
+      {
+        if (cluster_sizes[c] < min_pts_per_cluster || cluster_sizes[c] > max_pts_per_cluster)
+          continue;
+        output_ids[c] = static_cast<int> (clusters.size () - first_cluster);
+        clusters.emplace_back ();
+        clusters.back ().indices.reserve (cluster_sizes[c]);
+        clusters.back ().header = header;
+      }
+      for (int i = 0; i < nr_indices; ++i)
+      {
+        if (roots[i] < 0)
+          continue;
+        const int output_id = output_ids[cluster_ids[roots[i]]];
+        if (output_id >= 0)
+          clusters[first_cluster + output_id].indices.push_back (indices[i]);
+      }
+
+      const int nr_clusters = static_cast<int> (clusters.size () - first_cluster);
+#pragma omp parallel for num_threads(nr_threads) schedule(dynamic)
+      for (int c = 0; c < nr_clusters; ++c)
+        std::sort (clusters[first_cluster + c].indices.begin (), clusters[first_cluster + c].indices.end ());
+    }
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::extractEuclideanClusters (const PointCloud<PointT> &cloud,
@@ -210,6 +341,133 @@ pcl::extractEuclideanClusters (const PointCloud<PointT> &cloud,
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::extractEuclideanClustersParallel (const PointCloud<PointT> &cloud,
+                                       const Indices &indices,
+                                       const typename search::Search<PointT>::Ptr &tree,
+                                       float tolerance, std::vector<PointIndices> &clusters,
+                                       unsigned int min_pts_per_cluster,
+                                       unsigned int max_pts_per_cluster,
+                                       unsigned int nr_threads)
+{
+  if (tree->getInputCloud()->size() != cloud.size()) {
+    PCL_ERROR("[pcl::extractEuclideanClustersParallel] Tree built for a different point "
+              "cloud dataset (%zu) than the input cloud (%zu)!\n",
+              static_cast<std::size_t>(tree->getInputCloud()->size()),
+              static_cast<std::size_t>(cloud.size()));
+    return;
+  }
+  if (tree->getIndices()->size() != indices.size()) {
+    PCL_ERROR("[pcl::extractEuclideanClustersParallel] Tree built for a different set of "
+              "indices (%zu) than the input set (%zu)!\n",
+              static_cast<std::size_t>(tree->getIndices()->size()),
+              indices.size());
+    return;
+  }
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    nr_threads = omp_get_num_procs ();
+#else
+  nr_threads = 1;
+#endif
+
+  // Link every point with all its neighbors, the order of the searches does not matter
+  detail::ConcurrentUnionFind sets (cloud.size ());
+  const int nr_indices = static_cast<int> (indices.size ());
+  bool search_failed = false;
+#pragma omp parallel num_threads(nr_threads)
+  {
+    Indices nn_indices;
+    std::vector<float> nn_distances;
+#pragma omp for schedule(dynamic, 256)
+    for (int i = 0; i < nr_indices; ++i)
+    {
+      const index_t index = indices[i];
+      const int ret = tree->radiusSearch (cloud[index], tolerance, nn_indices, nn_distances);
+      if (ret == -1)
+      {
+#pragma omp atomic write
+        search_failed = true;
+        continue;
+      }
+
+      for (const auto &nn_index : nn_indices)
+      {
+        // Every pair is found from both sides, linking it once is enough
+        if (nn_index == -1 || nn_index >= index)
+          continue;
+        sets.unite (index, nn_index);
+      }
+    }
+  }
+  if (search_failed)
+  {
+    PCL_ERROR("[pcl::extractEuclideanClustersParallel] Received error code -1 from radiusSearch\n");
+    return;
+  }
+
+  detail::extractClustersFromSets (sets, indices, cloud.header, cloud.size (), clusters,
+                                   min_pts_per_cluster, max_pts_per_cluster, nr_threads);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::extractEuclideanClustersGrid (const PointCloud<PointT> &cloud,
+                                   const Indices &indices,
+                                   float tolerance, std::vector<PointIndices> &clusters,
+                                   unsigned int min_pts_per_cluster,
+                                   unsigned int max_pts_per_cluster,
+                                   unsigned int nr_threads)
+{
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    nr_threads = omp_get_num_procs ();
+#else
+  nr_threads = 1;
+#endif
+
+  ClusteringGrid<PointT> grid;
+  if (!grid.build (cloud, indices, tolerance, nr_threads))
+    return (false);
+
+  // Link the close points of every pair of neighboring cells, each pair of cells is handled by its lower cell
+  detail::ConcurrentUnionFind sets (cloud.size ());
+  const int nr_cells = static_cast<int> (grid.getNumberOfCells ());
+  const float sqr_tolerance = tolerance * tolerance;
+#pragma omp parallel num_threads(nr_threads)
+  {
+    std::vector<float> sqr_distances;
+#pragma omp for schedule(dynamic, 64)
+    for (int c = 0; c < nr_cells; ++c)
+    {
+      std::size_t neighbors[27];
+      const int nr_neighbors = grid.getNeighborCells (static_cast<std::size_t> (c), neighbors);
+      std::size_t size;
+      const index_t *points = grid.getCellPoints (c, size);
+      for (int n = 0; n < nr_neighbors; ++n)
+      {
+        const std::size_t neighbor = neighbors[n];
+        if (neighbor < static_cast<std::size_t> (c))
+          continue;
+        std::size_t neighbor_size;
+        const index_t *neighbor_points = grid.getCellPoints (neighbor, neighbor_size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+          grid.computeSquaredDistances (cloud[points[i]].getVector3fMap (), neighbor, sqr_distances);
+          for (std::size_t j = (neighbor == static_cast<std::size_t> (c)) ? i + 1 : 0; j < neighbor_size; ++j)
+            if (sqr_distances[j] < sqr_tolerance)
+              sets.unite (points[i], neighbor_points[j]);
+        }
+      }
+    }
+  }
+
+  detail::extractClustersFromSets (sets, indices, cloud.header, cloud.size (), clusters,
+                                   min_pts_per_cluster, max_pts_per_cluster, nr_threads);
+  return (true);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -225,19 +483,27 @@ pcl::EuclideanClusterExtraction<PointT>::extract (std::vector<PointIndices> &clu
     return;
   }
 
-  // Initialize the spatial locator
-  if (!tree_)
+  // The voxel hash needs no spatial locator, it is only skipped if the cloud spans too many cells
+  if (!use_grid_search_ ||
+      !extractEuclideanClustersGrid (*input_, *indices_, static_cast<float> (cluster_tolerance_), clusters, min_pts_per_cluster_, max_pts_per_cluster_, threads_))
   {
-    if (input_->isOrganized ())
-      tree_.reset (new pcl::search::OrganizedNeighbor<PointT> ());
+    // Initialize the spatial locator
+    if (!tree_)
+    {
+      if (input_->isOrganized ())
+        tree_.reset (new pcl::search::OrganizedNeighbor<PointT> ());
+      else
+        tree_.reset (new pcl::search::KdTree<PointT> (false));
+    }
+
+    // Send the input dataset to the spatial locator
+    tree_->setInputCloud (input_, indices_);
+    if (threads_ == 1)
+      extractEuclideanClusters (*input_, *indices_, tree_, static_cast<float> (cluster_tolerance_), clusters, min_pts_per_cluster_, max_pts_per_cluster_);
     else
-      tree_.reset (new pcl::search::KdTree<PointT> (false));
+      extractEuclideanClustersParallel (*input_, *indices_, tree_, static_cast<float> (cluster_tolerance_), clusters, min_pts_per_cluster_, max_pts_per_cluster_, threads_);
   }
 
-  // Send the input dataset to the spatial locator
-  tree_->setInputCloud (input_, indices_);
-  extractEuclideanClusters (*input_, *indices_, tree_, static_cast<float> (cluster_tolerance_), clusters, min_pts_per_cluster_, max_pts_per_cluster_);
-
   //tree_->setInputCloud (input_);
   //extractEuclideanClusters (*input_, tree_, cluster_tolerance_, clusters, min_pts_per_cluster_, max_pts_per_cluster_);
 
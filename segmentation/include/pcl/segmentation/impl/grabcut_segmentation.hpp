@@ -142,6 +142,9 @@ GrabCut<PointT>::initCompute ()
     computeNLinksNonOrganized ();
   }
 
+  // The N-links changed, the graph is rebuilt by the next call to initGraph
+  graph_.clear ();
+
   initialized_ = false;
   return (true);
 }
@@ -155,8 +158,7 @@ GrabCut<PointT>::addEdge (vertex_descriptor v1, vertex_descriptor v2, float capa
 template <typename PointT> void
 GrabCut<PointT>::setTerminalWeights (vertex_descriptor v, float source_capacity, float sink_capacity)
 {
-  graph_.addSourceEdge (v, source_capacity);
-  graph_.addTargetEdge (v, sink_capacity);
+  graph_.setTerminalWeights (v, source_capacity, sink_capacity);
 }
 
 template <typename PointT> void
@@ -270,15 +272,20 @@ GrabCut<PointT>::initGraph ()
 {
   using namespace pcl::segmentation::grabcut;
   const int number_of_indices = static_cast<int> (indices_->size ());
-  // Set up the graph (it can only be used once, so we have to recreate it each time the graph is updated)
-  graph_.clear ();
-  graph_nodes_.clear ();
-  graph_nodes_.resize (indices_->size ());
-  int start = graph_.addNodes (indices_->size ());
-  for (std::size_t idx = 0; idx < indices_->size (); ++idx)
+  // Set up the graph. The N-links only depend on the input, so once the graph is built only the T-links change
+  // between two iterations.
+  const bool build_graph = (graph_.getNumberOfNodes () != indices_->size ());
+  if (build_graph)
   {
-    graph_nodes_[idx] = start;
-    ++start;
+    graph_.clear ();
+    graph_nodes_.clear ();
+    graph_nodes_.resize (indices_->size ());
+    int start = graph_.addNodes (indices_->size ());
+    for (std::size_t idx = 0; idx < indices_->size (); ++idx)
+    {
+      graph_nodes_[idx] = start;
+      ++start;
+    }
   }
 
   // Set T-Link weights
@@ -311,6 +318,9 @@ GrabCut<PointT>::initGraph ()
     setTerminalWeights (graph_nodes_[i_point], fore, back);
   }
 
+  if (!build_graph)
+    return;
+
   // Set N-Link weights from precomputed values
   for (int i_point = 0; i_point < number_of_indices; ++i_point)
   {
@@ -41,6 +41,13 @@
 #include <pcl/segmentation/lccp_segmentation.h>
 #include <pcl/common/common.h>
 
+#include <algorithm>
+#include <utility>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 
 //////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////
@@ -61,7 +68,9 @@ pcl::LCCPSegmentation<PointT>::LCCPSegmentation () :
   seed_resolution_ (0),
   voxel_resolution_ (0),
   k_factor_ (0),
-  min_segment_size_ (0)
+  min_segment_size_ (0),
+  threads_ (1),
+  connections_valid_ (false)
 {
 }
 
@@ -74,6 +83,9 @@ template <typename PointT> void
 pcl::LCCPSegmentation<PointT>::reset ()
 {
   sv_adjacency_list_.clear ();
+  sv_edges_.clear ();
+  sv_edge_dirty_.clear ();
+  connections_valid_ = false;
   processed_.clear ();
   sv_label_to_supervoxel_map_.clear ();
   sv_label_to_seg_label_map_.clear ();
@@ -107,6 +119,69 @@ pcl::LCCPSegmentation<PointT>::segment ()
     PCL_WARN ("[pcl::LCCPSegmentation::segment] WARNING: Call function setInputSupervoxels first. Nothing has been done. \n");
 }
 
+template <typename PointT> void
+pcl::LCCPSegmentation<PointT>::updateInputSupervoxels (const std::map<std::uint32_t, typename pcl::Supervoxel<PointT>::Ptr> &supervoxel_clusters_arg,
+                                                       const std::multimap<std::uint32_t, std::uint32_t> &label_adjacency_arg)
+{
+  // The flat edge array can only be kept if the supervoxel labels and their adjacency are the same
+  bool same_graph = supervoxels_set_ && supervoxel_clusters_arg.size () == sv_label_to_supervoxel_map_.size () &&
+                    std::equal (supervoxel_clusters_arg.cbegin (), supervoxel_clusters_arg.cend (), sv_label_to_supervoxel_map_.cbegin (),
+                                [] (const auto &lhs, const auto &rhs) { return (lhs.first == rhs.first); });
+  if (same_graph)
+  {
+    std::vector<std::pair<std::uint32_t, std::uint32_t> > new_edges, old_edges;
+    new_edges.reserve (label_adjacency_arg.size ());
+    for (const auto &sv_neighbors : label_adjacency_arg)
+      new_edges.push_back (std::minmax (sv_neighbors.first, sv_neighbors.second));
+    old_edges.reserve (sv_edges_.size ());
+    for (const auto &edge : sv_edges_)
+      old_edges.push_back (std::minmax (sv_adjacency_list_[boost::source (edge, sv_adjacency_list_)],
+                                        sv_adjacency_list_[boost::target (edge, sv_adjacency_list_)]));
+    std::sort (new_edges.begin (), new_edges.end ());
+    new_edges.erase (std::unique (new_edges.begin (), new_edges.end ()), new_edges.end ());
+    std::sort (old_edges.begin (), old_edges.end ());
+    same_graph = (new_edges == old_edges);
+  }
+  if (!same_graph)
+  {
+    setInputSupervoxels (supervoxel_clusters_arg, label_adjacency_arg);
+    return;
+  }
+
+  // Find the supervoxels whose centroid or normal changed, only their connections have to be evaluated again
+  std::set<std::uint32_t> changed_labels;
+  auto old_sv_itr = sv_label_to_supervoxel_map_.cbegin ();
+  for (const auto &sv : supervoxel_clusters_arg)
+  {
+    const pcl::Supervoxel<PointT> &old_sv = *(old_sv_itr++)->second;
+    if (old_sv.centroid_.getVector3fMap () != sv.second->centroid_.getVector3fMap () ||
+        old_sv.normal_.getNormalVector3fMap () != sv.second->normal_.getNormalVector3fMap ())
+      changed_labels.insert (sv.first);
+  }
+  sv_label_to_supervoxel_map_ = supervoxel_clusters_arg;
+
+  for (std::size_t i = 0; i < sv_edges_.size (); ++i)
+  {
+    if (changed_labels.count (sv_adjacency_list_[boost::source (sv_edges_[i], sv_adjacency_list_)]) > 0 ||
+        changed_labels.count (sv_adjacency_list_[boost::target (sv_edges_[i], sv_adjacency_list_)]) > 0)
+      sv_edge_dirty_[i] = true;
+  }
+  grouping_data_valid_ = false;
+}
+
+
+template <typename PointT> void
+pcl::LCCPSegmentation<PointT>::setNumberOfThreads (unsigned int nr_threads)
+{
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    threads_ = omp_get_num_procs();
+#else
+    threads_ = 1;
+#endif
+  else
+    threads_ = nr_threads;
+}
 
 template <typename PointT> void
 pcl::LCCPSegmentation<PointT>::relabelCloud (pcl::PointCloud<pcl::PointXYZL> &labeled_cloud_arg)
@@ -275,6 +350,12 @@ pcl::LCCPSegmentation<PointT>::prepareSegmentation (const std::map<std::uint32_t
     boost::add_edge (u, v, sv_adjacency_list_);
   }
 
+  // Keep the edges in a flat array, which is processed in parallel
+  EdgeIterator edge_itr, edge_itr_end;
+  for (std::tie (edge_itr, edge_itr_end) = boost::edges (sv_adjacency_list_); edge_itr != edge_itr_end; ++edge_itr)
+    sv_edges_.push_back (*edge_itr);
+  sv_edge_dirty_.assign (sv_edges_.size (), true);
+
   // Initialization
   // clear the processed_ map
   seg_label_to_sv_list_map_.clear ();
@@ -295,6 +376,7 @@ pcl::LCCPSegmentation<PointT>::doGrouping ()
 {
   // clear the processed_ map
   seg_label_to_sv_list_map_.clear ();
+  seg_label_to_neighbor_set_map_.clear ();
   for (typename std::map<std::uint32_t, typename pcl::Supervoxel<PointT>::Ptr>::iterator svlabel_itr = sv_label_to_supervoxel_map_.begin ();
       svlabel_itr != sv_label_to_supervoxel_map_.end (); ++svlabel_itr)
   {
@@ -357,20 +439,25 @@ pcl::LCCPSegmentation<PointT>::applyKconvexity (const unsigned int k_arg)
   if (k_arg == 0)
     return;
 
-  EdgeIterator edge_itr, edge_itr_end, next_edge;
-  // Check all edges in the graph for k-convexity
-  for (std::tie (edge_itr, edge_itr_end) = boost::edges (sv_adjacency_list_), next_edge = edge_itr; edge_itr != edge_itr_end; edge_itr = next_edge)
+  // Check all edges in the graph for k-convexity. Every edge only reads the convexity of its neighbors and writes its own validity.
+  unsigned int k = k_arg;
+  int nr_edges = static_cast<int> (sv_edges_.size ());
+#pragma omp parallel for \
+  default(none) \
+  shared(k, nr_edges) \
+  schedule(dynamic, 64) \
+  num_threads(threads_)
+  for (int edge_idx = 0; edge_idx < nr_edges; ++edge_idx)
   {
-    ++next_edge;  // next_edge iterator is necessary, because removing an edge invalidates the iterator to the current edge
-
-    bool is_convex = sv_adjacency_list_[*edge_itr].is_convex;
+    const EdgeID& edge = sv_edges_[edge_idx];
+    bool is_convex = sv_adjacency_list_[edge].is_convex;
 
     if (is_convex)  // If edge is (0-)convex
     {
       unsigned int kcount = 0;
 
-      const VertexID source = boost::source (*edge_itr, sv_adjacency_list_);
-      const VertexID target = boost::target (*edge_itr, sv_adjacency_list_);
+      const VertexID source = boost::source (edge, sv_adjacency_list_);
+      const VertexID target = boost::target (edge, sv_adjacency_list_);
 
       OutEdgeIterator source_neighbors_itr, source_neighbors_itr_end;
       // Find common neighbors, check their connection
@@ -397,13 +484,13 @@ pcl::LCCPSegmentation<PointT>::applyKconvexity (const unsigned int k_arg)
           }
         }
 
-        if (kcount >= k_arg)  // Connection is k-convex, stop search
+        if (kcount >= k)  // Connection is k-convex, stop search
           break;
       }
 
       // Check k convexity
-      if (kcount < k_arg)
-        (sv_adjacency_list_)[*edge_itr].is_valid = false;
+      if (kcount < k)
+        (sv_adjacency_list_)[edge].is_valid = false;
     }
   }
 }
@@ -411,20 +498,51 @@ pcl::LCCPSegmentation<PointT>::applyKconvexity (const unsigned int k_arg)
 template <typename PointT> void
 pcl::LCCPSegmentation<PointT>::calculateConvexConnections (SupervoxelAdjacencyList& adjacency_list_arg)
 {
-
-  EdgeIterator edge_itr, edge_itr_end, next_edge;
-  for (std::tie(edge_itr, edge_itr_end) = boost::edges (adjacency_list_arg), next_edge = edge_itr; edge_itr != edge_itr_end; edge_itr = next_edge)
+  // The edges of sv_adjacency_list_ are already stored in a flat array, others have to be collected
+  std::vector<EdgeID> other_edges;
+  const std::vector<EdgeID>* edges = &sv_edges_;
+  if (&adjacency_list_arg != &sv_adjacency_list_)
+  {
+    EdgeIterator edge_itr, edge_itr_end;
+    for (std::tie (edge_itr, edge_itr_end) = boost::edges (adjacency_list_arg); edge_itr != edge_itr_end; ++edge_itr)
+      other_edges.push_back (*edge_itr);
+    edges = &other_edges;
+  }
+  // Only the edges of changed supervoxels have to be evaluated again, see updateInputSupervoxels
+  bool incremental = (edges == &sv_edges_) && connections_valid_;
+
+  int nr_edges = static_cast<int> (edges->size ());
+#pragma omp parallel for \
+  default(none) \
+  shared(adjacency_list_arg, edges, incremental, nr_edges) \
+  schedule(static) \
+  num_threads(threads_)
+  for (int edge_idx = 0; edge_idx < nr_edges; ++edge_idx)
   {
-    ++next_edge;  // next_edge iterator is necessary, because removing an edge invalidates the iterator to the current edge
+    const EdgeID& edge = (*edges)[edge_idx];
+    EdgeProperties& edge_properties = adjacency_list_arg[edge];
+    edge_properties.used_for_cutting = false;
+    if (incremental && !sv_edge_dirty_[edge_idx])
+    {
+      // k-convexity and cuts of a previous segmentation may have invalidated the edge
+      edge_properties.is_valid = edge_properties.is_convex;
+      continue;
+    }
 
-    std::uint32_t source_sv_label = adjacency_list_arg[boost::source (*edge_itr, adjacency_list_arg)];
-    std::uint32_t target_sv_label = adjacency_list_arg[boost::target (*edge_itr, adjacency_list_arg)];
+    std::uint32_t source_sv_label = adjacency_list_arg[boost::source (edge, adjacency_list_arg)];
+    std::uint32_t target_sv_label = adjacency_list_arg[boost::target (edge, adjacency_list_arg)];
 
     float normal_difference;
     bool is_convex = connIsConvex (source_sv_label, target_sv_label, normal_difference);
-    adjacency_list_arg[*edge_itr].is_convex = is_convex;
-    adjacency_list_arg[*edge_itr].is_valid = is_convex;
-    adjacency_list_arg[*edge_itr].normal_difference = normal_difference;
+    edge_properties.is_convex = is_convex;
+    edge_properties.is_valid = is_convex;
+    edge_properties.normal_difference = normal_difference;
+  }
+
+  if (edges == &sv_edges_)
+  {
+    sv_edge_dirty_.assign (sv_edges_.size (), false);
+    connections_valid_ = true;
   }
 }
 
@@ -433,8 +551,9 @@ pcl::LCCPSegmentation<PointT>::connIsConvex (const std::uint32_t source_label_ar
                                              const std::uint32_t target_label_arg,
                                              float &normal_angle)
 {
-  typename pcl::Supervoxel<PointT>::Ptr& sv_source = sv_label_to_supervoxel_map_[source_label_arg];
-  typename pcl::Supervoxel<PointT>::Ptr& sv_target = sv_label_to_supervoxel_map_[target_label_arg];
+  // Called in parallel, so the supervoxel map must not be modified here
+  const typename pcl::Supervoxel<PointT>::Ptr& sv_source = sv_label_to_supervoxel_map_.at (source_label_arg);
+  const typename pcl::Supervoxel<PointT>::Ptr& sv_target = sv_label_to_supervoxel_map_.at (target_label_arg);
 
   const Eigen::Vector3f& source_centroid = sv_source->centroid_.getVector3fMap ();
   const Eigen::Vector3f& target_centroid = sv_target->centroid_.getVector3fMap ();
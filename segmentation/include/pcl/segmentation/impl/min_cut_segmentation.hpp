@@ -43,8 +43,13 @@
 #include <pcl/segmentation/min_cut_segmentation.h>
 #include <pcl/search/search.h>
 #include <pcl/search/kdtree.h>
+#include <algorithm>
 #include <cmath>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT>
 pcl::MinCutSegmentation<PointT>::MinCutSegmentation () :
@@ -60,11 +65,8 @@ pcl::MinCutSegmentation<PointT>::MinCutSegmentation () :
   foreground_points_ (0),
   background_points_ (0),
   clusters_ (0),
-  vertices_ (0),
-  edge_marker_ (0),
-  source_ (),/////////////////////////////////
-  sink_ (),///////////////////////////////////
-  max_flow_ (0.0)
+  max_flow_ (0.0),
+  threads_ (1)
 {
 }
 
@@ -75,8 +77,7 @@ pcl::MinCutSegmentation<PointT>::~MinCutSegmentation ()
   foreground_points_.clear ();
   background_points_.clear ();
   clusters_.clear ();
-  vertices_.clear ();
-  edge_marker_.clear ();
+  edge_points_.clear ();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -177,6 +178,27 @@ pcl::MinCutSegmentation<PointT>::setNumberOfNeighbours (unsigned int neighbour_n
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> unsigned int
+pcl::MinCutSegmentation<PointT>::getNumberOfThreads () const
+{
+  return (threads_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::MinCutSegmentation<PointT>::setNumberOfThreads (unsigned int nr_threads)
+{
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    threads_ = omp_get_num_procs();
+#else
+    threads_ = 1;
+#endif
+  else
+    threads_ = nr_threads;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> std::vector<PointT, Eigen::aligned_allocator<PointT> >
 pcl::MinCutSegmentation<PointT>::getForegroundPoints () const
@@ -271,12 +293,9 @@ pcl::MinCutSegmentation<PointT>::extract (std::vector <pcl::PointIndices>& clust
     binary_potentials_are_valid_ = true;
   }
 
-  //IndexMap index_map = boost::get (boost::vertex_index, *graph_);
-  ResidualCapacityMap residual_capacity = boost::get (boost::edge_residual_capacity, *graph_);
-
-  max_flow_ = boost::boykov_kolmogorov_max_flow (*graph_, source_, sink_);
+  max_flow_ = graph_.solve ();
 
-  assembleLabels (residual_capacity);
+  assembleLabels ();
 
   clusters.reserve (clusters_.size ());
   std::copy (clusters_.begin (), clusters_.end (), std::back_inserter (clusters));
@@ -295,7 +314,56 @@ pcl::MinCutSegmentation<PointT>::getMaxFlow () const
 template <typename PointT> typename pcl::MinCutSegmentation<PointT>::mGraphPtr
 pcl::MinCutSegmentation<PointT>::getGraph () const
 {
-  return (graph_);
+  if (!graph_is_valid_)
+    return (mGraphPtr ());
+
+  mGraphPtr graph (new mGraph);
+  CapacityMap capacity = boost::get (boost::edge_capacity, *graph);
+  ResidualCapacityMap residual_capacity = boost::get (boost::edge_residual_capacity, *graph);
+  ReverseEdgeMap reverse_edges = boost::get (boost::edge_reverse, *graph);
+
+  const auto number_of_points = input_->size ();
+  for (std::size_t i_point = 0; i_point < number_of_points + 2; i_point++)
+    boost::add_vertex (*graph);
+  const VertexDescriptor source = number_of_points;
+  const VertexDescriptor sink = number_of_points + 1;
+
+  // Every edge comes with a reverse edge of zero capacity
+  const auto add_edge = [&] (VertexDescriptor u, VertexDescriptor v, double weight, double residual)
+  {
+    EdgeDescriptor edge = boost::add_edge (u, v, *graph).first;
+    EdgeDescriptor reverse_edge = boost::add_edge (v, u, *graph).first;
+    capacity[edge] = weight;
+    capacity[reverse_edge] = 0.0;
+    residual_capacity[edge] = residual;
+    residual_capacity[reverse_edge] = weight - residual;
+    reverse_edges[edge] = reverse_edge;
+    reverse_edges[reverse_edge] = edge;
+  };
+
+  for (std::size_t i_point = 0; i_point < indices_->size (); i_point++)
+  {
+    const int node = static_cast<int> (i_point);
+    double source_weight = 0.0;
+    double sink_weight = 0.0;
+    calculateUnaryPotential ((*indices_)[i_point], source_weight, sink_weight);
+    add_edge (source, (*indices_)[i_point], source_weight, graph_.getSourceResidualCapacity (node));
+    add_edge ((*indices_)[i_point], sink, sink_weight, graph_.getSinkResidualCapacity (node));
+  }
+
+  // The flow of an edge of the graph goes through the (u, v) or the (v, u) edge, depending on its direction
+  for (std::size_t i_edge = 0; i_edge < edge_points_.size (); i_edge++)
+  {
+    const int edge = static_cast<int> (i_edge);
+    const index_t u = edge_points_[i_edge].first;
+    const index_t v = edge_points_[i_edge].second;
+    const double weight = calculateBinaryPotential (u, v);
+    const double flow = weight - graph_.getEdgeResidualCapacity (edge);
+    add_edge (u, v, weight, weight - std::max (flow, 0.0));
+    add_edge (v, u, weight, weight - std::max (-flow, 0.0));
+  }
+
+  return (graph);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -303,7 +371,7 @@ template <typename PointT> bool
 pcl::MinCutSegmentation<PointT>::buildGraph ()
 {
   const auto number_of_points = input_->size ();
-  const auto number_of_indices = indices_->size ();
+  int number_of_indices = static_cast<int> (indices_->size ());
 
   if (input_->points.empty () || number_of_points == 0 || foreground_points_.empty () == true )
     return (false);
@@ -311,56 +379,57 @@ pcl::MinCutSegmentation<PointT>::buildGraph ()
   if (!search_)
     search_.reset (new pcl::search::KdTree<PointT>);
 
-  graph_.reset (new mGraph);
-
-  capacity_.reset (new CapacityMap);
-  *capacity_ = boost::get (boost::edge_capacity, *graph_);
-
-  reverse_edges_.reset (new ReverseEdgeMap);
-  *reverse_edges_ = boost::get (boost::edge_reverse, *graph_);
-
-  VertexDescriptor vertex_descriptor(0);
-  vertices_.clear ();
-  vertices_.resize (number_of_points + 2, vertex_descriptor);
-
-  std::set<int> out_edges_marker;
-  edge_marker_.clear ();
-  edge_marker_.resize (number_of_points + 2, out_edges_marker);
-
-  for (std::size_t i_point = 0; i_point < number_of_points + 2; i_point++)
-    vertices_[i_point] = boost::add_vertex (*graph_);
-
-  source_ = vertices_[number_of_points];
-  sink_ = vertices_[number_of_points + 1];
+  // Node of every point, -1 for the points that are not segmented
+  std::vector<int> point_nodes (number_of_points, -1);
+  for (int i_point = 0; i_point < number_of_indices; i_point++)
+    point_nodes[(*indices_)[i_point]] = i_point;
 
-  for (std::size_t i_point = 0; i_point < number_of_indices; i_point++)
+  // Find the neighbours of all the points, the first one is the point itself
+  int number_of_neighbours = static_cast<int> (number_of_neighbours_);
+  Indices neighbours (static_cast<std::size_t> (number_of_indices) * number_of_neighbours, UNAVAILABLE);
+  search_->setInputCloud (input_, indices_);
+#pragma omp parallel for \
+  default(none) \
+  shared(neighbours, number_of_indices, number_of_neighbours) \
+  schedule(dynamic, 64) \
+  num_threads(threads_)
+  for (int i_point = 0; i_point < number_of_indices; i_point++)
   {
-    index_t point_index = (*indices_)[i_point];
-    double source_weight = 0.0;
-    double sink_weight = 0.0;
-    calculateUnaryPotential (point_index, source_weight, sink_weight);
-    addEdge (static_cast<int> (source_), point_index, source_weight);
-    addEdge (point_index, static_cast<int> (sink_), sink_weight);
+    Indices point_neighbours;
+    std::vector<float> distances;
+    search_->nearestKSearch (i_point, number_of_neighbours, point_neighbours, distances);
+    std::copy (point_neighbours.begin (), point_neighbours.end (), neighbours.begin () + static_cast<std::size_t> (i_point) * number_of_neighbours);
   }
 
-  std::vector<int> neighbours;
-  std::vector<float> distances;
-  search_->setInputCloud (input_, indices_);
-  for (std::size_t i_point = 0; i_point < number_of_indices; i_point++)
+  // Every pair of neighbours gets a single edge, with the same capacity in both directions. A pair found from
+  // both of its points is only added from the first one.
+  graph_.clear ();
+  graph_.reserve (number_of_indices, static_cast<std::size_t> (number_of_indices) * number_of_neighbours);
+  graph_.addNodes (number_of_indices);
+  edge_points_.clear ();
+  for (int i_point = 0; i_point < number_of_indices; i_point++)
   {
-    index_t point_index = (*indices_)[i_point];
-    search_->nearestKSearch (i_point, number_of_neighbours_, neighbours, distances);
-    for (std::size_t i_nghbr = 1; i_nghbr < neighbours.size (); i_nghbr++)
+    const auto point_neighbours = neighbours.cbegin () + static_cast<std::size_t> (i_point) * number_of_neighbours;
+    for (int i_nghbr = 1; i_nghbr < number_of_neighbours; i_nghbr++)
     {
-      double weight = calculateBinaryPotential (point_index, neighbours[i_nghbr]);
-      addEdge (point_index, neighbours[i_nghbr], weight);
-      addEdge (neighbours[i_nghbr], point_index, weight);
+      const index_t neighbour = point_neighbours[i_nghbr];
+      if (neighbour == UNAVAILABLE)
+        break;
+      const int neighbour_node = point_nodes[neighbour];
+      if (neighbour_node == i_point)
+        continue;
+      if (neighbour_node < i_point)
+      {
+        const auto neighbour_neighbours = neighbours.cbegin () + static_cast<std::size_t> (neighbour_node) * number_of_neighbours;
+        if (std::find (neighbour_neighbours + 1, neighbour_neighbours + number_of_neighbours, (*indices_)[i_point]) != neighbour_neighbours + number_of_neighbours)
+          continue;
+      }
+      graph_.addEdge (i_point, neighbour_node, 0.0, 0.0);
+      edge_points_.emplace_back ((*indices_)[i_point], neighbour);
     }
-    neighbours.clear ();
-    distances.clear ();
   }
 
-  return (true);
+  return (recalculateUnaryPotentials () && recalculateBinaryPotentials ());
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -423,24 +492,17 @@ pcl::MinCutSegmentation<PointT>::calculateUnaryPotential (int point, double& sou
 template <typename PointT> bool
 pcl::MinCutSegmentation<PointT>::addEdge (int source, int target, double weight)
 {
-  std::set<int>::iterator iter_out = edge_marker_[source].find (target);
-  if ( iter_out != edge_marker_[source].end () )
+  // The nodes of the graph are the positions of the points in indices_
+  const auto source_iter = std::find (indices_->cbegin (), indices_->cend (), source);
+  const auto target_iter = std::find (indices_->cbegin (), indices_->cend (), target);
+  if (source_iter == indices_->cend () || target_iter == indices_->cend () || graph_.getNumberOfNodes () != indices_->size ())
     return (false);
-
-  EdgeDescriptor edge;
-  EdgeDescriptor reverse_edge;
-  bool edge_was_added, reverse_edge_was_added;
-
-  boost::tie (edge, edge_was_added) = boost::add_edge ( vertices_[source], vertices_[target], *graph_ );
-  boost::tie (reverse_edge, reverse_edge_was_added) = boost::add_edge ( vertices_[target], vertices_[source], *graph_ );
-  if ( !edge_was_added || !reverse_edge_was_added )
+  const std::pair<index_t, index_t> edge (source, target);
+  if (std::find (edge_points_.cbegin (), edge_points_.cend (), edge) != edge_points_.cend ())
     return (false);
 
-  (*capacity_)[edge] = weight;
-  (*capacity_)[reverse_edge] = 0.0;
-  (*reverse_edges_)[edge] = reverse_edge;
-  (*reverse_edges_)[reverse_edge] = edge;
-  edge_marker_[source].insert (target);
+  graph_.addEdge (static_cast<int> (source_iter - indices_->cbegin ()), static_cast<int> (target_iter - indices_->cbegin ()), weight, 0.0);
+  edge_points_.push_back (edge);
 
   return (true);
 }
@@ -464,22 +526,20 @@ pcl::MinCutSegmentation<PointT>::calculateBinaryPotential (int source, int targe
 template <typename PointT> bool
 pcl::MinCutSegmentation<PointT>::recalculateUnaryPotentials ()
 {
-  OutEdgeIterator src_edge_iter;
-  OutEdgeIterator src_edge_end;
-  std::pair<EdgeDescriptor, bool> sink_edge;
+  int number_of_indices = static_cast<int> (indices_->size ());
+  if (static_cast<int> (graph_.getNumberOfNodes ()) != number_of_indices)
+    return (false);
 
-  for (boost::tie (src_edge_iter, src_edge_end) = boost::out_edges (source_, *graph_); src_edge_iter != src_edge_end; src_edge_iter++)
+#pragma omp parallel for \
+  default(none) \
+  shared(number_of_indices) \
+  num_threads(threads_)
+  for (int i_point = 0; i_point < number_of_indices; i_point++)
   {
     double source_weight = 0.0;
     double sink_weight = 0.0;
-    sink_edge.second = false;
-    calculateUnaryPotential (static_cast<int> (boost::target (*src_edge_iter, *graph_)), source_weight, sink_weight);
-    sink_edge = boost::lookup_edge (boost::target (*src_edge_iter, *graph_), sink_, *graph_);
-    if (!sink_edge.second)
-      return (false);
-
-    (*capacity_)[*src_edge_iter] = source_weight;
-    (*capacity_)[sink_edge.first] = sink_weight;
+    calculateUnaryPotential ((*indices_)[i_point], source_weight, sink_weight);
+    graph_.setTerminalWeights (i_point, source_weight, sink_weight);
   }
 
   return (true);
@@ -489,42 +549,18 @@ pcl::MinCutSegmentation<PointT>::recalculateUnaryPotentials ()
 template <typename PointT> bool
 pcl::MinCutSegmentation<PointT>::recalculateBinaryPotentials ()
 {
-  VertexIterator vertex_iter;
-  VertexIterator vertex_end;
-  OutEdgeIterator edge_iter;
-  OutEdgeIterator edge_end;
-
-  std::vector< std::set<VertexDescriptor> > edge_marker;
-  std::set<VertexDescriptor> out_edges_marker;
-  edge_marker.clear ();
-  edge_marker.resize (indices_->size () + 2, out_edges_marker);
+  int number_of_edges = static_cast<int> (edge_points_.size ());
+  if (static_cast<int> (graph_.getNumberOfEdges ()) != number_of_edges)
+    return (false);
 
-  for (boost::tie (vertex_iter, vertex_end) = boost::vertices (*graph_); vertex_iter != vertex_end; vertex_iter++)
+#pragma omp parallel for \
+  default(none) \
+  shared(number_of_edges) \
+  num_threads(threads_)
+  for (int i_edge = 0; i_edge < number_of_edges; i_edge++)
   {
-    VertexDescriptor source_vertex = *vertex_iter;
-    if (source_vertex == source_ || source_vertex == sink_)
-      continue;
-    for (boost::tie (edge_iter, edge_end) = boost::out_edges (source_vertex, *graph_); edge_iter != edge_end; edge_iter++)
-    {
-      //If this is not the edge of the graph, but the reverse fictitious edge that is needed for the algorithm then continue
-      EdgeDescriptor reverse_edge = (*reverse_edges_)[*edge_iter];
-      if ((*capacity_)[reverse_edge] != 0.0)
-        continue;
-
-      //If we already changed weight for this edge then continue
-      VertexDescriptor target_vertex = boost::target (*edge_iter, *graph_);
-      std::set<VertexDescriptor>::iterator iter_out = edge_marker[static_cast<int> (source_vertex)].find (target_vertex);
-      if ( iter_out != edge_marker[static_cast<int> (source_vertex)].end () )
-        continue;
-
-      if (target_vertex != source_ && target_vertex != sink_)
-      {
-        //Change weight and remember that this edges were updated
-        double weight = calculateBinaryPotential (static_cast<int> (target_vertex), static_cast<int> (source_vertex));
-        (*capacity_)[*edge_iter] = weight;
-        edge_marker[static_cast<int> (source_vertex)].insert (target_vertex);
-      }
-    }
+    double weight = calculateBinaryPotential (edge_points_[i_edge].first, edge_points_[i_edge].second);
+    graph_.setEdgeCapacities (i_edge, weight, weight);
   }
 
   return (true);
@@ -532,32 +568,30 @@ pcl::MinCutSegmentation<PointT>::recalculateBinaryPotentials ()
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
-pcl::MinCutSegmentation<PointT>::assembleLabels (ResidualCapacityMap& residual_capacity)
+pcl::MinCutSegmentation<PointT>::assembleLabels ()
 {
-  std::vector<int> labels;
-  labels.resize (input_->size (), 0);
-  int number_of_indices = static_cast<int> (indices_->size ());
-  for (int i_point = 0; i_point < number_of_indices; i_point++)
-    labels[(*indices_)[i_point]] = 1;
-
   clusters_.clear ();
 
   pcl::PointIndices segment;
   clusters_.resize (2, segment);
 
-  OutEdgeIterator edge_iter, edge_end;
-  for ( boost::tie (edge_iter, edge_end) = boost::out_edges (source_, *graph_); edge_iter != edge_end; edge_iter++ )
+  const int number_of_indices = static_cast<int> (indices_->size ());
+  for (int i_point = 0; i_point < number_of_indices; i_point++)
   {
-    if (labels[edge_iter->m_target] == 1)
-    {
-      if (residual_capacity[*edge_iter] > epsilon_)
-        clusters_[1].indices.push_back (static_cast<int> (edge_iter->m_target));
-      else
-        clusters_[0].indices.push_back (static_cast<int> (edge_iter->m_target));
-    }
+    if (graph_.getSourceResidualCapacity (i_point) > epsilon_)
+      clusters_[1].indices.push_back ((*indices_)[i_point]);
+    else
+      clusters_[0].indices.push_back ((*indices_)[i_point]);
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::MinCutSegmentation<PointT>::assembleLabels (ResidualCapacityMap&)
+{
+  assembleLabels ();
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> pcl::PointCloud<pcl::PointXYZRGB>::Ptr
 pcl::MinCutSegmentation<PointT>::getColoredCloud ()
@@ -42,6 +42,10 @@
 
 #include <pcl/segmentation/organized_connected_component_segmentation.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 /**
  *  Directions: 1 2 3
  *              0 x 4
@@ -115,96 +119,141 @@ pcl::OrganizedConnectedComponentSegmentation<PointT, PointLT>::findLabeledRegion
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointT, typename PointLT> void
-pcl::OrganizedConnectedComponentSegmentation<PointT, PointLT>::segment (pcl::PointCloud<PointLT>& labels, std::vector<pcl::PointIndices>& label_indices) const
+pcl::OrganizedConnectedComponentSegmentation<PointT, PointLT>::setNumberOfThreads (unsigned int nr_threads)
 {
-  std::vector<unsigned> run_ids;
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    threads_ = omp_get_num_procs();
+#else
+    threads_ = 1;
+#endif
+  else
+    threads_ = nr_threads;
+}
 
-  unsigned invalid_label = std::numeric_limits<unsigned>::max ();
-  PointLT invalid_pt;
-  invalid_pt.label = std::numeric_limits<unsigned>::max ();
-  labels.resize (input_->size (), invalid_pt);
-  labels.width = input_->width;
-  labels.height = input_->height;
-  std::size_t clust_id = 0;
-  
-  //First pixel
-  if (std::isfinite ((*input_)[0].x))
-  {
-    labels[0].label = clust_id++;
-    run_ids.push_back (labels[0].label );
-  }   
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename PointLT> void
+pcl::OrganizedConnectedComponentSegmentation<PointT, PointLT>::labelRows (unsigned row_begin, unsigned row_end, pcl::PointCloud<PointLT>& labels, std::vector<unsigned>& runs) const
+{
+  const unsigned invalid_label = std::numeric_limits<unsigned>::max ();
+  const int width = static_cast<int> (input_->width);
 
-  // First row
-  for (int colIdx = 1; colIdx < static_cast<int> (input_->width); ++colIdx)
-  {
-    if (!std::isfinite ((*input_)[colIdx].x))
-      continue;
-    if (compare_->compare (colIdx, colIdx - 1 ))
-    {
-      labels[colIdx].label = labels[colIdx - 1].label;
-    }
-    else
-    {
-      labels[colIdx].label = clust_id++;
-      run_ids.push_back (labels[colIdx].label );
-    }
-  }
-  
-  // Everything else
-  unsigned int current_row = input_->width;
-  unsigned int previous_row = 0;
-  for (std::size_t rowIdx = 1; rowIdx < input_->height; ++rowIdx, previous_row = current_row, current_row += input_->width)
+  runs.clear ();
+  unsigned int current_row = row_begin * width;
+  unsigned int previous_row = current_row - width;
+  for (unsigned rowIdx = row_begin; rowIdx < row_end; ++rowIdx, previous_row = current_row, current_row += width)
   {
-    // First pixel
-    if (std::isfinite ((*input_)[current_row].x))
+    for (int colIdx = 0; colIdx < width; ++colIdx)
     {
-      if (compare_->compare (current_row, previous_row))
+      unsigned& label = labels[current_row + colIdx].label;
+      label = invalid_label;
+      if (!std::isfinite ((*input_)[current_row + colIdx].x))
+        continue;
+
+      if (colIdx > 0 && compare_->compare (current_row + colIdx, current_row + colIdx - 1))
+        label = labels[current_row + colIdx - 1].label;
+
+      if (rowIdx > row_begin && compare_->compare (current_row + colIdx, previous_row + colIdx))
       {
-        labels[current_row].label = labels[previous_row].label;
+        if (label == invalid_label)
+          label = labels[previous_row + colIdx].label;
+        else if (labels[previous_row + colIdx].label != invalid_label)
+        {
+          unsigned root1 = findRoot (runs, label);
+          unsigned root2 = findRoot (runs, labels[previous_row + colIdx].label);
+
+          if (root1 < root2)
+            runs[root2] = root1;
+          else
+            runs[root1] = root2;
+        }
       }
-      else
+
+      if (label == invalid_label)
       {
-        labels[current_row].label = clust_id++;
-        run_ids.push_back (labels[current_row].label);
+        label = static_cast<unsigned> (runs.size ());
+        runs.push_back (label);
       }
     }
-    
-    // Rest of row
-    for (int colIdx = 1; colIdx < static_cast<int> (input_->width); ++colIdx)
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename PointLT> void
+pcl::OrganizedConnectedComponentSegmentation<PointT, PointLT>::segment (pcl::PointCloud<PointLT>& labels, std::vector<pcl::PointIndices>& label_indices) const
+{
+  unsigned invalid_label = std::numeric_limits<unsigned>::max ();
+  labels.resize (input_->size ());
+  labels.width = input_->width;
+  labels.height = input_->height;
+  if (input_->empty ())
+  {
+    label_indices.resize (1);
+    label_indices[0].indices.clear ();
+    return;
+  }
+
+  // Label horizontal strips of the image independently. The runs are numbered in the order of the rows, so that a
+  // region is numbered by its first pixel whatever the number of strips.
+  int nr_strips = static_cast<int> (std::max (1u, std::min (threads_, input_->height)));
+  std::vector<std::vector<unsigned> > strip_runs (nr_strips);
+  std::vector<unsigned> strip_rows (nr_strips + 1);
+  for (int strip = 0; strip <= nr_strips; ++strip)
+    strip_rows[strip] = static_cast<unsigned> (static_cast<std::size_t> (input_->height) * strip / nr_strips);
+
+#pragma omp parallel for \
+  default(none) \
+  shared(labels, nr_strips, strip_rows, strip_runs) \
+  schedule(static, 1) \
+  num_threads(threads_)
+  for (int strip = 0; strip < nr_strips; ++strip)
+    labelRows (strip_rows[strip], strip_rows[strip + 1], labels, strip_runs[strip]);
+
+  std::vector<unsigned> strip_offsets (nr_strips + 1, 0);
+  for (int strip = 0; strip < nr_strips; ++strip)
+    strip_offsets[strip + 1] = strip_offsets[strip] + static_cast<unsigned> (strip_runs[strip].size ());
+
+  std::vector<unsigned> run_ids (strip_offsets[nr_strips]);
+  unsigned width = input_->width;
+#pragma omp parallel for \
+  default(none) \
+  shared(labels, nr_strips, strip_rows, strip_runs, strip_offsets, run_ids, width, invalid_label) \
+  schedule(static, 1) \
+  num_threads(threads_)
+  for (int strip = 0; strip < nr_strips; ++strip)
+  {
+    const unsigned offset = strip_offsets[strip];
+    for (std::size_t runIdx = 0; runIdx < strip_runs[strip].size (); ++runIdx)
+      run_ids[offset + runIdx] = strip_runs[strip][runIdx] + offset;
+    if (offset != 0)
+      for (std::size_t idx = strip_rows[strip] * width; idx < strip_rows[strip + 1] * width; ++idx)
+        if (labels[idx].label != invalid_label)
+          labels[idx].label += offset;
+  }
+
+  // Merge the regions that cross the first row of every strip
+  for (int strip = 1; strip < nr_strips; ++strip)
+  {
+    const unsigned current_row = strip_rows[strip] * width;
+    const unsigned previous_row = current_row - width;
+    for (unsigned colIdx = 0; colIdx < width; ++colIdx)
     {
-      if (std::isfinite ((*input_)[current_row + colIdx].x))
+      if (labels[current_row + colIdx].label == invalid_label || labels[previous_row + colIdx].label == invalid_label)
+        continue;
+      if (compare_->compare (current_row + colIdx, previous_row + colIdx))
       {
-        if (compare_->compare (current_row + colIdx, current_row + colIdx - 1))
-        {
-          labels[current_row + colIdx].label = labels[current_row + colIdx - 1].label;
-        }
-        if (compare_->compare (current_row + colIdx, previous_row + colIdx) )
-        {
-          if (labels[current_row + colIdx].label == invalid_label)
-            labels[current_row + colIdx].label = labels[previous_row + colIdx].label;
-          else if (labels[previous_row + colIdx].label != invalid_label)
-          {
-            unsigned root1 = findRoot (run_ids, labels[current_row + colIdx].label);
-            unsigned root2 = findRoot (run_ids, labels[previous_row + colIdx].label);
-            
-            if (root1 < root2)
-              run_ids[root2] = root1;
-            else
-              run_ids[root1] = root2;
-          }
-        }
-        
-        if (labels[current_row + colIdx].label == invalid_label)
-        {
-          labels[current_row + colIdx].label = clust_id++;
-          run_ids.push_back (labels[current_row + colIdx].label);
-        }
-        
+        unsigned root1 = findRoot (run_ids, labels[current_row + colIdx].label);
+        unsigned root2 = findRoot (run_ids, labels[previous_row + colIdx].label);
+
+        if (root1 < root2)
+          run_ids[root2] = root1;
+        else
+          run_ids[root1] = root2;
       }
     }
   }
-  
-  std::vector<unsigned> map (clust_id);
+
+  std::vector<unsigned> map (run_ids.size ());
   std::size_t max_id = 0;
   for (std::size_t runIdx = 0; runIdx < run_ids.size (); ++runIdx)
   {
@@ -215,14 +264,26 @@ pcl::OrganizedConnectedComponentSegmentation<PointT, PointLT>::segment (pcl::Poi
       map [runIdx] = map [findRoot (run_ids, runIdx)];
   }
 
+  int nr_points = static_cast<int> (input_->size ());
+#pragma omp parallel for \
+  default(none) \
+  shared(labels, map, nr_points, invalid_label) \
+  schedule(static) \
+  num_threads(threads_)
+  for (int idx = 0; idx < nr_points; idx++)
+  {
+    if (labels[idx].label != invalid_label)
+      labels[idx].label = map[labels[idx].label];
+  }
+
+  // Keep the memory of the index vectors from one call to the next
   label_indices.resize (max_id + 1);
+  for (auto &label_index : label_indices)
+    label_index.indices.clear ();
   for (std::size_t idx = 0; idx < input_->size (); idx++)
   {
     if (labels[idx].label != invalid_label)
-    {
-      labels[idx].label = map[labels[idx].label];
       label_indices[labels[idx].label].indices.push_back (idx);
-    }
   }
 }
 
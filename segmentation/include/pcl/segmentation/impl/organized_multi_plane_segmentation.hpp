@@ -45,6 +45,10 @@
 #include <pcl/common/centroid.h>
 #include <pcl/common/eigen.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> pcl::PointCloud<PointT>
 projectToPlaneFromViewpoint (pcl::PointCloud<PointT>& cloud, Eigen::Vector4f& normal, Eigen::Vector3f& centroid, Eigen::Vector3f& vp)
@@ -66,6 +70,20 @@ projectToPlaneFromViewpoint (pcl::PointCloud<PointT>& cloud, Eigen::Vector4f& no
   return (projected_cloud);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename PointNT, typename PointLT> void
+pcl::OrganizedMultiPlaneSegmentation<PointT, PointNT, PointLT>::setNumberOfThreads (unsigned int nr_threads)
+{
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    threads_ = omp_get_num_procs();
+#else
+    threads_ = 1;
+#endif
+  else
+    threads_ = nr_threads;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointT, typename PointNT, typename PointLT> void
 pcl::OrganizedMultiPlaneSegmentation<PointT, PointNT, PointLT>::segment (std::vector<ModelCoefficients>& model_coefficients, 
@@ -117,14 +135,21 @@ pcl::OrganizedMultiPlaneSegmentation<PointT, PointNT, PointLT>::segment (std::ve
   }
 
   // Calculate range part of planes' hessian normal form
-  std::vector<float> plane_d (input_->size ());
-  
-  for (std::size_t i = 0; i < input_->size (); ++i)
+  std::vector<float> &plane_d = *plane_d_;
+  plane_d.resize (input_->size ());
+  int nr_points = static_cast<int> (input_->size ());
+
+#pragma omp parallel for \
+  default(none) \
+  shared(plane_d, nr_points) \
+  schedule(static) \
+  num_threads(threads_)
+  for (int i = 0; i < nr_points; ++i)
     plane_d[i] = (*input_)[i].getVector3fMap ().dot ((*normals_)[i].getNormalVector3fMap ());
   
   // Make a comparator
   //PlaneCoefficientComparator<PointT,PointNT> plane_comparator (plane_d);
-  compare_->setPlaneCoeffD (plane_d);
+  compare_->setPlaneCoeffD (plane_d_);
   compare_->setInputCloud (input_);
   compare_->setInputNormals (normals_);
   compare_->setAngularThreshold (static_cast<float> (angular_threshold_));
@@ -133,59 +158,80 @@ pcl::OrganizedMultiPlaneSegmentation<PointT, PointNT, PointLT>::segment (std::ve
   // Set up the output
   OrganizedConnectedComponentSegmentation<PointT,PointLT> connected_component (compare_);
   connected_component.setInputCloud (input_);
+  connected_component.setNumberOfThreads (threads_);
   connected_component.segment (labels, label_indices);
 
-  Eigen::Vector4f clust_centroid = Eigen::Vector4f::Zero ();
+  // Compute the moments of the large enough clusters in parallel, the planes are collected in the order of the labels
+  std::vector<int> clusters;
+  for (std::size_t i = 0; i < label_indices.size (); ++i)
+    if (static_cast<unsigned> (label_indices[i].indices.size ()) > min_inliers_)
+      clusters.push_back (static_cast<int> (i));
+  int nr_clusters = static_cast<int> (clusters.size ());
+  std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f> > clust_centroids (nr_clusters, Eigen::Vector4f::Zero ());
+  std::vector<Eigen::Matrix3f, Eigen::aligned_allocator<Eigen::Matrix3f> > clust_covs (nr_clusters);
+
+#pragma omp parallel for \
+  default(none) \
+  shared(label_indices, clusters, nr_clusters, clust_centroids, clust_covs) \
+  schedule(dynamic) \
+  num_threads(threads_)
+  for (int i = 0; i < nr_clusters; ++i)
+    pcl::computeMeanAndCovarianceMatrix (*input_, label_indices[clusters[i]].indices, clust_covs[i], clust_centroids[i]);
+
+  // The output vectors may be reused from a previous frame
+  model_coefficients.clear ();
+  inlier_indices.clear ();
+  centroids.clear ();
+  covariances.clear ();
+
   Eigen::Vector4f vp = Eigen::Vector4f::Zero ();
-  Eigen::Matrix3f clust_cov;
   pcl::ModelCoefficients model;
   model.values.resize (4);
 
   // Fit Planes to each cluster
-  for (const auto &label_index : label_indices)
+  for (int i = 0; i < nr_clusters; ++i)
   {
-    if (static_cast<unsigned> (label_index.indices.size ()) > min_inliers_)
+    const auto &label_index = label_indices[clusters[i]];
+    const Eigen::Vector4f &clust_centroid = clust_centroids[i];
+    const Eigen::Matrix3f &clust_cov = clust_covs[i];
+    Eigen::Vector4f plane_params;
+    
+    EIGEN_ALIGN16 Eigen::Vector3f::Scalar eigen_value;
+    EIGEN_ALIGN16 Eigen::Vector3f eigen_vector;
+    pcl::eigen33 (clust_cov, eigen_value, eigen_vector);
+    plane_params[0] = eigen_vector[0];
+    plane_params[1] = eigen_vector[1];
+    plane_params[2] = eigen_vector[2];
+    plane_params[3] = 0;
+    plane_params[3] = -1 * plane_params.dot (clust_centroid);
+
+    vp -= clust_centroid;
+    float cos_theta = vp.dot (plane_params);
+    if (cos_theta < 0)
     {
-      pcl::computeMeanAndCovarianceMatrix (*input_, label_index.indices, clust_cov, clust_centroid);
-      Eigen::Vector4f plane_params;
-      
-      EIGEN_ALIGN16 Eigen::Vector3f::Scalar eigen_value;
-      EIGEN_ALIGN16 Eigen::Vector3f eigen_vector;
-      pcl::eigen33 (clust_cov, eigen_value, eigen_vector);
-      plane_params[0] = eigen_vector[0];
-      plane_params[1] = eigen_vector[1];
-      plane_params[2] = eigen_vector[2];
+      plane_params *= -1;
       plane_params[3] = 0;
       plane_params[3] = -1 * plane_params.dot (clust_centroid);
-
-      vp -= clust_centroid;
-      float cos_theta = vp.dot (plane_params);
-      if (cos_theta < 0)
-      {
-        plane_params *= -1;
-        plane_params[3] = 0;
-        plane_params[3] = -1 * plane_params.dot (clust_centroid);
-      }
-      
-      // Compute the curvature surface change
-      float curvature;
-      float eig_sum = clust_cov.coeff (0) + clust_cov.coeff (4) + clust_cov.coeff (8);
-      if (eig_sum != 0)
-        curvature = std::abs (eigen_value / eig_sum);
-      else
-        curvature = 0;
-
-      if (curvature < maximum_curvature_)
-      {
-        model.values[0] = plane_params[0];
-        model.values[1] = plane_params[1];
-        model.values[2] = plane_params[2];
-        model.values[3] = plane_params[3];
-        model_coefficients.push_back (model);
-        inlier_indices.push_back (label_index);
-        centroids.push_back (clust_centroid);
-        covariances.push_back (clust_cov);
-      }
+    }
+    
+    // Compute the curvature surface change
+    float curvature;
+    float eig_sum = clust_cov.coeff (0) + clust_cov.coeff (4) + clust_cov.coeff (8);
+    if (eig_sum != 0)
+      curvature = std::abs (eigen_value / eig_sum);
+    else
+      curvature = 0;
+
+    if (curvature < maximum_curvature_)
+    {
+      model.values[0] = plane_params[0];
+      model.values[1] = plane_params[1];
+      model.values[2] = plane_params[2];
+      model.values[3] = plane_params[3];
+      model_coefficients.push_back (model);
+      inlier_indices.push_back (label_index);
+      centroids.push_back (clust_centroid);
+      covariances.push_back (clust_cov);
     }
   }
   deinitCompute ();
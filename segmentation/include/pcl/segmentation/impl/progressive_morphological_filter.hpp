@@ -41,11 +41,14 @@
 
 #include <pcl/common/common.h>
 #include <pcl/common/io.h>
+#include <pcl/common/point_tests.h>
 #include <pcl/filters/morphological_filter.h>
 #include <pcl/segmentation/progressive_morphological_filter.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
+#include <algorithm>
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT>
 pcl::ProgressiveMorphologicalFilter<PointT>::ProgressiveMorphologicalFilter () :
@@ -55,7 +58,9 @@ pcl::ProgressiveMorphologicalFilter<PointT>::ProgressiveMorphologicalFilter () :
   initial_distance_ (0.15f),
   cell_size_ (1.0f),
   base_ (2.0f),
-  exponential_ (true)
+  exponential_ (true),
+  use_grid_ (false),
+  threads_ (0)
 {
 }
 
@@ -111,6 +116,13 @@ pcl::ProgressiveMorphologicalFilter<PointT>::extract (Indices& ground)
   // wish to process
   ground = *indices_;
 
+  if (use_grid_)
+  {
+    extractOnGrid (window_sizes, height_thresholds, ground);
+    deinitCompute ();
+    return;
+  }
+
   // Progressively filter ground returns using morphological open
   for (std::size_t i = 0; i < window_sizes.size (); ++i)
   {
@@ -145,6 +157,85 @@ pcl::ProgressiveMorphologicalFilter<PointT>::extract (Indices& ground)
   deinitCompute ();
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ProgressiveMorphologicalFilter<PointT>::extractOnGrid (const std::vector<float>& window_sizes,
+                                                             const std::vector<float>& height_thresholds,
+                                                             Indices& ground)
+{
+  // non finite points have no cell, they are dropped like in the per point path
+  if (!input_->is_dense)
+  {
+    ground.erase (std::remove_if (ground.begin (), ground.end (),
+                                  [this] (index_t idx) { return (!pcl::isFinite ((*input_)[idx])); }),
+                  ground.end ());
+  }
+  if (ground.empty ())
+    return;
+
+  // setup grid based on scale and extents of the points to process
+  Eigen::Vector4f global_max, global_min;
+  pcl::getMinMax3D<PointT> (*input_, ground, global_min, global_max);
+
+  int rows = static_cast<int> (std::floor ((global_max.y () - global_min.y ()) / cell_size_) + 1);
+  int cols = static_cast<int> (std::floor ((global_max.x () - global_min.x ()) / cell_size_) + 1);
+
+  // Cell of every point to process, in the order of ground
+  int num_points = static_cast<int> (ground.size ());
+  std::vector<int> point_cells (num_points);
+#pragma omp parallel for \
+  default(none) \
+  shared(global_min, ground, num_points, point_cells, rows) \
+  num_threads(threads_)
+  for (int i = 0; i < num_points; ++i)
+  {
+    const PointT& p = (*input_)[ground[i]];
+    int row = static_cast<int> (std::floor ((p.y - global_min.y ()) / cell_size_));
+    int col = static_cast<int> (std::floor ((p.x - global_min.x ()) / cell_size_));
+    point_cells[i] = col * rows + row;
+  }
+
+  Eigen::MatrixXf A (rows, cols), Zf (rows, cols);
+  for (std::size_t i = 0; i < window_sizes.size (); ++i)
+  {
+    int half_size = static_cast<int> (std::round ((window_sizes[i] / cell_size_ - 1.0f) / 2.0f));
+    PCL_DEBUG ("      Iteration %d (height threshold = %f, window size = %f, half size = %d)...",
+               i, height_thresholds[i], window_sizes[i], half_size);
+
+    // Minimum elevation of the current ground points in every cell
+    A.setConstant (std::numeric_limits<float>::quiet_NaN ());
+    for (std::size_t p_idx = 0; p_idx < ground.size (); ++p_idx)
+    {
+      float& cell = A.data ()[point_cells[p_idx]];
+      if ((*input_)[ground[p_idx]].z < cell || std::isnan (cell))
+        cell = (*input_)[ground[p_idx]].z;
+    }
+
+    // Apply the morphological opening operation at the current window size.
+    pcl::applyMorphologicalOperator (A, half_size, MORPH_OPEN, Zf, threads_);
+
+    // Keep the points whose difference to the opened surface is less than the
+    // current height threshold, along with their cells.
+    Indices pt_indices;
+    std::vector<int> pt_cells;
+    for (std::size_t p_idx = 0; p_idx < ground.size (); ++p_idx)
+    {
+      float diff = (*input_)[ground[p_idx]].z - Zf.data ()[point_cells[p_idx]];
+      if (diff < height_thresholds[i])
+      {
+        pt_indices.push_back (ground[p_idx]);
+        pt_cells.push_back (point_cells[p_idx]);
+      }
+    }
+
+    // Ground is now limited to pt_indices
+    ground.swap (pt_indices);
+    point_cells.swap (pt_cells);
+
+    PCL_DEBUG ("ground now has %d points\n", ground.size ());
+  }
+}
+
 #define PCL_INSTANTIATE_ProgressiveMorphologicalFilter(T) template class pcl::ProgressiveMorphologicalFilter<T>;
 
 #endif    // PCL_SEGMENTATION_PROGRESSIVE_MORPHOLOGICAL_FILTER_HPP_
@@ -38,9 +38,13 @@
 #ifndef PCL_SEGMENTATION_IMPL_RANDOM_WALKER_HPP
 #define PCL_SEGMENTATION_IMPL_RANDOM_WALKER_HPP
 
+#include <cmath>
+#include <limits>
+
 #include <boost/bimap.hpp>
 
 #include <Eigen/Sparse>
+#include <Eigen/IterativeLinearSolvers>
 
 namespace pcl
 {
@@ -88,6 +92,7 @@ namespace pcl
           , index_map_ (boost::get (boost::vertex_index, g_))
           , degree_storage_ (boost::num_vertices (g_), 0)
           , degree_map_ (boost::make_iterator_property_map (degree_storage_.begin (), index_map_))
+          , vertex_to_row_ (boost::num_vertices (g_), -1)
           {
           }
 
@@ -135,7 +140,9 @@ namespace pcl
               if (color_map_[*vi] || std::fabs (degree_map_[*vi]) < std::numeric_limits<Weight>::epsilon ())
                 continue;
               // Create a row in L matrix for the vertex
-              std::size_t current_row = insertInBimap (L_vertex_bimap, *vi);
+              std::size_t current_row = row_to_vertex_.size ();
+              row_to_vertex_.push_back (*vi);
+              vertex_to_row_[index_map_[*vi]] = static_cast<std::ptrdiff_t> (current_row);
               // Add diagonal degree entry for the vertex
               L_triplets.push_back (T (current_row, current_row, degree_map_[*vi]));
               // Iterate over incident vertices and add entries on corresponding columns of L or B
@@ -164,15 +171,16 @@ namespace pcl
                 {
                   // This is a non-seed and will go to L matrix,
                   // but only if a row for this vertex already exists
-                  if (L_vertex_bimap.right.count (tgt) && L_vertex_bimap.right.at (tgt) != current_row)
+                  const std::ptrdiff_t tgt_row = vertex_to_row_[index_map_[tgt]];
+                  if (tgt_row >= 0 && static_cast<std::size_t> (tgt_row) != current_row)
                   {
-                    L_triplets.push_back (T (current_row, L_vertex_bimap.right.at (tgt), -w));
+                    L_triplets.push_back (T (current_row, tgt_row, -w));
                   }
                 }
               }
             }
 
-            std::size_t num_equations = L_vertex_bimap.size ();
+            std::size_t num_equations = row_to_vertex_.size ();
             std::size_t num_colors = B_color_bimap.size ();
             L.resize (num_equations, num_equations);
             B.resize (num_equations, num_colors);
@@ -190,16 +198,26 @@ namespace pcl
             if (L.rows () == 0 || B.cols () == 0)
               return true;
 
-            Eigen::SimplicialCholesky<SparseMatrix, Eigen::Lower> cg;
-            cg.compute (L);
-            bool succeeded = true;
-            for (Eigen::Index i = 0; i < B.cols (); ++i)
+            // The system is symmetric positive definite, it is solved with a Jacobi preconditioned conjugate gradient.
+            // Unlike a Cholesky factorization this does not fill in on large (image) graphs, and on a full row major
+            // matrix Eigen runs the matrix-vector products in parallel when OpenMP is enabled (see Eigen::setNbThreads).
+            using RowMajorSparseMatrix = Eigen::SparseMatrix<Weight, Eigen::RowMajor>;
+            RowMajorSparseMatrix A = L.template selfadjointView<Eigen::Lower> ();
+            Eigen::ConjugateGradient<RowMajorSparseMatrix, Eigen::Lower | Eigen::Upper, Eigen::DiagonalPreconditioner<Weight> > cg;
+            cg.setTolerance (std::sqrt (std::numeric_limits<Weight>::epsilon ()) * Weight (0.1));
+            cg.compute (A);
+            bool succeeded = (cg.info () == Eigen::Success);
+            // The potentials of every vertex sum up to one, so the last column follows from the others
+            const Eigen::Index num_solved = B.cols () > 1 ? B.cols () - 1 : B.cols ();
+            for (Eigen::Index i = 0; i < num_solved && succeeded; ++i)
             {
               Vector b = B.col (i);
               X.col (i) = cg.solve (b);
               if (cg.info () != Eigen::Success)
                 succeeded = false;
             }
+            if (num_solved < B.cols ())
+              X.col (num_solved) = Vector::Ones (X.rows ()) - X.leftCols (num_solved).rowwise ().sum ();
 
             assignColors ();
             return succeeded;
@@ -214,7 +232,7 @@ namespace pcl
               {
                 std::size_t max_column;
                 X.row (i).maxCoeff (&max_column);
-                VertexDescriptor vertex = L_vertex_bimap.left.at (i);
+                VertexDescriptor vertex = row_to_vertex_[i];
                 Color color = B_color_bimap.left.at (max_column);
                 color_map_[vertex] = color;
               }
@@ -227,7 +245,7 @@ namespace pcl
             potentials = Matrix::Zero (num_vertices (g_), colors_.size ());
             // Copy over rows from X
             for (Eigen::Index i = 0; i < X.rows (); ++i)
-              potentials.row (L_vertex_bimap.left.at (i)).head (X.cols ()) = X.row (i);
+              potentials.row (row_to_vertex_[i]).head (X.cols ()) = X.row (i);
             // In rows that correspond to seeds put ones in proper columns
             for (std::size_t i = 0; i < seeds_.size (); ++i)
             {
@@ -267,8 +285,9 @@ namespace pcl
           SparseMatrix B;
           Matrix X;
 
-          // Map vertex identifiers to the rows/columns of L and vice versa
-          boost::bimap<std::size_t, VertexDescriptor> L_vertex_bimap;
+          // Map the rows/columns of L to vertex identifiers and vertex indices to the rows/columns of L (-1 if none)
+          std::vector<VertexDescriptor> row_to_vertex_;
+          std::vector<std::ptrdiff_t> vertex_to_row_;
           // Map colors to the columns of B and vice versa
           boost::bimap<std::size_t, Color> B_color_bimap;
 
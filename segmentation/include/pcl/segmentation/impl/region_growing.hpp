@@ -48,10 +48,49 @@
 #include <pcl/search/search.h>
 #include <pcl/search/kdtree.h>
 
+#include <algorithm>
 #include <queue>
 #include <cmath>
 #include <ctime>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Sort a vector with several threads: blocks of it are sorted concurrently, then merged pairwise. */
+    template <typename T> void
+    parallelSort (std::vector<T> &data, unsigned int nr_threads)
+    {
+      const std::size_t min_block_size = 1 << 14;
+      const int nr_blocks = static_cast<int> (std::min<std::size_t> (nr_threads, (data.size () + min_block_size - 1) / min_block_size));
+      if (nr_blocks <= 1)
+      {
+        std::sort (data.begin (), data.end ());
+        return;
+      }
+
+      std::vector<std::size_t> bounds (nr_blocks + 1);
+      for (int b = 0; b <= nr_blocks; ++b)
+        bounds[b] = data.size () * b / nr_blocks;
+#pragma omp parallel for num_threads(nr_threads) schedule(static, 1)
+      for (int b = 0; b < nr_blocks; ++b)
+        std::sort (data.begin () + bounds[b], data.begin () + bounds[b + 1]);
+
+      for (int width = 1; width < nr_blocks; width *= 2)
+      {
+#pragma omp parallel for num_threads(nr_threads) schedule(static, 1)
+        for (int b = 0; b < nr_blocks - width; b += 2 * width)
+          std::inplace_merge (data.begin () + bounds[b], data.begin () + bounds[b + width],
+                              data.begin () + bounds[std::min (b + 2 * width, nr_blocks)]);
+      }
+    }
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename NormalT>
 pcl::RegionGrowing<PointT, NormalT>::RegionGrowing () :
@@ -66,7 +105,10 @@ pcl::RegionGrowing<PointT, NormalT>::RegionGrowing () :
   neighbour_number_ (30),
   search_ (),
   normals_ (),
-  point_neighbours_ (0),
+  store_neighbours_ (true),
+  threads_ (1),
+  point_neighbour_indices_ (0),
+  point_neighbour_offsets_ (0),
   point_labels_ (0),
   normal_flag_ (true),
   num_pts_in_segment_ (0),
@@ -79,7 +121,8 @@ pcl::RegionGrowing<PointT, NormalT>::RegionGrowing () :
 template <typename PointT, typename NormalT>
 pcl::RegionGrowing<PointT, NormalT>::~RegionGrowing ()
 {
-  point_neighbours_.clear ();
+  point_neighbour_indices_.clear ();
+  point_neighbour_offsets_.clear ();
   point_labels_.clear ();
   num_pts_in_segment_.clear ();
   clusters_.clear ();
@@ -217,6 +260,41 @@ pcl::RegionGrowing<PointT, NormalT>::setNumberOfNeighbours (unsigned int neighbo
   neighbour_number_ = neighbour_number;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename NormalT> bool
+pcl::RegionGrowing<PointT, NormalT>::getStoreNeighbours () const
+{
+  return (store_neighbours_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename NormalT> void
+pcl::RegionGrowing<PointT, NormalT>::setStoreNeighbours (bool value)
+{
+  store_neighbours_ = value;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename NormalT> unsigned int
+pcl::RegionGrowing<PointT, NormalT>::getNumberOfThreads () const
+{
+  return (threads_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename NormalT> void
+pcl::RegionGrowing<PointT, NormalT>::setNumberOfThreads (unsigned int nr_threads)
+{
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    threads_ = omp_get_num_procs ();
+#else
+    threads_ = 1;
+#endif
+  else
+    threads_ = nr_threads;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename NormalT> typename pcl::RegionGrowing<PointT, NormalT>::KdTreePtr
 pcl::RegionGrowing<PointT, NormalT>::getSearchMethod () const
@@ -251,7 +329,7 @@ pcl::RegionGrowing<PointT, NormalT>::extract (std::vector <pcl::PointIndices>& c
 {
   clusters_.clear ();
   clusters.clear ();
-  point_neighbours_.clear ();
+  point_neighbour_indices_.clear ();
   point_labels_.clear ();
   num_pts_in_segment_.clear ();
   number_of_segments_ = 0;
@@ -342,35 +420,115 @@ pcl::RegionGrowing<PointT, NormalT>::prepareForSegmentation ()
 template <typename PointT, typename NormalT> void
 pcl::RegionGrowing<PointT, NormalT>::findPointNeighbours ()
 {
-  int point_number = static_cast<int> (indices_->size ());
-  std::vector<int> neighbours;
-  std::vector<float> distances;
+  point_neighbour_indices_.clear ();
+  point_neighbour_offsets_.clear ();
+  if (store_neighbours_)
+    storePointNeighbours (neighbour_number_, nullptr);
+}
 
-  point_neighbours_.resize (input_->size (), neighbours);
-  if (input_->is_dense)
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename NormalT> void
+pcl::RegionGrowing<PointT, NormalT>::storePointNeighbours (unsigned int nr_neighbours, std::vector<float> *distances)
+{
+  const int point_number = static_cast<int> (indices_->size ());
+  const int block_size = 4096;
+  const int nr_blocks = (point_number + block_size - 1) / block_size;
+
+  // A point listed several times in indices_ is only stored once, at its first occurrence, so that no
+  // two threads write the same offset
+  std::vector<bool> is_stored (input_->size (), false);
+  std::vector<bool> is_first (point_number, false);
+  for (int i_point = 0; i_point < point_number; i_point++)
   {
-    for (int i_point = 0; i_point < point_number; i_point++)
+    const index_t point_index = (*indices_)[i_point];
+    is_first[i_point] = !is_stored[point_index];
+    is_stored[point_index] = true;
+  }
+
+  // Search the neighbours of blocks of points concurrently, each block into its own buffer. Meanwhile
+  // point_neighbour_offsets_[i + 1] holds the number of neighbours of the point i.
+  point_neighbour_offsets_.assign (input_->size () + 1, 0);
+  std::vector<Indices> block_neighbours (nr_blocks);
+  std::vector<std::vector<float> > block_distances (nr_blocks);
+#pragma omp parallel num_threads(threads_)
+  {
+    Indices neighbours;
+    std::vector<float> neighbour_distances;
+#pragma omp for schedule(dynamic, 1)
+    for (int i_block = 0; i_block < nr_blocks; i_block++)
     {
-      int point_index = (*indices_)[i_point];
-      neighbours.clear ();
-      search_->nearestKSearch (i_point, neighbour_number_, neighbours, distances);
-      point_neighbours_[point_index].swap (neighbours);
+      const int block_end = std::min (point_number, (i_block + 1) * block_size);
+      for (int i_point = i_block * block_size; i_point < block_end; i_point++)
+      {
+        const index_t point_index = (*indices_)[i_point];
+        if (!is_first[i_point] || (!input_->is_dense && !pcl::isFinite ((*input_)[point_index])))
+          continue;
+        search_->nearestKSearch (i_point, nr_neighbours, neighbours, neighbour_distances);
+        point_neighbour_offsets_[point_index + 1] = neighbours.size ();
+        block_neighbours[i_block].insert (block_neighbours[i_block].end (), neighbours.begin (), neighbours.end ());
+        if (distances)
+          block_distances[i_block].insert (block_distances[i_block].end (), neighbour_distances.begin (), neighbour_distances.end ());
+      }
     }
   }
-  else
+
+  for (std::size_t i_point = 0; i_point < input_->size (); i_point++)
+    point_neighbour_offsets_[i_point + 1] += point_neighbour_offsets_[i_point];
+
+  // Move the buffers to their place in the shared arrays
+  point_neighbour_indices_.resize (point_neighbour_offsets_.back ());
+  if (distances)
+    distances->resize (point_neighbour_offsets_.back ());
+#pragma omp parallel for num_threads(threads_) schedule(dynamic, 1)
+  for (int i_block = 0; i_block < nr_blocks; i_block++)
   {
-    for (int i_point = 0; i_point < point_number; i_point++)
+    std::size_t position = 0;
+    const int block_end = std::min (point_number, (i_block + 1) * block_size);
+    for (int i_point = i_block * block_size; i_point < block_end; i_point++)
     {
-      neighbours.clear ();
-      int point_index = (*indices_)[i_point];
-      if (!pcl::isFinite ((*input_)[point_index]))
+      if (!is_first[i_point])
         continue;
-      search_->nearestKSearch (i_point, neighbour_number_, neighbours, distances);
-      point_neighbours_[point_index].swap (neighbours);
+      const index_t point_index = (*indices_)[i_point];
+      const std::size_t begin = point_neighbour_offsets_[point_index];
+      const std::size_t size = point_neighbour_offsets_[point_index + 1] - begin;
+      std::copy_n (block_neighbours[i_block].begin () + position, size, point_neighbour_indices_.begin () + begin);
+      if (distances)
+        std::copy_n (block_distances[i_block].begin () + position, size, distances->begin () + begin);
+      position += size;
     }
+    Indices ().swap (block_neighbours[i_block]);
+    std::vector<float> ().swap (block_distances[i_block]);
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename NormalT> std::size_t
+pcl::RegionGrowing<PointT, NormalT>::getPointNeighbours (index_t point, const index_t* &neighbours, Indices &buffer, std::vector<float> &distances) const
+{
+  if (store_neighbours_)
+  {
+    neighbours = point_neighbour_indices_.data () + point_neighbour_offsets_[point];
+    return (point_neighbour_offsets_[point + 1] - point_neighbour_offsets_[point]);
+  }
+
+  buffer.clear ();
+  if (input_->is_dense || pcl::isFinite ((*input_)[point]))
+    search_->nearestKSearch ((*input_)[point], neighbour_number_, buffer, distances);
+  neighbours = buffer.data ();
+  return (buffer.size ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename NormalT> pcl::Indices
+pcl::RegionGrowing<PointT, NormalT>::getPointNeighbours (index_t point) const
+{
+  const index_t* neighbours;
+  Indices buffer;
+  std::vector<float> distances;
+  const std::size_t nr_neighbours = getPointNeighbours (point, neighbours, buffer, distances);
+  return (Indices (neighbours, neighbours + nr_neighbours));
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename NormalT> void
 pcl::RegionGrowing<PointT, NormalT>::applySmoothRegionGrowingAlgorithm ()
@@ -384,13 +542,15 @@ pcl::RegionGrowing<PointT, NormalT>::applySmoothRegionGrowingAlgorithm ()
 
   if (normal_flag_ == true)
   {
+#pragma omp parallel for num_threads(threads_) schedule(static)
     for (int i_point = 0; i_point < num_of_pts; i_point++)
     {
       int point_index = (*indices_)[i_point];
       point_residual[i_point].first = (*normals_)[point_index].curvature;
       point_residual[i_point].second = point_index;
     }
-    std::sort (point_residual.begin (), point_residual.end (), comparePair);
+    // Points of equal curvature are ordered by index, so that the seeds do not depend on the number of threads
+    detail::parallelSort (point_residual, threads_);
   }
   else
   {
@@ -438,30 +598,28 @@ pcl::RegionGrowing<PointT, NormalT>::growRegion (int initial_seed, int segment_n
 
   int num_pts_in_segment = 1;
 
+  Indices neighbour_buffer;
+  std::vector<float> distance_buffer;
   while (!seeds.empty ())
   {
     int curr_seed;
     curr_seed = seeds.front ();
     seeds.pop ();
 
-    std::size_t i_nghbr = 0;
-    while ( i_nghbr < neighbour_number_ && i_nghbr < point_neighbours_[curr_seed].size () )
+    const index_t *neighbours = nullptr;
+    const std::size_t number_of_neighbours = std::min<std::size_t> (neighbour_number_,
+        getPointNeighbours (curr_seed, neighbours, neighbour_buffer, distance_buffer));
+    for (std::size_t i_nghbr = 0; i_nghbr < number_of_neighbours; i_nghbr++)
     {
-      int index = point_neighbours_[curr_seed][i_nghbr];
+      int index = neighbours[i_nghbr];
       if (point_labels_[index] != -1)
-      {
-        i_nghbr++;
         continue;
-      }
 
       bool is_a_seed = false;
       bool belongs_to_segment = validatePoint (initial_seed, curr_seed, index, is_a_seed);
 
       if (!belongs_to_segment)
-      {
-        i_nghbr++;
         continue;
-      }
 
       point_labels_[index] = segment_number;
       num_pts_in_segment++;
@@ -470,8 +628,6 @@ pcl::RegionGrowing<PointT, NormalT>::growRegion (int initial_seed, int segment_n
       {
         seeds.push (index);
       }
-
-      i_nghbr++;
     }// next neighbour
   }// next seed
 
@@ -592,7 +748,7 @@ pcl::RegionGrowing<PointT, NormalT>::getSegmentFromPoint (int index, pcl::PointI
   {
     if (clusters_.empty ())
     {
-      point_neighbours_.clear ();
+      point_neighbour_indices_.clear ();
       point_labels_.clear ();
       num_pts_in_segment_.clear ();
       number_of_segments_ = 0;
@@ -40,6 +40,7 @@
 #ifndef PCL_SEGMENTATION_REGION_GROWING_RGB_HPP_
 #define PCL_SEGMENTATION_REGION_GROWING_RGB_HPP_
 
+#include <pcl/common/point_tests.h> // for pcl::isFinite
 #include <pcl/console/print.h> // for PCL_ERROR
 #include <pcl/segmentation/region_growing_rgb.h>
 #include <pcl/search/search.h>
@@ -54,6 +55,7 @@ pcl::RegionGrowingRGB<PointT, NormalT>::RegionGrowingRGB () :
   color_r2r_threshold_ (10.0f),
   distance_threshold_ (0.05f),
   region_neighbour_number_ (100),
+  point_neighbour_distances_ (0),
   point_distances_ (0),
   segment_neighbours_ (0),
   segment_distances_ (0),
@@ -69,6 +71,7 @@ pcl::RegionGrowingRGB<PointT, NormalT>::RegionGrowingRGB () :
 template <typename PointT, typename NormalT>
 pcl::RegionGrowingRGB<PointT, NormalT>::~RegionGrowingRGB ()
 {
+  point_neighbour_distances_.clear ();
   point_distances_.clear ();
   segment_neighbours_.clear ();
   segment_distances_.clear ();
@@ -165,9 +168,10 @@ pcl::RegionGrowingRGB<PointT, NormalT>::extract (std::vector <pcl::PointIndices>
 {
   clusters_.clear ();
   clusters.clear ();
-  point_neighbours_.clear ();
+  point_neighbour_indices_.clear ();
   point_labels_.clear ();
   num_pts_in_segment_.clear ();
+  point_neighbour_distances_.clear ();
   point_distances_.clear ();
   segment_neighbours_.clear ();
   segment_distances_.clear ();
@@ -272,21 +276,21 @@ pcl::RegionGrowingRGB<PointT, NormalT>::prepareForSegmentation ()
 template <typename PointT, typename NormalT> void
 pcl::RegionGrowingRGB<PointT, NormalT>::findPointNeighbours ()
 {
-  int point_number = static_cast<int> (indices_->size ());
-  std::vector<int> neighbours;
-  std::vector<float> distances;
-
-  point_neighbours_.resize (input_->size (), neighbours);
-  point_distances_.resize (input_->size (), distances);
+  point_neighbour_indices_.clear ();
+  point_neighbour_offsets_.clear ();
+  point_neighbour_distances_.clear ();
+  point_distances_.clear ();
 
-  for (int i_point = 0; i_point < point_number; i_point++)
+  // The region merging needs the distances too, growRegion only looks at the first neighbour_number_ neighbours
+  if (store_neighbours_)
   {
-    int point_index = (*indices_)[i_point];
-    neighbours.clear ();
-    distances.clear ();
-    search_->nearestKSearch (i_point, region_neighbour_number_, neighbours, distances);
-    point_neighbours_[point_index].swap (neighbours);
-    point_distances_[point_index].swap (distances);
+    storePointNeighbours (region_neighbour_number_, &point_neighbour_distances_);
+
+    // deprecated per point copy of the distances, kept until point_distances_ is removed
+    point_distances_.resize (input_->size ());
+    for (std::size_t i_point = 0; i_point < input_->size (); i_point++)
+      point_distances_[i_point].assign (point_neighbour_distances_.begin () + point_neighbour_offsets_[i_point],
+                                        point_neighbour_distances_.begin () + point_neighbour_offsets_[i_point + 1]);
   }
 }
 
@@ -317,25 +321,43 @@ pcl::RegionGrowingRGB<PointT, NormalT>::findRegionsKNN (int index, int nghbr_num
   float max_dist = std::numeric_limits<float>::max ();
   distances.resize (clusters_.size (), max_dist);
 
+  Indices neighbour_buffer;
+  std::vector<float> distance_buffer;
   int number_of_points = num_pts_in_segment_[index];
   //loop through every point in this segment and check neighbours
   for (int i_point = 0; i_point < number_of_points; i_point++)
   {
     int point_index = clusters_[index].indices[i_point];
-    int number_of_neighbours = static_cast<int> (point_neighbours_[point_index].size ());
+    const index_t *point_neighbours = nullptr;
+    const float *point_distances = nullptr;
+    std::size_t number_of_neighbours = 0;
+    if (store_neighbours_)
+    {
+      point_neighbours = point_neighbour_indices_.data () + point_neighbour_offsets_[point_index];
+      point_distances = point_neighbour_distances_.data () + point_neighbour_offsets_[point_index];
+      number_of_neighbours = std::min<std::size_t> (region_neighbour_number_,
+          point_neighbour_offsets_[point_index + 1] - point_neighbour_offsets_[point_index]);
+    }
+    else if (input_->is_dense || pcl::isFinite ((*input_)[point_index]))
+    {
+      search_->nearestKSearch ((*input_)[point_index], region_neighbour_number_, neighbour_buffer, distance_buffer);
+      point_neighbours = neighbour_buffer.data ();
+      point_distances = distance_buffer.data ();
+      number_of_neighbours = neighbour_buffer.size ();
+    }
     //loop through every neighbour of the current point, find out to which segment it belongs
     //and if it belongs to neighbouring segment and is close enough then remember segment and its distance
-    for (int i_nghbr = 0; i_nghbr < number_of_neighbours; i_nghbr++)
+    for (std::size_t i_nghbr = 0; i_nghbr < number_of_neighbours; i_nghbr++)
     {
       // find segment
       int segment_index = -1;
-      segment_index = point_labels_[ point_neighbours_[point_index][i_nghbr] ];
+      segment_index = point_labels_[ point_neighbours[i_nghbr] ];
 
       if ( segment_index != index )
       {
         // try to push it to the queue
-        if (distances[segment_index] > point_distances_[point_index][i_nghbr])
-          distances[segment_index] = point_distances_[point_index][i_nghbr];
+        if (distances[segment_index] > point_distances[i_nghbr])
+          distances[segment_index] = point_distances[i_nghbr];
       }
     }
   }// next point
@@ -714,9 +736,10 @@ pcl::RegionGrowingRGB<PointT, NormalT>::getSegmentFromPoint (int index, pcl::Poi
     if (clusters_.empty ())
     {
       clusters_.clear ();
-      point_neighbours_.clear ();
+      point_neighbour_indices_.clear ();
       point_labels_.clear ();
       num_pts_in_segment_.clear ();
+      point_neighbour_distances_.clear ();
       point_distances_.clear ();
       segment_neighbours_.clear ();
       segment_distances_.clear ();
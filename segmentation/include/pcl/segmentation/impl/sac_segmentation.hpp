@@ -72,6 +72,13 @@
 
 #include <pcl/memory.h>  // for static_pointer_cast
 
+#include <algorithm>
+#include <queue>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::SACSegmentation<PointT>::segment (PointIndices &inliers, ModelCoefficients &model_coefficients)
@@ -130,6 +137,187 @@ pcl::SACSegmentation<PointT>::segment (PointIndices &inliers, ModelCoefficients
   deinitCompute ();
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::SACSegmentation<PointT>::segmentModels (std::vector<PointIndices> &inliers, std::vector<ModelCoefficients> &model_coefficients, unsigned int max_models)
+{
+  inliers.clear ();
+  model_coefficients.clear ();
+
+  if (!initCompute ())
+    return;
+
+  // Initialize the Sample Consensus model and set its parameters
+  if (!initSACModel (model_type_))
+  {
+    PCL_ERROR ("[pcl::%s::segmentModels] Error initializing the SAC model!\n", getClassName ().c_str ());
+    deinitCompute ();
+    return;
+  }
+  // The method itself is not used, but it sets the sampling parameters of the model
+  initSAC (method_type_);
+
+  if (max_iterations_ <= 0)
+  {
+    PCL_ERROR ("[pcl::%s::segmentModels] The maximum number of iterations has to be positive!\n", getClassName ().c_str ());
+    deinitCompute ();
+    return;
+  }
+
+  unsigned int threads = 1;
+#ifdef _OPENMP
+  if (threads_ == 0)
+    threads = omp_get_num_procs ();
+  else if (threads_ > 0)
+    threads = threads_;
+#endif
+
+  std::size_t min_inliers = std::max<std::size_t> (min_inliers_, model_->getSampleSize ());
+  int nr_hypotheses = max_iterations_;
+
+  // The points that are not the inlier of a model yet, the model only sees these
+  Indices remaining = *indices_;
+  std::vector<bool> explained (input_->size (), false);
+
+  std::vector<Indices> samples (nr_hypotheses);
+  std::vector<Eigen::VectorXf> hypotheses (nr_hypotheses);
+  std::vector<std::size_t> inlier_counts (nr_hypotheses);
+  std::vector<double> distances;
+
+  while ((max_models == 0 || inliers.size () < max_models) && remaining.size () >= min_inliers)
+  {
+    model_->setIndices (remaining);
+
+    // The random number generator of the model is not thread safe, the samples are drawn first
+    int iterations = 0;
+    for (auto &sample : samples)
+      model_->getSamples (iterations, sample);
+
+#pragma omp parallel for \
+  default(none) \
+  shared(nr_hypotheses, samples, hypotheses, inlier_counts) \
+  schedule(dynamic) \
+  num_threads(threads)
+    for (int i_hypothesis = 0; i_hypothesis < nr_hypotheses; i_hypothesis++)
+    {
+      inlier_counts[i_hypothesis] = 0;
+      if (!samples[i_hypothesis].empty () && model_->computeModelCoefficients (samples[i_hypothesis], hypotheses[i_hypothesis]))
+        inlier_counts[i_hypothesis] = model_->countWithinDistance (hypotheses[i_hypothesis], threshold_);
+    }
+
+    // Keep the hypotheses greedily, by their number of inliers that are not the inlier of a kept hypothesis. This
+    // number only decreases when a hypothesis is kept, so it is only computed again when a hypothesis reaches the top
+    // of the queue. Equal hypotheses are taken in the order of their samples, the result does not depend on the threads.
+    // A hypothesis drawn from the inliers of a kept one describes the same structure, it is dropped right away.
+    std::priority_queue<std::pair<std::size_t, int> > queue;
+    for (int i_hypothesis = 0; i_hypothesis < nr_hypotheses; i_hypothesis++)
+      if (inlier_counts[i_hypothesis] >= min_inliers)
+        queue.emplace (inlier_counts[i_hypothesis], -i_hypothesis);
+
+    std::vector<Eigen::VectorXf> round_coefficients;
+    std::vector<Indices> round_inliers;
+    while (!queue.empty () && (max_models == 0 || inliers.size () + round_coefficients.size () < max_models))
+    {
+      const int i_hypothesis = -queue.top ().second;
+      queue.pop ();
+
+      const Indices &sample = samples[i_hypothesis];
+      if (std::any_of (sample.cbegin (), sample.cend (), [&explained] (index_t index) { return (explained[index]); }))
+        continue;
+
+      model_->getDistancesToModel (hypotheses[i_hypothesis], distances);
+      if (distances.size () != remaining.size ())
+        continue;
+
+      Indices hypothesis_inliers;
+      for (std::size_t i_point = 0; i_point < remaining.size (); i_point++)
+        if (distances[i_point] <= threshold_ && !explained[remaining[i_point]])
+          hypothesis_inliers.push_back (remaining[i_point]);
+
+      if (hypothesis_inliers.size () < min_inliers)
+        continue;
+      if (!queue.empty () && hypothesis_inliers.size () < queue.top ().first)
+      {
+        queue.emplace (hypothesis_inliers.size (), -i_hypothesis);
+        continue;
+      }
+
+      for (const auto &index : hypothesis_inliers)
+        explained[index] = true;
+      round_coefficients.push_back (hypotheses[i_hypothesis]);
+      round_inliers.push_back (std::move (hypothesis_inliers));
+    }
+
+    if (round_coefficients.empty ())
+      break;
+
+    // Refine the models, and compute the distance of all the remaining points to them
+    int nr_models = static_cast<int> (round_coefficients.size ());
+    std::vector<std::vector<double> > model_distances (nr_models);
+#pragma omp parallel for \
+  default(none) \
+  shared(nr_models, round_coefficients, round_inliers, model_distances) \
+  schedule(dynamic) \
+  num_threads(threads)
+    for (int i_model = 0; i_model < nr_models; i_model++)
+    {
+      if (optimize_coefficients_)
+      {
+        Eigen::VectorXf coeff_refined;
+        model_->optimizeModelCoefficients (round_inliers[i_model], round_coefficients[i_model], coeff_refined);
+        round_coefficients[i_model] = coeff_refined;
+      }
+      model_->getDistancesToModel (round_coefficients[i_model], model_distances[i_model]);
+    }
+
+    // As in sequential RANSAC, a point is an inlier of the best model it is close to
+    for (auto &model_inliers : round_inliers)
+    {
+      for (const auto &index : model_inliers)
+        explained[index] = false;
+      model_inliers.clear ();
+    }
+    for (std::size_t i_point = 0; i_point < remaining.size (); i_point++)
+    {
+      for (int i_model = 0; i_model < nr_models; i_model++)
+      {
+        const std::vector<double> &point_distances = model_distances[i_model];
+        if (point_distances.size () == remaining.size () && point_distances[i_point] <= threshold_)
+        {
+          round_inliers[i_model].push_back (remaining[i_point]);
+          break;
+        }
+      }
+    }
+
+    std::size_t nr_found = inliers.size ();
+    for (int i_model = 0; i_model < nr_models; i_model++)
+    {
+      if (round_inliers[i_model].size () < min_inliers)
+        continue;
+      for (const auto &index : round_inliers[i_model])
+        explained[index] = true;
+
+      PointIndices model_inliers;
+      model_inliers.header = input_->header;
+      model_inliers.indices = std::move (round_inliers[i_model]);
+      inliers.push_back (std::move (model_inliers));
+
+      ModelCoefficients coefficients;
+      coefficients.header = input_->header;
+      coefficients.values.assign (round_coefficients[i_model].data (), round_coefficients[i_model].data () + round_coefficients[i_model].size ());
+      model_coefficients.push_back (std::move (coefficients));
+    }
+    if (inliers.size () == nr_found)
+      break;
+
+    PCL_DEBUG ("[pcl::%s::segmentModels] Found %lu model(s) in %lu points.\n", getClassName ().c_str (), inliers.size () - nr_found, remaining.size ());
+    remaining.erase (std::remove_if (remaining.begin (), remaining.end (), [&explained] (index_t index) { return (explained[index]); }), remaining.end ());
+  }
+
+  deinitCompute ();
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> bool
 pcl::SACSegmentation<PointT>::initSACModel (const int model_type)
@@ -43,6 +43,10 @@
 #include <pcl/segmentation/supervoxel_clustering.h>
 #include <pcl/common/io.h> // for copyPointCloud
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT>
 pcl::SupervoxelClustering<PointT>::SupervoxelClustering (float voxel_resolution, float seed_resolution) :
@@ -53,9 +57,12 @@ pcl::SupervoxelClustering<PointT>::SupervoxelClustering (float voxel_resolution,
   color_importance_ (0.1f),
   spatial_importance_ (0.4f),
   normal_importance_ (1.0f),
-  use_default_transform_behaviour_ (true)
+  use_default_transform_behaviour_ (true),
+  threads_ (1)
 {
   adjacency_octree_.reset (new OctreeAdjacencyT (resolution_));
+  //Only the flat neighbor arrays of the octree are used
+  adjacency_octree_->setStoreContainerNeighbors (false);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -157,10 +164,15 @@ pcl::SupervoxelClustering<PointT>::refineSupervoxels (int num_itr, std::map<std:
   int max_depth = static_cast<int> (1.8f*seed_resolution_/resolution_);
   for (int i = 0; i < num_itr; ++i)
   {
+    //The normals of a supervoxel only depend on its own voxels
+    std::vector<SupervoxelHelper*> helpers;
+    helpers.reserve (supervoxel_helpers_.size ());
     for (typename HelperListT::iterator sv_itr = supervoxel_helpers_.begin (); sv_itr != supervoxel_helpers_.end (); ++sv_itr)
-    {
-      sv_itr->refineNormals ();
-    }
+      helpers.push_back (&(*sv_itr));
+    const int num_helpers = static_cast<int> (helpers.size ());
+#pragma omp parallel for num_threads(threads_) schedule(dynamic)
+    for (int h = 0; h < num_helpers; ++h)
+      helpers[h]->refineNormals ();
     
     reseedSupervoxels ();
     expandSupervoxels (max_depth);
@@ -192,6 +204,7 @@ pcl::SupervoxelClustering<PointT>::prepareForSegmentation ()
        || (!use_default_transform_behaviour_ && use_single_camera_transform_))
       adjacency_octree_->setTransformFunction ([this] (PointT &p) { transformFunction (p); });
 
+  adjacency_octree_->setNumberOfThreads (threads_);
   adjacency_octree_->addPointsFromInputCloud ();
   //double prep_end = timer_.getTime ();
   //std::cout<<"Time elapsed populating octree with next frame ="<<prep_end-prep_start<<" ms\n";
@@ -210,16 +223,20 @@ pcl::SupervoxelClustering<PointT>::computeVoxelData ()
 {
   voxel_centroid_cloud_.reset (new PointCloudT);
   voxel_centroid_cloud_->resize (adjacency_octree_->getLeafCount ());
-  typename LeafVectorT::iterator leaf_itr = adjacency_octree_->begin ();
-  typename PointCloudT::iterator cent_cloud_itr = voxel_centroid_cloud_->begin ();
-  for (int idx = 0 ; leaf_itr != adjacency_octree_->end (); ++leaf_itr, ++cent_cloud_itr, ++idx)
+  voxel_leaves_.assign (adjacency_octree_->begin (), adjacency_octree_->end ());
+  const int num_leaves = static_cast<int> (voxel_leaves_.size ());
+#pragma omp parallel for num_threads(threads_) schedule(static)
+  for (int idx = 0; idx < num_leaves; ++idx)
   {
-    VoxelData& new_voxel_data = (*leaf_itr)->getData ();
+    VoxelData& new_voxel_data = voxel_leaves_[idx]->getData ();
     //Add the point to the centroid cloud
-    new_voxel_data.getPoint (*cent_cloud_itr);
-    //voxel_centroid_cloud_->push_back(new_voxel_data.getPoint ());
+    new_voxel_data.getPoint ((*voxel_centroid_cloud_)[idx]);
     new_voxel_data.idx_ = idx;
   }
+
+  //The octree already holds the neighbors of the leaves as indices into its leaf vector
+  leaf_neighbors_ = adjacency_octree_->getNeighborIndices ();
+  leaf_neighbor_offsets_ = adjacency_octree_->getNeighborOffsets ();
   
   //If normals were provided
   if (input_normals_)
@@ -227,58 +244,62 @@ pcl::SupervoxelClustering<PointT>::computeVoxelData ()
     //Verify that input normal cloud size is same as input cloud size
     assert (input_normals_->size () == input_->size ());
     //For every point in the input cloud, find its corresponding leaf
-    typename NormalCloudT::const_iterator normal_itr = input_normals_->begin ();
-    for (typename PointCloudT::const_iterator input_itr = input_->begin (); input_itr != input_->end (); ++input_itr, ++normal_itr)
+    const int num_points = static_cast<int> (input_->size ());
+    std::vector<int> point_leaves (num_points, -1);
+#pragma omp parallel for num_threads(threads_) schedule(static)
+    for (int i = 0; i < num_points; ++i)
     {
       //If the point is not finite we ignore it
-      if ( !pcl::isFinite<PointT> (*input_itr))
+      if ( !pcl::isFinite<PointT> ((*input_)[i]))
         continue;
       //Otherwise look up its leaf container
-      LeafContainerT* leaf = adjacency_octree_->getLeafContainerAtPoint (*input_itr);
-
-      //Get the voxel data object
-      VoxelData& voxel_data = leaf->getData ();
-      //Add this normal in (we will normalize at the end)
-      voxel_data.normal_ += normal_itr->getNormalVector4fMap ();
-      voxel_data.curvature_ += normal_itr->curvature;
+      point_leaves[i] = adjacency_octree_->getLeafContainerAtPoint ((*input_)[i])->getData ().idx_;
+    }
+    //Add the normals in, in the order of the points (we will normalize at the end)
+    for (int i = 0; i < num_points; ++i)
+    {
+      if (point_leaves[i] < 0)
+        continue;
+      VoxelData& voxel_data = voxel_leaves_[point_leaves[i]]->getData ();
+      voxel_data.normal_ += (*input_normals_)[i].getNormalVector4fMap ();
+      voxel_data.curvature_ += (*input_normals_)[i].curvature;
     }
     //Now iterate through the leaves and normalize 
-    for (leaf_itr = adjacency_octree_->begin (); leaf_itr != adjacency_octree_->end (); ++leaf_itr)
+#pragma omp parallel for num_threads(threads_) schedule(static)
+    for (int idx = 0; idx < num_leaves; ++idx)
     {
-      VoxelData& voxel_data = (*leaf_itr)->getData ();
+      VoxelData& voxel_data = voxel_leaves_[idx]->getData ();
       voxel_data.normal_.normalize ();
       voxel_data.owner_ = nullptr;
       voxel_data.distance_ = std::numeric_limits<float>::max ();
       //Get the number of points in this leaf
-      int num_points = (*leaf_itr)->getPointCounter ();
+      int num_points = voxel_leaves_[idx]->getPointCounter ();
       voxel_data.curvature_ /= num_points;
     }
   }
   else //Otherwise just compute the normals
   {
-    for (leaf_itr = adjacency_octree_->begin (); leaf_itr != adjacency_octree_->end (); ++leaf_itr)
+#pragma omp parallel for num_threads(threads_) schedule(dynamic, 256)
+    for (int idx = 0; idx < num_leaves; ++idx)
     {
-      VoxelData& new_voxel_data = (*leaf_itr)->getData ();
+      VoxelData& new_voxel_data = voxel_leaves_[idx]->getData ();
       //For every point, get its neighbors, build an index vector, compute normal
       Indices indices;
       indices.reserve (81); 
       //Push this point
-      indices.push_back (new_voxel_data.idx_);
-      for (typename LeafContainerT::const_iterator neighb_itr=(*leaf_itr)->cbegin (); neighb_itr!=(*leaf_itr)->cend (); ++neighb_itr)
+      indices.push_back (idx);
+      for (std::size_t n = leaf_neighbor_offsets_[idx]; n < leaf_neighbor_offsets_[idx + 1]; ++n)
       {
-        VoxelData& neighb_voxel_data = (*neighb_itr)->getData ();
         //Push neighbor index
-        indices.push_back (neighb_voxel_data.idx_);
+        const index_t neighbor = leaf_neighbors_[n];
+        indices.push_back (neighbor);
         //Get neighbors neighbors, push onto cloud
-        for (typename LeafContainerT::const_iterator neighb_neighb_itr=(*neighb_itr)->cbegin (); neighb_neighb_itr!=(*neighb_itr)->cend (); ++neighb_neighb_itr)
-        {
-          VoxelData& neighb2_voxel_data = (*neighb_neighb_itr)->getData ();
-          indices.push_back (neighb2_voxel_data.idx_);
-        }
+        indices.insert (indices.end (), leaf_neighbors_.begin () + leaf_neighbor_offsets_[neighbor],
+                        leaf_neighbors_.begin () + leaf_neighbor_offsets_[neighbor + 1]);
       }
       //Compute normal
       pcl::computePointNormal (*voxel_centroid_cloud_, indices, new_voxel_data.normal_, new_voxel_data.curvature_);
-      pcl::flipNormalTowardsViewpoint ((*voxel_centroid_cloud_)[new_voxel_data.idx_], 0.0f,0.0f,0.0f, new_voxel_data.normal_);
+      pcl::flipNormalTowardsViewpoint ((*voxel_centroid_cloud_)[idx], 0.0f,0.0f,0.0f, new_voxel_data.normal_);
       new_voxel_data.normal_[3] = 0.0f;
       new_voxel_data.normal_.normalize ();
       new_voxel_data.owner_ = nullptr;
@@ -293,7 +314,11 @@ pcl::SupervoxelClustering<PointT>::computeVoxelData ()
 template <typename PointT> void
 pcl::SupervoxelClustering<PointT>::expandSupervoxels ( int depth )
 {
-  
+  if (threads_ != 1)
+  {
+    expandSupervoxelsParallel (depth);
+    return;
+  }
   
   for (int i = 1; i < depth; ++i)
   {
@@ -321,20 +346,93 @@ pcl::SupervoxelClustering<PointT>::expandSupervoxels ( int depth )
 
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::SupervoxelClustering<PointT>::expandSupervoxelsParallel (int depth)
+{
+  std::vector<std::vector<std::pair<index_t, float> > > candidates;
+  std::vector<int> winners (voxel_leaves_.size (), -1);
+  Indices contested;
+  for (int i = 1; i < depth; ++i)
+  {
+    std::vector<SupervoxelHelper*> helpers;
+    helpers.reserve (supervoxel_helpers_.size ());
+    for (typename HelperListT::iterator sv_itr = supervoxel_helpers_.begin (); sv_itr != supervoxel_helpers_.end (); ++sv_itr)
+      helpers.push_back (&(*sv_itr));
+    const int num_helpers = static_cast<int> (helpers.size ());
+    candidates.resize (num_helpers);
+
+    //Every supervoxel evaluates its neighboring voxels, nothing is changed yet
+#pragma omp parallel for num_threads(threads_) schedule(dynamic)
+    for (int h = 0; h < num_helpers; ++h)
+      helpers[h]->findExpansionCandidates (candidates[h]);
+
+    //Each contested voxel goes to the closest supervoxel, to the first one (lowest label) on ties
+    contested.clear ();
+    for (int h = 0; h < num_helpers; ++h)
+    {
+      for (const auto &candidate : candidates[h])
+      {
+        VoxelData& voxel = voxel_leaves_[candidate.first]->getData ();
+        if (candidate.second < voxel.distance_)
+        {
+          voxel.distance_ = candidate.second;
+          if (winners[candidate.first] < 0)
+            contested.push_back (candidate.first);
+          winners[candidate.first] = h;
+        }
+      }
+    }
+    for (const auto &idx : contested)
+    {
+      LeafContainerT* leaf = voxel_leaves_[idx];
+      VoxelData& voxel = leaf->getData ();
+      if (voxel.owner_)
+        voxel.owner_->removeLeaf (leaf);
+      helpers[winners[idx]]->addLeaf (leaf);
+      winners[idx] = -1;
+    }
+
+    //Update the centers to reflect new centers
+#pragma omp parallel for num_threads(threads_) schedule(dynamic)
+    for (int h = 0; h < num_helpers; ++h)
+      if (helpers[h]->size () != 0)
+        helpers[h]->updateCentroid ();
+    for (typename HelperListT::iterator sv_itr = supervoxel_helpers_.begin (); sv_itr != supervoxel_helpers_.end (); )
+    {
+      if (sv_itr->size () == 0)
+        sv_itr = supervoxel_helpers_.erase (sv_itr);
+      else
+        ++sv_itr;
+    }
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::SupervoxelClustering<PointT>::makeSupervoxels (std::map<std::uint32_t,typename Supervoxel<PointT>::Ptr > &supervoxel_clusters)
 {
   supervoxel_clusters.clear ();
+  std::vector<std::pair<const SupervoxelHelper*, Supervoxel<PointT>*> > supervoxels;
+  supervoxels.reserve (supervoxel_helpers_.size ());
   for (typename HelperListT::iterator sv_itr = supervoxel_helpers_.begin (); sv_itr != supervoxel_helpers_.end (); ++sv_itr)
   {
     std::uint32_t label = sv_itr->getLabel ();
     supervoxel_clusters[label].reset (new Supervoxel<PointT>);
-    sv_itr->getXYZ (supervoxel_clusters[label]->centroid_.x,supervoxel_clusters[label]->centroid_.y,supervoxel_clusters[label]->centroid_.z);
-    sv_itr->getRGB (supervoxel_clusters[label]->centroid_.rgba);
-    sv_itr->getNormal (supervoxel_clusters[label]->normal_);
-    sv_itr->getVoxels (supervoxel_clusters[label]->voxels_);
-    sv_itr->getNormals (supervoxel_clusters[label]->normals_);
+    supervoxels.emplace_back (&(*sv_itr), supervoxel_clusters[label].get ());
+  }
+  //Copying the voxels out only reads the helpers
+  const int num_supervoxels = static_cast<int> (supervoxels.size ());
+#pragma omp parallel for num_threads(threads_) schedule(dynamic)
+  for (int i = 0; i < num_supervoxels; ++i)
+  {
+    const SupervoxelHelper* helper = supervoxels[i].first;
+    Supervoxel<PointT>* supervoxel = supervoxels[i].second;
+    helper->getXYZ (supervoxel->centroid_.x,supervoxel->centroid_.y,supervoxel->centroid_.z);
+    helper->getRGB (supervoxel->centroid_.rgba);
+    helper->getNormal (supervoxel->normal_);
+    helper->getVoxels (supervoxel->voxels_);
+    helper->getNormals (supervoxel->normals_);
   }
 }
 
@@ -391,27 +489,28 @@ pcl::SupervoxelClustering<PointT>::selectInitialSupervoxelSeeds (Indices &seed_i
     voxel_kdtree_ ->setInputCloud (voxel_centroid_cloud_);
   }
   
+  float search_radius = 0.5f*seed_resolution_;
+  // This is 1/20th of the number of voxels which fit in a planar slice through search volume
+  // Area of planar slice / area of voxel side. (Note: This is smaller than the value mentioned in the original paper)
+  float min_points = 0.05f * (search_radius)*(search_radius) * 3.1415926536f  / (resolution_*resolution_);
+  std::vector<char> keep_seed (num_seeds, 0);
+#pragma omp parallel for num_threads(threads_) schedule(dynamic, 64) firstprivate(closest_index, distance)
   for (int i = 0; i < num_seeds; ++i)  
   {
     voxel_kdtree_->nearestKSearch (voxel_centers[i], 1, closest_index, distance);
     seed_indices_orig[i] = closest_index[0];
+
+    std::vector<int> neighbors;
+    std::vector<float> sqr_distances;
+    int num = voxel_kdtree_->radiusSearch (seed_indices_orig[i], search_radius , neighbors, sqr_distances);
+    keep_seed[i] = num > min_points;
   }
   
-  std::vector<int> neighbors;
-  std::vector<float> sqr_distances;
   seed_indices.reserve (seed_indices_orig.size ());
-  float search_radius = 0.5f*seed_resolution_;
-  // This is 1/20th of the number of voxels which fit in a planar slice through search volume
-  // Area of planar slice / area of voxel side. (Note: This is smaller than the value mentioned in the original paper)
-  float min_points = 0.05f * (search_radius)*(search_radius) * 3.1415926536f  / (resolution_*resolution_);
-  for (const auto &index_orig : seed_indices_orig)
+  for (int i = 0; i < num_seeds; ++i)
   {
-    int num = voxel_kdtree_->radiusSearch (index_orig, search_radius , neighbors, sqr_distances);
-    if ( num > min_points)
-    {
-      seed_indices.push_back (index_orig);
-    }
-    
+    if (keep_seed[i])
+      seed_indices.push_back (seed_indices_orig[i]);
   }
  // std::cout << "Number of seed points after filtering="<<seed_points.size ()<<std::endl;
   
@@ -678,6 +777,27 @@ pcl::SupervoxelClustering<PointT>::setUseSingleCameraTransform (bool val)
   use_single_camera_transform_ = val;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::SupervoxelClustering<PointT>::setNumberOfThreads (unsigned int nr_threads)
+{
+  if (nr_threads == 0)
+#ifdef _OPENMP
+    threads_ = omp_get_num_procs();
+#else
+    threads_ = 1;
+#endif
+  else
+    threads_ = nr_threads;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> unsigned int
+pcl::SupervoxelClustering<PointT>::getNumberOfThreads () const
+{
+  return (threads_);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> int
 pcl::SupervoxelClustering<PointT>::getMaxLabel () const
@@ -796,11 +916,13 @@ pcl::SupervoxelClustering<PointT>::SupervoxelHelper::expand ()
   //For each leaf belonging to this supervoxel
   for (auto leaf_itr = leaves_.cbegin (); leaf_itr != leaves_.cend (); ++leaf_itr)
   {
+    const int idx = (*leaf_itr)->getData ().idx_;
     //for each neighbor of the leaf
-    for (typename LeafContainerT::const_iterator neighb_itr=(*leaf_itr)->cbegin (); neighb_itr!=(*leaf_itr)->cend (); ++neighb_itr)
+    for (std::size_t n = parent_->leaf_neighbor_offsets_[idx]; n < parent_->leaf_neighbor_offsets_[idx + 1]; ++n)
     {
+      LeafContainerT* neighbor_leaf = parent_->voxel_leaves_[parent_->leaf_neighbors_[n]];
       //Get a reference to the data contained in the leaf
-      VoxelData& neighbor_voxel = ((*neighb_itr)->getData ());
+      VoxelData& neighbor_voxel = neighbor_leaf->getData ();
       //TODO this is a shortcut, really we should always recompute distance
       if(neighbor_voxel.owner_ == this)
         continue;
@@ -814,9 +936,9 @@ pcl::SupervoxelClustering<PointT>::SupervoxelHelper::expand ()
         if (neighbor_voxel.owner_ != this)
         {
           if (neighbor_voxel.owner_)
-            (neighbor_voxel.owner_)->removeLeaf(*neighb_itr);
+            (neighbor_voxel.owner_)->removeLeaf(neighbor_leaf);
           neighbor_voxel.owner_ = this;
-          new_owned.push_back (*neighb_itr);
+          new_owned.push_back (neighbor_leaf);
         }
       }
     }
@@ -828,6 +950,30 @@ pcl::SupervoxelClustering<PointT>::SupervoxelHelper::expand ()
   }  
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::SupervoxelClustering<PointT>::SupervoxelHelper::findExpansionCandidates (std::vector<std::pair<index_t, float> > &candidates) const
+{
+  candidates.clear ();
+  //For each leaf belonging to this supervoxel
+  for (auto leaf_itr = leaves_.cbegin (); leaf_itr != leaves_.cend (); ++leaf_itr)
+  {
+    const int idx = (*leaf_itr)->getData ().idx_;
+    //for each neighbor of the leaf
+    for (std::size_t n = parent_->leaf_neighbor_offsets_[idx]; n < parent_->leaf_neighbor_offsets_[idx + 1]; ++n)
+    {
+      const index_t neighbor = parent_->leaf_neighbors_[n];
+      const VoxelData& neighbor_voxel = parent_->voxel_leaves_[neighbor]->getData ();
+      if (neighbor_voxel.owner_ == this)
+        continue;
+      //Keep it if it is closer to us than to its current owner
+      float dist = parent_->voxelDataDistance (centroid_, neighbor_voxel);
+      if (dist < neighbor_voxel.distance_)
+        candidates.emplace_back (neighbor, dist);
+    }
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::SupervoxelClustering<PointT>::SupervoxelHelper::refineNormals ()
@@ -840,23 +986,22 @@ pcl::SupervoxelClustering<PointT>::SupervoxelHelper::refineNormals ()
     indices.reserve (81); 
     //Push this point
     indices.push_back (voxel_data.idx_);
-    for (typename LeafContainerT::const_iterator neighb_itr=(*leaf_itr)->cbegin (); neighb_itr!=(*leaf_itr)->cend (); ++neighb_itr)
+    for (std::size_t n = parent_->leaf_neighbor_offsets_[voxel_data.idx_]; n < parent_->leaf_neighbor_offsets_[voxel_data.idx_ + 1]; ++n)
     {
       //Get a reference to the data contained in the leaf
-      VoxelData& neighbor_voxel_data = ((*neighb_itr)->getData ());
+      const index_t neighbor = parent_->leaf_neighbors_[n];
+      const VoxelData& neighbor_voxel_data = parent_->voxel_leaves_[neighbor]->getData ();
       //If the neighbor is in this supervoxel, use it
       if (neighbor_voxel_data.owner_ == this)
       {
-        indices.push_back (neighbor_voxel_data.idx_);
+        indices.push_back (neighbor);
         //Also check its neighbors
-        for (typename LeafContainerT::const_iterator neighb_neighb_itr=(*neighb_itr)->cbegin (); neighb_neighb_itr!=(*neighb_itr)->cend (); ++neighb_neighb_itr)
+        for (std::size_t nn = parent_->leaf_neighbor_offsets_[neighbor]; nn < parent_->leaf_neighbor_offsets_[neighbor + 1]; ++nn)
         {
-          VoxelData& neighb_neighb_voxel_data = (*neighb_neighb_itr)->getData ();
-          if (neighb_neighb_voxel_data.owner_ == this)
-            indices.push_back (neighb_neighb_voxel_data.idx_);
+          const index_t neighbor_neighbor = parent_->leaf_neighbors_[nn];
+          if (parent_->voxel_leaves_[neighbor_neighbor]->getData ().owner_ == this)
+            indices.push_back (neighbor_neighbor);
         }
-        
-        
       }
     }
     //Compute normal
@@ -924,11 +1069,12 @@ pcl::SupervoxelClustering<PointT>::SupervoxelHelper::getNeighborLabels (std::set
   //For each leaf belonging to this supervoxel
   for (auto leaf_itr = leaves_.cbegin (); leaf_itr != leaves_.cend (); ++leaf_itr)
   {
+    const int idx = (*leaf_itr)->getData ().idx_;
     //for each neighbor of the leaf
-    for (typename LeafContainerT::const_iterator neighb_itr=(*leaf_itr)->cbegin (); neighb_itr!=(*leaf_itr)->cend (); ++neighb_itr)
+    for (std::size_t n = parent_->leaf_neighbor_offsets_[idx]; n < parent_->leaf_neighbor_offsets_[idx + 1]; ++n)
     {
       //Get a reference to the data contained in the leaf
-      VoxelData& neighbor_voxel = ((*neighb_itr)->getData ());
+      const VoxelData& neighbor_voxel = parent_->voxel_leaves_[parent_->leaf_neighbors_[n]]->getData ();
       //If it has an owner, and it's not us - get it's owner's label insert into set
       if (neighbor_voxel.owner_ != this && neighbor_voxel.owner_)
       {
@@ -50,6 +50,10 @@ namespace pcl
    *  S. C. Stein, M. Schoeler, J. Papon, F. Woergoetter
    *  Object Partitioning using Local Convexity
    *  In Proceedings of the IEEE Conference on Computer Vision and Pattern Recognition (CVPR) 2014
+   *
+   *  The convexity of the supervoxel connections is evaluated in parallel (see \ref setNumberOfThreads). When only some
+   *  supervoxels change between two frames, \ref updateInputSupervoxels keeps the classification of the connections
+   *  which are not affected, and the next call to \ref segment only evaluates the connections of the changed supervoxels.
    *  \author Simon Christoph Stein and Markus Schoeler (mschoeler@gwdg.de)
    *  \ingroup segmentation
    */
@@ -111,6 +115,16 @@ namespace pcl
         supervoxels_set_ = true;
       }
 
+      /** \brief Update the supervoxels of a previous call to \ref setInputSupervoxels, e.g. with the supervoxels of the next frame of a sequence.
+       *  If the supervoxel labels and their adjacency did not change, only the connections of the supervoxels whose centroid or normal changed
+       *  are evaluated again by the next call to \ref segment. Otherwise this is the same as calling \ref setInputSupervoxels.
+       *  \param[in] supervoxel_clusters_arg Map of < supervoxel labels, supervoxels >
+       *  \param[in] label_adjacency_arg The graph defining the supervoxel adjacency relations
+       *  \note The supervoxels given to the previous call are compared with the new ones, so they must not be modified in place. */
+      void
+      updateInputSupervoxels (const std::map<std::uint32_t, typename pcl::Supervoxel<PointT>::Ptr> &supervoxel_clusters_arg,
+                              const std::multimap<std::uint32_t, std::uint32_t> &label_adjacency_arg);
+
       /** \brief Merge supervoxels using local convexity. The input parameters are generated by using the \ref SupervoxelClustering class. To retrieve the output use the \ref relabelCloud method.
        *  \note There are three ways to retrieve the segmentation afterwards: \ref relabelCloud, \ref getSegmentToSupervoxelMap and \ref getSupervoxelToSegmentMap. */
       void
@@ -201,6 +215,7 @@ namespace pcl
       setConcavityToleranceThreshold (float concavity_tolerance_threshold_arg)
       {
         concavity_tolerance_threshold_ = concavity_tolerance_threshold_arg;
+        connections_valid_ = false;
       }
 
       /** \brief Determines if a smoothness check is done during segmentation, trying to invalidate edges of non-smooth connected edges (steps). Two supervoxels are unsmooth if their plane-to-plane distance DIST > (expected_distance + smoothness_threshold_*voxel_resolution_). For parallel supervoxels, the expected_distance is zero.
@@ -218,6 +233,7 @@ namespace pcl
         voxel_resolution_ = voxel_res_arg;
         seed_resolution_ = seed_res_arg;
         smoothness_threshold_ = smoothness_threshold_arg;
+        connections_valid_ = false;
       }
 
       /** \brief Determines if we want to use the sanity criterion to invalidate singular connected patches
@@ -226,6 +242,7 @@ namespace pcl
       setSanityCheck (const bool use_sanity_criterion_arg)
       {
         use_sanity_check_ = use_sanity_criterion_arg;
+        connections_valid_ = false;
       }
 
       /** \brief Set the value used for k convexity. For k>0 convex connections between p_i and p_j require k common neighbors of these patches that have a convex connection to both.
@@ -244,6 +261,18 @@ namespace pcl
         min_segment_size_ = min_segment_size_arg;
       }
 
+      /** \brief Set the number of threads used to evaluate the supervoxel connections.
+       *  \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic) */
+      void
+      setNumberOfThreads (unsigned int nr_threads = 0);
+
+      /** \brief Get the number of threads used to evaluate the supervoxel connections. */
+      inline unsigned int
+      getNumberOfThreads () const
+      {
+        return (threads_);
+      }
+
     protected:
 
       /** \brief Segments smaller than \ref min_segment_size_ are merged to the label of largest neighbor */
@@ -275,7 +304,8 @@ namespace pcl
                                const unsigned int group_label);
 
       /** \brief Calculates convexity of edges and saves this to the adjacency graph.
-       *  \param[in,out] adjacency_list_arg The supervoxel adjacency list*/
+       *  \param[in,out] adjacency_list_arg The supervoxel adjacency list
+       *  \note For \ref sv_adjacency_list_ only the edges marked in \ref sv_edge_dirty_ are evaluated, if the others are still valid. */
       void
       calculateConvexConnections (SupervoxelAdjacencyList& adjacency_list_arg);
 
@@ -326,6 +356,9 @@ namespace pcl
       /** \brief Minimum segment size */
       std::uint32_t min_segment_size_;
 
+      /** \brief Number of threads used to evaluate the supervoxel connections */
+      unsigned int threads_;
+
       /** \brief Stores which supervoxel labels were already visited during recursive grouping.
        *  \note processed_[sv_Label] = false (default)/true (already processed) */
       std::map<std::uint32_t, bool> processed_;
@@ -333,6 +366,15 @@ namespace pcl
       /** \brief Adjacency graph with the supervoxel labels as nodes and edges between adjacent supervoxels */
       SupervoxelAdjacencyList sv_adjacency_list_;
 
+      /** \brief The edges of \ref sv_adjacency_list_ in a flat array, which is processed in parallel */
+      std::vector<EdgeID> sv_edges_;
+
+      /** \brief Marks the edges in \ref sv_edges_ whose convexity has to be evaluated again */
+      std::vector<bool> sv_edge_dirty_;
+
+      /** \brief Marks if the convexity of the edges in \ref sv_edges_ which are not dirty is still valid */
+      bool connections_valid_;
+
       /** \brief map from the supervoxel labels to the supervoxel objects  */
       std::map<std::uint32_t, typename pcl::Supervoxel<PointT>::Ptr> sv_label_to_supervoxel_map_;
 
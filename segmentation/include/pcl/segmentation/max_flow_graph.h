@@ -0,0 +1,250 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2020-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <pcl/pcl_macros.h>
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+namespace pcl
+{
+  namespace segmentation
+  {
+    /** \brief @b MaxFlowGraph is an array based s-t graph with a Boykov-Kolmogorov maximum flow solver, as used by
+      * MinCutSegmentation and GrabCut.
+      *
+      * Nodes and edges are added first, then \ref solve computes the maximum flow, and thus the minimum cut, between
+      * the source and the sink. The edges are stored as pairs of opposite arcs, grouped by node in one contiguous
+      * array, and the two terminal edges of a node are folded into a single signed residual capacity. Once built,
+      * the capacities can be changed and the problem solved again without rebuilding the graph, which is what
+      * happens when only the seeds of a segmentation change.
+      *
+      * The algorithm is described in:
+      * "An Experimental Comparison of Min-Cut/Max-Flow Algorithms for Energy Minimization in Vision"
+      * Y. Boykov and V. Kolmogorov, IEEE PAMI 2004.
+      *
+      * \note Terminal capacities may be negative, an edge from the source of capacity -c is an edge of capacity c
+      * to the sink. The capacities of the edges between nodes must not be negative.
+      * \ingroup segmentation
+      */
+    class PCL_EXPORTS MaxFlowGraph
+    {
+      public:
+        /** \brief Empty constructor. */
+        MaxFlowGraph ();
+
+        /** \brief Reserve memory for the given number of nodes and edges. */
+        void
+        reserve (std::size_t nodes, std::size_t edges);
+
+        /** \brief Remove all the nodes and edges. */
+        void
+        clear ();
+
+        /** \brief Add nodes to the graph.
+          * \param[in] n the number of nodes to add
+          * \return the id of the first node added, the others follow
+          */
+        int
+        addNodes (std::size_t n = 1);
+
+        /** \brief Get the number of nodes of the graph. */
+        inline std::size_t
+        getNumberOfNodes () const { return (source_capacities_.size ()); }
+
+        /** \brief Get the number of edges between nodes of the graph. */
+        inline std::size_t
+        getNumberOfEdges () const { return (edge_nodes_.size () / 2); }
+
+        /** \brief Add an edge between two nodes, and its reverse edge.
+          * \param[in] u the first node
+          * \param[in] v the second node
+          * \param[in] cap_uv the capacity from u to v
+          * \param[in] cap_vu the capacity from v to u
+          * \return the id of the edge, to be used with \ref setEdgeCapacities
+          */
+        int
+        addEdge (int u, int v, double cap_uv, double cap_vu = 0.0);
+
+        /** \brief Change the capacities of an edge. The flow has to be computed again with \ref solve. */
+        void
+        setEdgeCapacities (int edge, double cap_uv, double cap_vu = 0.0);
+
+        /** \brief Add to the capacities of the edges from the source to a node and from the node to the sink. */
+        void
+        addTerminalWeights (int u, double source_capacity, double sink_capacity);
+
+        /** \brief Set the capacities of the edges from the source to a node and from the node to the sink. The flow
+          * has to be computed again with \ref solve.
+          */
+        void
+        setTerminalWeights (int u, double source_capacity, double sink_capacity);
+
+        /** \brief Compute the maximum flow from the source to the sink, starting from a zero flow.
+          * \return the value of the flow
+          */
+        double
+        solve ();
+
+        /** \brief Get the value of the flow computed by the last call to \ref solve. */
+        inline double
+        getFlow () const { return (flow_); }
+
+        /** \brief Whether a node is on the source side of the minimum cut after \ref solve. Nodes that can be reached
+          * from the source through non saturated edges are on the source side, all others on the sink side.
+          */
+        inline bool
+        inSourceTree (int u) const { return (parents_[u] != NO_PARENT && !in_sink_tree_[u]); }
+
+        /** \brief Get the residual capacity of the edge from u to v of an edge after \ref solve. */
+        double
+        getEdgeResidualCapacity (int edge) const;
+
+        /** \brief Get the residual capacity of the edge from v to u of an edge after \ref solve. */
+        double
+        getReverseEdgeResidualCapacity (int edge) const;
+
+        /** \brief Get the residual capacity of the edge from the source to a node after \ref solve. */
+        double
+        getSourceResidualCapacity (int u) const;
+
+        /** \brief Get the residual capacity of the edge from a node to the sink after \ref solve. */
+        double
+        getSinkResidualCapacity (int u) const;
+
+      protected:
+        /** \brief Special values of the parent arc of a node. */
+        enum : int { NO_PARENT = -1, TERMINAL = -2, ORPHAN = -3 };
+
+        /** \brief Sort the arcs by node, if edges were added since the last call. */
+        void
+        buildArcs ();
+
+        /** \brief Reset the residual capacities and the search trees. */
+        void
+        initialize ();
+
+        /** \brief Add a node to the back of the queue of active nodes, if not already in it. */
+        inline void
+        setActive (int u)
+        {
+          if (!is_active_[u])
+          {
+            is_active_[u] = 1;
+            active_.push_back (u);
+          }
+        }
+
+        /** \brief Grow the search tree of a node through its non saturated arcs.
+          * \return the arc from the source tree to the sink tree that was found, or NO_PARENT
+          */
+        int
+        grow (int u);
+
+        /** \brief Push the bottleneck flow through the path that goes through the given arc, and collect the nodes
+          * that lose their parent. */
+        void
+        augment (int middle_arc);
+
+        /** \brief Find a new parent for an orphan, or make it a free node. */
+        void
+        adopt (int u);
+
+        /** \brief Capacity of the edges from the source, by node. */
+        std::vector<double> source_capacities_;
+
+        /** \brief Capacity of the edges to the sink, by node. */
+        std::vector<double> sink_capacities_;
+
+        /** \brief Nodes of every edge, two per edge. */
+        std::vector<int> edge_nodes_;
+
+        /** \brief Capacities of every edge, forward then reverse. */
+        std::vector<double> edge_capacities_;
+
+        /** \brief Position of the first arc of every node in the arc arrays, followed by the number of arcs. */
+        std::vector<std::size_t> node_arcs_;
+
+        /** \brief Position of the forward arc of every edge in the arc arrays, its reverse arc is its sister. */
+        std::vector<int> edge_arcs_;
+
+        /** \brief Node at which every arc ends. */
+        std::vector<int> arc_heads_;
+
+        /** \brief Opposite arc of every arc. */
+        std::vector<int> arc_sisters_;
+
+        /** \brief Residual capacity of every arc. */
+        std::vector<double> arc_residuals_;
+
+        /** \brief Residual capacity of the terminal edges of every node, positive towards the source. */
+        std::vector<double> terminal_residuals_;
+
+        /** \brief Arc from every node to its parent in its search tree, or one of the special values. */
+        std::vector<int> parents_;
+
+        /** \brief Whether every node belongs to the sink search tree. */
+        std::vector<unsigned char> in_sink_tree_;
+
+        /** \brief Whether every node is in the queue of active nodes. */
+        std::vector<unsigned char> is_active_;
+
+        /** \brief Time at which the distance to the terminal of every node was last checked. */
+        std::vector<int> timestamps_;
+
+        /** \brief Distance of every node to the terminal of its tree, valid at its timestamp. */
+        std::vector<int> distances_;
+
+        /** \brief Queue of active nodes. */
+        std::deque<int> active_;
+
+        /** \brief Queue of orphans. */
+        std::deque<int> orphans_;
+
+        /** \brief Current time, incremented at every growth step. */
+        int time_;
+
+        /** \brief Whether the arc arrays match the edges. */
+        bool arcs_are_valid_;
+
+        /** \brief Value of the flow. */
+        double flow_;
+    };
+  }
+}
@@ -39,6 +39,7 @@
 #pragma once
 
 #include <pcl/segmentation/boost.h>
+#include <pcl/segmentation/max_flow_graph.h>
 #include <pcl/memory.h>
 #include <pcl/pcl_base.h>
 #include <pcl/pcl_macros.h>
@@ -46,7 +47,7 @@
 #include <pcl/point_types.h>
 #include <pcl/search/search.h>
 #include <string>
-#include <set>
+#include <utility>
 
 namespace pcl
 {
@@ -54,6 +55,10 @@ namespace pcl
     * The description can be found in the article:
     * "Min-Cut Based Segmentation of Point Clouds"
     * \author: Aleksey Golovinskiy and Thomas Funkhouser.
+    *
+    * The graph is stored in a pcl::segmentation::MaxFlowGraph, with one node per point. It is only built again when
+    * the cloud or the number of neighbours change: new foreground points, radius, source weight or sigma only update
+    * its capacities before the next cut.
     */
   template <typename PointT>
   class PCL_EXPORTS MinCutSegmentation : public pcl::PCLBase<PointT>
@@ -172,6 +177,16 @@ namespace pcl
       void
       setNumberOfNeighbours (unsigned int neighbour_number);
 
+      /** \brief Returns the number of threads used to search the neighbours and compute the potentials. */
+      unsigned int
+      getNumberOfThreads () const;
+
+      /** \brief Allows to set the number of threads used to search the neighbours and compute the potentials.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads = 0);
+
       /** \brief Returns the points that must belong to foreground. */
       std::vector<PointT, Eigen::aligned_allocator<PointT> >
       getForegroundPoints () const;
@@ -204,7 +219,11 @@ namespace pcl
       double
       getMaxFlow () const;
 
-      /** \brief Returns the graph that was build for finding the minimum cut. */
+      /** \brief Returns the graph that was build for finding the minimum cut, converted to a boost graph with the
+        * capacities and the residual capacities of the last cut. Vertices 0 to N-1 are the points of the cloud, N is
+        * the source and N+1 the sink.
+        */
+      PCL_DEPRECATED(1, 14, "the graph is no longer a boost graph, it is converted at every call")
       mGraphPtr
       getGraph () const;
 
@@ -228,10 +247,13 @@ namespace pcl
       calculateUnaryPotential (int point, double& source_weight, double& sink_weight) const;
 
       /** \brief This method simply adds the edge from the source point to the target point with a given weight.
+        * The capacity of the edge is calculated again when the binary potentials change.
         * \param[in] source index of the source point of the edge
         * \param[in] target index of the target point of the edge
         * \param[in] weight weight that will be assigned to the (source, target) edge
+        * \return false if one of the points is not in the indices, the graph is not built or the edge exists
         */
+      PCL_DEPRECATED(1, 14, "the edges are added to graph_ by buildGraph ()")
       bool
       addEdge (int source, int target, double weight);
 
@@ -251,9 +273,14 @@ namespace pcl
       bool
       recalculateBinaryPotentials ();
 
+      /** \brief This method analyzes the residual network and assigns a label to every point in the cloud. */
+      void
+      assembleLabels ();
+
       /** \brief This method analyzes the residual network and assigns a label to every point in the cloud.
-        * \param[in] residual_capacity residual network that was obtained during the segmentation
+        * \param[in] residual_capacity unused, the residual network is read from graph_
         */
+      PCL_DEPRECATED(1, 14, "the residual network is read from graph_, use assembleLabels ()")
       void
       assembleLabels (ResidualCapacityMap& residual_capacity);
 
@@ -295,30 +322,18 @@ namespace pcl
       /** \brief After the segmentation it will contain the segments. */
       std::vector <pcl::PointIndices> clusters_;
 
-      /** \brief Stores the graph for finding the maximum flow. */
-      mGraphPtr graph_;
-
-      /** \brief Stores the capacity of every edge in the graph. */
-      std::shared_ptr<CapacityMap> capacity_;
-
-      /** \brief Stores reverse edges for every edge in the graph. */
-      std::shared_ptr<ReverseEdgeMap> reverse_edges_;
-
-      /** \brief Stores the vertices of the graph. */
-      std::vector< VertexDescriptor > vertices_;
+      /** \brief Stores the graph for finding the maximum flow. Node i is the point (*indices_)[i]. */
+      pcl::segmentation::MaxFlowGraph graph_;
 
-      /** \brief Stores the information about the edges that were added to the graph. It is used to avoid the duplicate edges. */
-      std::vector< std::set<int> > edge_marker_;
-
-      /** \brief Stores the vertex that serves as source. */
-      VertexDescriptor source_;
-
-      /** \brief Stores the vertex that serves as sink. */
-      VertexDescriptor sink_;
+      /** \brief Stores the points at the ends of every edge of the graph, in the order of the edges. */
+      std::vector<std::pair<index_t, index_t> > edge_points_;
 
       /** \brief Stores the maximum flow value that was calculated during the segmentation. */
       double max_flow_;
 
+      /** \brief Stores the number of threads to use. */
+      unsigned int threads_;
+
     public:
       PCL_MAKE_ALIGNED_OPERATOR_NEW
   };
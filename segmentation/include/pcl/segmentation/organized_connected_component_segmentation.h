@@ -52,6 +52,10 @@ namespace pcl
     * id, along with a vector of PointIndices corresponding to each component.
     * See OrganizedMultiPlaneSegmentation for an example application.
     *
+    * The image can be split in horizontal strips that are labeled in parallel (see setNumberOfThreads), the
+    * components crossing the borders of the strips are merged afterwards. The result does not depend on the number
+    * of threads, but the comparator is then called from several threads at once.
+    *
     * \author Alex Trevor, Suat Gedikli
     */
   template <typename PointT, typename PointLT>
@@ -80,6 +84,7 @@ namespace pcl
         */
       OrganizedConnectedComponentSegmentation (const ComparatorConstPtr& compare)
         : compare_ (compare)
+        , threads_ (1)
       {
       }
 
@@ -102,9 +107,20 @@ namespace pcl
       ComparatorConstPtr
       getComparator () const { return (compare_); }
 
+      /** \brief Set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads = 0);
+
+      /** \brief Get the number of threads to use. */
+      unsigned int
+      getNumberOfThreads () const { return (threads_); }
+
       /** \brief Perform the connected component segmentation.
         * \param[out] labels a PointCloud of labels: each connected component will have a unique id.
         * \param[out] label_indices a vector of PointIndices corresponding to each label / component id.
+        * \note Both outputs are overwritten, passing the same ones for every frame of a stream reuses their memory.
         */
       void
       segment (pcl::PointCloud<PointLT>& labels, std::vector<pcl::PointIndices>& label_indices) const;
@@ -119,7 +135,19 @@ namespace pcl
       
 
     protected:
+      /** \brief Label the rows [row_begin, row_end) of the input, without comparing the first one to the row above.
+        * \param[in] row_begin the first row to label
+        * \param[in] row_end the row after the last one to label
+        * \param[out] labels the labels, indices of the runs of these rows (or the invalid label)
+        * \param[out] runs the parent of every run in the union-find forest of the runs
+        */
+      void
+      labelRows (unsigned row_begin, unsigned row_end, pcl::PointCloud<PointLT>& labels, std::vector<unsigned>& runs) const;
+
       ComparatorConstPtr compare_;
+
+      /** \brief The number of threads to use. */
+      unsigned int threads_;
       
       inline unsigned
       findRoot (const std::vector<unsigned>& runs, unsigned index) const
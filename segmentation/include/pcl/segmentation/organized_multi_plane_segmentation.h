@@ -96,7 +96,9 @@ namespace pcl
         distance_threshold_ (0.02),
         maximum_curvature_ (0.001),
         project_points_ (false), 
-        compare_ (new PlaneComparator ()), refinement_compare_ (new PlaneRefinementComparator ())
+        compare_ (new PlaneComparator ()), refinement_compare_ (new PlaneRefinementComparator ()),
+        plane_d_ (new std::vector<float>),
+        threads_ (1)
       {
       }
 
@@ -213,6 +215,20 @@ namespace pcl
         project_points_ = project_points;
       }
 
+      /** \brief Set the number of threads used for the connected component labeling and the plane fitting. The
+        * comparator has to be thread safe if more than one thread is used.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads = 0);
+
+      /** \brief Get the number of threads used for the connected component labeling and the plane fitting. */
+      unsigned int
+      getNumberOfThreads () const
+      {
+        return (threads_);
+      }
+
       /** \brief Segmentation of all planes in a point cloud given by setInputCloud(), setIndices()
         * \param[out] model_coefficients a vector of model_coefficients for each plane found in the input cloud
         * \param[out] inlier_indices a vector of inliers for each detected plane
@@ -304,6 +320,12 @@ namespace pcl
       /** \brief A comparator for use on the refinement step.  Compares points to regions segmented in the first pass. */
       PlaneRefinementComparatorPtr refinement_compare_;
 
+      /** \brief The d component of the plane equation of every point, kept from one frame to the next. */
+      shared_ptr<std::vector<float> > plane_d_;
+
+      /** \brief The number of threads to use. */
+      unsigned int threads_;
+
       /** \brief Class getName method. */
       virtual std::string
       getClassName () const
@@ -127,6 +127,28 @@ namespace pcl
       inline void
       setExponential (bool exponential) { exponential_ = exponential; }
 
+      /** \brief Get whether the morphological opening is computed on a 2.5D grid. */
+      inline bool
+      getUseGrid () const { return (use_grid_); }
+
+      /** \brief Set whether the morphological opening is computed on a 2.5D grid.
+        * When set, the current ground points are rasterized into a minimum elevation grid of cells of the cell size,
+        * and the opening is applied to this grid (see pcl::applyMorphologicalOperator) with a window of
+        * round ((window size / cell size - 1) / 2) cells on either side of a cell, instead of searching the neighbors
+        * of every point. The points are then compared to the opened elevation of their cell. This is much faster on
+        * large clouds, but the neighborhood of a point is its window of cells rather than a window centered on the
+        * point, so the result differs slightly.
+        * \param[in] use_grid whether to use the grid
+        */
+      inline void
+      setUseGrid (bool use_grid) { use_grid_ = use_grid; }
+
+      /** \brief Initialize the scheduler and set the number of threads to use with the grid.
+        * \param nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
       /** \brief This method launches the segmentation algorithm and returns indices of
         * points determined to be ground returns.
         * \param[out] ground indices of points determined to be ground returns.
@@ -136,6 +158,15 @@ namespace pcl
 
     protected:
 
+      /** \brief Progressively filter the ground points with the morphological opening of a 2.5D grid.
+        * \param[in] window_sizes the window size of every iteration
+        * \param[in] height_thresholds the height threshold of every iteration
+        * \param[in,out] ground the points to process, then the indices of the ground points
+        */
+      void
+      extractOnGrid (const std::vector<float>& window_sizes, const std::vector<float>& height_thresholds,
+                     Indices& ground);
+
       /** \brief Maximum window size to be used in filtering ground returns. */
       int max_window_size_;
 
@@ -156,6 +187,12 @@ namespace pcl
 
       /** \brief Exponentially grow window sizes? */
       bool exponential_;
+
+      /** \brief Compute the morphological opening on a 2.5D grid? */
+      bool use_grid_;
+
+      /** \brief Number of threads to be used with the grid. */
+      unsigned int threads_;
   };
 }
 
@@ -76,6 +76,12 @@ namespace pcl
       * The output of the algorithm (i.e. label assignment) is written back
       * to the color map.
       *
+      * The probabilities are the solution of a sparse symmetric positive
+      * definite linear system, which is solved with a Jacobi preconditioned
+      * conjugate gradient. When PCL is built with OpenMP its matrix-vector
+      * products run in parallel, the number of threads is controlled with
+      * Eigen::setNbThreads().
+      *
       * \param[in] graph an undirected graph with internal edge weight and
       *            vertex color property maps
       *
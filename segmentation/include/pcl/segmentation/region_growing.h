@@ -179,6 +179,32 @@ namespace pcl
       void
       setNumberOfNeighbours (unsigned int neighbour_number);
 
+      /** \brief Returns true if the neighbours of all points are searched once and stored before growing the regions. */
+      bool
+      getStoreNeighbours () const;
+
+      /** \brief Allows to choose whether the neighbours of all points are searched once and stored before growing
+        * the regions (the default), or searched again whenever a point is visited. Storing them takes
+        * 4 * neighbour_number bytes per point, searching them on demand takes no memory but is slower since
+        * the points are usually visited several times.
+        * \param[in] value true to store the neighbours, false to search them on demand
+        */
+      void
+      setStoreNeighbours (bool value);
+
+      /** \brief Returns the number of threads used to search the neighbours and sort the seeds. */
+      unsigned int
+      getNumberOfThreads () const;
+
+      /** \brief Allows to set the number of threads used to search and store the neighbours of the points
+        * and to sort the seed points by curvature. The regions themselves are grown serially, so the
+        * segmentation does not depend on the number of threads. The search method has to support
+        * concurrent searches.
+        * \param[in] nr_threads the number of threads to use (0 to use all available cores)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads = 0);
+
       /** \brief Returns the pointer to the search method that is used for KNN. */
       KdTreePtr
       getSearchMethod () const;
@@ -246,6 +272,32 @@ namespace pcl
       virtual void
       findPointNeighbours ();
 
+      /** \brief This method finds the given number of nearest neighbours of every point in parallel and stores them
+        * in point_neighbour_indices_, in the layout described there.
+        * \param[in] nr_neighbours the number of neighbours to find for every point
+        * \param[out] distances if not null, the squared distances of the neighbours, in the same layout
+        */
+      void
+      storePointNeighbours (unsigned int nr_neighbours, std::vector<float> *distances);
+
+      /** \brief This method returns the neighbours of a point, the stored ones or, if they are not stored, neighbour_number_
+        * neighbours searched now.
+        * \param[in] point index of the point in the input cloud
+        * \param[out] neighbours pointer to the first neighbour of the point
+        * \param[out] buffer storage for the searched neighbours, \a neighbours points into it if they are not stored
+        * \param[out] distances storage for the squared distances of the searched neighbours
+        * \return the number of neighbours of the point
+        */
+      std::size_t
+      getPointNeighbours (index_t point, const index_t* &neighbours, Indices &buffer, std::vector<float> &distances) const;
+
+      /** \brief This method returns a copy of the neighbours of a point, the stored ones or, if they are not stored,
+        * neighbour_number_ neighbours searched now. It replaces the removed point_neighbours_[point].
+        * \param[in] point index of the point in the input cloud
+        */
+      Indices
+      getPointNeighbours (index_t point) const;
+
       /** \brief This function implements the algorithm described in the article
         * "Segmentation of point clouds using smoothness constraint"
         * by T. Rabbania, F. A. van den Heuvelb, G. Vosselmanc.
@@ -311,8 +363,18 @@ namespace pcl
       /** \brief Contains normals of the points that will be segmented. */
       NormalPtr normals_;
 
-      /** \brief Contains neighbours of each point. */
-      std::vector<std::vector<int> > point_neighbours_;
+      /** \brief If set to true then the neighbours of all points are searched once and stored in point_neighbour_indices_. */
+      bool store_neighbours_;
+
+      /** \brief The number of threads used to search the neighbours and sort the seeds. */
+      unsigned int threads_;
+
+      /** \brief Contains the neighbours of all points, one after the other (compressed sparse rows). The neighbours
+        * of the point i of the input cloud are the ones in [point_neighbour_offsets_[i], point_neighbour_offsets_[i + 1]). */
+      Indices point_neighbour_indices_;
+
+      /** \brief Position of the neighbours of every point of the input cloud in point_neighbour_indices_, followed by their total number. */
+      std::vector<std::size_t> point_neighbour_offsets_;
 
       /** \brief Point labels that tells to which segment each point belongs. */
       std::vector<int> point_labels_;
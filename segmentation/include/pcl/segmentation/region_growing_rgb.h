@@ -73,7 +73,9 @@ namespace pcl
       using RegionGrowing<PointT, NormalT>::smooth_mode_flag_;
       using RegionGrowing<PointT, NormalT>::theta_threshold_;
       using RegionGrowing<PointT, NormalT>::curvature_threshold_;
-      using RegionGrowing<PointT, NormalT>::point_neighbours_;
+      using RegionGrowing<PointT, NormalT>::store_neighbours_;
+      using RegionGrowing<PointT, NormalT>::point_neighbour_indices_;
+      using RegionGrowing<PointT, NormalT>::point_neighbour_offsets_;
       using RegionGrowing<PointT, NormalT>::point_labels_;
       using RegionGrowing<PointT, NormalT>::num_pts_in_segment_;
       using RegionGrowing<PointT, NormalT>::clusters_;
@@ -180,6 +182,8 @@ namespace pcl
 
     protected:
 
+      using RegionGrowing<PointT, NormalT>::storePointNeighbours;
+
       /** \brief This method simply checks if it is possible to execute the segmentation algorithm with
         * the current settings. If it is possible then it returns true.
         */
@@ -263,7 +267,13 @@ namespace pcl
       /** \brief Number of neighbouring segments to find. */
       unsigned int region_neighbour_number_;
 
-      /** \brief Stores distances for the point neighbours from point_neighbours_ */
+      /** \brief Stores distances for the point neighbours from point_neighbour_indices_, in the same layout */
+      std::vector<float> point_neighbour_distances_;
+
+      /** \brief Stores distances for the point neighbours of each point of the input cloud.
+        * \deprecated The region merging reads the distances from point_neighbour_distances_, this copy is
+        * only filled for subclasses and will be removed in PCL 1.14.
+        */
       std::vector< std::vector<float> > point_distances_;
 
       /** \brief Stores the neighboures for the corresponding segments. */
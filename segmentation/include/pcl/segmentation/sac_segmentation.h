@@ -98,6 +98,7 @@ namespace pcl
         , threads_ (-1)
         , probability_ (0.99)
         , random_ (random)
+        , min_inliers_ (0)
       {
       }
 
@@ -243,6 +244,16 @@ namespace pcl
       inline double 
       getEpsAngle () const { return (eps_angle_); }
 
+      /** \brief Set the minimum number of inliers of a model extracted by \ref segmentModels.
+        * \param[in] min_inliers the minimum number of inliers (0 uses the sample size of the model)
+        */
+      inline void
+      setMinInliers (unsigned int min_inliers) { min_inliers_ = min_inliers; }
+
+      /** \brief Get the minimum number of inliers of a model extracted by \ref segmentModels. */
+      inline unsigned int
+      getMinInliers () const { return (min_inliers_); }
+
       /** \brief Base method for segmentation of a model in a PointCloud given by <setInputCloud (), setIndices ()>
         * \param[out] inliers the resultant point indices that support the model found (inliers)
         * \param[out] model_coefficients the resultant model coefficients
@@ -250,6 +261,25 @@ namespace pcl
       virtual void 
       segment (PointIndices &inliers, ModelCoefficients &model_coefficients);
 
+      /** \brief Segment several models of the same type in a PointCloud given by <setInputCloud (), setIndices ()>.
+        *
+        * This replaces the usual loop of \ref segment calls followed by the removal of the inliers with ExtractIndices.
+        * The points that are not explained yet are kept in an index list, the input cloud is never copied. Every round
+        * draws \ref setMaxIterations samples and evaluates the hypotheses in parallel. The hypotheses are then kept
+        * greedily, by their number of inliers that are not explained by a better one yet. The kept models are refined in
+        * parallel (see \ref setOptimizeCoefficients), every point is given to the best model it is close to, and their
+        * inliers are removed before the next round. The extraction stops when no hypothesis has \ref setMinInliers
+        * inliers anymore, or when \a max_models models were found.
+        *
+        * \param[out] inliers the inliers of every model found
+        * \param[out] model_coefficients the coefficients of every model found, in the same order
+        * \param[in] max_models the maximum number of models to extract (0 for no limit)
+        * \note Hypotheses are scored by their number of inliers, as in RANSAC, whatever the method type. The number of
+        * threads is given by \ref setNumberOfThreads.
+        */
+      void
+      segmentModels (std::vector<PointIndices> &inliers, std::vector<ModelCoefficients> &model_coefficients, unsigned int max_models = 0);
+
     protected:
       /** \brief Initialize the Sample Consensus model and set its parameters.
         * \param[in] model_type the type of SAC model that is to be used
@@ -308,6 +338,9 @@ namespace pcl
       /** \brief Set to true if we need a random seed. */
       bool random_;
 
+      /** \brief The minimum number of inliers of a model extracted by segmentModels (user given parameter). */
+      unsigned int min_inliers_;
+
       /** \brief Class get name method. */
       virtual std::string 
       getClassName () const { return ("SACSegmentation"); }
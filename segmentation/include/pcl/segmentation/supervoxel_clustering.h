@@ -242,6 +242,21 @@ namespace pcl
       void
       setUseSingleCameraTransform (bool val);
 
+      /** \brief Set the number of threads to use
+       *  \note The adjacency octree, the voxel data, the normals and the refinement of the supervoxels are computed in
+       *  parallel with the same result. With more than one thread the supervoxels are also expanded in parallel rounds:
+       *  every supervoxel first evaluates its neighboring voxels, then each contested voxel goes to the closest
+       *  supervoxel (the one with the lowest label on ties). The result differs slightly from the serial expansion, but
+       *  does not depend on the number of threads.
+       *  \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+       */
+      void
+      setNumberOfThreads (unsigned int nr_threads = 0);
+
+      /** \brief Get the number of threads to use */
+      unsigned int
+      getNumberOfThreads () const;
+
       /** \brief This method launches the segmentation algorithm and returns the supervoxels that were
        * obtained during the segmentation.
        * \param[out] supervoxel_clusters A map of labels to pointers to supervoxel structures
@@ -334,6 +349,10 @@ namespace pcl
       void
       expandSupervoxels (int depth);
 
+      /** \brief This performs the superpixel evolution in parallel rounds, see \ref setNumberOfThreads */
+      void
+      expandSupervoxelsParallel (int depth);
+
       /** \brief This sets the data of the voxels in the tree */
       void
       computeVoxelData ();
@@ -387,6 +406,20 @@ namespace pcl
       /** \brief Whether to use default transform behavior or not */
       bool use_default_transform_behaviour_;
 
+      /** \brief The number of threads the scheduler should use */
+      unsigned int threads_;
+
+      /** \brief The leaves of the adjacency octree, indexed by VoxelData::idx_ */
+      LeafVectorT voxel_leaves_;
+
+      /** \brief The neighbors of every leaf (the leaf itself included), as indices into voxel_leaves_, one leaf after
+       *  the other. The neighbors of leaf i are the ones in [leaf_neighbor_offsets_[i], leaf_neighbor_offsets_[i + 1]).
+       */
+      Indices leaf_neighbors_;
+
+      /** \brief Position of the neighbors of every leaf in leaf_neighbors_, followed by their total number */
+      std::vector<std::size_t> leaf_neighbor_offsets_;
+
       /** \brief Internal storage class for supervoxels
        * \note Stores pointers to leaves of clustering internal octree,
        * \note so should not be used outside of clustering class
@@ -427,6 +460,12 @@ namespace pcl
           void
           expand ();
 
+          /** \brief Find the neighboring voxels that this supervoxel could take over, with their distance to its
+           *  centroid, without changing anything
+           */
+          void
+          findExpansionCandidates (std::vector<std::pair<index_t, float> > &candidates) const;
+
           void
           refineNormals ();
 
@@ -0,0 +1,488 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2020-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pcl/segmentation/max_flow_graph.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+  /** \brief Move the negative part of each terminal capacity to the other terminal, an edge from the source of
+    * capacity -c being an edge of capacity c to the sink. Their difference does not change.
+    */
+  inline void
+  normalizeTerminalCapacities (double &source, double &sink)
+  {
+    const double negative_source = std::max (0.0, -source);
+    const double negative_sink = std::max (0.0, -sink);
+    source = std::max (0.0, source) + negative_sink;
+    sink = std::max (0.0, sink) + negative_source;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+pcl::segmentation::MaxFlowGraph::MaxFlowGraph () :
+  time_ (0),
+  arcs_are_valid_ (false),
+  flow_ (0.0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::segmentation::MaxFlowGraph::reserve (std::size_t nodes, std::size_t edges)
+{
+  source_capacities_.reserve (nodes);
+  sink_capacities_.reserve (nodes);
+  edge_nodes_.reserve (2 * edges);
+  edge_capacities_.reserve (2 * edges);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::segmentation::MaxFlowGraph::clear ()
+{
+  source_capacities_.clear ();
+  sink_capacities_.clear ();
+  edge_nodes_.clear ();
+  edge_capacities_.clear ();
+  arcs_are_valid_ = false;
+  flow_ = 0.0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::segmentation::MaxFlowGraph::addNodes (std::size_t n)
+{
+  const int first = static_cast<int> (source_capacities_.size ());
+  source_capacities_.resize (source_capacities_.size () + n, 0.0);
+  sink_capacities_.resize (sink_capacities_.size () + n, 0.0);
+  arcs_are_valid_ = false;
+  return (first);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::segmentation::MaxFlowGraph::addEdge (int u, int v, double cap_uv, double cap_vu)
+{
+  const int edge = static_cast<int> (getNumberOfEdges ());
+  edge_nodes_.push_back (u);
+  edge_nodes_.push_back (v);
+  edge_capacities_.push_back (cap_uv);
+  edge_capacities_.push_back (cap_vu);
+  arcs_are_valid_ = false;
+  return (edge);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::segmentation::MaxFlowGraph::setEdgeCapacities (int edge, double cap_uv, double cap_vu)
+{
+  edge_capacities_[2 * edge] = cap_uv;
+  edge_capacities_[2 * edge + 1] = cap_vu;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::segmentation::MaxFlowGraph::addTerminalWeights (int u, double source_capacity, double sink_capacity)
+{
+  source_capacities_[u] += source_capacity;
+  sink_capacities_[u] += sink_capacity;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::segmentation::MaxFlowGraph::setTerminalWeights (int u, double source_capacity, double sink_capacity)
+{
+  source_capacities_[u] = source_capacity;
+  sink_capacities_[u] = sink_capacity;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+double
+pcl::segmentation::MaxFlowGraph::getEdgeResidualCapacity (int edge) const
+{
+  return (arc_residuals_[edge_arcs_[edge]]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+double
+pcl::segmentation::MaxFlowGraph::getReverseEdgeResidualCapacity (int edge) const
+{
+  return (arc_residuals_[arc_sisters_[edge_arcs_[edge]]]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+double
+pcl::segmentation::MaxFlowGraph::getSourceResidualCapacity (int u) const
+{
+  // The flow through both terminal edges is min (source, sink), plus what was pushed from the source
+  double source = source_capacities_[u], sink = sink_capacities_[u];
+  normalizeTerminalCapacities (source, sink);
+  return (source - std::min (source, sink) - std::max (0.0, (source - sink) - terminal_residuals_[u]));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+double
+pcl::segmentation::MaxFlowGraph::getSinkResidualCapacity (int u) const
+{
+  double source = source_capacities_[u], sink = sink_capacities_[u];
+  normalizeTerminalCapacities (source, sink);
+  return (sink - std::min (source, sink) - std::max (0.0, terminal_residuals_[u] - (source - sink)));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::segmentation::MaxFlowGraph::buildArcs ()
+{
+  if (arcs_are_valid_)
+    return;
+
+  const std::size_t number_of_nodes = getNumberOfNodes ();
+  const std::size_t number_of_edges = getNumberOfEdges ();
+
+  // Count the arcs of every node, then place them
+  node_arcs_.assign (number_of_nodes + 1, 0);
+  for (const auto &node : edge_nodes_)
+    ++node_arcs_[node + 1];
+  for (std::size_t i = 0; i < number_of_nodes; ++i)
+    node_arcs_[i + 1] += node_arcs_[i];
+
+  std::vector<std::size_t> next_arc (node_arcs_.begin (), node_arcs_.end () - 1);
+  edge_arcs_.resize (number_of_edges);
+  arc_heads_.resize (2 * number_of_edges);
+  arc_sisters_.resize (2 * number_of_edges);
+  for (std::size_t edge = 0; edge < number_of_edges; ++edge)
+  {
+    const int u = edge_nodes_[2 * edge];
+    const int v = edge_nodes_[2 * edge + 1];
+    const int forward = static_cast<int> (next_arc[u]++);
+    const int reverse = static_cast<int> (next_arc[v]++);
+    arc_heads_[forward] = v;
+    arc_heads_[reverse] = u;
+    arc_sisters_[forward] = reverse;
+    arc_sisters_[reverse] = forward;
+    edge_arcs_[edge] = forward;
+  }
+  arc_residuals_.resize (2 * number_of_edges);
+  arcs_are_valid_ = true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::segmentation::MaxFlowGraph::initialize ()
+{
+  const std::size_t number_of_nodes = getNumberOfNodes ();
+  for (std::size_t edge = 0; edge < edge_arcs_.size (); ++edge)
+  {
+    arc_residuals_[edge_arcs_[edge]] = edge_capacities_[2 * edge];
+    arc_residuals_[arc_sisters_[edge_arcs_[edge]]] = edge_capacities_[2 * edge + 1];
+  }
+
+  // Only the difference of the terminal capacities needs to go through the graph
+  flow_ = 0.0;
+  terminal_residuals_.resize (number_of_nodes);
+  parents_.assign (number_of_nodes, NO_PARENT);
+  in_sink_tree_.assign (number_of_nodes, 0);
+  is_active_.assign (number_of_nodes, 0);
+  timestamps_.assign (number_of_nodes, 0);
+  distances_.assign (number_of_nodes, 0);
+  active_.clear ();
+  orphans_.clear ();
+  time_ = 0;
+  for (std::size_t u = 0; u < number_of_nodes; ++u)
+  {
+    double source = source_capacities_[u], sink = sink_capacities_[u];
+    normalizeTerminalCapacities (source, sink);
+    flow_ += std::min (source, sink);
+    terminal_residuals_[u] = source - sink;
+    if (terminal_residuals_[u] != 0.0)
+    {
+      parents_[u] = TERMINAL;
+      in_sink_tree_[u] = terminal_residuals_[u] < 0.0;
+      distances_[u] = 1;
+      setActive (static_cast<int> (u));
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+double
+pcl::segmentation::MaxFlowGraph::solve ()
+{
+  buildArcs ();
+  initialize ();
+
+  int current = NO_PARENT;
+  while (true)
+  {
+    // Keep growing from the same node as long as it finds paths
+    int u = current;
+    if (u >= 0)
+    {
+      is_active_[u] = 0;
+      if (parents_[u] == NO_PARENT)
+        u = NO_PARENT;
+    }
+    while (u < 0 && !active_.empty ())
+    {
+      u = active_.front ();
+      active_.pop_front ();
+      is_active_[u] = 0;
+      if (parents_[u] == NO_PARENT)
+        u = NO_PARENT;
+    }
+    if (u < 0)
+      break;
+
+    const int middle_arc = grow (u);
+    ++time_;
+
+    if (middle_arc >= 0)
+    {
+      // Prevent u from being queued again while it is the current node
+      is_active_[u] = 1;
+      current = u;
+      augment (middle_arc);
+      while (!orphans_.empty ())
+      {
+        const int orphan = orphans_.front ();
+        orphans_.pop_front ();
+        adopt (orphan);
+      }
+    }
+    else
+      current = NO_PARENT;
+  }
+
+  return (flow_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::segmentation::MaxFlowGraph::grow (int u)
+{
+  const bool sink = in_sink_tree_[u];
+  for (std::size_t a = node_arcs_[u]; a < node_arcs_[u + 1]; ++a)
+  {
+    const int arc = static_cast<int> (a);
+    const int sister = arc_sisters_[arc];
+    // The residual capacity away from the root of the tree
+    if ((sink ? arc_residuals_[sister] : arc_residuals_[arc]) <= 0.0)
+      continue;
+
+    const int v = arc_heads_[arc];
+    if (parents_[v] == NO_PARENT)
+    {
+      // Free node, it joins the tree
+      in_sink_tree_[v] = sink;
+      parents_[v] = sister;
+      timestamps_[v] = timestamps_[u];
+      distances_[v] = distances_[u] + 1;
+      setActive (v);
+    }
+    else if (in_sink_tree_[v] != sink)
+    {
+      // The trees touch, return the arc from the source tree to the sink tree
+      return (sink ? sister : arc);
+    }
+    else if (timestamps_[v] <= timestamps_[u] && distances_[v] > distances_[u])
+    {
+      // Shorten the path of v to the terminal
+      parents_[v] = sister;
+      timestamps_[v] = timestamps_[u];
+      distances_[v] = distances_[u] + 1;
+    }
+  }
+  return (NO_PARENT);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::segmentation::MaxFlowGraph::augment (int middle_arc)
+{
+  // Find the bottleneck capacity
+  double bottleneck = arc_residuals_[middle_arc];
+  int u = arc_heads_[arc_sisters_[middle_arc]];
+  for (int arc = parents_[u]; arc != TERMINAL; arc = parents_[u])
+  {
+    bottleneck = std::min (bottleneck, arc_residuals_[arc_sisters_[arc]]);
+    u = arc_heads_[arc];
+  }
+  bottleneck = std::min (bottleneck, terminal_residuals_[u]);
+  u = arc_heads_[middle_arc];
+  for (int arc = parents_[u]; arc != TERMINAL; arc = parents_[u])
+  {
+    bottleneck = std::min (bottleneck, arc_residuals_[arc]);
+    u = arc_heads_[arc];
+  }
+  bottleneck = std::min (bottleneck, -terminal_residuals_[u]);
+
+  // Push the flow, the nodes whose arc to their parent is saturated become orphans
+  arc_residuals_[arc_sisters_[middle_arc]] += bottleneck;
+  arc_residuals_[middle_arc] -= bottleneck;
+
+  u = arc_heads_[arc_sisters_[middle_arc]];
+  for (int arc = parents_[u]; arc != TERMINAL; arc = parents_[u])
+  {
+    arc_residuals_[arc] += bottleneck;
+    arc_residuals_[arc_sisters_[arc]] -= bottleneck;
+    const int parent = arc_heads_[arc];
+    if (arc_residuals_[arc_sisters_[arc]] <= 0.0)
+    {
+      parents_[u] = ORPHAN;
+      orphans_.push_front (u);
+    }
+    u = parent;
+  }
+  terminal_residuals_[u] -= bottleneck;
+  if (terminal_residuals_[u] <= 0.0)
+  {
+    parents_[u] = ORPHAN;
+    orphans_.push_front (u);
+  }
+
+  u = arc_heads_[middle_arc];
+  for (int arc = parents_[u]; arc != TERMINAL; arc = parents_[u])
+  {
+    arc_residuals_[arc_sisters_[arc]] += bottleneck;
+    arc_residuals_[arc] -= bottleneck;
+    const int parent = arc_heads_[arc];
+    if (arc_residuals_[arc] <= 0.0)
+    {
+      parents_[u] = ORPHAN;
+      orphans_.push_front (u);
+    }
+    u = parent;
+  }
+  terminal_residuals_[u] += bottleneck;
+  if (terminal_residuals_[u] >= 0.0)
+  {
+    parents_[u] = ORPHAN;
+    orphans_.push_front (u);
+  }
+
+  flow_ += bottleneck;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::segmentation::MaxFlowGraph::adopt (int u)
+{
+  const bool sink = in_sink_tree_[u];
+  const int infinite_distance = std::numeric_limits<int>::max ();
+
+  // Look for the neighbor of the same tree that is the closest to the terminal
+  int best_arc = NO_PARENT;
+  int best_distance = infinite_distance;
+  for (std::size_t a = node_arcs_[u]; a < node_arcs_[u + 1]; ++a)
+  {
+    const int arc = static_cast<int> (a);
+    // The residual capacity towards the root of the tree
+    if ((sink ? arc_residuals_[arc] : arc_residuals_[arc_sisters_[arc]]) <= 0.0)
+      continue;
+    const int v = arc_heads_[arc];
+    if (parents_[v] == NO_PARENT || static_cast<bool> (in_sink_tree_[v]) != sink)
+      continue;
+
+    // Check that v is connected to the terminal, and find its distance to it
+    int distance = 0;
+    for (int w = v; ; )
+    {
+      if (timestamps_[w] == time_)
+      {
+        distance += distances_[w];
+        break;
+      }
+      const int parent_arc = parents_[w];
+      ++distance;
+      if (parent_arc == TERMINAL)
+      {
+        timestamps_[w] = time_;
+        distances_[w] = 1;
+        break;
+      }
+      if (parent_arc == ORPHAN)
+      {
+        distance = infinite_distance;
+        break;
+      }
+      w = arc_heads_[parent_arc];
+    }
+
+    if (distance < infinite_distance)
+    {
+      if (distance < best_distance)
+      {
+        best_arc = arc;
+        best_distance = distance;
+      }
+      // Remember the distances along the path for the next checks
+      for (int w = v; timestamps_[w] != time_; w = arc_heads_[parents_[w]])
+      {
+        timestamps_[w] = time_;
+        distances_[w] = distance--;
+      }
+    }
+  }
+
+  if (best_arc != NO_PARENT)
+  {
+    parents_[u] = best_arc;
+    timestamps_[u] = time_;
+    distances_[u] = best_distance + 1;
+    return;
+  }
+
+  // No parent was found, u becomes free and its children orphans
+  parents_[u] = NO_PARENT;
+  for (std::size_t a = node_arcs_[u]; a < node_arcs_[u + 1]; ++a)
+  {
+    const int arc = static_cast<int> (a);
+    const int v = arc_heads_[arc];
+    if (parents_[v] == NO_PARENT || static_cast<bool> (in_sink_tree_[v]) != sink)
+      continue;
+    if ((sink ? arc_residuals_[arc] : arc_residuals_[arc_sisters_[arc]]) > 0.0)
+      setActive (v);
+    const int parent_arc = parents_[v];
+    if (parent_arc != TERMINAL && parent_arc != ORPHAN && arc_heads_[parent_arc] == u)
+    {
+      parents_[v] = ORPHAN;
+      orphans_.push_back (v);
+    }
+  }
+}
@@ -49,6 +49,7 @@
 #include <pcl/filters/sampling_surface_normal.h>
 #include <pcl/filters/voxel_grid.h>
 #include <pcl/filters/voxel_grid_covariance.h>
+#include <pcl/filters/voxel_grid_occlusion_estimation.h>
 #include <pcl/filters/extract_indices.h>
 #include <pcl/filters/project_inliers.h>
 #include <pcl/filters/radius_outlier_removal.h>
@@ -1325,6 +1326,55 @@ TEST (VoxelGridCovariance, Filters)
   EXPECT_NEAR (leaves[2]->getMean ()[2], 0.0508024, 1e-4);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (VoxelGridOcclusionEstimation, Filters)
+{
+  // The sensor looks at the bunny from behind
+  PointCloud<PointXYZ>::Ptr input (new PointCloud<PointXYZ> (*cloud));
+  input->sensor_origin_ = Eigen::Vector4f (0.0f, 0.1f, -0.5f, 0.0f);
+
+  VoxelGridOcclusionEstimation<PointXYZ> grid;
+  grid.setInputCloud (input);
+  grid.setLeafSize (0.01f, 0.01f, 0.01f);
+  grid.initializeVoxelGrid ();
+
+  // Reference states of all voxels, one ray at a time
+  std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> > voxels, expected_occluded;
+  std::vector<int> expected_states;
+  const Eigen::Vector3i min_b = grid.getMinBoxCoordinates ();
+  const Eigen::Vector3i max_b = grid.getMaxBoxCoordinates ();
+  for (int k = min_b.z (); k <= max_b.z (); ++k)
+    for (int j = min_b.y (); j <= max_b.y (); ++j)
+      for (int i = min_b.x (); i <= max_b.x (); ++i)
+      {
+        const Eigen::Vector3i ijk (i, j, k);
+        int state;
+        ASSERT_EQ (0, grid.occlusionEstimation (state, ijk));
+        voxels.push_back (ijk);
+        expected_states.push_back (state);
+        if (state == 1 && grid.getCentroidIndexAt (ijk) == -1)
+          expected_occluded.push_back (ijk);
+      }
+  EXPECT_FALSE (expected_occluded.empty ());
+  EXPECT_LT (expected_occluded.size (), voxels.size ());
+
+  // The batch and the parallel estimation give the same states
+  for (const unsigned int threads : {1u, 4u})
+  {
+    grid.setNumberOfThreads (threads);
+
+    std::vector<int> states;
+    ASSERT_EQ (0, grid.occlusionEstimation (states, voxels));
+    EXPECT_EQ (expected_states, states);
+
+    std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> > occluded;
+    ASSERT_EQ (0, grid.occlusionEstimationAll (occluded));
+    ASSERT_EQ (expected_occluded.size (), occluded.size ());
+    for (std::size_t i = 0; i < occluded.size (); ++i)
+      EXPECT_EQ (expected_occluded[i], occluded[i]);
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (ProjectInliers, Filters)
 {
@@ -43,6 +43,9 @@
 #include <pcl/filters/morphological_filter.h>
 #include <pcl/point_types.h>
 
+#include <cmath>
+#include <limits>
+
 using namespace pcl;
 
 PointCloud<PointXYZ> cloud;
@@ -157,6 +160,61 @@ TEST (Morphological, Unsupported)
   EXPECT_EQ (cloud_in.size (), cloud_out.size ());
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Erosion or dilation of a grid, by looking at every cell of the window
+Eigen::MatrixXf
+bruteForceExtremum (const Eigen::MatrixXf &grid, int half_size, bool erode)
+{
+  Eigen::MatrixXf result (grid.rows (), grid.cols ());
+  for (Eigen::Index row = 0; row < grid.rows (); ++row)
+    for (Eigen::Index col = 0; col < grid.cols (); ++col)
+    {
+      float value = std::numeric_limits<float>::quiet_NaN ();
+      for (Eigen::Index j = std::max<Eigen::Index> (row - half_size, 0); j <= std::min<Eigen::Index> (row + half_size, grid.rows () - 1); ++j)
+        for (Eigen::Index k = std::max<Eigen::Index> (col - half_size, 0); k <= std::min<Eigen::Index> (col + half_size, grid.cols () - 1); ++k)
+          if (!std::isnan (grid (j, k)) && (std::isnan (value) || (erode ? grid (j, k) < value : grid (j, k) > value)))
+            value = grid (j, k);
+      result (row, col) = value;
+    }
+  return (result);
+}
+
+// Whether two grids hold the same values, and are empty at the same cells
+bool
+gridsEqual (const Eigen::MatrixXf &a, const Eigen::MatrixXf &b)
+{
+  return ((a.array () == b.array () || (a.array ().isNaN () && b.array ().isNaN ())).all ());
+}
+
+TEST (Morphological, Grid)
+{
+  Eigen::MatrixXf grid = Eigen::MatrixXf::Random (37, 23);
+  for (Eigen::Index i = 0; i < grid.size (); i += 7)
+    grid.data ()[i] = std::numeric_limits<float>::quiet_NaN ();
+  // A corner without any data
+  grid.topLeftCorner (5, 6).setConstant (std::numeric_limits<float>::quiet_NaN ());
+
+  for (int half_size = 0; half_size < 5; ++half_size)
+  {
+    const Eigen::MatrixXf eroded = bruteForceExtremum (grid, half_size, true);
+    const Eigen::MatrixXf dilated = bruteForceExtremum (grid, half_size, false);
+    const Eigen::MatrixXf opened = bruteForceExtremum (eroded, half_size, false);
+    const Eigen::MatrixXf closed = bruteForceExtremum (dilated, half_size, true);
+
+    for (const unsigned int threads : {1u, 4u})
+    {
+      Eigen::MatrixXf result;
+      applyMorphologicalOperator (grid, half_size, MORPH_ERODE, result, threads);
+      EXPECT_TRUE (gridsEqual (eroded, result));
+      applyMorphologicalOperator (grid, half_size, MORPH_DILATE, result, threads);
+      EXPECT_TRUE (gridsEqual (dilated, result));
+      applyMorphologicalOperator (grid, half_size, MORPH_OPEN, result, threads);
+      EXPECT_TRUE (gridsEqual (opened, result));
+      applyMorphologicalOperator (grid, half_size, MORPH_CLOSE, result, threads);
+      EXPECT_TRUE (gridsEqual (closed, result));
+    }
+  }
+}
 
 /* ---[ */
 int
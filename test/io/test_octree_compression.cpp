@@ -41,7 +41,11 @@
 #include <pcl/compression/octree_pointcloud_compression.h>
 #include <pcl/compression/compression_profiles.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <exception>
+#include <limits>
 
 int total_runs = 0;
 
@@ -52,6 +56,19 @@ char* pcd_file;
 #define MAX_COLOR 255
 #define NUMBER_OF_TEST_RUNS 2
 
+// Input stream buffer which can not seek, like the ones of sockets and pipes
+class SequentialBuffer : public std::streambuf
+{
+public:
+  explicit SequentialBuffer(const std::string& data) : data_(data)
+  {
+    setg(&data_[0], &data_[0], &data_[0] + data_.size());
+  }
+
+private:
+  std::string data_;
+};
+
 TEST (PCL, OctreeDeCompressionRandomPointXYZRGBA)
 {
   srand(static_cast<unsigned int> (time(NULL)));
@@ -153,6 +170,165 @@ TEST (PCL, OctreeDeCompressionRandomPointXYZ)
   } // compression profiles
 } // TEST
 
+TEST (PCL, OctreeDeCompressionRansPointXYZ)
+{
+  srand(static_cast<unsigned int> (time(NULL)));
+
+  // instantiate point cloud compression encoder/decoder, the decoder detects the entropy coder of each frame
+  pcl::io::OctreePointCloudCompression<pcl::PointXYZ> pointcloud_encoder(pcl::io::MANUAL_CONFIGURATION, false, 0.001, 0.01, false, 30, false);
+  pcl::io::OctreePointCloudCompression<pcl::PointXYZ> pointcloud_decoder;
+  pointcloud_decoder.setRansEncoding(false);
+  pcl::PointCloud<pcl::PointXYZ>::Ptr cloud_out(new pcl::PointCloud<pcl::PointXYZ>());
+
+  // alternate between rANS and static range coded frames
+  for (int test_idx = 0; test_idx < 2 * NUMBER_OF_TEST_RUNS; test_idx++)
+  {
+    pointcloud_encoder.setRansEncoding(test_idx % 2 == 0);
+
+    int point_count = MAX_POINTS * rand() / RAND_MAX + 1;
+    pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>());
+    for (int point = 0; point < point_count; point++)
+    {
+      pcl::PointXYZ new_point(static_cast<float> (MAX_XYZ * rand() / RAND_MAX),
+                             static_cast<float> (MAX_XYZ * rand() / RAND_MAX),
+                             static_cast<float> (MAX_XYZ * rand() / RAND_MAX));
+      cloud->push_back(new_point);
+    }
+
+    std::stringstream compressed_data;
+    pointcloud_encoder.encodePointCloud(cloud, compressed_data);
+    pointcloud_decoder.decodePointCloud(compressed_data, cloud_out);
+    EXPECT_EQ(cloud->size(), cloud_out->size());
+  }
+} // TEST
+
+TEST (PCL, OctreeDeCompressionChunkedPointXYZRGBA)
+{
+  // fixed seed, the clouds have to be large enough to be split into several chunks
+  srand(5489u);
+
+  // iterate over all pre-defined compression profiles
+  for (int compression_profile = pcl::io::LOW_RES_ONLINE_COMPRESSION_WITHOUT_COLOR;
+        compression_profile != pcl::io::COMPRESSION_PROFILE_COUNT; ++compression_profile)
+  {
+    // instantiate point cloud compression encoder/decoder
+    pcl::io::OctreePointCloudCompression<pcl::PointXYZRGBA> pointcloud_encoder((pcl::io::compression_Profiles_e) compression_profile, false);
+    pcl::io::OctreePointCloudCompression<pcl::PointXYZRGBA> pointcloud_decoder;
+    pointcloud_encoder.setNumberOfThreads(4);
+    pointcloud_decoder.setNumberOfThreads(4);
+    for (int test_idx = 0; test_idx < NUMBER_OF_TEST_RUNS; test_idx++, total_runs++)
+    {
+      int point_count = 1000 + static_cast<int> ((MAX_POINTS - 1000) * rand() / RAND_MAX);
+      pcl::PointCloud<pcl::PointXYZRGBA>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGBA>());
+      for (int point = 0; point < point_count; point++)
+      {
+        pcl::PointXYZRGBA new_point;
+        new_point.x = static_cast<float> (MAX_XYZ * rand() / RAND_MAX);
+        new_point.y = static_cast<float> (MAX_XYZ * rand() / RAND_MAX);
+        new_point.z = static_cast<float> (MAX_XYZ * rand() / RAND_MAX);
+        new_point.rgba = static_cast<std::uint32_t> (rand());
+        cloud->push_back(new_point);
+      }
+      pointcloud_encoder.setChunkDepth(test_idx + 1);
+      pcl::octree::OctreePointCloudSearch<pcl::PointXYZRGBA> input_search(16.0);
+      input_search.setInputCloud(cloud);
+      input_search.addPointsFromInputCloud();
+
+      std::stringstream compressed_data;
+      pointcloud_encoder.encodePointCloudChunked(cloud, compressed_data);
+      const std::string compressed_string = compressed_data.str();
+
+      // chunks decoded in parallel
+      pcl::PointCloud<pcl::PointXYZRGBA>::Ptr cloud_out(new pcl::PointCloud<pcl::PointXYZRGBA>());
+      pointcloud_decoder.decodePointCloudChunked(compressed_data, cloud_out);
+      ASSERT_GT(cloud_out->size(), 0u);
+      if (!pcl::io::compressionProfiles_[compression_profile].doVoxelGridDownSampling)
+      {
+        EXPECT_EQ(cloud->size(), cloud_out->size());
+      }
+      EXPECT_EQ(cloud_out->width, cloud_out->size());
+      EXPECT_EQ(1u, cloud_out->height);
+
+      // every decoded point is an input point, up to the precision of the coordinates and the colors
+      const pcl::io::configurationProfile_t& profile = pcl::io::compressionProfiles_[compression_profile];
+      const double max_error = std::sqrt(3.0) * std::max(profile.pointResolution, profile.octreeResolution);
+      const std::uint8_t color_mask = static_cast<std::uint8_t>(0xFF << (8 - profile.colorBitResolution));
+      pcl::Indices nearest(1);
+      std::vector<float> nearest_sqr_distance(1);
+      for (const auto& point : *cloud_out)
+      {
+        ASSERT_EQ(1, input_search.nearestKSearch(point, 1, nearest, nearest_sqr_distance));
+        EXPECT_LE(std::sqrt(nearest_sqr_distance[0]), max_error);
+        if (profile.doColorEncoding)
+        {
+          const pcl::PointXYZRGBA& input_point = (*cloud)[nearest[0]];
+          EXPECT_EQ(input_point.r & color_mask, point.r);
+          EXPECT_EQ(input_point.g & color_mask, point.g);
+          EXPECT_EQ(input_point.b & color_mask, point.b);
+        }
+      }
+
+      // streams which can not seek are decoded as well
+      SequentialBuffer sequential_buffer(compressed_string);
+      std::istream sequential_data(&sequential_buffer);
+      pcl::PointCloud<pcl::PointXYZRGBA>::Ptr sequential_out(new pcl::PointCloud<pcl::PointXYZRGBA>());
+      pointcloud_decoder.decodePointCloudChunked(sequential_data, sequential_out);
+      ASSERT_EQ(cloud_out->size(), sequential_out->size());
+      for (std::size_t i = 0; i < cloud_out->size(); i++)
+        EXPECT_EQ((*cloud_out)[i].getVector3fMap(), (*sequential_out)[i].getVector3fMap());
+
+      // chunks decoded one by one from the index give the same points
+      std::istringstream chunked_data(compressed_string);
+      std::vector<pcl::io::OctreePointCloudCompression<pcl::PointXYZRGBA>::ChunkInfo> chunks;
+      ASSERT_TRUE(pointcloud_decoder.readChunkIndex(chunked_data, chunks));
+      ASSERT_GT(chunks.size(), 1u);
+      std::size_t point_idx = 0;
+      for (auto chunk = chunks.rbegin(); chunk != chunks.rend(); ++chunk)
+      {
+        pcl::PointCloud<pcl::PointXYZRGBA>::Ptr chunk_out(new pcl::PointCloud<pcl::PointXYZRGBA>());
+        pointcloud_decoder.decodePointCloudChunk(chunked_data, *chunk, chunk_out);
+        EXPECT_EQ(chunk->point_count, chunk_out->size());
+        point_idx += chunk_out->size();
+        // chunks are stored in the order of the index, the last one ends the cloud
+        const std::size_t chunk_begin = cloud_out->size() - point_idx;
+        for (std::size_t i = 0; i < chunk_out->size(); i++)
+        {
+          EXPECT_EQ((*cloud_out)[chunk_begin + i].getVector3fMap(), (*chunk_out)[i].getVector3fMap());
+          EXPECT_EQ((*cloud_out)[chunk_begin + i].rgba, (*chunk_out)[i].rgba);
+        }
+      }
+      EXPECT_EQ(cloud_out->size(), point_idx);
+
+      // truncated and corrupt frames are rejected
+      const std::size_t index_begin = std::strlen("<PCL-OCT-CHUNKED>");
+      std::istringstream truncated_index_data(compressed_string.substr(0, index_begin + sizeof(std::uint32_t) + 1));
+      EXPECT_FALSE(pointcloud_decoder.readChunkIndex(truncated_index_data, chunks));
+      EXPECT_TRUE(chunks.empty());
+      pcl::PointCloud<pcl::PointXYZRGBA>::Ptr rejected_out(new pcl::PointCloud<pcl::PointXYZRGBA>());
+      std::istringstream truncated_data(compressed_string.substr(0, compressed_string.size() - 1));
+      pointcloud_decoder.decodePointCloudChunked(truncated_data, rejected_out);
+      EXPECT_TRUE(rejected_out->empty());
+      std::string corrupt_string = compressed_string;
+      const std::uint32_t nr_chunks = std::numeric_limits<std::uint32_t>::max();
+      corrupt_string.replace(index_begin, sizeof(nr_chunks), reinterpret_cast<const char*>(&nr_chunks), sizeof(nr_chunks));
+      std::istringstream corrupt_count_data(corrupt_string);
+      EXPECT_FALSE(pointcloud_decoder.readChunkIndex(corrupt_count_data, chunks));
+      corrupt_string = compressed_string;
+      const std::uint64_t chunk_size = std::numeric_limits<std::uint64_t>::max() / 2;
+      corrupt_string.replace(index_begin + sizeof(std::uint32_t) + 3 * sizeof(std::uint32_t) + sizeof(std::uint64_t),
+                             sizeof(chunk_size), reinterpret_cast<const char*>(&chunk_size), sizeof(chunk_size));
+      SequentialBuffer corrupt_size_buffer(corrupt_string);
+      std::istream corrupt_size_data(&corrupt_size_buffer);
+      pointcloud_decoder.decodePointCloudChunked(corrupt_size_data, rejected_out);
+      EXPECT_TRUE(rejected_out->empty());
+      std::istringstream corrupt_chunk_data(corrupt_string);
+      ASSERT_TRUE(pointcloud_decoder.readChunkIndex(corrupt_chunk_data, chunks));
+      pointcloud_decoder.decodePointCloudChunk(corrupt_chunk_data, chunks[0], rejected_out);
+      EXPECT_TRUE(rejected_out->empty());
+    } // runs
+  } // compression profiles
+} // TEST
+
 TEST(PCL, OctreeDeCompressionFile)
 {
   pcl::PointCloud<pcl::PointXYZRGB>::Ptr input_cloud_ptr (new pcl::PointCloud<pcl::PointXYZRGB>);
@@ -167,6 +167,48 @@ TEST (PCL, Static_Range_Coder_Test)
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, Interleaved_Rans_Coder_Test)
+{
+  // Run test for different vector sizes, including sizes that are no multiple of the number of states
+  for (unsigned int vectorSize: { 0, 1, 3, 253, 10000 })
+  {
+    std::stringstream sstream;
+    std::vector<char> inputRandomData (vectorSize);
+    std::vector<char> inputSkewedData (vectorSize);
+    std::vector<char> outputRandomData (vectorSize);
+    std::vector<char> outputSkewedData (vectorSize);
+
+    // fill vectors with uniformly distributed and with highly skewed random data
+    for (std::size_t i=0; i<vectorSize; i++)
+    {
+      inputRandomData[i] = static_cast<char> (rand () & 0xFF);
+      inputSkewedData[i] = static_cast<char> ((rand () % 100) ? 0 : (rand () & 0x07));
+    }
+
+    // initialize rANS coder
+    pcl::InterleavedRansCoder ransCoder;
+
+    // encode both char vectors to the same stringstream
+    unsigned long writeByteLen = ransCoder.encodeCharVectorToStream(inputRandomData, sstream);
+    writeByteLen += ransCoder.encodeCharVectorToStream(inputSkewedData, sstream);
+
+    // decode stringstream to char vectors
+    unsigned long readByteLen = ransCoder.decodeStreamToCharVector(sstream, outputRandomData);
+    readByteLen += ransCoder.decodeStreamToCharVector(sstream, outputSkewedData);
+
+    // compare amount of bytes that are read and written to/from stream
+    EXPECT_EQ (writeByteLen, readByteLen);
+    EXPECT_EQ (writeByteLen, sstream.str().length());
+
+    // compare input and output vectors - should be identical
+    for (std::size_t i=0; i<vectorSize; i++)
+    {
+      EXPECT_EQ (inputRandomData[i], outputRandomData[i]);
+      EXPECT_EQ (inputSkewedData[i], outputSkewedData[i]);
+    }
+  }
+}
 
 /* ---[ */
 int
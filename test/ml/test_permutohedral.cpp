@@ -0,0 +1,98 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2020-, Open Perception
+ *
+ *  All rights reserved
+ */
+#include <pcl/test/gtest.h>
+#include <pcl/common/random.h>
+#include <pcl/ml/permutohedral.h>
+
+using namespace pcl;
+using namespace pcl::common;
+
+// Features of the pixels of an image with a random color, as for a bilateral kernel
+std::vector<float>
+createFeatures (int width, int height, int& dimension)
+{
+  UniformGenerator<float> engine (0.0f, 255.0f, 2021);
+  dimension = 5;
+  std::vector<float> feature;
+  for (int y = 0; y < height; ++y)
+    for (int x = 0; x < width; ++x)
+    {
+      feature.push_back (static_cast<float> (x) / 3.0f);
+      feature.push_back (static_cast<float> (y) / 3.0f);
+      for (int c = 0; c < 3; ++c)
+        feature.push_back (engine.run () / 20.0f);
+    }
+  return feature;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (Permutohedral, Neighbors)
+{
+  int d;
+  const std::vector<float> feature = createFeatures (40, 30, d);
+  Permutohedral lattice;
+  lattice.init (feature, d, 40 * 30);
+  ASSERT_GT (lattice.M_, 0);
+  ASSERT_EQ ((d + 1) * lattice.M_, lattice.blur_neighbors_.size ());
+
+  // Neighbors along an axis go both ways
+  for (int j = 0; j <= d; ++j)
+    for (int i = 0; i < lattice.M_; ++i)
+    {
+      const int n1 = lattice.blur_neighbors_[j * lattice.M_ + i].n1;
+      if (n1 >= 0)
+        EXPECT_EQ (i, lattice.blur_neighbors_[j * lattice.M_ + n1].n2);
+      const int n2 = lattice.blur_neighbors_[j * lattice.M_ + i].n2;
+      if (n2 >= 0)
+        EXPECT_EQ (i, lattice.blur_neighbors_[j * lattice.M_ + n2].n1);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (Permutohedral, Threads)
+{
+  int d;
+  const int N = 40 * 30;
+  const std::vector<float> feature = createFeatures (40, 30, d);
+  UniformGenerator<float> engine (-1.0f, 1.0f, 2022);
+  std::vector<float> in (3 * N);
+  for (auto& v : in)
+    v = engine.run ();
+
+  Permutohedral lattice;
+  lattice.init (feature, d, N);
+  std::vector<float> out (3 * N);
+  lattice.compute (out, in, 3);
+
+  Permutohedral lattice_mt;
+  lattice_mt.setNumberOfThreads (4);
+  EXPECT_EQ (4, lattice_mt.getNumberOfThreads ());
+  lattice_mt.init (feature, d, N);
+  EXPECT_EQ (lattice.M_, lattice_mt.M_);
+  EXPECT_EQ (lattice.offset_, lattice_mt.offset_);
+  EXPECT_EQ (lattice.barycentric_, lattice_mt.barycentric_);
+  std::vector<float> out_mt (3 * N);
+  lattice_mt.compute (out_mt, in, 3);
+  EXPECT_EQ (out, out_mt);
+
+  // Filtering a subset of the features
+  std::vector<float> part (3 * 100), part_mt (3 * 100);
+  lattice.compute (part, in, 3, 200, 500, 400, 100);
+  lattice_mt.compute (part_mt, in, 3, 200, 500, 400, 100);
+  EXPECT_EQ (part, part_mt);
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  testing::InitGoogleTest (&argc, argv);
+  return (RUN_ALL_TESTS ());
+}
+/* ]--- */
@@ -38,6 +38,7 @@
  */
 #include <pcl/test/gtest.h>
 
+#include <algorithm>
 #include <vector>
 
 #include <pcl/common/time.h>
@@ -1022,6 +1023,71 @@ TEST (PCL, Octree_Pointcloud_Change_Detector_Test)
   }
 }
 
+TEST (PCL, Octree_Pointcloud_Stream_Change_Detector_Test)
+{
+  constexpr unsigned int test_runs = 10;
+
+  srand (static_cast<unsigned int> (time (nullptr)));
+
+  for (unsigned int test_id = 0; test_id < test_runs; test_id++)
+  {
+    // two frames, the second one partially overlapping the first one
+    PointCloud<PointXYZ>::Ptr cloudA (new PointCloud<PointXYZ> ());
+    PointCloud<PointXYZ>::Ptr cloudB (new PointCloud<PointXYZ> ());
+    for (std::size_t i = 0; i < 1000; i++)
+    {
+      const PointXYZ point (static_cast<float> (5.0 * rand () / RAND_MAX),
+                            static_cast<float> (10.0 * rand () / RAND_MAX),
+                            static_cast<float> (10.0 * rand () / RAND_MAX));
+      cloudA->push_back (point);
+      if (i % 2)
+        cloudB->push_back (point);
+      else
+        cloudB->push_back (PointXYZ (point.x + 2.0f, point.y, point.z));
+    }
+    // a point outside of the bounding box is ignored
+    cloudB->push_back (PointXYZ (50.0f, 0.0f, 0.0f));
+
+    OctreePointCloudStreamChangeDetector<PointXYZ> stream (0.5);
+    stream.defineBoundingBox (Eigen::Vector3d (0.0, 0.0, 0.0), Eigen::Vector3d (10.0, 10.0, 10.0));
+    stream.setNumberOfThreads (test_id % 4 + 1);
+
+    std::vector<int> newPointIdxVector;
+    ASSERT_EQ (0u, stream.getPointIndicesFromNewVoxels (newPointIdxVector));
+
+    // all points of the first frame are new
+    stream.addFrame (cloudA);
+    ASSERT_EQ (cloudA->size (), stream.getPointIndicesFromNewVoxels (newPointIdxVector));
+
+    // the frame being built does not change the published ones
+    OctreePointCloudStreamChangeDetector<PointXYZ>::OctreePtr frameA = stream.getCurrentFrame ();
+    OctreePointCloudStreamChangeDetector<PointXYZ>::OctreePtr frameB = stream.buildFrame (cloudB);
+    ASSERT_EQ (frameA, stream.getCurrentFrame ());
+    stream.publishFrame (frameB);
+    ASSERT_EQ (frameA, stream.getPreviousFrame ());
+    ASSERT_EQ (frameB, stream.getCurrentFrame ());
+
+    // same result as the double buffered change detector
+    OctreePointCloudChangeDetector<PointXYZ> octree (0.5);
+    octree.defineBoundingBox (0.0, 0.0, 0.0, 10.0, 10.0, 10.0);
+    octree.setInputCloud (cloudA);
+    octree.addPointsFromInputCloud ();
+    octree.switchBuffers ();
+    cloudB->resize (cloudA->size ());
+    octree.setInputCloud (cloudB);
+    octree.addPointsFromInputCloud ();
+
+    for (const int min_points : {0, 3})
+    {
+      std::vector<int> expected;
+      octree.getPointIndicesFromNewVoxels (expected, min_points);
+      newPointIdxVector.clear ();
+      stream.getPointIndicesFromNewVoxels (newPointIdxVector, min_points);
+      ASSERT_EQ (expected, newPointIdxVector);
+    }
+  }
+}
+
 TEST (PCL, Octree_Pointcloud_Voxel_Centroid_Test)
 {
 
@@ -1529,6 +1595,308 @@ TEST (PCL, Octree_Pointcloud_Ray_Traversal)
   }
 }
 
+TEST (PCL, Octree_Pointcloud_Ray_Traversal_Batch)
+{
+  constexpr unsigned int nr_rays = 500;
+
+  PointCloud<PointXYZ>::Ptr cloudIn (new PointCloud<PointXYZ> ());
+  cloudIn->width = 2000;
+  cloudIn->height = 1;
+  cloudIn->points.resize (cloudIn->width * cloudIn->height);
+
+  srand (static_cast<unsigned int> (time (nullptr)));
+
+  for (auto& point : cloudIn->points)
+    point = PointXYZ (static_cast<float> (10.0 * rand () / RAND_MAX),
+                      static_cast<float> (10.0 * rand () / RAND_MAX),
+                      static_cast<float> (10.0 * rand () / RAND_MAX));
+
+  octree::OctreePointCloudSearch<PointXYZ> octree_search (0.5f);
+  octree_search.setInputCloud (cloudIn);
+  octree_search.addPointsFromInputCloud ();
+  octree_search.setNumberOfThreads (4);
+
+  std::vector<Eigen::Vector3f> origins (nr_rays), directions (nr_rays);
+  for (unsigned int i = 0; i < nr_rays; i++)
+  {
+    origins[i] = Eigen::Vector3f (static_cast<float> (12.0 * rand () / RAND_MAX) - 1.0f,
+                                  static_cast<float> (12.0 * rand () / RAND_MAX) - 1.0f,
+                                  static_cast<float> (12.0 * rand () / RAND_MAX) - 1.0f);
+    directions[i] = Eigen::Vector3f (static_cast<float> (2.0 * rand () / RAND_MAX - 1.0),
+                                     static_cast<float> (2.0 * rand () / RAND_MAX - 1.0),
+                                     static_cast<float> (2.0 * rand () / RAND_MAX - 1.0));
+  }
+
+  for (const int max_voxel_count : {0, 3})
+  {
+    std::vector<pcl::PointCloud<pcl::PointXYZ>::VectorType> voxels_batch;
+    std::vector<std::vector<int>> indices_batch;
+    const int voxel_count = octree_search.getIntersectedVoxelCentersBatch (origins, directions, voxels_batch, max_voxel_count);
+    ASSERT_EQ (voxel_count, octree_search.getIntersectedVoxelIndicesBatch (origins, directions, indices_batch, max_voxel_count));
+    ASSERT_EQ (nr_rays, voxels_batch.size ());
+    ASSERT_EQ (nr_rays, indices_batch.size ());
+
+    // every ray of the batch matches the ray traced on its own
+    int total_count = 0;
+    for (unsigned int i = 0; i < nr_rays; i++)
+    {
+      pcl::PointCloud<pcl::PointXYZ>::VectorType voxels;
+      std::vector<int> indices;
+      total_count += octree_search.getIntersectedVoxelCenters (origins[i], directions[i], voxels, max_voxel_count);
+      octree_search.getIntersectedVoxelIndices (origins[i], directions[i], indices, max_voxel_count);
+      ASSERT_EQ (voxels.size (), voxels_batch[i].size ());
+      for (std::size_t j = 0; j < voxels.size (); j++)
+        ASSERT_EQ (voxels[j].getVector3fMap (), voxels_batch[i][j].getVector3fMap ());
+      ASSERT_EQ (indices, indices_batch[i]);
+    }
+    ASSERT_EQ (total_count, voxel_count);
+  }
+}
+
+TEST (PCL, Octree_Pointcloud_Linear_Search)
+{
+  constexpr unsigned int test_runs = 10;
+  constexpr unsigned int query_runs = 20;
+
+  PointCloud<PointXYZ>::Ptr cloudIn (new PointCloud<PointXYZ> ());
+
+  srand (static_cast<unsigned int> (time (nullptr)));
+
+  for (unsigned int test_id = 0; test_id < test_runs; test_id++)
+  {
+    // clustered points, so that leaves hold several points and branches are sparse
+    cloudIn->width = 1000 + rand () % 1000;
+    cloudIn->height = 1;
+    cloudIn->points.resize (cloudIn->width * cloudIn->height);
+    for (auto& point : cloudIn->points)
+      point = PointXYZ (static_cast<float> (2.0 * rand () / RAND_MAX) * static_cast<float> (rand () % 5),
+                        static_cast<float> (10.0 * rand () / RAND_MAX),
+                        static_cast<float> (5.0 * rand () / RAND_MAX));
+
+    // a linear octree fits its bounding box to the cloud
+    OctreePointCloudSearch<PointXYZ> octree_fitted (0.1);
+    octree_fitted.setInputCloud (cloudIn);
+    octree_fitted.buildLinearOctree ();
+    ASSERT_TRUE (octree_fitted.isLinearOctree ());
+    std::vector<int> voxel_indices;
+    for (std::size_t i = 0; i < cloudIn->size (); i++)
+      ASSERT_TRUE (octree_fitted.voxelSearch ((*cloudIn)[i], voxel_indices));
+
+    // both octrees share the same bounding box, so that they have the same voxels
+    OctreePointCloudSearch<PointXYZ> octree_pointer (0.1);
+    octree_pointer.defineBoundingBox (-1.0, -1.0, -1.0, 11.0, 11.0, 11.0);
+    octree_pointer.setInputCloud (cloudIn);
+    octree_pointer.addPointsFromInputCloud ();
+
+    OctreePointCloudSearch<PointXYZ> octree_linear (0.1);
+    octree_linear.defineBoundingBox (-1.0, -1.0, -1.0, 11.0, 11.0, 11.0);
+    octree_linear.setNumberOfThreads (test_id % 4 + 1);
+    octree_linear.setInputCloud (cloudIn);
+    octree_linear.buildLinearOctree ();
+    ASSERT_TRUE (octree_linear.isLinearOctree ());
+    ASSERT_EQ (octree_pointer.getTreeDepth (), octree_linear.getTreeDepth ());
+
+    for (unsigned int query_id = 0; query_id < query_runs; query_id++)
+    {
+      const PointXYZ query (static_cast<float> (12.0 * rand () / RAND_MAX) - 1.0f,
+                            static_cast<float> (12.0 * rand () / RAND_MAX) - 1.0f,
+                            static_cast<float> (7.0 * rand () / RAND_MAX) - 1.0f);
+
+      std::vector<int> indices_pointer, indices_linear;
+      std::vector<float> distances_pointer, distances_linear;
+
+      // k nearest neighbours
+      const int k = 1 + rand () % 20;
+      octree_pointer.nearestKSearch (query, k, indices_pointer, distances_pointer);
+      octree_linear.nearestKSearch (query, k, indices_linear, distances_linear);
+      ASSERT_EQ (indices_pointer, indices_linear);
+      ASSERT_EQ (distances_pointer, distances_linear);
+
+      // radius search, with and without a maximum number of neighbours
+      const double radius = 2.0 * rand () / RAND_MAX;
+      octree_pointer.radiusSearch (query, radius, indices_pointer, distances_pointer);
+      octree_linear.radiusSearch (query, radius, indices_linear, distances_linear);
+      ASSERT_EQ (indices_pointer, indices_linear);
+      ASSERT_EQ (distances_pointer, distances_linear);
+      octree_pointer.radiusSearch (query, radius, indices_pointer, distances_pointer, 5);
+      octree_linear.radiusSearch (query, radius, indices_linear, distances_linear, 5);
+      ASSERT_EQ (indices_pointer, indices_linear);
+
+      // approximate nearest neighbour
+      int index_pointer = -1, index_linear = -1;
+      float distance_pointer = 0.0f, distance_linear = 0.0f;
+      octree_pointer.approxNearestSearch (query, index_pointer, distance_pointer);
+      octree_linear.approxNearestSearch (query, index_linear, distance_linear);
+      ASSERT_EQ (index_pointer, index_linear);
+      ASSERT_EQ (distance_pointer, distance_linear);
+
+      // box search
+      const Eigen::Vector3f min_pt = query.getVector3fMap ();
+      const Eigen::Vector3f max_pt = min_pt + Eigen::Vector3f::Constant (static_cast<float> (3.0 * rand () / RAND_MAX));
+      octree_pointer.boxSearch (min_pt, max_pt, indices_pointer);
+      octree_linear.boxSearch (min_pt, max_pt, indices_linear);
+      ASSERT_EQ (indices_pointer, indices_linear);
+
+      // voxel search
+      const int index = rand () % static_cast<int> (cloudIn->size ());
+      indices_pointer.clear ();
+      indices_linear.clear ();
+      ASSERT_TRUE (octree_pointer.voxelSearch ((*cloudIn)[index], indices_pointer));
+      ASSERT_TRUE (octree_linear.voxelSearch ((*cloudIn)[index], indices_linear));
+      ASSERT_EQ (indices_pointer, indices_linear);
+
+      // ray traversal
+      const Eigen::Vector3f direction (static_cast<float> (2.0 * rand () / RAND_MAX - 1.0),
+                                       static_cast<float> (2.0 * rand () / RAND_MAX - 1.0),
+                                       static_cast<float> (2.0 * rand () / RAND_MAX - 1.0));
+      const int max_voxels = rand () % 2 ? 0 : 1 + rand () % 10;
+      pcl::PointCloud<pcl::PointXYZ>::VectorType centers_pointer, centers_linear;
+      ASSERT_EQ (octree_pointer.getIntersectedVoxelCenters (min_pt, direction, centers_pointer, max_voxels),
+                 octree_linear.getIntersectedVoxelCenters (min_pt, direction, centers_linear, max_voxels));
+      ASSERT_EQ (centers_pointer.size (), centers_linear.size ());
+      for (std::size_t i = 0; i < centers_pointer.size (); i++)
+        ASSERT_EQ (centers_pointer[i].getVector3fMap (), centers_linear[i].getVector3fMap ());
+      ASSERT_EQ (octree_pointer.getIntersectedVoxelIndices (min_pt, direction, indices_pointer, max_voxels),
+                 octree_linear.getIntersectedVoxelIndices (min_pt, direction, indices_linear, max_voxels));
+      ASSERT_EQ (indices_pointer, indices_linear);
+    }
+
+    // a linear octree is only built on an empty octree
+    octree_pointer.buildLinearOctree ();
+    ASSERT_FALSE (octree_pointer.isLinearOctree ());
+    octree_linear.deleteTree ();
+    ASSERT_FALSE (octree_linear.isLinearOctree ());
+
+    // it is deleted when the input changes or the tree is deleted through the base
+    // class, added points go to the pointer based octree along with all others
+    octree_linear.buildLinearOctree ();
+    ASSERT_TRUE (octree_linear.isLinearOctree ());
+    octree_linear.setInputCloud (cloudIn);
+    ASSERT_FALSE (octree_linear.isLinearOctree ());
+    octree_linear.buildLinearOctree ();
+    ASSERT_TRUE (octree_linear.isLinearOctree ());
+    octree_linear.addPointToCloud (PointXYZ (12.0f, 12.0f, 12.0f), cloudIn);
+    ASSERT_FALSE (octree_linear.isLinearOctree ());
+    for (std::size_t i = 0; i < cloudIn->size (); i++)
+    {
+      voxel_indices.clear ();
+      ASSERT_TRUE (octree_linear.voxelSearch ((*cloudIn)[i], voxel_indices));
+      ASSERT_NE (voxel_indices.end (), std::find (voxel_indices.begin (), voxel_indices.end (), static_cast<int> (i)));
+    }
+    std::vector<int> k_indices;
+    std::vector<float> k_distances;
+    ASSERT_EQ (cloudIn->size (), octree_linear.nearestKSearch (PointXYZ (0.0f, 0.0f, 0.0f), static_cast<int> (cloudIn->size ()), k_indices, k_distances));
+    OctreePointCloud<PointXYZ>& octree_base = octree_linear;
+    octree_base.deleteTree ();
+    octree_linear.buildLinearOctree ();
+    ASSERT_TRUE (octree_linear.isLinearOctree ());
+    octree_base.deleteTree ();
+    ASSERT_FALSE (octree_linear.isLinearOctree ());
+    octree_base.setInputCloud (cloudIn);
+    octree_linear.buildLinearOctree ();
+    ASSERT_TRUE (octree_linear.isLinearOctree ());
+    octree_base.setInputCloud (cloudIn);
+    ASSERT_FALSE (octree_linear.isLinearOctree ());
+  }
+}
+
+TEST (PCL, Octree_Pointcloud_Frustum_Search)
+{
+  constexpr unsigned int test_runs = 10;
+
+  PointCloud<PointXYZ>::Ptr cloudIn (new PointCloud<PointXYZ> ());
+
+  srand (static_cast<unsigned int> (time (nullptr)));
+
+  for (unsigned int test_id = 0; test_id < test_runs; test_id++)
+  {
+    cloudIn->width = 2000;
+    cloudIn->height = 1;
+    cloudIn->points.resize (cloudIn->width * cloudIn->height);
+    for (auto& point : cloudIn->points)
+      point = PointXYZ (static_cast<float> (10.0 * rand () / RAND_MAX),
+                        static_cast<float> (10.0 * rand () / RAND_MAX),
+                        static_cast<float> (10.0 * rand () / RAND_MAX));
+
+    // camera looking along +x with a 60 degree field of view, planes pointing inwards
+    const Eigen::Vector3f eye (-2.0f,
+                               static_cast<float> (10.0 * rand () / RAND_MAX),
+                               static_cast<float> (10.0 * rand () / RAND_MAX));
+    const float t = std::tan (static_cast<float> (M_PI) / 6.0f);
+    std::vector<Eigen::Vector4f> planes;
+    planes.emplace_back (1.0f, 0.0f, 0.0f, -eye.x () - 1.0f);
+    planes.emplace_back (-1.0f, 0.0f, 0.0f, eye.x () + 9.0f);
+    planes.emplace_back (t, -1.0f, 0.0f, eye.y () - t * eye.x ());
+    planes.emplace_back (t, 1.0f, 0.0f, -eye.y () - t * eye.x ());
+    planes.emplace_back (t, 0.0f, -1.0f, eye.z () - t * eye.x ());
+    planes.emplace_back (t, 0.0f, 1.0f, -eye.z () - t * eye.x ());
+
+    std::vector<int> expected;
+    for (std::size_t i = 0; i < cloudIn->size (); i++)
+    {
+      const Eigen::Vector4f pt ((*cloudIn)[i].x, (*cloudIn)[i].y, (*cloudIn)[i].z, 1.0f);
+      bool inside = true;
+      for (const auto& plane : planes)
+        inside = inside && (plane.dot (pt) >= 0);
+      if (inside)
+        expected.push_back (static_cast<int> (i));
+    }
+
+    OctreePointCloudSearch<PointXYZ> octree_pointer (0.5);
+    octree_pointer.setInputCloud (cloudIn);
+    octree_pointer.addPointsFromInputCloud ();
+
+    std::vector<int> k_indices;
+    ASSERT_EQ (expected.size (), octree_pointer.frustumSearch (planes, k_indices));
+    std::sort (k_indices.begin (), k_indices.end ());
+    ASSERT_EQ (expected, k_indices);
+
+    OctreePointCloudSearch<PointXYZ> octree_linear (0.5);
+    octree_linear.setNumberOfThreads (test_id % 4 + 1);
+    octree_linear.setInputCloud (cloudIn);
+    octree_linear.buildLinearOctree ();
+    const std::vector<int>& linear_indices = octree_linear.getLinearIndices ();
+
+    using IndexRange = OctreePointCloudSearch<PointXYZ>::IndexRange;
+    std::vector<IndexRange> ranges;
+    ASSERT_EQ (expected.size (), octree_linear.frustumSearch (planes, ranges));
+    k_indices.clear ();
+    for (std::size_t i = 0; i < ranges.size (); i++)
+    {
+      ASSERT_LT (ranges[i].first, ranges[i].second);
+      if (i > 0)
+      {
+        ASSERT_LT (ranges[i - 1].second, ranges[i].first);
+      }
+      k_indices.insert (k_indices.end (), linear_indices.begin () + ranges[i].first, linear_indices.begin () + ranges[i].second);
+    }
+    std::sort (k_indices.begin (), k_indices.end ());
+    ASSERT_EQ (expected, k_indices);
+
+    ASSERT_EQ (expected.size (), octree_linear.frustumSearch (planes, k_indices));
+    std::sort (k_indices.begin (), k_indices.end ());
+    ASSERT_EQ (expected, k_indices);
+
+    // without screen space error the level of detail search returns all points
+    std::vector<IndexRange> lod_ranges;
+    ASSERT_EQ (expected.size (), octree_linear.frustumSearchLOD (planes, eye, 500.0f, 0.0f, lod_ranges));
+    ASSERT_EQ (ranges, lod_ranges);
+
+    // coarser levels of detail return fewer points, all of them inside the frustum
+    std::size_t previous_size = expected.size ();
+    for (const float max_pixel_size : {10.0f, 50.0f, 200.0f})
+    {
+      const std::size_t lod_size = octree_linear.frustumSearchLOD (planes, eye, 500.0f, max_pixel_size, lod_ranges);
+      ASSERT_LE (lod_size, previous_size);
+      ASSERT_EQ (expected.empty (), lod_size == 0);
+      for (const IndexRange& range : lod_ranges)
+        for (std::uint32_t i = range.first; i < range.second; i++)
+          ASSERT_TRUE (std::binary_search (expected.begin (), expected.end (), linear_indices[i]));
+      previous_size = lod_size;
+    }
+  }
+}
+
 TEST (PCL, Octree_Pointcloud_Adjacency)
 {
   constexpr unsigned int test_runs = 100;
@@ -1600,6 +1968,95 @@ TEST (PCL, Octree_Pointcloud_Adjacency)
   }
 }
 
+TEST (PCL, Octree_Pointcloud_Adjacency_Flat)
+{
+  constexpr unsigned int test_runs = 5;
+  const double resolution = 0.1;
+
+  srand (static_cast<unsigned int> (time (nullptr)));
+
+  for (unsigned int test_id = 0; test_id < test_runs; test_id++)
+  {
+    PointCloud<PointXYZ>::Ptr cloudIn (new PointCloud<PointXYZ> ());
+    for (int i = 0; i < 2000; ++i)
+      cloudIn->push_back (PointXYZ (static_cast<float> (1.0 * rand () / RAND_MAX),
+                                    static_cast<float> (1.0 * rand () / RAND_MAX),
+                                    static_cast<float> (1.0 * rand () / RAND_MAX)));
+
+    OctreePointCloudAdjacency<PointXYZ> octree (resolution);
+    octree.setInputCloud (cloudIn);
+    octree.setNumberOfThreads (4);
+    EXPECT_EQ (4, octree.getNumberOfThreads ());
+    octree.addPointsFromInputCloud ();
+
+    // the flat neighbors do not depend on the number of threads nor on the neighbor lists
+    OctreePointCloudAdjacency<PointXYZ> octree_serial (resolution);
+    octree_serial.setInputCloud (cloudIn);
+    octree_serial.setStoreContainerNeighbors (false);
+    EXPECT_FALSE (octree_serial.getStoreContainerNeighbors ());
+    octree_serial.addPointsFromInputCloud ();
+
+    const Indices &neighbors = octree.getNeighborIndices ();
+    const std::vector<std::size_t> &offsets = octree.getNeighborOffsets ();
+    ASSERT_EQ (octree.size () + 1, offsets.size ());
+    ASSERT_EQ (neighbors.size (), offsets.back ());
+    EXPECT_EQ (neighbors, octree_serial.getNeighborIndices ());
+    EXPECT_EQ (offsets, octree_serial.getNeighborOffsets ());
+
+    // so does the adjacency graph, one undirected edge per pair of neighbors and one loop per leaf
+    OctreePointCloudAdjacency<PointXYZ>::VoxelAdjacencyList graph, graph_serial;
+    octree.computeVoxelAdjacencyGraph (graph);
+    octree_serial.computeVoxelAdjacencyGraph (graph_serial);
+    EXPECT_EQ (octree.size (), boost::num_vertices (graph));
+    EXPECT_EQ ((neighbors.size () + octree.size ()) / 2, boost::num_edges (graph));
+    EXPECT_EQ (boost::num_vertices (graph), boost::num_vertices (graph_serial));
+    EXPECT_EQ (boost::num_edges (graph), boost::num_edges (graph_serial));
+
+    // the leaf vector is in depth first order
+    std::vector<OctreeKey> keys;
+    for (auto leaf_itr = octree.leaf_depth_begin (); leaf_itr != octree.leaf_depth_end (); ++leaf_itr)
+      keys.push_back (leaf_itr.getCurrentOctreeKey ());
+    ASSERT_EQ (octree.size (), keys.size ());
+
+    for (std::size_t i = 0; i < octree.size (); ++i)
+    {
+      // same neighbors, in the same order, as the neighbor list of the container
+      ASSERT_EQ (octree.at (i)->size (), offsets[i + 1] - offsets[i]);
+      EXPECT_EQ (0, octree_serial.at (i)->size ());
+      auto neighbor_itr = octree.at (i)->cbegin ();
+      for (std::size_t n = offsets[i]; n < offsets[i + 1]; ++n, ++neighbor_itr)
+        EXPECT_EQ (octree.at (neighbors[n]), *neighbor_itr);
+
+      // all touching leaves, the leaf itself included
+      Indices expected;
+      for (std::size_t j = 0; j < keys.size (); ++j)
+      {
+        auto touching = [] (unsigned int a, unsigned int b) { return ((a > b ? a - b : b - a) <= 1); };
+        if (touching (keys[i].x, keys[j].x) && touching (keys[i].y, keys[j].y) && touching (keys[i].z, keys[j].z))
+          expected.push_back (static_cast<index_t> (j));
+      }
+      Indices found (neighbors.begin () + offsets[i], neighbors.begin () + offsets[i + 1]);
+      std::sort (found.begin (), found.end ());
+      EXPECT_EQ (expected, found);
+    }
+  }
+
+  // occlusion tests look up the leaves on the way to the camera
+  PointCloud<PointXYZ>::Ptr cloudIn (new PointCloud<PointXYZ> ());
+  cloudIn->push_back (PointXYZ (0.0f, 0.0f, 5.0f));
+  cloudIn->push_back (PointXYZ (0.0f, 0.0f, 2.5f));
+  cloudIn->push_back (PointXYZ (3.0f, 0.0f, 0.0f));
+  // define the grid
+  cloudIn->push_back (PointXYZ (-1.0f, -1.0f, -1.0f));
+  cloudIn->push_back (PointXYZ (4.0f, 1.0f, 6.0f));
+  OctreePointCloudAdjacency<PointXYZ> octree (resolution);
+  octree.setInputCloud (cloudIn);
+  octree.addPointsFromInputCloud ();
+  EXPECT_TRUE (octree.testForOcclusion ((*cloudIn)[0]));
+  EXPECT_FALSE (octree.testForOcclusion ((*cloudIn)[1]));
+  EXPECT_FALSE (octree.testForOcclusion ((*cloudIn)[2]));
+}
+
 TEST (PCL, Octree_Pointcloud_Bounds)
 {
     const double SOME_RESOLUTION (10 + 1/3.0);
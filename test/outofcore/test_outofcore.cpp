@@ -44,9 +44,14 @@
 
 #include <pcl/test/gtest.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
 #include <vector>
 #include <iostream>
 #include <random>
+#include <tuple>
 
 #include <pcl/common/time.h>
 
@@ -57,6 +62,7 @@
 #include <pcl/outofcore/outofcore_impl.h>
 
 #include <pcl/PCLPointCloud2.h>
+#include <pcl/io/pcd_io.h>
 
 using namespace pcl::outofcore;
 
@@ -940,6 +946,425 @@ TEST_F (OutofcoreTest, PointCloud2_Query)
   cleanUpFilesystem ();
 }
 
+//test that the asynchronous I/O path returns the same points as the serial queries
+TEST_F (OutofcoreTest, Outofcore_AsyncQuery)
+{
+  cleanUpFilesystem ();
+
+  const Eigen::Vector3d min (-100.1, -100.1, -100.1);
+  const Eigen::Vector3d max (100.1, 100.1, 100.1);
+
+  const std::uint64_t depth = 3;
+
+  std::mt19937 rng (rngseed);
+  std::uniform_real_distribution<float> dist (-100.0f, 100.0f);
+
+  pcl::PointCloud<PointT>::Ptr test_cloud (new pcl::PointCloud<PointT> ());
+  for (std::size_t i = 0; i < numPts; i++)
+    test_cloud->push_back (PointT (dist (rng), dist (rng), dist (rng)));
+
+  {
+    octree_disk octree_build (depth, min, max, filename_otreeA, "ECEF");
+    ASSERT_EQ (numPts, octree_build.addPointCloud (test_cloud));
+  }
+
+  //reload the tree, its payloads are read from disk on demand
+  octree_disk octreeA (filename_otreeA, false);
+
+  // partially covered nodes are filtered point wise
+  const Eigen::Vector3d query_min (-30.0, -60.0, 10.0);
+  const Eigen::Vector3d query_max (70.0, 20.0, 90.0);
+
+  // six planes of a frustum containing the whole tree
+  const double planes[24] = { 1, 0, 0, 200,  -1, 0, 0, 200,
+                              0, 1, 0, 200,   0, -1, 0, 200,
+                              0, 0, 1, 200,   0, 0, -1, 200 };
+
+  AlignedPointTVector serial_bb, serial_frustum;
+  octreeA.queryBBIncludes (query_min, query_max, depth, serial_bb);
+  octreeA.queryFrustum (planes, static_cast<std::uint32_t> (depth), serial_frustum);
+  EXPECT_GT (serial_bb.size (), 0);
+  EXPECT_EQ (numPts, serial_frustum.size ());
+
+  // tiny read ahead and cache to exercise blocking requests and eviction
+  octreeA.setAsyncIO (3, 16 * 1024, 2);
+  EXPECT_EQ (3, octreeA.getAsyncIOThreads ());
+
+  for (int run = 0; run < 2; run++)
+  {
+    AlignedPointTVector async_bb, async_frustum;
+    octreeA.queryBBIncludes (query_min, query_max, depth, async_bb);
+    octreeA.queryFrustum (planes, static_cast<std::uint32_t> (depth), async_frustum);
+
+    ASSERT_EQ (serial_bb.size (), async_bb.size ());
+    for (std::size_t i = 0; i < serial_bb.size (); i++)
+      EXPECT_TRUE (compPt (serial_bb[i], async_bb[i]));
+
+    ASSERT_EQ (serial_frustum.size (), async_frustum.size ());
+    for (std::size_t i = 0; i < serial_frustum.size (); i++)
+      EXPECT_TRUE (compPt (serial_frustum[i], async_frustum[i]));
+  }
+
+  // a frustum excluding the tree returns no points
+  const double outside_planes[24] = { 1, 0, 0, -500,  -1, 0, 0, 600,
+                                      0, 1, 0, 200,    0, -1, 0, 200,
+                                      0, 0, 1, 200,    0, 0, -1, 200 };
+  AlignedPointTVector outside;
+  octreeA.queryFrustum (outside_planes, static_cast<std::uint32_t> (depth), outside);
+  EXPECT_TRUE (outside.empty ());
+
+  // rebuilding the LOD rewrites the branch nodes with as many, but other points, the
+  // cached payloads of the previous LOD must not be returned
+  auto lod_filter = std::dynamic_pointer_cast<pcl::RandomSample<pcl::PCLPointCloud2> > (octreeA.getLODFilter ());
+  ASSERT_TRUE (lod_filter);
+  octreeA.setAsyncIO (2);
+  AlignedPointTVector first_lod, async_lod, serial_lod;
+  lod_filter->setSeed (rngseed);
+  octreeA.buildLOD ();
+  octreeA.queryBBIncludes (min, max, 1, first_lod);
+  lod_filter->setSeed (rngseed + 1);
+  octreeA.buildLOD ();
+  octreeA.queryBBIncludes (min, max, 1, async_lod);
+
+  octreeA.setAsyncIO (0);
+  EXPECT_EQ (0, octreeA.getAsyncIOThreads ());
+  octreeA.queryBBIncludes (min, max, 1, serial_lod);
+  ASSERT_EQ (first_lod.size (), serial_lod.size ());
+  EXPECT_FALSE (std::equal (first_lod.begin (), first_lod.end (), serial_lod.begin (), compPt));
+  ASSERT_EQ (serial_lod.size (), async_lod.size ());
+  for (std::size_t i = 0; i < serial_lod.size (); i++)
+    EXPECT_TRUE (compPt (serial_lod[i], async_lod[i]));
+
+  cleanUpFilesystem ();
+}
+
+TEST_F (OutofcoreTest, Outofcore_FrustumLOD)
+{
+  cleanUpFilesystem ();
+
+  const Eigen::Vector3d min (-100.1, -100.1, -100.1);
+  const Eigen::Vector3d max (100.1, 100.1, 100.1);
+
+  const std::uint64_t depth = 3;
+
+  std::mt19937 rng (rngseed);
+  std::uniform_real_distribution<float> dist (-100.0f, 100.0f);
+
+  pcl::PointCloud<PointT>::Ptr test_cloud (new pcl::PointCloud<PointT> ());
+  for (std::size_t i = 0; i < numPts; i++)
+    test_cloud->push_back (PointT (dist (rng), dist (rng), dist (rng)));
+
+  {
+    octree_disk octree_build (depth, min, max, filename_otreeA, "ECEF");
+    octree_build.addPointCloud_and_genLOD (test_cloud);
+  }
+
+  octree_disk octreeA (filename_otreeA, false);
+
+  // six planes of a frustum containing the whole tree
+  const double planes[24] = { 1, 0, 0, 200,  -1, 0, 0, 200,
+                              0, 1, 0, 200,   0, -1, 0, 200,
+                              0, 0, 1, 200,   0, 0, -1, 200 };
+  const Eigen::Vector3d eye (-300.0, 0.0, 0.0);
+
+  AlignedPointTVector leaves;
+  octreeA.queryFrustum (planes, static_cast<std::uint32_t> (depth), leaves);
+
+  // without screen space error the leaves are selected
+  AlignedPointTVector dst;
+  std::vector<std::pair<std::size_t, std::size_t> > ranges;
+  octreeA.queryFrustumLOD (planes, eye, 1000.0, 0.0, dst, ranges);
+  EXPECT_EQ (leaves.size (), dst.size ());
+
+  // a coarse enough level of detail is the root node
+  octreeA.queryFrustumLOD (planes, eye, 1000.0, 1e6, dst, ranges);
+  ASSERT_EQ (1, ranges.size ());
+  EXPECT_EQ (octreeA.getNumPointsAtDepth (0), dst.size ());
+
+  // in between, the ranges partition the points and the async query returns the same points
+  AlignedPointTVector serial;
+  std::vector<std::pair<std::size_t, std::size_t> > serial_ranges;
+  octreeA.queryFrustumLOD (planes, eye, 1000.0, 300.0, serial, serial_ranges);
+  EXPECT_GT (serial_ranges.size (), 1);
+  EXPECT_LT (serial.size (), leaves.size ());
+  std::size_t next = 0;
+  for (const auto &range : serial_ranges)
+  {
+    EXPECT_EQ (next, range.first);
+    next = range.second;
+  }
+  EXPECT_EQ (serial.size (), next);
+
+  octreeA.setAsyncIO (2, 16 * 1024, 2);
+  octreeA.queryFrustumLOD (planes, eye, 1000.0, 300.0, dst, ranges);
+  EXPECT_EQ (serial_ranges, ranges);
+  ASSERT_EQ (serial.size (), dst.size ());
+  for (std::size_t i = 0; i < serial.size (); i++)
+    EXPECT_TRUE (compPt (serial[i], dst[i]));
+  octreeA.setAsyncIO (0);
+
+  // a frustum excluding the tree returns no points
+  const double outside_planes[24] = { 1, 0, 0, -500,  -1, 0, 0, 600,
+                                      0, 1, 0, 200,    0, -1, 0, 200,
+                                      0, 0, 1, 200,    0, 0, -1, 200 };
+  octreeA.queryFrustumLOD (outside_planes, eye, 1000.0, 2000.0, dst, ranges);
+  EXPECT_TRUE (dst.empty ());
+  EXPECT_TRUE (ranges.empty ());
+
+  cleanUpFilesystem ();
+}
+
+//test that the bulk loader builds the same tree as the incremental insertion
+TEST_F (OutofcoreTest, Outofcore_BulkLoad)
+{
+  cleanUpFilesystem ();
+
+  const Eigen::Vector3d min (-100.1, -100.1, -100.1);
+  const Eigen::Vector3d max (100.1, 100.1, 100.1);
+
+  const std::uint64_t depth = 4;
+
+  std::mt19937 rng (rngseed);
+  std::uniform_real_distribution<float> dist (-100.0f, 100.0f);
+
+  pcl::PointCloud<PointT>::Ptr test_cloud (new pcl::PointCloud<PointT> ());
+  for (std::size_t i = 0; i < numPts; i++)
+    test_cloud->push_back (PointT (dist (rng), dist (rng), dist (rng)));
+
+  // points outside of the bounding box are dropped
+  pcl::PointCloud<PointT>::Ptr bulk_cloud (new pcl::PointCloud<PointT> (*test_cloud));
+  bulk_cloud->push_back (PointT (200.0f, 0.0f, 0.0f));
+  bulk_cloud->push_back (PointT (0.0f, -300.0f, 0.0f));
+
+  // the same points split over two files
+  const boost::filesystem::path pcd_dir ("bulk_load_input");
+  boost::filesystem::create_directory (pcd_dir);
+  std::vector<boost::filesystem::path> pcd_files = { pcd_dir / "first.pcd", pcd_dir / "second.pcd" };
+  pcl::PointCloud<PointT> first_half, second_half;
+  first_half.points.assign (bulk_cloud->points.begin (), bulk_cloud->points.begin () + numPts / 2);
+  second_half.points.assign (bulk_cloud->points.begin () + numPts / 2, bulk_cloud->points.end ());
+  first_half.width = static_cast<std::uint32_t> (first_half.size ());
+  first_half.height = second_half.height = 1;
+  second_half.width = static_cast<std::uint32_t> (second_half.size ());
+  pcl::io::savePCDFileBinary (pcd_files[0].string (), first_half);
+  pcl::io::savePCDFileBinary (pcd_files[1].string (), second_half);
+
+  {
+    octree_disk octree_reference (depth, min, max, filename_otreeA, "ECEF");
+    ASSERT_EQ (numPts, octree_reference.addPointCloud (test_cloud));
+
+    // tiny partitions, such that the partitions are partitioned again
+    octree_disk octree_bulk (depth, min, max, filename_otreeB, "ECEF");
+    octree_bulk.setNumberOfThreads (3);
+    octree_bulk.setBulkLoadPartitionSize (5);
+    EXPECT_EQ (3, octree_bulk.getNumberOfThreads ());
+    EXPECT_EQ (5, octree_bulk.getBulkLoadPartitionSize ());
+    ASSERT_EQ (numPts, octree_bulk.bulkLoad (bulk_cloud, true));
+
+    // only empty trees can be bulk loaded
+    EXPECT_EQ (0, octree_bulk.bulkLoad (bulk_cloud, true));
+
+    octree_disk octree_files (depth, min, max, filename_otreeA_LOD, "ECEF");
+    ASSERT_EQ (numPts, octree_files.bulkLoad (pcd_files, false));
+  }
+  boost::filesystem::remove_all (pcd_dir);
+
+  octree_disk octreeA (filename_otreeA, false);
+  octree_disk octreeB (filename_otreeB, false);
+  octree_disk octreeC (filename_otreeA_LOD, false);
+
+  auto lessPt = [] (const PointT &p1, const PointT &p2)
+  {
+    return (std::tie (p1.x, p1.y, p1.z) < std::tie (p2.x, p2.y, p2.z));
+  };
+
+  // same leaves holding the same points
+  std::vector<Eigen::Vector3d, Eigen::aligned_allocator<Eigen::Vector3d> > voxels_reference, voxels_bulk, voxels_files;
+  octreeA.getOccupiedVoxelCenters (voxels_reference);
+  octreeB.getOccupiedVoxelCenters (voxels_bulk);
+  octreeC.getOccupiedVoxelCenters (voxels_files);
+  EXPECT_EQ (voxels_reference, voxels_bulk);
+  EXPECT_EQ (voxels_reference, voxels_files);
+
+  AlignedPointTVector points_reference, points_bulk, points_files;
+  octreeA.queryBBIncludes (min, max, depth, points_reference);
+  octreeB.queryBBIncludes (min, max, depth, points_bulk);
+  octreeC.queryBBIncludes (min, max, depth, points_files);
+  ASSERT_EQ (numPts, points_reference.size ());
+  ASSERT_EQ (numPts, points_bulk.size ());
+  ASSERT_EQ (numPts, points_files.size ());
+  std::sort (points_reference.begin (), points_reference.end (), lessPt);
+  std::sort (points_bulk.begin (), points_bulk.end (), lessPt);
+  std::sort (points_files.begin (), points_files.end (), lessPt);
+  for (std::size_t i = 0; i < numPts; i++)
+  {
+    EXPECT_TRUE (compPt (points_reference[i], points_bulk[i]));
+    EXPECT_TRUE (compPt (points_reference[i], points_files[i]));
+  }
+
+  // every level holds a subsample of the level below it
+  EXPECT_EQ (numPts, octreeB.getNumPointsAtDepth (depth));
+  for (std::uint64_t d = 0; d < depth; d++)
+  {
+    EXPECT_GE (octreeB.getNumPointsAtDepth (d), 1);
+    EXPECT_LE (octreeB.getNumPointsAtDepth (d), octreeB.getNumPointsAtDepth (d + 1));
+
+    AlignedPointTVector lod;
+    octreeB.queryBBIncludes (min, max, d, lod);
+    EXPECT_EQ (octreeB.getNumPointsAtDepth (d), lod.size ());
+    for (const PointT &point : lod)
+      EXPECT_TRUE (std::binary_search (points_bulk.begin (), points_bulk.end (), point, lessPt));
+
+    EXPECT_EQ (0, octreeC.getNumPointsAtDepth (d));
+  }
+
+  cleanUpFilesystem ();
+}
+
+TEST_F (OutofcoreTest, Outofcore_PackedOctree)
+{
+  cleanUpFilesystem ();
+
+  const Eigen::Vector3d min (-100.1, -100.1, -100.1);
+  const Eigen::Vector3d max (100.1, 100.1, 100.1);
+
+  const std::uint64_t depth = 4;
+
+  std::mt19937 rng (rngseed);
+  std::uniform_real_distribution<float> dist (-100.0f, 100.0f);
+
+  pcl::PointCloud<PointT>::Ptr test_cloud (new pcl::PointCloud<PointT> ());
+  for (std::size_t i = 0; i < numPts; i++)
+    test_cloud->push_back (PointT (dist (rng), dist (rng), dist (rng)));
+
+  {
+    octree_disk octree (depth, min, max, filename_otreeA, "ECEF");
+    ASSERT_EQ (numPts, octree.bulkLoad (test_cloud, true));
+  }
+
+  const boost::filesystem::path packed_file ("tree_test.pack");
+  const boost::filesystem::path packed_raw_file ("tree_test_raw.pack");
+
+  octree_disk octree (filename_otreeA, false);
+  OutofcorePackedOctree<PointT>::convert (octree, packed_file);
+  OutofcorePackedOctree<PointT>::convert (octree, packed_raw_file, false);
+
+  OutofcorePackedOctree<PointT> packed (packed_file);
+  OutofcorePackedOctree<PointT> packed_raw (packed_raw_file);
+
+  auto lessPt = [] (const PointT &p1, const PointT &p2)
+  {
+    return (std::tie (p1.x, p1.y, p1.z) < std::tie (p2.x, p2.y, p2.z));
+  };
+
+  ASSERT_EQ (depth, packed.getDepth ());
+  ASSERT_EQ (packed.getNumberOfNodes (), packed_raw.getNumberOfNodes ());
+
+  Eigen::Vector3d packed_min, packed_max, tree_min, tree_max;
+  packed.getBoundingBox (packed_min, packed_max);
+  octree.getBoundingBox (tree_min, tree_max);
+  EXPECT_EQ (tree_min, packed_min);
+  EXPECT_EQ (tree_max, packed_max);
+
+  // the whole tree and a box cutting through the nodes, at every level of detail
+  const Eigen::Vector3d cut_min (-33.3, -50.0, -10.0);
+  const Eigen::Vector3d cut_max (60.0, 25.0, 70.0);
+  for (std::uint64_t d = 0; d <= depth; d++)
+  {
+    EXPECT_EQ (octree.getNumPointsAtDepth (d), packed.getNumPointsAtDepth (d));
+    EXPECT_EQ (octree.getNumPointsAtDepth (d), packed_raw.getNumPointsAtDepth (d));
+
+    for (const auto &box : { std::make_pair (min, max), std::make_pair (cut_min, cut_max) })
+    {
+      AlignedPointTVector points, points_packed, points_raw;
+      octree.queryBBIncludes (box.first, box.second, d, points);
+      packed.queryBBIncludes (box.first, box.second, d, points_packed);
+      packed_raw.queryBBIncludes (box.first, box.second, d, points_raw);
+      ASSERT_EQ (points.size (), points_packed.size ());
+      ASSERT_EQ (points.size (), points_raw.size ());
+
+      std::sort (points.begin (), points.end (), lessPt);
+      std::sort (points_packed.begin (), points_packed.end (), lessPt);
+      std::sort (points_raw.begin (), points_raw.end (), lessPt);
+      for (std::size_t i = 0; i < points.size (); i++)
+      {
+        EXPECT_TRUE (compPt (points[i], points_packed[i]));
+        EXPECT_TRUE (compPt (points[i], points_raw[i]));
+      }
+    }
+  }
+
+  // uncompressed points are mapped straight from the file
+  for (std::size_t i = 0; i < packed_raw.getNumberOfNodes (); i++)
+  {
+    const OutofcorePackedNode &node = packed_raw.getNode (i);
+    EXPECT_EQ (0, node.flags & OutofcorePackedNode::COMPRESSED);
+    if (node.point_count == 0)
+      continue;
+
+    const PointT* points = packed_raw.getNodePoints (i);
+    ASSERT_TRUE (points != nullptr);
+
+    AlignedPointTVector points_raw, points_packed;
+    packed_raw.readNode (i, points_raw);
+    packed.readNode (i, points_packed);
+    ASSERT_EQ (node.point_count, points_raw.size ());
+    ASSERT_EQ (node.point_count, points_packed.size ());
+    for (std::size_t j = 0; j < points_raw.size (); j++)
+    {
+      EXPECT_TRUE (compPt (points[j], points_raw[j]));
+      EXPECT_TRUE (compPt (points[j], points_packed[j]));
+    }
+  }
+  EXPECT_LT (boost::filesystem::file_size (packed_file), boost::filesystem::file_size (packed_raw_file));
+
+  // other point types and other files are refused
+  EXPECT_THROW ({ OutofcorePackedOctree<pcl::PointXYZI> packed_xyzi (packed_file); }, pcl::PCLException);
+  EXPECT_THROW ({ OutofcorePackedOctree<PointT> packed_index (filename_otreeA); }, pcl::PCLException);
+  EXPECT_THROW ({ OutofcorePackedOctree<PointT> packed_missing ("missing.pack"); }, pcl::PCLException);
+
+  // children outside of the node table, pointing back up the tree or reached twice are refused by queries
+  std::string packed_data;
+  {
+    std::ifstream in (packed_raw_file.string ().c_str (), std::ios::binary);
+    packed_data.assign (std::istreambuf_iterator<char> (in), std::istreambuf_iterator<char> ());
+  }
+  OutofcorePackedHeader header;
+  std::memcpy (&header, packed_data.data (), sizeof (header));
+  const boost::filesystem::path corrupt_file ("corrupt.pack");
+  OutofcorePackedNode root;
+  std::memcpy (&root, &packed_data[header.node_table_offset], sizeof (root));
+  const std::vector<std::pair<std::size_t, std::uint32_t> > corrupt_children = {
+    { 0, static_cast<std::uint32_t> (header.node_count) }, { 1, 1 }, { 1, *std::max_element (root.children, root.children + 8) }
+  };
+  Eigen::Vector3d min_bb, max_bb;
+  packed.getBoundingBox (min_bb, max_bb);
+  for (const auto &corrupt_child : corrupt_children)
+  {
+    // replace the first child of the node
+    std::string corrupt_data (packed_data);
+    const std::size_t node_offset = header.node_table_offset + corrupt_child.first * sizeof (OutofcorePackedNode);
+    OutofcorePackedNode node;
+    std::memcpy (&node, &corrupt_data[node_offset], sizeof (node));
+    const std::uint32_t* child = std::find_if (node.children, node.children + 8, [] (std::uint32_t c) { return (c != 0); });
+    ASSERT_NE (node.children + 8, child);
+    const std::size_t child_offset = node_offset + offsetof (OutofcorePackedNode, children) + (child - node.children) * sizeof (std::uint32_t);
+    std::memcpy (&corrupt_data[child_offset], &corrupt_child.second, sizeof (std::uint32_t));
+    {
+      std::ofstream out (corrupt_file.string ().c_str (), std::ios::binary);
+      out.write (corrupt_data.data (), corrupt_data.size ());
+    }
+    OutofcorePackedOctree<PointT> packed_corrupt (corrupt_file);
+    AlignedPointTVector points;
+    EXPECT_THROW (packed_corrupt.queryBBIncludes (min_bb, max_bb, packed_corrupt.getDepth (), points), pcl::PCLException);
+  }
+  boost::filesystem::remove (corrupt_file);
+
+  boost::filesystem::remove (packed_file);
+  boost::filesystem::remove (packed_raw_file);
+  cleanUpFilesystem ();
+}
+
 /* [--- */
 int
 main (int argc, char** argv)
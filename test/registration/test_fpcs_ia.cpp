@@ -37,6 +37,9 @@
 
 #include <pcl/test/gtest.h>
 
+#include <algorithm>
+#include <cfloat>
+
 #include <pcl/point_types.h>
 #include <pcl/io/pcd_io.h>
 #include <pcl/registration/ia_fpcs.h>
@@ -87,6 +90,136 @@ TEST (PCL, FPCSInitialAlignment)
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// exposes the pair search and the base matching of FPCSInitialAlignment
+class FPCSPairSearch : public FPCSInitialAlignment <PointXYZ, PointXYZ>
+{
+  public:
+    using FPCSInitialAlignment <PointXYZ, PointXYZ>::initCompute;
+    using FPCSInitialAlignment <PointXYZ, PointXYZ>::selectBase;
+    using FPCSInitialAlignment <PointXYZ, PointXYZ>::buildPairIndex;
+    using FPCSInitialAlignment <PointXYZ, PointXYZ>::bruteForceCorrespondences;
+    using FPCSInitialAlignment <PointXYZ, PointXYZ>::determineBaseMatches;
+    using FPCSInitialAlignment <PointXYZ, PointXYZ>::handleMatches;
+    using FPCSInitialAlignment <PointXYZ, PointXYZ>::pair_index_;
+    using FPCSInitialAlignment <PointXYZ, PointXYZ>::pair_index_max_dist_;
+    using FPCSInitialAlignment <PointXYZ, PointXYZ>::max_pair_diff_;
+};
+
+TEST (PCL, FPCSPairIndex)
+{
+  // an absolute delta and fixed source indices, initCompute seeds the normalization and
+  // the sampling of the source from the time
+  pcl::IndicesPtr source_indices (new pcl::Indices);
+  for (std::size_t i = 0; i < cloud_source.size (); i += 2)
+    source_indices->push_back (static_cast<pcl::index_t> (i));
+
+  FPCSPairSearch fpcs_ia[2];
+  const int threads[2] = { 1, 4 };
+  for (int i = 0; i < 2; ++i)
+  {
+    fpcs_ia[i].setInputSource (cloud_source.makeShared ());
+    fpcs_ia[i].setInputTarget (cloud_target.makeShared ());
+    fpcs_ia[i].setNumberOfThreads (threads[i]);
+    fpcs_ia[i].setApproxOverlap (approx_overlap);
+    fpcs_ia[i].setDelta (0.002f, false);
+    fpcs_ia[i].setIndices (source_indices);
+    ASSERT_TRUE (fpcs_ia[i].initCompute ());
+    fpcs_ia[i].buildPairIndex ();
+    EXPECT_FALSE (fpcs_ia[i].pair_index_.empty ());
+  }
+
+  // the pair index does not depend on the number of threads
+  ASSERT_EQ (fpcs_ia[0].pair_index_.size (), fpcs_ia[1].pair_index_.size ());
+  for (std::size_t j = 0; j < fpcs_ia[0].pair_index_.size (); ++j)
+  {
+    EXPECT_EQ (fpcs_ia[0].pair_index_[j].index_query, fpcs_ia[1].pair_index_[j].index_query);
+    EXPECT_EQ (fpcs_ia[0].pair_index_[j].index_match, fpcs_ia[1].pair_index_[j].index_match);
+  }
+
+  // the same exhaustive search, without the index
+  FPCSPairSearch fpcs_ia_exhaustive;
+  fpcs_ia_exhaustive.setInputSource (cloud_source.makeShared ());
+  fpcs_ia_exhaustive.setInputTarget (cloud_target.makeShared ());
+  fpcs_ia_exhaustive.setApproxOverlap (approx_overlap);
+  fpcs_ia_exhaustive.setDelta (0.002f, false);
+  fpcs_ia_exhaustive.setIndices (source_indices);
+  fpcs_ia_exhaustive.setMaxPairIndexSize (0);
+  ASSERT_TRUE (fpcs_ia_exhaustive.initCompute ());
+  fpcs_ia_exhaustive.buildPairIndex ();
+  EXPECT_TRUE (fpcs_ia_exhaustive.pair_index_.empty ());
+
+  const auto sorted_pairs = [] (Correspondences pairs)
+  {
+    std::sort (pairs.begin (), pairs.end (), [] (const Correspondence& a, const Correspondence& b)
+    {
+      return (a.index_query < b.index_query || (a.index_query == b.index_query && a.index_match < b.index_match));
+    });
+    return (pairs);
+  };
+  const auto equal_pairs = [] (const Correspondences& pairs_a, const Correspondences& pairs_b)
+  {
+    ASSERT_EQ (pairs_a.size (), pairs_b.size ());
+    for (std::size_t j = 0; j < pairs_a.size (); ++j)
+    {
+      EXPECT_EQ (pairs_a[j].index_query, pairs_b[j].index_query);
+      EXPECT_EQ (pairs_a[j].index_match, pairs_b[j].index_match);
+    }
+  };
+
+  // coplanar bases of the target, as the trials select them
+  std::srand (5489u);
+  int nr_indexed = 0, nr_scored = 0;
+  for (int i = 0; i < 20; ++i)
+  {
+    std::vector<int> base_indices (4);
+    float ratio[2];
+    ASSERT_EQ (0, fpcs_ia[0].selectBase (base_indices, ratio));
+
+    MatchingCandidates candidates[2];
+    for (int diagonal = 0; diagonal < 2; ++diagonal)
+    {
+      const int idx1 = base_indices[2 * diagonal], idx2 = base_indices[2 * diagonal + 1];
+      if (euclideanDistance (cloud_target[idx1], cloud_target[idx2]) + fpcs_ia[0].max_pair_diff_ <= fpcs_ia[0].pair_index_max_dist_)
+        nr_indexed++;
+
+      Correspondences pairs[2], pairs_exhaustive;
+      fpcs_ia[0].bruteForceCorrespondences (idx1, idx2, pairs[0]);
+      fpcs_ia[1].bruteForceCorrespondences (idx1, idx2, pairs[1]);
+      fpcs_ia_exhaustive.bruteForceCorrespondences (idx1, idx2, pairs_exhaustive);
+      equal_pairs (pairs[0], pairs[1]);
+      equal_pairs (sorted_pairs (pairs[0]), sorted_pairs (pairs_exhaustive));
+    }
+
+    // the candidates found from the indexed pairs are scored the same way by 1 and 4 threads,
+    // only the first matches are scored to keep the test short
+    for (int t = 0; t < 2; ++t)
+    {
+      Correspondences pairs_a, pairs_b;
+      std::vector<std::vector<int> > matches;
+      candidates[t].resize (1);
+      if (fpcs_ia[t].bruteForceCorrespondences (base_indices[0], base_indices[1], pairs_a) == 0 &&
+          fpcs_ia[t].bruteForceCorrespondences (base_indices[2], base_indices[3], pairs_b) == 0 &&
+          fpcs_ia[t].determineBaseMatches (base_indices, matches, pairs_a, pairs_b, ratio) == 0)
+      {
+        matches.resize (std::min<std::size_t> (matches.size (), 16));
+        fpcs_ia[t].handleMatches (base_indices, matches, candidates[t]);
+      }
+    }
+    ASSERT_EQ (candidates[0].size (), candidates[1].size ());
+    if (!candidates[0].empty () && candidates[0][0].fitness_score < FLT_MAX)
+    {
+      nr_scored++;
+      EXPECT_EQ (candidates[0][0].fitness_score, candidates[1][0].fitness_score);
+      EXPECT_EQ (candidates[0][0].transformation, candidates[1][0].transformation);
+    }
+  }
+
+  // most base diagonals are looked up in the index and most bases give a scored candidate
+  EXPECT_GT (nr_indexed, 30);
+  EXPECT_GT (nr_scored, 10);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 int
 main (int argc, char** argv)
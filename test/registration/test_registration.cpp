@@ -46,6 +46,10 @@
 #include <pcl/registration/icp.h>
 #include <pcl/registration/joint_icp.h>
 #include <pcl/registration/icp_nl.h>
+#include <pcl/registration/multi_resolution_registration.h>
+#include <pcl/registration/batch_registration.h>
+#include <pcl/registration/elch.h>
+#include <pcl/registration/lum.h>
 #include <pcl/registration/gicp.h>
 #include <pcl/registration/gicp6d.h>
 #include <pcl/registration/transformation_estimation_point_to_plane.h>
@@ -243,6 +247,97 @@ TEST (PCL, IterativeClosestPointWithNormals)
   EXPECT_TRUE(reg_double.getUseSymmetricObjective());
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, MultiResolutionRegistration)
+{
+  PointCloud<PointXYZ>::Ptr source (cloud_source.makeShared ());
+  PointCloud<PointXYZ>::Ptr target (new PointCloud<PointXYZ>);
+  Eigen::Affine3f delta (Eigen::Translation3f (0.02f, -0.01f, 0.015f) *
+                         Eigen::AngleAxisf (0.15f, Eigen::Vector3f::UnitY ()));
+  transformPointCloud (*source, *target, delta);
+
+  IterativeClosestPoint<PointXYZ, PointXYZ>::Ptr icp (new IterativeClosestPoint<PointXYZ, PointXYZ>);
+  icp->setTransformationEpsilon (1e-8);
+  icp->setMaximumIterations (50);
+
+  MultiResolutionRegistration<PointXYZ, PointXYZ> reg;
+  reg.setRegistration (icp);
+  reg.addLevel (0.01, 0.05, 30);
+  reg.addLevel (0.005, 0.02);
+  reg.addLevel (0.0, 0.01);
+  EXPECT_EQ (reg.getLevels ().size (), 3);
+  reg.setInputSource (source);
+  reg.setInputTarget (target);
+
+  reg.align (cloud_reg);
+  ASSERT_TRUE (reg.hasConverged ());
+  EXPECT_EQ (cloud_reg.size (), source->size ());
+  EXPECT_TRUE (reg.getFinalTransformation ().isApprox (delta.matrix (), 1e-3f));
+  // The wrapped registration gets its own settings back
+  EXPECT_EQ (icp->getMaximumIterations (), 50);
+
+  // The cached pyramids are reused by a second alignment
+  const Eigen::Matrix4f first = reg.getFinalTransformation ();
+  reg.align (cloud_reg);
+  EXPECT_TRUE (reg.getFinalTransformation ().isApprox (first, 1e-5f));
+  for (std::size_t i = 0; i < cloud_reg.size (); ++i)
+    EXPECT_NEAR (cloud_reg[i].x, (delta * source->points[i].getVector3fMap ()).x (), 1e-3);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, BatchRegistration)
+{
+  using Batch = pcl::registration::BatchRegistration<PointXYZ, PointXYZ>;
+  const auto make_icp = [] ()
+  {
+    IterativeClosestPoint<PointXYZ, PointXYZ>::Ptr icp (new IterativeClosestPoint<PointXYZ, PointXYZ>);
+    icp->setTransformationEpsilon (1e-8);
+    icp->setMaximumIterations (50);
+    return (icp);
+  };
+
+  // Two targets, each of them shared by several tasks
+  PointCloud<PointXYZ>::Ptr source (cloud_source.makeShared ());
+  std::vector<PointCloud<PointXYZ>::Ptr> targets;
+  std::vector<Eigen::Affine3f, Eigen::aligned_allocator<Eigen::Affine3f> > deltas;
+  for (int t = 0; t < 2; ++t)
+  {
+    deltas.push_back (Eigen::Translation3f (0.01f * t, 0.01f, -0.005f) *
+                      Eigen::AngleAxisf (0.05f + 0.05f * t, Eigen::Vector3f::UnitY ()));
+    targets.emplace_back (new PointCloud<PointXYZ>);
+    transformPointCloud (*source, *targets.back (), deltas.back ());
+  }
+
+  Batch batch;
+  batch.setRegistrationFactory (make_icp);
+  batch.setNumberOfThreads (4);
+  for (int i = 0; i < 6; ++i)
+    EXPECT_EQ (batch.addTask (source, targets[i % 2], i < 3 ? Eigen::Matrix4f::Identity () : deltas[i % 2].matrix ()), i);
+  // An invalid task does not abort the batch
+  batch.addTask (source, PointCloud<PointXYZ>::Ptr (new PointCloud<PointXYZ>));
+
+  Batch::Results results;
+  batch.compute (results);
+  ASSERT_EQ (results.size (), batch.getTasks ().size ());
+  EXPECT_FALSE (results.back ().converged);
+
+  for (int i = 0; i < 6; ++i)
+  {
+    // Same result as a single registration
+    auto icp = make_icp ();
+    icp->setInputSource (source);
+    icp->setInputTarget (targets[i % 2]);
+    icp->align (cloud_reg, batch.getTasks ()[i].guess);
+
+    EXPECT_EQ (results[i].converged, icp->hasConverged ());
+    EXPECT_EQ (results[i].convergence_state, icp->getConvergeCriteria ()->getConvergenceState ());
+    EXPECT_TRUE (results[i].final_transformation.isApprox (icp->getFinalTransformation (), 1e-5f));
+    EXPECT_NEAR (results[i].fitness_score, icp->getFitnessScore (), 1e-6);
+    EXPECT_TRUE (results[i].final_transformation.isApprox (deltas[i % 2].matrix (), 1e-3f));
+    EXPECT_GE (results[i].time, 0.0);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
 void
 sampleRandomTransform (Eigen::Affine3f &trans, float max_angle, float max_trans)
@@ -258,6 +353,176 @@ sampleRandomTransform (Eigen::Affine3f &trans, float max_angle, float max_trans)
     trans = Eigen::Translation3f(translation) * rotation;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// LUM::compute as it was before the sparse decomposition: dense G, column pivoting QR
+class LUMDense : public registration::LUM<PointXYZ>
+{
+public:
+  void
+  computeDense ()
+  {
+    const SLAMGraph& graph = *getLoopGraph ();
+    const int n = static_cast<int> (getNumVertices ());
+    for (int i = 0; i < getMaxIterations (); ++i)
+    {
+      typename SLAMGraph::edge_iterator e, e_end;
+      for (std::tie (e, e_end) = edges (graph); e != e_end; ++e)
+        computeEdge (*e);
+
+      Eigen::MatrixXf G = Eigen::MatrixXf::Zero (6 * (n - 1), 6 * (n - 1));
+      Eigen::VectorXf B = Eigen::VectorXf::Zero (6 * (n - 1));
+      for (int vi = 1; vi != n; ++vi)
+      {
+        for (int vj = 0; vj != n; ++vj)
+        {
+          Edge e;
+          bool present1;
+          std::tie (e, present1) = edge (vi, vj, graph);
+          if (!present1)
+          {
+            bool present2;
+            std::tie (e, present2) = edge (vj, vi, graph);
+            if (!present2)
+              continue;
+          }
+          if (vj > 0)
+            G.block (6 * (vi - 1), 6 * (vj - 1), 6, 6) = -graph[e].cinv_;
+          G.block (6 * (vi - 1), 6 * (vi - 1), 6, 6) += graph[e].cinv_;
+          B.segment (6 * (vi - 1), 6) += (present1 ? 1 : -1) * graph[e].cinvd_;
+        }
+      }
+      Eigen::VectorXf X = G.colPivHouseholderQr ().solve (B);
+
+      float sum = 0.0;
+      for (int vi = 1; vi != n; ++vi)
+      {
+        Eigen::Vector6f difference_pose = static_cast<Eigen::Vector6f> (-incidenceCorrection (getPose (vi)).inverse () * X.segment (6 * (vi - 1), 6));
+        sum += difference_pose.norm ();
+        setPose (vi, getPose (vi) + difference_pose);
+      }
+      if (sum <= getConvergenceThreshold () * static_cast<float> (n - 1))
+        return;
+    }
+  }
+};
+
+// True pose of the scans of buildLUMLoop
+Eigen::Vector6f
+getLUMLoopPose (int i)
+{
+  const float a = 0.05f * static_cast<float> (i);
+  Eigen::Vector6f pose;
+  pose << 0.02f * static_cast<float> (i), -0.01f * static_cast<float> (i), 0.005f * static_cast<float> (i), 0.5f * a, -0.3f * a, a;
+  return (pose);
+}
+
+// A loop of six scans of bun0 with disturbed pose estimates; with both_directions two
+// scans are linked in both directions, which makes G unsymmetric
+template <typename LUMType> void
+buildLUMLoop (LUMType &lum, bool both_directions)
+{
+  constexpr int nr_scans = 6;
+  for (int i = 0; i < nr_scans; ++i)
+  {
+    const Eigen::Vector6f pose = getLUMLoopPose (i);
+    // the scans are the same cloud seen from their true pose, with some measurement noise
+    // as LUM ignores edges which fit exactly
+    PointCloud<PointXYZ>::Ptr scan (new PointCloud<PointXYZ>);
+    const Eigen::Affine3f true_transform = pcl::getTransformation (pose (0), pose (1), pose (2), pose (3), pose (4), pose (5));
+    transformPointCloud (cloud_source, *scan, true_transform.inverse ());
+    for (std::size_t k = 0; k < scan->size (); ++k)
+      (*scan)[k].getVector3fMap () += 0.0005f * Eigen::Vector3f (std::sin (static_cast<float> (7 * k + i)),
+                                                                  std::cos (static_cast<float> (5 * k + 3 * i)),
+                                                                  std::sin (static_cast<float> (3 * k + 2 * i)));
+
+    Eigen::Vector6f noise;
+    noise << 0.01f, -0.005f, 0.008f, 0.02f, -0.01f, 0.015f;
+    lum.addPointCloud (scan, i == 0 ? Eigen::Vector6f (Eigen::Vector6f::Zero ()) : Eigen::Vector6f (pose + static_cast<float> (i % 3 + 1) * noise));
+  }
+
+  CorrespondencesPtr corrs (new Correspondences);
+  for (int k = 0; k < static_cast<int> (cloud_source.size ()); k += 5)
+    corrs->emplace_back (k, k, 0.0f);
+  for (int i = 0; i < nr_scans; ++i)
+    lum.setCorrespondences (i, (i + 1) % nr_scans, corrs);
+  lum.setCorrespondences (1, 4, corrs);
+  if (both_directions)
+    lum.setCorrespondences (3, 2, corrs);
+}
+
+TEST (PCL, LUM)
+{
+  for (const bool both_directions : {false, true})
+  {
+    LUMDense dense;
+    buildLUMLoop (dense, both_directions);
+    dense.computeDense ();
+
+    registration::LUM<PointXYZ> serial;
+    buildLUMLoop (serial, both_directions);
+    serial.setNumberOfThreads (1);
+    serial.compute ();
+
+    registration::LUM<PointXYZ> threaded;
+    buildLUMLoop (threaded, both_directions);
+    threaded.setNumberOfThreads (4);
+    threaded.compute ();
+
+    for (int i = 1; i < static_cast<int> (dense.getNumVertices ()); ++i)
+    {
+      const Eigen::Vector6f dense_pose = dense.getPose (i);
+      const Eigen::Vector6f serial_pose = serial.getPose (i);
+      const Eigen::Vector6f threaded_pose = threaded.getPose (i);
+      const Eigen::Vector6f true_pose = getLUMLoopPose (i);
+      for (int j = 0; j < 6; ++j)
+      {
+        // up to the measurement noise, the poses converge to the true ones
+        EXPECT_NEAR (true_pose (j), serial_pose (j), 5e-3);
+        EXPECT_NEAR (dense_pose (j), serial_pose (j), 1e-4);
+        // the edges are independent, so the result does not depend on the threads
+        EXPECT_EQ (serial_pose (j), threaded_pose (j));
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, ELCH)
+{
+  constexpr int nr_scans = 8;
+  registration::ELCH<PointXYZ> serial, threaded;
+  serial.setNumberOfThreads (1);
+  threaded.setNumberOfThreads (4);
+  for (int i = 0; i < nr_scans; ++i)
+  {
+    PointCloud<PointXYZ>::Ptr scan (new PointCloud<PointXYZ> (cloud_source));
+    serial.addPointCloud (scan);
+    threaded.addPointCloud (PointCloud<PointXYZ>::Ptr (new PointCloud<PointXYZ> (cloud_source)));
+  }
+
+  const Eigen::Matrix4f loop_transform = pcl::getTransformation (0.1f, -0.05f, 0.02f, 0.05f, -0.02f, 0.1f).matrix ();
+  for (auto elch : {&serial, &threaded})
+  {
+    elch->setLoopStart (0);
+    elch->setLoopEnd (nr_scans - 1);
+    elch->setLoopTransform (loop_transform);
+    elch->compute ();
+  }
+
+  const auto& serial_graph = *serial.getLoopGraph ();
+  const auto& threaded_graph = *threaded.getLoopGraph ();
+  // the start of the loop stays in place, its end is moved by the whole loop transform
+  EXPECT_TRUE (serial_graph[0].transform.matrix ().isIdentity (1e-5f));
+  EXPECT_TRUE (serial_graph[nr_scans - 1].transform.matrix ().isApprox (loop_transform, 1e-4f));
+  for (int i = 0; i < nr_scans; ++i)
+  {
+    EXPECT_EQ (serial_graph[i].transform.matrix (), threaded_graph[i].transform.matrix ());
+    ASSERT_EQ (serial_graph[i].cloud->size (), threaded_graph[i].cloud->size ());
+    for (std::size_t j = 0; j < serial_graph[i].cloud->size (); ++j)
+      EXPECT_EQ ((*serial_graph[i].cloud)[j].getVector3fMap (), (*threaded_graph[i].cloud)[j].getVector3fMap ());
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, IterativeClosestPointWithRejectors)
 {
@@ -133,6 +133,11 @@ TEST (PCL, SampleConsensusInitialAlignment)
     EXPECT_EQ (cloud_reg.size (), cloud_source.size ());
     EXPECT_LT (reg.getFitnessScore (), 0.0005);
   }
+  // Generate and verify the hypotheses in parallel
+  reg.setNumberOfThreads (0);
+  reg.align (cloud_reg);
+  EXPECT_EQ (cloud_reg.size (), cloud_source.size ());
+  EXPECT_LT (reg.getFitnessScore (), 0.0005);
 }
 
 
@@ -233,6 +238,12 @@ TEST (PCL, SampleConsensusPrerejective)
     inlier_fraction = static_cast<float> (reg.getInliers ().size ()) / static_cast<float> (cloud_source.size ());
     EXPECT_GT (inlier_fraction, 0.95f);
   }
+  // Generate and verify the hypotheses in parallel
+  reg.setNumberOfThreads (0);
+  reg.align (cloud_reg);
+  EXPECT_EQ (cloud_reg.size (), cloud_source.size ());
+  inlier_fraction = static_cast<float> (reg.getInliers ().size ()) / static_cast<float> (cloud_source.size ());
+  EXPECT_GT (inlier_fraction, 0.95f);
 }
 
 int
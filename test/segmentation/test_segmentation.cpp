@@ -44,11 +44,23 @@
 #include <pcl/search/search.h>
 #include <pcl/features/normal_3d.h>
 
+#include <pcl/segmentation/conditional_euclidean_clustering.h>
+#include <pcl/segmentation/extract_clusters.h>
 #include <pcl/segmentation/extract_polygonal_prism_data.h>
 #include <pcl/segmentation/segment_differences.h>
 #include <pcl/segmentation/region_growing.h>
 #include <pcl/segmentation/region_growing_rgb.h>
+#include <pcl/segmentation/sac_segmentation.h>
 #include <pcl/segmentation/min_cut_segmentation.h>
+#include <pcl/segmentation/max_flow_graph.h>
+#include <pcl/segmentation/progressive_morphological_filter.h>
+#include <pcl/segmentation/approximate_progressive_morphological_filter.h>
+#include <pcl/segmentation/supervoxel_clustering.h>
+#include <pcl/segmentation/lccp_segmentation.h>
+#include <pcl/segmentation/organized_multi_plane_segmentation.h>
+
+#include <limits>
+#include <set>
 
 using namespace pcl;
 using namespace pcl::io;
@@ -201,6 +213,105 @@ TEST (RegionGrowingTest, SegmentFromPoint)
   EXPECT_NE (0, cluster.indices.size());
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (RegionGrowingTest, NeighbourStorage)
+{
+  pcl::RegionGrowing<pcl::PointXYZ, pcl::Normal> rg;
+  rg.setInputCloud (another_cloud_);
+  rg.setInputNormals (another_normals_);
+  rg.setMinClusterSize (10);
+
+  std::vector <pcl::PointIndices> serial_clusters, parallel_clusters, on_demand_clusters;
+  rg.extract (serial_clusters);
+  rg.setNumberOfThreads (4);
+  rg.extract (parallel_clusters);
+  rg.setStoreNeighbours (false);
+  rg.extract (on_demand_clusters);
+
+  // Neither the number of threads nor the neighbour storage change the segmentation
+  EXPECT_NE (0, serial_clusters.size ());
+  ASSERT_EQ (serial_clusters.size (), parallel_clusters.size ());
+  ASSERT_EQ (serial_clusters.size (), on_demand_clusters.size ());
+  for (std::size_t i = 0; i < serial_clusters.size (); ++i)
+  {
+    EXPECT_EQ (serial_clusters[i].indices, parallel_clusters[i].indices);
+    EXPECT_EQ (serial_clusters[i].indices, on_demand_clusters[i].indices);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (RegionGrowingTest, DuplicateIndices)
+{
+  // every point is listed twice, its neighbours are only stored once
+  pcl::IndicesPtr indices (new pcl::Indices);
+  for (int repeat = 0; repeat < 2; ++repeat)
+    for (int i = 0; i < static_cast<int> (another_cloud_->size ()); ++i)
+      indices->push_back (i);
+
+  pcl::RegionGrowing<pcl::PointXYZ, pcl::Normal> rg;
+  rg.setInputCloud (another_cloud_);
+  rg.setInputNormals (another_normals_);
+  rg.setIndices (indices);
+  rg.setMinClusterSize (10);
+
+  std::vector <pcl::PointIndices> serial_clusters, parallel_clusters;
+  rg.extract (serial_clusters);
+  rg.setNumberOfThreads (4);
+  rg.extract (parallel_clusters);
+
+  EXPECT_NE (0, serial_clusters.size ());
+  ASSERT_EQ (serial_clusters.size (), parallel_clusters.size ());
+  std::vector<int> nr_labels (another_cloud_->size (), 0);
+  for (std::size_t i = 0; i < serial_clusters.size (); ++i)
+  {
+    EXPECT_EQ (serial_clusters[i].indices, parallel_clusters[i].indices);
+    for (const auto& index : parallel_clusters[i].indices)
+      nr_labels[index]++;
+  }
+  EXPECT_LE (*std::max_element (nr_labels.begin (), nr_labels.end ()), 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Reads the neighbour distances like subclasses written against the nested point_distances_ do
+class RegionGrowingRGBDistances : public RegionGrowingRGB<pcl::PointXYZRGB>
+{
+  public:
+    void
+    checkDistances () const
+    {
+      ASSERT_EQ (input_->size (), point_distances_.size ());
+      for (std::size_t i_point = 0; i_point < input_->size (); ++i_point)
+      {
+        const std::vector<float> flat (point_neighbour_distances_.begin () + point_neighbour_offsets_[i_point],
+                                       point_neighbour_distances_.begin () + point_neighbour_offsets_[i_point + 1]);
+        EXPECT_EQ (flat, point_distances_[i_point]);
+      }
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (RegionGrowingRGBTest, NeighbourStorage)
+{
+  RegionGrowingRGBDistances rg;
+  rg.setInputCloud (colored_cloud);
+  rg.setDistanceThreshold (10);
+  rg.setRegionColorThreshold (5);
+  rg.setPointColorThreshold (6);
+  rg.setMinClusterSize (20);
+
+  std::vector <pcl::PointIndices> stored_clusters, on_demand_clusters;
+  rg.setNumberOfThreads (4);
+  rg.extract (stored_clusters);
+  rg.checkDistances ();
+  rg.setStoreNeighbours (false);
+  rg.extract (on_demand_clusters);
+
+  EXPECT_NE (0, stored_clusters.size ());
+  ASSERT_EQ (stored_clusters.size (), on_demand_clusters.size ());
+  for (std::size_t i = 0; i < stored_clusters.size (); ++i)
+    EXPECT_EQ (stored_clusters[i].indices, on_demand_clusters[i].indices);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (MinCutSegmentationTest, Segment)
 {
@@ -334,6 +445,474 @@ TEST (MinCutSegmentationTest, SegmentWithWrongParameters)
   EXPECT_EQ (2, num_of_segments);
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (MinCutSegmentationTest, ReuseGraph)
+{
+  pcl::PointXYZ object_center;
+  object_center.x = -36.01f;
+  object_center.y = -64.73f;
+  object_center.z = -6.18f;
+  pcl::PointCloud<pcl::PointXYZ>::Ptr foreground_points (new pcl::PointCloud<pcl::PointXYZ> ());
+  foreground_points->points.push_back (object_center);
+  pcl::PointCloud<pcl::PointXYZ>::Ptr other_foreground_points (new pcl::PointCloud<pcl::PointXYZ> ());
+  other_foreground_points->points.push_back ((*another_cloud_)[another_cloud_->size () / 2]);
+
+  pcl::MinCutSegmentation<pcl::PointXYZ> mcSeg;
+  mcSeg.setInputCloud (another_cloud_);
+  mcSeg.setRadius (3.8003856);
+  mcSeg.setSigma (0.25);
+  mcSeg.setSourceWeight (0.8);
+  mcSeg.setNumberOfNeighbours (14);
+  mcSeg.setForegroundPoints (foreground_points);
+
+  std::vector <pcl::PointIndices> clusters;
+  mcSeg.extract (clusters);
+  ASSERT_EQ (2, clusters.size ());
+  EXPECT_FALSE (clusters[1].indices.empty ());
+  const double max_flow = mcSeg.getMaxFlow ();
+
+  // Only the unary potentials change, the graph is kept
+  std::vector <pcl::PointIndices> other_clusters;
+  mcSeg.setForegroundPoints (other_foreground_points);
+  mcSeg.extract (other_clusters);
+
+  pcl::MinCutSegmentation<pcl::PointXYZ> other_mcSeg;
+  other_mcSeg.setInputCloud (another_cloud_);
+  other_mcSeg.setRadius (3.8003856);
+  other_mcSeg.setSigma (0.25);
+  other_mcSeg.setSourceWeight (0.8);
+  other_mcSeg.setNumberOfNeighbours (14);
+  other_mcSeg.setForegroundPoints (other_foreground_points);
+  other_mcSeg.setNumberOfThreads (4);
+
+  std::vector <pcl::PointIndices> expected_clusters;
+  other_mcSeg.extract (expected_clusters);
+  ASSERT_EQ (2, other_clusters.size ());
+  ASSERT_EQ (2, expected_clusters.size ());
+  EXPECT_EQ (expected_clusters[0].indices, other_clusters[0].indices);
+  EXPECT_EQ (expected_clusters[1].indices, other_clusters[1].indices);
+  EXPECT_NEAR (other_mcSeg.getMaxFlow (), mcSeg.getMaxFlow (), 1e-6 * other_mcSeg.getMaxFlow ());
+
+  // Back to the first seeds
+  mcSeg.setForegroundPoints (foreground_points);
+  mcSeg.extract (other_clusters);
+  ASSERT_EQ (2, other_clusters.size ());
+  EXPECT_EQ (clusters[0].indices, other_clusters[0].indices);
+  EXPECT_EQ (clusters[1].indices, other_clusters[1].indices);
+  EXPECT_NEAR (max_flow, mcSeg.getMaxFlow (), 1e-6 * max_flow);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (MaxFlowGraph, NegativeTerminalCapacities)
+{
+  // A capacity of -c from the source is a capacity of c to the sink, and the other way around
+  pcl::segmentation::MaxFlowGraph graph;
+  graph.addNodes (4);
+  graph.setTerminalWeights (0, -3.0, 0.0);
+  graph.setTerminalWeights (1, 5.0, 0.0);
+  graph.setTerminalWeights (2, 4.0, 2.0);
+  graph.setTerminalWeights (3, -1.0, 2.0);
+  graph.addEdge (1, 0, 2.0);
+  graph.addEdge (2, 3, 1.0);
+
+  EXPECT_DOUBLE_EQ (5.0, graph.solve ());
+  const double source_residuals[] = {0.0, 3.0, 1.0, 0.0};
+  const double sink_residuals[] = {1.0, 0.0, 0.0, 2.0};
+  for (int u = 0; u < 4; ++u)
+  {
+    EXPECT_DOUBLE_EQ (source_residuals[u], graph.getSourceResidualCapacity (u));
+    EXPECT_DOUBLE_EQ (sink_residuals[u], graph.getSinkResidualCapacity (u));
+  }
+  EXPECT_FALSE (graph.inSourceTree (0));
+  EXPECT_TRUE (graph.inSourceTree (1));
+  EXPECT_TRUE (graph.inSourceTree (2));
+  EXPECT_FALSE (graph.inSourceTree (3));
+
+  // The same graph with non negative capacities
+  graph.setTerminalWeights (0, 0.0, 3.0);
+  graph.setTerminalWeights (3, 0.0, 3.0);
+  EXPECT_DOUBLE_EQ (5.0, graph.solve ());
+  for (int u = 0; u < 4; ++u)
+  {
+    EXPECT_DOUBLE_EQ (source_residuals[u], graph.getSourceResidualCapacity (u));
+    EXPECT_DOUBLE_EQ (sink_residuals[u], graph.getSinkResidualCapacity (u));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (EuclideanClusterExtraction, Parallel)
+{
+  // Every other point only, so that the indices are used
+  pcl::IndicesPtr indices (new pcl::Indices);
+  for (index_t i = 0; i < static_cast<index_t> (another_cloud_->size ()); i += 2)
+    indices->push_back (i);
+
+  for (const double tolerance : {0.05, 0.1, 0.3})
+  {
+    EuclideanClusterExtraction<PointXYZ> ec;
+    ec.setInputCloud (another_cloud_);
+    ec.setIndices (indices);
+    ec.setClusterTolerance (tolerance);
+    ec.setMinClusterSize (5);
+    ec.setMaxClusterSize (25000);
+
+    std::vector<PointIndices> serial_clusters, parallel_clusters;
+    ec.extract (serial_clusters);
+    ec.setNumberOfThreads (4);
+    ec.extract (parallel_clusters);
+
+    EXPECT_FALSE (serial_clusters.empty ());
+    ASSERT_EQ (serial_clusters.size (), parallel_clusters.size ());
+    for (std::size_t i = 0; i < serial_clusters.size (); ++i)
+      EXPECT_EQ (serial_clusters[i].indices, parallel_clusters[i].indices);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (EuclideanClusterExtraction, GridSearch)
+{
+  pcl::IndicesPtr indices (new pcl::Indices);
+  for (index_t i = 0; i < static_cast<index_t> (another_cloud_->size ()); i += 2)
+    indices->push_back (i);
+
+  for (const double tolerance : {0.05, 0.1, 0.3})
+  {
+    EuclideanClusterExtraction<PointXYZ> ec;
+    ec.setInputCloud (another_cloud_);
+    ec.setIndices (indices);
+    ec.setClusterTolerance (tolerance);
+    ec.setMinClusterSize (5);
+    ec.setMaxClusterSize (25000);
+
+    std::vector<PointIndices> tree_clusters, grid_clusters, parallel_grid_clusters;
+    ec.extract (tree_clusters);
+    ec.setUseGridSearch (true);
+    ec.extract (grid_clusters);
+    ec.setNumberOfThreads (4);
+    ec.extract (parallel_grid_clusters);
+
+    EXPECT_FALSE (tree_clusters.empty ());
+    ASSERT_EQ (tree_clusters.size (), grid_clusters.size ());
+    ASSERT_EQ (tree_clusters.size (), parallel_grid_clusters.size ());
+    for (std::size_t i = 0; i < tree_clusters.size (); ++i)
+    {
+      EXPECT_EQ (tree_clusters[i].indices, grid_clusters[i].indices);
+      EXPECT_EQ (tree_clusters[i].indices, parallel_grid_clusters[i].indices);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// A condition that depends on the order of the points, only the pairs going up are accepted
+bool
+goingUp (const PointXYZ &a, const PointXYZ &b, float)
+{
+  return (b.z >= a.z - 0.01f);
+}
+
+TEST (ConditionalEuclideanClustering, GridSearch)
+{
+  ConditionalEuclideanClustering<PointXYZ> cec;
+  cec.setInputCloud (another_cloud_);
+  cec.setConditionFunction (&goingUp);
+  cec.setClusterTolerance (0.1f);
+  cec.setMinClusterSize (5);
+
+  IndicesClusters tree_clusters, grid_clusters;
+  cec.segment (tree_clusters);
+  cec.setUseGridSearch (true);
+  cec.segment (grid_clusters);
+
+  // The clusters hold the same points, in an order that depends on the search
+  EXPECT_FALSE (tree_clusters.empty ());
+  ASSERT_EQ (tree_clusters.size (), grid_clusters.size ());
+  for (std::size_t i = 0; i < tree_clusters.size (); ++i)
+  {
+    std::sort (tree_clusters[i].indices.begin (), tree_clusters[i].indices.end ());
+    std::sort (grid_clusters[i].indices.begin (), grid_clusters[i].indices.end ());
+    EXPECT_EQ (tree_clusters[i].indices, grid_clusters[i].indices);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (SupervoxelClustering, Parallel)
+{
+  std::vector<PointCloud<PointXYZL>::Ptr> labeled_clouds;
+  for (const unsigned int threads : {1u, 2u, 4u})
+  {
+    SupervoxelClustering<PointXYZ> super (0.1f, 0.5f);
+    super.setInputCloud (another_cloud_);
+    super.setNumberOfThreads (threads);
+
+    std::map<std::uint32_t, Supervoxel<PointXYZ>::Ptr> supervoxel_clusters;
+    super.extract (supervoxel_clusters);
+    EXPECT_FALSE (supervoxel_clusters.empty ());
+    super.refineSupervoxels (2, supervoxel_clusters);
+    EXPECT_FALSE (supervoxel_clusters.empty ());
+    labeled_clouds.push_back (super.getLabeledVoxelCloud ());
+  }
+
+  // The parallel expansion does not depend on the number of threads
+  for (const auto &labeled_cloud : labeled_clouds)
+    EXPECT_FALSE (labeled_cloud->empty ());
+  ASSERT_EQ (labeled_clouds[1]->size (), labeled_clouds[2]->size ());
+  for (std::size_t i = 0; i < labeled_clouds[1]->size (); ++i)
+    EXPECT_EQ ((*labeled_clouds[1])[i].label, (*labeled_clouds[2])[i].label);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (ProgressiveMorphologicalFilter, Grid)
+{
+  // A sloped ground of 40x40m, sampled every 25cm, with a 4m high building on it
+  PointCloud<PointXYZ>::Ptr terrain (new PointCloud<PointXYZ>);
+  Indices expected_ground;
+  for (int i = 0; i < 160; ++i)
+    for (int j = 0; j < 160; ++j)
+    {
+      PointXYZ point (0.25f * i, 0.25f * j, 0.1f * 0.25f * i);
+      if (point.x > 10.0f && point.x < 18.0f && point.y > 20.0f && point.y < 26.0f)
+        point.z += 4.0f;
+      else
+        expected_ground.push_back (static_cast<index_t> (terrain->size ()));
+      terrain->push_back (point);
+    }
+
+  ProgressiveMorphologicalFilter<PointXYZ> pmf;
+  pmf.setInputCloud (terrain);
+  pmf.setMaxWindowSize (20);
+  pmf.setSlope (1.0f);
+  pmf.setInitialDistance (0.5f);
+  pmf.setMaxDistance (3.0f);
+  pmf.setUseGrid (true);
+  pmf.setNumberOfThreads (2);
+  Indices ground;
+  pmf.extract (ground);
+  EXPECT_EQ (expected_ground, ground);
+
+  ApproximateProgressiveMorphologicalFilter<PointXYZ> apmf;
+  apmf.setInputCloud (terrain);
+  apmf.setMaxWindowSize (20);
+  apmf.setSlope (1.0f);
+  apmf.setInitialDistance (0.5f);
+  apmf.setMaxDistance (3.0f);
+  apmf.setNumberOfThreads (2);
+  apmf.extract (ground);
+  EXPECT_EQ (expected_ground, ground);
+
+  // Non finite points of a non dense cloud are dropped
+  PointCloud<PointXYZ>::Ptr sparse_terrain (new PointCloud<PointXYZ> (*terrain));
+  for (std::size_t i = 0; i < sparse_terrain->size (); i += 7)
+    (*sparse_terrain)[i].x = (*sparse_terrain)[i].y = (*sparse_terrain)[i].z = std::numeric_limits<float>::quiet_NaN ();
+  sparse_terrain->is_dense = false;
+  Indices expected_sparse_ground;
+  for (const auto& idx : expected_ground)
+    if (idx % 7 != 0)
+      expected_sparse_ground.push_back (idx);
+
+  pmf.setInputCloud (sparse_terrain);
+  pmf.extract (ground);
+  EXPECT_EQ (expected_sparse_ground, ground);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (SACSegmentation, SegmentModels)
+{
+  // Three perpendicular planar patches (z = 0, x = 0 and y = 2) with 30x30 points each, and some points in between
+  pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ>);
+  for (int i = 0; i < 30; i++)
+    for (int j = 0; j < 30; j++)
+    {
+      const float u = 0.1f + 0.05f * static_cast<float> (i), v = 0.1f + 0.05f * static_cast<float> (j);
+      cloud->push_back (pcl::PointXYZ (u, v, 0.0f));
+      cloud->push_back (pcl::PointXYZ (0.0f, u, v));
+      cloud->push_back (pcl::PointXYZ (u, 2.0f, v));
+    }
+  for (int i = 0; i < 50; i++)
+    cloud->push_back (pcl::PointXYZ (0.5f + 0.013f * static_cast<float> (i), 0.3f + 0.021f * static_cast<float> (i % 7), 0.2f + 0.017f * static_cast<float> (i % 11)));
+
+  pcl::SACSegmentation<pcl::PointXYZ> seg;
+  seg.setModelType (pcl::SACMODEL_PLANE);
+  seg.setMethodType (pcl::SAC_RANSAC);
+  seg.setMaxIterations (200);
+  seg.setDistanceThreshold (0.01);
+  seg.setMinInliers (100);
+  seg.setInputCloud (cloud);
+
+  std::vector<pcl::PointIndices> inliers;
+  std::vector<pcl::ModelCoefficients> coefficients;
+  seg.segmentModels (inliers, coefficients);
+  ASSERT_EQ (3, inliers.size ());
+  ASSERT_EQ (3, coefficients.size ());
+  std::set<int> axes;
+  for (std::size_t i = 0; i < inliers.size (); i++)
+  {
+    EXPECT_EQ (900, inliers[i].indices.size ());
+    ASSERT_EQ (4, coefficients[i].values.size ());
+    const Eigen::Vector3f normal (coefficients[i].values[0], coefficients[i].values[1], coefficients[i].values[2]);
+    int axis;
+    EXPECT_NEAR (1.0, normal.cwiseAbs ().maxCoeff (&axis), 1e-4);
+    axes.insert (axis);
+  }
+  EXPECT_EQ (3, axes.size ());
+
+  // The number of models can be limited, and the result does not depend on the number of threads
+  std::vector<pcl::PointIndices> parallel_inliers;
+  std::vector<pcl::ModelCoefficients> parallel_coefficients;
+  seg.setNumberOfThreads (4);
+  seg.segmentModels (parallel_inliers, parallel_coefficients, 2);
+  ASSERT_EQ (2, parallel_inliers.size ());
+  for (std::size_t i = 0; i < parallel_inliers.size (); i++)
+  {
+    EXPECT_EQ (inliers[i].indices, parallel_inliers[i].indices);
+    EXPECT_EQ (coefficients[i].values, parallel_coefficients[i].values);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (OrganizedMultiPlaneSegmentation, Parallel)
+{
+  // A 64x48 depth image of a floor (y = 1) and a back wall (z = 3), with a band of invalid points
+  const unsigned width = 64, height = 48;
+  const float focal = 40.0f, nan = std::numeric_limits<float>::quiet_NaN ();
+  pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ> (width, height));
+  pcl::PointCloud<pcl::Normal>::Ptr normals (new pcl::PointCloud<pcl::Normal> (width, height));
+  for (unsigned v = 0; v < height; v++)
+    for (unsigned u = 0; u < width; u++)
+    {
+      pcl::PointXYZ& point = (*cloud) (u, v);
+      pcl::Normal& normal = (*normals) (u, v);
+      if (u >= 30 && u < 33)
+      {
+        point.x = point.y = point.z = nan;
+        normal.normal_x = normal.normal_y = normal.normal_z = nan;
+        continue;
+      }
+      const Eigen::Vector3f ray ((static_cast<float> (u) - 0.5f * width) / focal, (static_cast<float> (v) - 0.5f * height) / focal, 1.0f);
+      const bool floor = ray.y () > 0.0f && 1.0f / ray.y () < 3.0f;
+      point.getVector3fMap () = ray * (floor ? 1.0f / ray.y () : 3.0f);
+      normal.getNormalVector3fMap () = floor ? Eigen::Vector3f (0.0f, -1.0f, 0.0f) : Eigen::Vector3f (0.0f, 0.0f, -1.0f);
+      normal.curvature = 0.0f;
+    }
+
+  pcl::OrganizedMultiPlaneSegmentation<pcl::PointXYZ, pcl::Normal, pcl::Label> mps;
+  mps.setMinInliers (100);
+  mps.setAngularThreshold (0.05);
+  mps.setDistanceThreshold (0.01);
+  mps.setInputNormals (normals);
+  mps.setInputCloud (cloud);
+
+  std::vector<pcl::ModelCoefficients> coefficients;
+  std::vector<pcl::PointIndices> inliers, label_indices;
+  std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f> > centroids;
+  std::vector<Eigen::Matrix3f, Eigen::aligned_allocator<Eigen::Matrix3f> > covariances;
+  pcl::PointCloud<pcl::Label> labels;
+  mps.segment (coefficients, inliers, centroids, covariances, labels, label_indices);
+  ASSERT_EQ (4, inliers.size ());
+  std::size_t nr_inliers = 0;
+  for (const auto& plane : inliers)
+    nr_inliers += plane.indices.size ();
+  EXPECT_EQ (static_cast<std::size_t> (width - 3) * height, nr_inliers);
+
+  // The result does not depend on the number of threads, and the output buffers can be reused
+  std::vector<pcl::ModelCoefficients> parallel_coefficients;
+  std::vector<pcl::PointIndices> parallel_inliers, parallel_label_indices;
+  pcl::PointCloud<pcl::Label> parallel_labels;
+  mps.setNumberOfThreads (4);
+  for (int run = 0; run < 2; run++)
+  {
+    mps.segment (parallel_coefficients, parallel_inliers, centroids, covariances, parallel_labels, parallel_label_indices);
+    ASSERT_EQ (inliers.size (), parallel_inliers.size ());
+    for (std::size_t i = 0; i < inliers.size (); i++)
+    {
+      EXPECT_EQ (inliers[i].indices, parallel_inliers[i].indices);
+      EXPECT_EQ (coefficients[i].values, parallel_coefficients[i].values);
+    }
+    ASSERT_EQ (label_indices.size (), parallel_label_indices.size ());
+    for (std::size_t i = 0; i < label_indices.size (); i++)
+      EXPECT_EQ (label_indices[i].indices, parallel_label_indices[i].indices);
+    for (std::size_t i = 0; i < labels.size (); i++)
+      EXPECT_EQ (labels[i].label, parallel_labels[i].label);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (LCCPSegmentation, UpdateInputSupervoxels)
+{
+  // A floor (y = 0) of 5x5 supervoxels and a wall (z = 5) of 5x4 supervoxels, meeting at a concave edge
+  using SupervoxelMap = std::map<std::uint32_t, pcl::Supervoxel<pcl::PointXYZRGBA>::Ptr>;
+  SupervoxelMap supervoxels;
+  std::multimap<std::uint32_t, std::uint32_t> adjacency;
+  const auto add_supervoxel = [&supervoxels] (std::uint32_t label, const Eigen::Vector3f& centroid, const Eigen::Vector3f& normal)
+  {
+    pcl::Supervoxel<pcl::PointXYZRGBA>::Ptr supervoxel (new pcl::Supervoxel<pcl::PointXYZRGBA>);
+    supervoxel->centroid_.getVector3fMap () = centroid;
+    supervoxel->normal_.getNormalVector3fMap () = normal;
+    supervoxels[label] = supervoxel;
+  };
+  const auto connect = [&adjacency] (std::uint32_t label_a, std::uint32_t label_b)
+  {
+    adjacency.insert (std::make_pair (label_a, label_b));
+    adjacency.insert (std::make_pair (label_b, label_a));
+  };
+  const auto floor_label = [] (int x, int z) { return (static_cast<std::uint32_t> (1 + x + 5 * z)); };
+  const auto wall_label = [] (int x, int y) { return (static_cast<std::uint32_t> (100 + x + 5 * y)); };
+  for (int x = 0; x < 5; x++)
+  {
+    for (int z = 0; z < 5; z++)
+    {
+      add_supervoxel (floor_label (x, z), Eigen::Vector3f (x, 0, z), Eigen::Vector3f::UnitY ());
+      if (x > 0)
+        connect (floor_label (x, z), floor_label (x - 1, z));
+      if (z > 0)
+        connect (floor_label (x, z), floor_label (x, z - 1));
+    }
+    for (int y = 1; y < 5; y++)
+    {
+      add_supervoxel (wall_label (x, y), Eigen::Vector3f (x, y, 5), -Eigen::Vector3f::UnitZ ());
+      if (x > 0)
+        connect (wall_label (x, y), wall_label (x - 1, y));
+      connect (wall_label (x, y), y > 1 ? wall_label (x, y - 1) : floor_label (x, 4));
+    }
+  }
+
+  pcl::LCCPSegmentation<pcl::PointXYZRGBA> lccp;
+  lccp.setNumberOfThreads (4);
+  lccp.setInputSupervoxels (supervoxels, adjacency);
+  lccp.segment ();
+  std::map<std::uint32_t, std::set<std::uint32_t> > segments;
+  lccp.getSegmentToSupervoxelMap (segments);
+  ASSERT_EQ (2, segments.size ());
+  std::map<std::uint32_t, std::uint32_t> supervoxel_to_segment;
+  lccp.getSupervoxelToSegmentMap (supervoxel_to_segment);
+  EXPECT_EQ (25, segments[supervoxel_to_segment[floor_label (0, 0)]].size ());
+  EXPECT_EQ (20, segments[supervoxel_to_segment[wall_label (0, 1)]].size ());
+
+  // Turning the wall around makes the edge convex, only the connections of the wall are evaluated again
+  const SupervoxelMap original_supervoxels (supervoxels);
+  for (int x = 0; x < 5; x++)
+    for (int y = 1; y < 5; y++)
+      add_supervoxel (wall_label (x, y), Eigen::Vector3f (x, y, 5), Eigen::Vector3f::UnitZ ());
+  lccp.updateInputSupervoxels (supervoxels, adjacency);
+  lccp.segment ();
+  lccp.getSegmentToSupervoxelMap (segments);
+  ASSERT_EQ (1, segments.size ());
+  EXPECT_EQ (45, segments.begin ()->second.size ());
+
+  // The same as segmenting the new supervoxels from scratch
+  pcl::LCCPSegmentation<pcl::PointXYZRGBA> reference;
+  reference.setInputSupervoxels (supervoxels, adjacency);
+  reference.segment ();
+  std::map<std::uint32_t, std::set<std::uint32_t> > reference_segments;
+  reference.getSegmentToSupervoxelMap (reference_segments);
+  ASSERT_EQ (1, reference_segments.size ());
+
+  // And back again
+  lccp.updateInputSupervoxels (original_supervoxels, adjacency);
+  lccp.segment ();
+  lccp.getSegmentToSupervoxelMap (segments);
+  EXPECT_EQ (2, segments.size ());
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 TEST (SegmentDifferences, Segmentation)
 {